@@ -61,7 +61,7 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 namespace slade::global
 {
-string error;
+thread_local string error;
 
 #ifdef GIT_DESCRIPTION
 string sc_rev = GIT_DESCRIPTION;
@@ -269,7 +269,7 @@ public:
 
 		// Last 10 log lines
 		trace_ += "\nLast Log Messages:\n";
-		auto& log = log::history();
+		const auto log = log::history();
 		for (auto a = log.size() - 10; a < log.size(); a++)
 			trace_ += log[a].message + "\n";
 
@@ -33,6 +33,7 @@
 #include "Archive.h"
 #include "General/UndoRedo.h"
 #include "Utility/FileUtils.h"
+#include "Utility/MappedFile.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
 #include <filesystem>
@@ -47,6 +48,7 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 CVAR(Bool, archive_load_data, false, CVar::Flag::Save)
 CVAR(Bool, backup_archives, true, CVar::Flag::Save)
+CVAR(Bool, archive_mmap_files, true, CVar::Flag::Save)
 bool                  Archive::save_backup = true;
 vector<ArchiveFormat> Archive::formats_;
 
@@ -455,9 +457,10 @@ string Archive::filename(bool full) const
 // -----------------------------------------------------------------------------
 bool Archive::open(string_view filename)
 {
-	// Read the file into a MemChunk
+	// Read the file into a MemChunk (memory mapped if possible, so that entry
+	// data can reference the file data rather than copying it)
 	MemChunk mc;
-	if (!mc.importFile(filename))
+	if (!(archive_mmap_files && mc.importFileMapped(filename)) && !mc.importFile(filename))
 	{
 		global::error = "Unable to open file. Make sure it isn't in use by another program.";
 		return false;
@@ -473,7 +476,8 @@ bool Archive::open(string_view filename)
 	if (open(mc))
 	{
 		log::info(2, "Archive::open took {}ms", timer.getElapsedTime().asMilliseconds());
-		on_disk_ = true;
+		on_disk_      = true;
+		file_mapping_ = mc.mapping();
 		return true;
 	}
 	else
@@ -530,6 +534,47 @@ bool Archive::checkEntry(const ArchiveEntry* entry) const
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Reads [entry]'s data from [offset] in the archive file on disk. If the file
+// is memory mapped the entry will reference the mapped data, otherwise it is
+// read from the file.
+// Returns false if the archive file couldn't be opened
+// -----------------------------------------------------------------------------
+bool Archive::importEntryDataFromFile(ArchiveEntry* entry, uint32_t offset)
+{
+	const auto size = entry->size();
+
+	// Stop using the mapping (and read from the file instead) if the file has
+	// been changed by another program since it was mapped
+	if (file_mapping_ && file_mapping_->isMapped() && !file_mapping_->fileUnchanged())
+	{
+		log::warning("Archive file {} has changed on disk, no longer using memory mapped data", filename_);
+		file_mapping_.reset();
+	}
+
+	// Use mapped data if possible
+	if (file_mapping_ && file_mapping_->isMapped() && offset <= file_mapping_->size()
+		&& size <= file_mapping_->size() - offset)
+	{
+		MemChunk mc;
+		if (mc.importMapped(file_mapping_, offset, size))
+		{
+			entry->importMemChunk(mc);
+			return true;
+		}
+	}
+
+	// Otherwise read from the file
+	wxFile file(filename_);
+	if (!file.IsOpened())
+		return false;
+
+	file.Seek(offset, wxFromStart);
+	entry->importFileStream(file, size);
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the entry matching [name] within [dir].
 // If no dir is given the root dir is used
@@ -664,7 +709,7 @@ bool Archive::save(string_view filename)
 		if (!filename.empty())
 		{
 			// New filename is given (ie 'save as'), write to new file and change archive filename accordingly
-			success = write(filename);
+			success = MappedFile::writeFile(filename, [this](const string& path) { return write(path); });
 			if (success)
 				filename_ = filename;
 
@@ -685,8 +730,13 @@ bool Archive::save(string_view filename)
 				wxCopyFile(filename_, bakfile, true);
 			}
 
-			// Write it to the file
-			success = write(filename_);
+			// Write it to the file. If it is memory mapped it is replaced rather than
+			// overwritten, so data still referencing it stays valid (unless the
+			// existing data will be left as-is, then it is written in place)
+			if (writeKeepsFileData(filename_))
+				success = write(filename_);
+			else
+				success = MappedFile::writeFile(filename_, [this](const string& path) { return write(path); });
 
 			// Update variables
 			on_disk_       = true;
@@ -697,6 +747,10 @@ bool Archive::save(string_view filename)
 	// If saving was successful, update variables and announce save
 	if (success)
 	{
+		// Re-map the newly written file for loading entry data
+		if (file_mapping_)
+			file_mapping_ = archive_mmap_files && !parent_.lock() ? MappedFile::open(filename_) : nullptr;
+
 		setModified(false);
 		signals_.saved(*this);
 	}
@@ -6,6 +6,8 @@
 
 namespace slade
 {
+class MappedFile;
+
 struct ArchiveFormat
 {
 	string             id;
@@ -190,6 +192,15 @@ protected:
 	bool   read_only_     = false; // If true, the archive cannot be modified
 	time_t file_modified_ = 0;
 
+	shared_ptr<MappedFile> file_mapping_; // Memory mapping of the archive file (if opened from disk via mapping)
+
+	bool importEntryDataFromFile(ArchiveEntry* entry, uint32_t offset);
+
+	// Returns true if writing to [filename] will leave the existing archive data
+	// in the file intact (eg. only appending to it), so any memory mapping of the
+	// file doesn't need to be released first
+	virtual bool writeKeepsFileData(string_view filename) { return false; }
+
 private:
 	bool                   modified_ = true;
 	shared_ptr<ArchiveDir> dir_root_;
@@ -40,6 +40,11 @@ using namespace slade;
 
 namespace
 {
+// Directories with at least this many entries get a name index for lookups
+constexpr size_t NAME_INDEX_MIN_ENTRIES = 64;
+
+using NameIndexMap = std::unordered_map<string, vector<unsigned>>;
+
 void buildEntryList(vector<shared_ptr<ArchiveEntry>>& list, ArchiveDir const* dir)
 {
 	for (const auto& subdir : dir->subdirs())
@@ -57,6 +62,47 @@ void buildDirList(vector<shared_ptr<ArchiveDir>>& list, ArchiveDir const* dir)
 		buildDirList(list, subdir.get());
 	}
 }
+
+// -----------------------------------------------------------------------------
+// Adds [position] to the (sorted) list for [key] in name index [map]
+// -----------------------------------------------------------------------------
+void addToNameIndex(NameIndexMap& map, const string& key, unsigned position)
+{
+	auto& list = map[key];
+	list.insert(std::upper_bound(list.begin(), list.end(), position), position);
+}
+
+// -----------------------------------------------------------------------------
+// Removes [position] from the list for [key] in name index [map].
+// Returns false if it wasn't in the list
+// -----------------------------------------------------------------------------
+bool removeFromNameIndex(NameIndexMap& map, const string& key, unsigned position)
+{
+	const auto bucket = map.find(key);
+	if (bucket == map.end())
+		return false;
+
+	auto&      list = bucket->second;
+	const auto pos  = std::lower_bound(list.begin(), list.end(), position);
+	if (pos == list.end() || *pos != position)
+		return false;
+
+	list.erase(pos);
+	if (list.empty())
+		map.erase(bucket);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [offset] to all positions from [first] onwards in name index [map]
+// -----------------------------------------------------------------------------
+void shiftNameIndexPositions(NameIndexMap& map, unsigned first, int offset)
+{
+	for (auto& [key, list] : map)
+		for (auto pos = std::lower_bound(list.begin(), list.end(), first); pos != list.end(); ++pos)
+			*pos += offset;
+}
 } // namespace
 
 
@@ -223,6 +269,13 @@ ArchiveEntry* ArchiveDir::entry(string_view name, bool cut_ext) const
 	if (name.empty())
 		return nullptr;
 
+	// Use the name index if there is one
+	if (name_index_)
+	{
+		const auto index = indexedEntryIndex(name, cut_ext);
+		return index >= 0 ? entries_[index].get() : nullptr;
+	}
+
 	// Go through entries
 	for (auto& entry : entries_)
 	{
@@ -245,6 +298,13 @@ shared_ptr<ArchiveEntry> ArchiveDir::sharedEntry(string_view name, bool cut_ext)
 	if (name.empty())
 		return nullptr;
 
+	// Use the name index if there is one
+	if (name_index_)
+	{
+		const auto index = indexedEntryIndex(name, cut_ext);
+		return index >= 0 ? entries_[index] : nullptr;
+	}
+
 	// Go through entries
 	for (auto& entry : entries_)
 	{
@@ -306,11 +366,22 @@ bool ArchiveDir::addEntry(shared_ptr<ArchiveEntry> entry, bool ignore_requiremen
 	entry->parent_ = this;
 
 	// Check index
+	const auto position = std::min(index, static_cast<unsigned>(entries_.size()));
 	if (index >= entries_.size())
 		entries_.push_back(entry); // 'Invalid' index, add to end of list
 	else
 		entries_.insert(entries_.begin() + index, entry); // Add it at index
 
+	// Add to name index, or build it if there are now enough entries to need it
+	if (name_index_)
+	{
+		if (position + 1 < entries_.size())
+			shiftNameIndex(position, 1);
+		indexEntry(entry.get(), position);
+	}
+	else if (entries_.size() >= NAME_INDEX_MIN_ENTRIES)
+		buildNameIndex();
+
 	// Check entry name if duplicate names aren't allowed
 	if (!ignore_requirements && !allow_duplicate_names_)
 		ensureUniqueName(entry.get());
@@ -331,6 +402,14 @@ bool ArchiveDir::removeEntry(unsigned index)
 	// De-parent entry
 	entries_[index]->parent_ = nullptr;
 
+	// Remove it from the name index
+	if (name_index_)
+	{
+		unindexEntry(entries_[index]->upperName(), index);
+		if (index + 1 < entries_.size())
+			shiftNameIndex(index + 1, -1);
+	}
+
 	// Remove it from the entry list
 	entries_.erase(entries_.begin() + index);
 
@@ -350,6 +429,15 @@ bool ArchiveDir::swapEntries(unsigned index1, unsigned index2)
 	// Swap entries
 	entries_[index1].swap(entries_[index2]);
 
+	// Swap their positions in the name index
+	if (name_index_)
+	{
+		unindexEntry(entries_[index2]->upperName(), index1);
+		unindexEntry(entries_[index1]->upperName(), index2);
+		indexEntry(entries_[index1].get(), index1);
+		indexEntry(entries_[index2].get(), index2);
+	}
+
 	return true;
 }
 
@@ -453,6 +541,7 @@ void ArchiveDir::clear()
 {
 	entries_.clear();
 	subdirs_.clear();
+	name_index_.reset();
 }
 
 // -----------------------------------------------------------------------------
@@ -516,40 +605,63 @@ bool ArchiveDir::exportTo(string_view path) const
 // -----------------------------------------------------------------------------
 void ArchiveDir::ensureUniqueName(ArchiveEntry* entry) const
 {
-	unsigned      index     = 0;
-	unsigned      number    = 0;
-	const auto    n_entries = entries_.size();
+	unsigned      number = 0;
 	strutil::Path fn(entry->name());
 	auto          name = fn.fileName();
-	while (index < n_entries)
+	while (isNameUsed(name, entry))
 	{
-		if (entries_[index].get() == entry)
-		{
-			index++;
-			continue;
-		}
-
-		if (strutil::equalCI(entries_[index]->name(), name))
-		{
-			fn.setFileName(fmt::format("{} ({})", entry->nameNoExt(), ++number));
-			name  = fn.fileName();
-			index = 0;
-			continue;
-		}
-
-		index++;
+		fn.setFileName(fmt::format("{} ({})", entry->nameNoExt(), ++number));
+		name = fn.fileName();
 	}
 
 	if (number > 0)
 		entry->setName(name);
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if any entry in the directory other than [ignore] is named
+// [name] (case-insensitive)
+// -----------------------------------------------------------------------------
+bool ArchiveDir::isNameUsed(string_view name, const ArchiveEntry* ignore) const
+{
+	if (name_index_)
+	{
+		const auto bucket = name_index_->names.find(strutil::upper(name));
+		if (bucket == name_index_->names.end())
+			return false;
+
+		for (const auto position : bucket->second)
+			if (entries_[position].get() != ignore)
+				return true;
+
+		return false;
+	}
+
+	for (const auto& entry : entries_)
+		if (entry.get() != ignore && strutil::equalCI(entry->name(), name))
+			return true;
+
+	return false;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the first entry in the directory that has the same name as another,
 // or nullptr if all names are unique
 // -----------------------------------------------------------------------------
 ArchiveEntry* ArchiveDir::findDuplicateEntryName() const
 {
+	// With a name index, the first entry sharing its name with any other entry
+	// is the first duplicate
+	if (name_index_)
+	{
+		for (const auto& entry : entries_)
+			if (const auto bucket = name_index_->names.find(entry->upperName());
+				bucket != name_index_->names.end() && bucket->second.size() > 1)
+				return entry.get();
+
+		return nullptr;
+	}
+
 	unsigned   i1        = 0;
 	const auto n_entries = entries_.size();
 	while (i1 < n_entries)
@@ -571,6 +683,84 @@ ArchiveEntry* ArchiveDir::findDuplicateEntryName() const
 	return nullptr;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the index of the first entry matching [name] in this directory, using
+// the name index, or -1 if no entries match.
+// If [cut_ext] is true, [name] is compared against entry names without their
+// extensions
+// -----------------------------------------------------------------------------
+int ArchiveDir::indexedEntryIndex(string_view name, bool cut_ext) const
+{
+	const auto& names  = cut_ext ? name_index_->names_no_ext : name_index_->names;
+	const auto  bucket = names.find(strutil::upper(name));
+	if (bucket == names.end())
+		return -1;
+
+	// Duplicate names are allowed in some archives, so get the entry that comes
+	// first in the directory (positions are kept sorted)
+	return static_cast<int>(bucket->second.front());
+}
+
+// -----------------------------------------------------------------------------
+// Builds the name index from all entries in this directory
+// -----------------------------------------------------------------------------
+void ArchiveDir::buildNameIndex()
+{
+	name_index_ = std::make_unique<NameIndex>();
+	name_index_->names.reserve(entries_.size());
+	name_index_->names_no_ext.reserve(entries_.size());
+	for (unsigned a = 0; a < entries_.size(); ++a)
+		indexEntry(entries_[a].get(), a);
+}
+
+// -----------------------------------------------------------------------------
+// Adds [entry] at [position] to the name index
+// -----------------------------------------------------------------------------
+void ArchiveDir::indexEntry(const ArchiveEntry* entry, unsigned position)
+{
+	addToNameIndex(name_index_->names, entry->upperName(), position);
+	addToNameIndex(name_index_->names_no_ext, string{ entry->upperNameNoExt() }, position);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the entry at [position] (indexed as [upper_name]) from the name
+// index. Returns false if it wasn't in the index
+// -----------------------------------------------------------------------------
+bool ArchiveDir::unindexEntry(string_view upper_name, unsigned position)
+{
+	if (!removeFromNameIndex(name_index_->names, string{ upper_name }, position))
+		return false;
+
+	removeFromNameIndex(name_index_->names_no_ext, string{ upper_name.substr(0, upper_name.find('.')) }, position);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [offset] to all entry positions from [first] onwards in the name index,
+// for when entries are inserted or removed before the end of the directory
+// -----------------------------------------------------------------------------
+void ArchiveDir::shiftNameIndex(unsigned first, int offset)
+{
+	shiftNameIndexPositions(name_index_->names, first, offset);
+	shiftNameIndexPositions(name_index_->names_no_ext, first, offset);
+}
+
+// -----------------------------------------------------------------------------
+// Called when [entry] (previously named [old_upper_name]) has been renamed, to
+// update the name index
+// -----------------------------------------------------------------------------
+void ArchiveDir::entryRenamed(ArchiveEntry* entry, string_view old_upper_name)
+{
+	// Subdirectory entries also have this directory as their parent, but
+	// aren't in the index
+	if (!name_index_)
+		return;
+
+	const auto position = entryIndex(entry);
+	if (position >= 0 && unindexEntry(old_upper_name, position))
+		indexEntry(entry, position);
+}
+
 
 // -----------------------------------------------------------------------------
 //
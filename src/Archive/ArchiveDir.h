@@ -7,6 +7,7 @@ namespace slade
 class ArchiveDir
 {
 	friend class Archive;
+	friend class ArchiveEntry;
 
 public:
 	ArchiveDir(string_view name, const shared_ptr<ArchiveDir>& parent = nullptr, Archive* archive = nullptr);
@@ -42,6 +43,7 @@ public:
 	bool addEntry(shared_ptr<ArchiveEntry> entry, unsigned index = 0xFFFFFFFF) { return addEntry(entry, false, index); }
 	bool removeEntry(unsigned index);
 	bool swapEntries(unsigned index1, unsigned index2);
+	void reserveEntries(unsigned count) { entries_.reserve(count); }
 
 	// Subdirs
 	unsigned               numSubdirs() const { return subdirs_.size(); }
@@ -88,6 +90,23 @@ private:
 	vector<shared_ptr<ArchiveDir>>   subdirs_;
 	bool                             allow_duplicate_names_ = true;
 
+	// Case-insensitive (uppercase) entry name lookup, only built for directories
+	// with many entries. Each name maps to the (sorted) positions of the entries
+	// using it. Maintained as entries are added, removed, swapped and renamed
+	struct NameIndex
+	{
+		std::unordered_map<string, vector<unsigned>> names;
+		std::unordered_map<string, vector<unsigned>> names_no_ext;
+	};
+	unique_ptr<NameIndex> name_index_;
+
 	void ensureUniqueName(ArchiveEntry* entry) const;
+	bool isNameUsed(string_view name, const ArchiveEntry* ignore) const;
+	int  indexedEntryIndex(string_view name, bool cut_ext) const;
+	void buildNameIndex();
+	void indexEntry(const ArchiveEntry* entry, unsigned position);
+	bool unindexEntry(string_view upper_name, unsigned position);
+	void shiftNameIndex(unsigned first, int offset);
+	void entryRenamed(ArchiveEntry* entry, string_view old_upper_name);
 };
 } // namespace slade
@@ -35,7 +35,9 @@
 #include "Main.h"
 #include "ArchiveEntry.h"
 #include "Archive.h"
+#include "ArchiveDir.h"
 #include "General/Misc.h"
+#include "Utility/MappedFile.h"
 #include "Utility/StringUtils.h"
 
 using namespace slade;
@@ -91,6 +93,7 @@ ArchiveEntry::ArchiveEntry(ArchiveEntry& copy) :
 	type_{ copy.type_ },
 	ex_props_{ copy.ex_props_ },
 	encrypted_{ copy.encrypted_ },
+	full_size_{ copy.full_size_ },
 	reliability_{ copy.reliability_ }
 {
 	// Copy data
@@ -165,8 +168,8 @@ string ArchiveEntry::path(bool include_name) const
 // -----------------------------------------------------------------------------
 const uint8_t* ArchiveEntry::rawData(bool allow_load)
 {
-	// Return entry data
-	return data(allow_load).data();
+	// Return entry data (const, so memory mapped data isn't copied)
+	return std::as_const(data(allow_load)).data();
 }
 
 // -----------------------------------------------------------------------------
@@ -178,6 +181,12 @@ MemChunk& ArchiveEntry::data(bool allow_load)
 	// Get parent archive
 	auto parent_archive = parent();
 
+	// If the data is viewing a memory mapped file that has since been changed
+	// by another program, it can't be trusted (or even safely read if the file
+	// was truncated), so drop it and load it again from the file
+	if (data_.isMapped() && !data_.mapping()->fileUnchanged())
+		unloadData(true);
+
 	// Load the data if needed (and possible)
 	if (allow_load && !isLoaded() && parent_archive && size_ > 0 && size_ <= maxEntrySizeBytes())
 	{
@@ -229,8 +238,13 @@ int ArchiveEntry::index()
 // -----------------------------------------------------------------------------
 void ArchiveEntry::setName(string_view name)
 {
-	name_       = name;
-	upper_name_ = strutil::upper(name);
+	auto old_upper_name = std::move(upper_name_);
+	name_               = name;
+	upper_name_         = strutil::upper(name);
+
+	// Update the parent directory's name index
+	if (parent_ && old_upper_name != upper_name_)
+		parent_->entryRenamed(this, old_upper_name);
 }
 
 // -----------------------------------------------------------------------------
@@ -239,6 +253,11 @@ void ArchiveEntry::setName(string_view name)
 // -----------------------------------------------------------------------------
 void ArchiveEntry::setState(State state, bool silent)
 {
+	// Anything that modifies the entry (even during initial loading) sets the
+	// state, so use this to keep track of data changes
+	if (state != State::Unmodified)
+		++data_version_;
+
 	if (state_locked_ || (state == State::Unmodified && state_ == State::Unmodified))
 		return;
 
@@ -322,8 +341,11 @@ void ArchiveEntry::formatName(const ArchiveFormat& format)
 		if (const auto pos = name_.find('.'); pos != string::npos)
 			strutil::truncateIP(name_, pos);
 
-	// Update uppercase name
-	upper_name_ = strutil::upper(name_);
+	// Update uppercase name (and the parent directory's name index)
+	auto old_upper_name = std::move(upper_name_);
+	upper_name_         = strutil::upper(name_);
+	if (parent_ && old_upper_name != upper_name_)
+		parent_->entryRenamed(this, old_upper_name);
 }
 
 // -----------------------------------------------------------------------------
@@ -389,6 +411,7 @@ void ArchiveEntry::clearData()
 	// Reset attributes
 	size_        = 0;
 	data_loaded_ = false;
+	++data_version_;
 }
 
 // -----------------------------------------------------------------------------
@@ -441,8 +464,23 @@ bool ArchiveEntry::importMemChunk(MemChunk& mc)
 	// Check that the given MemChunk has data
 	if (mc.hasData())
 	{
+		// Memory mapped file data can be shared rather than copied
+		if (mc.isMapped() && !locked_ && mc.size() <= maxEntrySizeBytes())
+		{
+			clearData();
+			data_.importMem(mc);
+
+			// Update attributes
+			size_ = data_.size();
+			setLoaded();
+			setType(EntryType::unknownType());
+			setState(State::Modified);
+
+			return true;
+		}
+
 		// Copy the data from the MemChunk into the entry
-		return importMem(mc.data(), mc.size());
+		return importMem(std::as_const(mc).data(), mc.size());
 	}
 
 	return false;
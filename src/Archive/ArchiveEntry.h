@@ -57,6 +57,9 @@ public:
 	bool                     isLocked() const { return locked_; }
 	bool                     isLoaded() const { return data_loaded_; }
 	Encryption               encryption() const { return encrypted_; }
+	uint32_t                 fileOffset() const { return file_offset_; }
+	uint32_t                 fullSize() const { return full_size_; }
+	uint32_t                 dataVersion() const { return data_version_; }
 	ArchiveEntry*            nextEntry();
 	ArchiveEntry*            prevEntry();
 	shared_ptr<ArchiveEntry> getShared();
@@ -72,6 +75,8 @@ public:
 	}
 	void setState(State state, bool silent = false);
 	void setEncryption(Encryption enc) { encrypted_ = enc; }
+	void setFileOffset(uint32_t offset) { file_offset_ = offset; }
+	void setFullSize(uint32_t size) { full_size_ = size; }
 	void unloadData(bool force = false);
 	void lock();
 	void unlock();
@@ -128,6 +133,11 @@ private:
 	bool       locked_       = false;            // If true the entry data+info cannot be changed
 	bool       data_loaded_  = true;             // True if the entry's data is currently loaded into the data MemChunk
 	Encryption encrypted_    = Encryption::None; // Is there some encrypting on the archive?
+	uint32_t   data_version_ = 0;                // Incremented whenever the entry is modified
+
+	// Archive format info (for formats that read entry data from the archive file directly)
+	uint32_t file_offset_ = 0; // Offset of the entry data in the archive file
+	uint32_t full_size_   = 0; // Full (decoded) size of encrypted entry data, 0 if unknown
 
 	// Misc stuff
 	int    reliability_ = 0; // The reliability of the entry's identification
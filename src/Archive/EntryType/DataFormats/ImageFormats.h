@@ -5,7 +5,7 @@
 class PNGDataFormat : public EntryDataFormat
 {
 public:
-	PNGDataFormat() : EntryDataFormat("img_png") {}
+	PNGDataFormat() : EntryDataFormat("img_png", "\x89PNG\r\n\x1A\n", 9) {}
 	~PNGDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -58,7 +58,7 @@ public:
 class GIFDataFormat : public EntryDataFormat
 {
 public:
-	GIFDataFormat() : EntryDataFormat("img_gif"){};
+	GIFDataFormat() : EntryDataFormat("img_gif", "GIF8", 7){};
 	~GIFDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -244,7 +244,7 @@ public:
 class JPEGDataFormat : public EntryDataFormat
 {
 public:
-	JPEGDataFormat() : EntryDataFormat("img_jpeg"){};
+	JPEGDataFormat() : EntryDataFormat("img_jpeg", "\xFF\xD8\xFF", 129){};
 	~JPEGDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -300,7 +300,7 @@ public:
 class WebPDataFormat : public EntryDataFormat
 {
 public:
-	WebPDataFormat() : EntryDataFormat("img_webp") {}
+	WebPDataFormat() : EntryDataFormat("img_webp", "RIFF") {}
 	~WebPDataFormat() override = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -332,7 +332,7 @@ public:
 
 	int isThisFormat(MemChunk& mc) override
 	{
-		const uint8_t* data = mc.data();
+		const uint8_t* data = std::as_const(mc).data();
 
 		// Check size
 		if (mc.size() > sizeof(gfx::PatchHeader))
@@ -389,7 +389,7 @@ public:
 			if (mc[mc.size() - 1] != 0xFF)
 				return MATCH_FALSE;
 
-			const gfx::OldPatchHeader* header = (const gfx::OldPatchHeader*)mc.data();
+			const gfx::OldPatchHeader* header = (const gfx::OldPatchHeader*)std::as_const(mc).data();
 
 			// Check header values are 'sane'
 			if (header->width > 0 && header->height > 0)
@@ -442,7 +442,7 @@ public:
 		if (mc.size() <= sizeof(gfx::PatchHeader))
 			return MATCH_FALSE;
 
-		const uint8_t* data = mc.data();
+		const uint8_t* data = std::as_const(mc).data();
 
 		// Check that it ends on a FF byte.
 		if (mc[mc.size() - 1] != 0xFF)
@@ -518,7 +518,7 @@ public:
 		if (mc.size() < 6)
 			return MATCH_FALSE;
 
-		const uint8_t* data   = mc.data();
+		const uint8_t* data   = std::as_const(mc).data();
 		uint8_t        qwidth = data[0]; // quarter of width
 		uint8_t        height = data[1];
 		if (qwidth == 0 || height == 0
@@ -550,7 +550,7 @@ public:
 		if (mc.size() < sizeof(gfx::PatchHeader))
 			return MATCH_FALSE;
 
-		const uint8_t*          data   = mc.data();
+		const uint8_t*          data   = std::as_const(mc).data();
 		const gfx::PatchHeader* header = (const gfx::PatchHeader*)data;
 
 		// Check header values are 'sane'
@@ -579,7 +579,7 @@ public:
 		if (mc.size() < sizeof(gfx::JagPicHeader))
 			return MATCH_FALSE;
 
-		const uint8_t*           data   = mc.data();
+		const uint8_t*           data   = std::as_const(mc).data();
 		const gfx::JagPicHeader* header = (const gfx::JagPicHeader*)data;
 		int                      width  = wxINT16_SWAP_ON_LE(header->width);
 		int                      height = wxINT16_SWAP_ON_LE(header->height);
@@ -631,7 +631,7 @@ public:
 			return MATCH_FALSE;
 
 		// Verify duplication of content
-		const uint8_t* data = mc.data();
+		const uint8_t* data = std::as_const(mc).data();
 		size_t         dupe = size - 320;
 		for (size_t p = 0; p < 320; ++p)
 		{
@@ -694,7 +694,7 @@ public:
 		if (mc.size() < sizeof(gfx::PSXPicHeader))
 			return MATCH_FALSE;
 
-		const uint8_t*           data   = mc.data();
+		const uint8_t*           data   = std::as_const(mc).data();
 		const gfx::PSXPicHeader* header = (const gfx::PSXPicHeader*)data;
 
 		// Check header values are 'sane'
@@ -714,7 +714,7 @@ public:
 class IMGZDataFormat : public EntryDataFormat
 {
 public:
-	IMGZDataFormat() : EntryDataFormat("img_imgz"){};
+	IMGZDataFormat() : EntryDataFormat("img_imgz", "IMGZ", sizeof(gfx::IMGZHeader)){};
 	~IMGZDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -725,7 +725,7 @@ public:
 		if (size < sizeof(gfx::IMGZHeader))
 			return MATCH_FALSE;
 
-		const uint8_t*         data   = mc.data();
+		const uint8_t*         data   = std::as_const(mc).data();
 		const gfx::IMGZHeader* header = (const gfx::IMGZHeader*)data;
 
 		// Check signature
@@ -932,7 +932,7 @@ public:
 		if (mc.size() < sizeof(gfx::PatchHeader))
 			return MATCH_FALSE;
 
-		const uint8_t*          data   = mc.data();
+		const uint8_t*          data   = std::as_const(mc).data();
 		const gfx::PatchHeader* header = (const gfx::PatchHeader*)data;
 
 		// Check header values are 'sane'
@@ -1189,7 +1189,7 @@ public:
 
 	int isThisFormat(MemChunk& mc) override
 	{
-		const uint8_t* data = mc.data();
+		const uint8_t* data = std::as_const(mc).data();
 
 		// Check size
 		if (mc.size() > sizeof(gfx::ROTTPatchHeader))
@@ -1239,7 +1239,7 @@ public:
 
 	int isThisFormat(MemChunk& mc) override
 	{
-		const uint8_t* data = mc.data();
+		const uint8_t* data = std::as_const(mc).data();
 
 		// Check size
 		if (mc.size() > sizeof(gfx::ROTTPatchHeader))
@@ -1290,7 +1290,7 @@ public:
 
 	int isThisFormat(MemChunk& mc) override
 	{
-		const uint8_t* data = mc.data();
+		const uint8_t* data = std::as_const(mc).data();
 
 		// Check size
 		if (mc.size() > 800)
@@ -1319,7 +1319,7 @@ public:
 		if (mc.size() < sizeof(gfx::PatchHeader))
 			return MATCH_FALSE;
 
-		const uint8_t*          data   = mc.data();
+		const uint8_t*          data   = std::as_const(mc).data();
 		const gfx::PatchHeader* header = (const gfx::PatchHeader*)data;
 
 		// Check header values are 'sane'
@@ -1348,7 +1348,7 @@ public:
 		if (size < 8)
 			return MATCH_FALSE;
 
-		const uint8_t* data = mc.data();
+		const uint8_t* data = std::as_const(mc).data();
 		if (data[0] && data[1] && (size - 4 == (data[0] * data[1] * 4)) && data[size - 2] == 0 && data[size - 1] == 0)
 			return MATCH_TRUE;
 		return MATCH_FALSE;
@@ -1520,7 +1520,7 @@ public:
 		if (mc.size() <= 0x302)
 			return MATCH_FALSE;
 
-		const uint16_t* gfx_data = (const uint16_t*)mc.data();
+		const uint16_t* gfx_data = (const uint16_t*)std::as_const(mc).data();
 
 		size_t height = wxINT16_SWAP_ON_BE(gfx_data[0]);
 
@@ -1609,7 +1609,7 @@ public:
 		if (mc.size() <= 0x302)
 			return MATCH_FALSE;
 
-		const uint16_t* gfx_data = (const uint16_t*)mc.data();
+		const uint16_t* gfx_data = (const uint16_t*)std::as_const(mc).data();
 
 		size_t height = wxINT16_SWAP_ON_BE(gfx_data[0]);
 
@@ -103,8 +103,10 @@ int EntryDataFormat::isThisFormat(MemChunk& mc)
 // -----------------------------------------------------------------------------
 void EntryDataFormat::copyToFormat(EntryDataFormat& target) const
 {
-	target.patterns_ = patterns_;
-	target.size_min_ = size_min_;
+	target.magic_       = magic_;
+	target.detect_size_ = detect_size_;
+	target.patterns_    = patterns_;
+	target.size_min_    = size_min_;
 }
 
 
@@ -12,10 +12,17 @@ public:
 	static const int MATCH_PROBABLY = 192;
 	static const int MATCH_TRUE     = 255;
 
-	EntryDataFormat(string_view id) : id_{ id } {}
+	EntryDataFormat(string_view id, string_view magic = {}, unsigned detect_size = 0) :
+		id_{ id },
+		magic_{ magic },
+		detect_size_{ detect_size }
+	{
+	}
 	virtual ~EntryDataFormat() = default;
 
 	const string& id() const { return id_; }
+	const string& magic() const { return magic_; }
+	unsigned      detectSize() const { return detect_size_; }
 
 	virtual int isThisFormat(MemChunk& mc);
 	void        copyToFormat(EntryDataFormat& target) const;
@@ -28,6 +35,11 @@ public:
 
 private:
 	string id_;
+	string magic_; // Bytes the data must begin with to be this format (if any), used to speed up type detection
+
+	// Number of bytes from the start of the data isThisFormat needs to detect this format, or 0 if it needs all of it
+	// (eg. if it checks the data size). Used to detect types from only the start of unloaded entry data
+	unsigned detect_size_ = 0;
 
 	// Struct to specify an inclusive range for a byte (min <= valid <= max)
 	// If max == min, only 1 valid value
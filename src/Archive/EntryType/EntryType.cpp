@@ -32,12 +32,14 @@
 #include "Main.h"
 #include "EntryType.h"
 #include "App.h"
+#include "EntryTypeClassifier.h"
 #include "Archive/ArchiveManager.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "General/Console.h"
 #include "MainEditor/MainEditor.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 #include <filesystem>
 
 using namespace slade;
@@ -58,6 +60,115 @@ EntryType* etype_unknown = nullptr; // The default, 'unknown' entry type
 EntryType* etype_folder  = nullptr; // Folder entry type
 EntryType* etype_marker  = nullptr; // Marker entry type
 EntryType* etype_map     = nullptr; // Map marker type
+
+// Max number of entries to gather in an EntryTypeDetectBatch before detecting
+constexpr size_t DETECT_BATCH_MAX_ENTRIES = 4096;
+
+// Compiled entry type list for detection, rebuilt when types are added
+EntryTypeClassifier type_classifier;
+bool                type_classifier_valid = false;
+std::mutex          type_classifier_mutex;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns a list of all entry types, in the order they are checked for
+// detection
+// -----------------------------------------------------------------------------
+vector<EntryType*> detectionOrder()
+{
+	vector<EntryType*> types;
+	types.reserve(entry_types.size());
+	for (const auto& type : entry_types)
+		types.push_back(type.get());
+
+	return types;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the entry type classifier, building it first if needed
+// -----------------------------------------------------------------------------
+const EntryTypeClassifier& typeClassifier()
+{
+	std::lock_guard lock(type_classifier_mutex);
+
+	if (!type_classifier_valid)
+	{
+		type_classifier.build(detectionOrder());
+		type_classifier_valid = true;
+	}
+
+	return type_classifier;
+}
+
+// -----------------------------------------------------------------------------
+// Finds the most reliable type match out of [types], using [is_type] to check
+// each type for a match.
+// Returns the matching type (or etype_unknown) and sets [reliability] to the
+// match result
+// -----------------------------------------------------------------------------
+template<typename F> EntryType* bestTypeMatch(const vector<EntryType*>& types, int& reliability, F&& is_type)
+{
+	auto type   = etype_unknown;
+	reliability = 0;
+
+	// Go through all given types
+	for (const auto etype : types)
+	{
+		// If the current type is more 'reliable' than this one, skip it
+		const int type_reliability = type->reliability() * reliability / 255;
+		if (type_reliability >= etype->reliability())
+			continue;
+
+		// Check for possible type match
+		const int r = is_type(etype);
+		if (r > 0)
+		{
+			// Type matches
+			type        = etype;
+			reliability = r;
+
+			// No need to continue if the identification is 100% reliable
+			if (type->reliability() * r / 255 >= 255)
+				break;
+		}
+	}
+
+	return type;
+}
+
+// -----------------------------------------------------------------------------
+// Finds the most reliable type match for the entry in [context] without
+// modifying it, only checking the types [classifier] gives as candidates.
+// Returns the matching type (or etype_unknown) and sets [reliability] to the
+// match result.
+// Only reads from the entry and the type list, so can be called for different
+// entries on multiple threads at once
+// -----------------------------------------------------------------------------
+EntryType* findEntryType(EntryType::MatchContext& context, int& reliability, const EntryTypeClassifier& classifier)
+{
+	thread_local vector<EntryType*> candidates;
+
+	classifier.candidates(context, candidates);
+
+	return bestTypeMatch(candidates, reliability, [&context](EntryType* type) { return type->isThisType(context); });
+}
+
+// -----------------------------------------------------------------------------
+// Finds the most reliable type match for [entry], see above
+// -----------------------------------------------------------------------------
+EntryType* findEntryType(ArchiveEntry& entry, int& reliability, const EntryTypeClassifier& classifier)
+{
+	EntryType::MatchContext context{ entry };
+	return findEntryType(context, reliability, classifier);
+}
 } // namespace
 
 
@@ -100,13 +211,14 @@ void EntryType::dump() const
 void EntryType::copyToType(EntryType& target) const
 {
 	// Copy type attributes
-	target.editor_      = editor_;
-	target.extension_   = extension_;
-	target.icon_        = icon_;
-	target.name_        = name_;
-	target.reliability_ = reliability_;
-	target.category_    = category_;
-	target.colour_      = colour_;
+	target.editor_            = editor_;
+	target.extension_         = extension_;
+	target.icon_              = icon_;
+	target.name_              = name_;
+	target.reliability_       = reliability_;
+	target.category_          = category_;
+	target.colour_            = colour_;
+	target.compression_level_ = compression_level_;
 
 	// Copy type match criteria
 	target.format_          = format_;
@@ -137,6 +249,18 @@ string EntryType::fileFilterString() const
 // -----------------------------------------------------------------------------
 int EntryType::isThisType(ArchiveEntry& entry) const
 {
+	MatchContext context{ entry };
+	return isThisType(context);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the entry in [context] matches the EntryType's criteria,
+// false otherwise
+// -----------------------------------------------------------------------------
+int EntryType::isThisType(MatchContext& context) const
+{
+	auto& entry = context.entry;
+
 	// Check type is detectable
 	if (!detectable_)
 		return EntryDataFormat::MATCH_FALSE;
@@ -155,7 +279,7 @@ int EntryType::isThisType(ArchiveEntry& entry) const
 		bool match = false;
 		for (const auto& a : match_archive_)
 		{
-			if (entry.parent() && entry.parent()->formatDesc().entry_format == a)
+			if (entry.parent() && context.archiveFormat() == a)
 			{
 				match = true;
 				break;
@@ -186,19 +310,14 @@ int EntryType::isThisType(ArchiveEntry& entry) const
 	int r = EntryDataFormat::MATCH_TRUE;
 	if (format_ == EntryDataFormat::textFormat())
 	{
-		// Hack for identifying ACS script sources despite DB2 apparently appending
-		// two null bytes to them, which make the memchr test fail.
-		size_t end = entry.size() - 1;
-		if (end > 3)
-			end -= 2;
 		// Text is a special case, as other data formats can sometimes be detected as 'text',
 		// we'll only check for it if text data is specified in the entry type
-		if (entry.size() > 0 && memchr(entry.rawData(), 0, end) != nullptr)
+		if (!context.isText())
 			return EntryDataFormat::MATCH_FALSE;
 	}
 	else if (format_ != EntryDataFormat::anyFormat() && entry.size() > 0)
 	{
-		r = format_->isThisFormat(entry.data());
+		r = context.formatMatch(format_);
 		if (r == EntryDataFormat::MATCH_FALSE)
 			return EntryDataFormat::MATCH_FALSE;
 	}
@@ -231,16 +350,10 @@ int EntryType::isThisType(ArchiveEntry& entry) const
 	// Entry name related stuff
 	if (!match_name_.empty() || !match_extension_.empty())
 	{
-		// Get entry name (lowercase), find extension separator
-		const string_view fn      = entry.upperName();
-		const size_t      ext_sep = fn.find_last_of('.');
-
 		// Check for name match if needed
 		if (!match_name_.empty())
 		{
-			auto name = fn;
-			if (ext_sep != string::npos)
-				name = fn.substr(0, ext_sep);
+			auto name = context.name;
 
 			// If we are matching 8 characters or less, only check the first 8 characters of the entry name
 			if (match_name_.size() <= 8 && name.size() > 8)
@@ -266,12 +379,11 @@ int EntryType::isThisType(ArchiveEntry& entry) const
 		if (!match_extension_.empty())
 		{
 			bool match = false;
-			if (ext_sep != string::npos)
+			if (context.has_extension)
 			{
-				const auto ext = fn.substr(ext_sep + 1);
 				for (const auto& match_ext : match_extension_)
 				{
-					if (ext == match_ext)
+					if (context.extension == match_ext)
 					{
 						match = true;
 						break;
@@ -291,7 +403,7 @@ int EntryType::isThisType(ArchiveEntry& entry) const
 		if (!entry.parent())
 			return EntryDataFormat::MATCH_FALSE;
 
-		const auto e_section = entry.parent()->detectNamespace(&entry);
+		const auto& e_section = context.section();
 
 		r = EntryDataFormat::MATCH_FALSE;
 		for (const auto& ns : section_)
@@ -471,6 +583,10 @@ bool EntryType::readEntryTypeDefinitions(string_view definitions, string_view so
 			{
 				ntype->reliability_ = static_cast<uint8_t>(fieldnode->intValue());
 			}
+			else if (fn_name == "compression_level") // Compression level field
+			{
+				ntype->compression_level_ = std::clamp(fieldnode->intValue(), 0, 9);
+			}
 			else if (fn_name == "match_archive") // Archive field
 			{
 				for (unsigned v = 0; v < fieldnode->nValues(); v++)
@@ -522,6 +638,10 @@ bool EntryType::readEntryTypeDefinitions(string_view definitions, string_view so
 		entry_types.push_back(std::move(ntype));
 	}
 
+	// Type list changed, classifier will need rebuilding
+	std::lock_guard lock(type_classifier_mutex);
+	type_classifier_valid = false;
+
 	return true;
 }
 
@@ -602,32 +722,92 @@ bool EntryType::detectEntryType(ArchiveEntry& entry)
 		return true;
 	}
 
-	// Reset entry type
-	entry.setType(etype_unknown);
+	// Find and set the entry type
+	int  r     = 0;
+	auto etype = findEntryType(entry, r, typeClassifier());
+	entry.setType(etype, r);
 
-	// Go through all registered types
-	const size_t entry_types_size = entry_types.size();
-	for (size_t a = 0; a < entry_types_size; a++)
-	{
-		// If the current type is more 'reliable' than this one, skip it
-		if (entry.typeReliability() >= entry_types[a]->reliability())
-			continue;
+	// Return t/f depending on if a matching type was found
+	return entry.type() != etype_unknown;
+}
 
-		// Check for possible type match
-		const int r = entry_types[a]->isThisType(entry);
-		if (r > 0)
+// -----------------------------------------------------------------------------
+// Detects the types of all [entries], split across worker threads.
+// The entries' data must already be loaded, and nothing else may modify the
+// entries or their parent archive until this returns. Detected types are set on
+// the entries in order once all detection is complete
+// -----------------------------------------------------------------------------
+void EntryType::detectEntryTypes(const vector<ArchiveEntry*>& entries)
+{
+	// Find types
+	const auto&                        classifier = typeClassifier();
+	vector<std::pair<EntryType*, int>> results(entries.size(), { nullptr, 0 });
+	ThreadPool::global().parallelFor(
+		entries.size(),
+		[&entries, &results, &classifier](size_t index)
 		{
-			// Type matches, set it
-			entry.setType(entry_types[a].get(), r);
+			auto& entry = *entries[index];
 
-			// No need to continue if the identification is 100% reliable
-			if (entry.typeReliability() >= 255)
-				return true;
-		}
-	}
+			// Do nothing if the entry is a folder or a map marker
+			if (entry.type() == etype_folder || entry.type() == etype_map)
+				return;
 
-	// Return t/f depending on if a matching type was found
-	return entry.type() != etype_unknown;
+			// Zero-sized entries are markers
+			if (entry.size() == 0)
+				results[index] = { etype_marker, 0 };
+			else
+				results[index].first = findEntryType(entry, results[index].second, classifier);
+		},
+		8);
+
+	// Set types
+	for (unsigned a = 0; a < entries.size(); ++a)
+		if (results[a].first)
+			entries[a]->setType(results[a].first, results[a].second);
+}
+
+// -----------------------------------------------------------------------------
+// Detects the types of all [entries] (in parallel) without loading their data.
+// Only the first [size] bytes of each entry's data are read via [read] to begin
+// with, all of it is only read if a type being checked needs more than that to
+// detect its data format, and none of it is kept afterwards.
+// Entries that [read] fails for are left as they are
+// -----------------------------------------------------------------------------
+void EntryType::detectEntryTypes(const vector<ArchiveEntry*>& entries, DataReader read, unsigned size)
+{
+	// Find types
+	const auto&                        classifier = typeClassifier();
+	vector<std::pair<EntryType*, int>> results(entries.size(), { nullptr, 0 });
+	ThreadPool::global().parallelFor(
+		entries.size(),
+		[&entries, &results, &classifier, &read, size](size_t index)
+		{
+			auto& entry = *entries[index];
+
+			// Do nothing if the entry is a folder or a map marker
+			if (entry.type() == etype_folder || entry.type() == etype_map)
+				return;
+
+			// Zero-sized entries are markers
+			if (entry.size() == 0)
+			{
+				results[index] = { etype_marker, 0 };
+				return;
+			}
+
+			MemChunk prefix;
+			if (!read(index, prefix, size))
+				return;
+
+			MatchContext context{ entry, prefix, [&read, index](MemChunk& mc) { return read(index, mc, 0); } };
+			results[index].first = findEntryType(context, results[index].second, classifier);
+		},
+		8);
+
+	// Set types
+	for (unsigned a = 0; a < entries.size(); ++a)
+		if (results[a].first)
+			entries[a]->setType(results[a].first, results[a].second);
 }
 
 // -----------------------------------------------------------------------------
@@ -702,6 +882,131 @@ vector<string> EntryType::allCategories()
 }
 
 
+// -----------------------------------------------------------------------------
+//
+// EntryType::MatchContext Struct Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MatchContext struct constructor
+// -----------------------------------------------------------------------------
+EntryType::MatchContext::MatchContext(ArchiveEntry& entry) : entry{ entry }, full_name{ entry.upperName() }
+{
+	const auto ext_sep = full_name.find_last_of('.');
+	if (ext_sep != string_view::npos)
+	{
+		name          = full_name.substr(0, ext_sep);
+		extension     = full_name.substr(ext_sep + 1);
+		has_extension = true;
+	}
+	else
+		name = full_name;
+}
+
+// -----------------------------------------------------------------------------
+// MatchContext struct constructor for an entry that only has the start of its
+// data ([prefix]) available, [read_all] is used to read all of it if needed
+// -----------------------------------------------------------------------------
+EntryType::MatchContext::MatchContext(ArchiveEntry& entry, MemChunk& prefix, std::function<bool(MemChunk&)> read_all) :
+	MatchContext{ entry }
+{
+	data_     = &prefix;
+	read_all_ = std::move(read_all);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the entry format id of the entry's parent archive, or an empty string
+// if it has no parent
+// -----------------------------------------------------------------------------
+const string& EntryType::MatchContext::archiveFormat()
+{
+	if (!archive_format_)
+		archive_format_ = entry.parent() ? entry.parent()->formatDesc().entry_format : string{};
+
+	return *archive_format_;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the namespace (section) of the archive the entry is in
+// -----------------------------------------------------------------------------
+const string& EntryType::MatchContext::section()
+{
+	if (!section_)
+		section_ = entry.parent() ? entry.parent()->detectNamespace(&entry) : string{};
+
+	return *section_;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the entry data, which may only be the start of it if the context was
+// created with a prefix. All of the data is read first if it is needed, ie. if
+// [size] is 0 or more than the prefix has
+// -----------------------------------------------------------------------------
+MemChunk& EntryType::MatchContext::data(unsigned size)
+{
+	if (!data_)
+		return entry.data();
+
+	if (read_all_ && data_->size() < entry.size() && (size == 0 || size > data_->size()))
+	{
+		if (read_all_(all_data_))
+			data_ = &all_data_;
+		read_all_ = nullptr;
+	}
+
+	return *data_;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the entry data could be text (ie. doesn't contain any null
+// bytes)
+// -----------------------------------------------------------------------------
+bool EntryType::MatchContext::isText()
+{
+	if (!is_text_)
+	{
+		// Hack for identifying ACS script sources despite DB2 apparently appending
+		// two null bytes to them, which make the memchr test fail.
+		size_t end = entry.size() - 1;
+		if (end > 3)
+			end -= 2;
+
+		// A null byte in the start of the data is enough to rule out text,
+		// otherwise all of it has to be checked
+		const auto has_null = [end](const MemChunk& mc)
+		{
+			return memchr(mc.data(), 0, std::min<size_t>(end, mc.size())) != nullptr;
+		};
+		if (entry.size() == 0)
+			is_text_ = true;
+		else if (has_null(data(1)))
+			is_text_ = false;
+		else
+			is_text_ = data(1).size() >= end || !has_null(data(end));
+	}
+
+	return *is_text_;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the result of checking the entry data against [format]. Each format
+// is only checked once per entry
+// -----------------------------------------------------------------------------
+int EntryType::MatchContext::formatMatch(EntryDataFormat* format)
+{
+	for (const auto& [match_format, result] : format_matches_)
+		if (match_format == format)
+			return result;
+
+	const int result = format->isThisFormat(data(format->detectSize()));
+	format_matches_.emplace_back(format, result);
+
+	return result;
+}
+
+
 // -----------------------------------------------------------------------------
 //
 // Console Commands
@@ -817,3 +1122,116 @@ CONSOLE_COMMAND(size, 0, true)
 	}
 	log::info("{}: {} bytes", meep->name(), meep->size());
 }
+
+// -----------------------------------------------------------------------------
+// Benchmarks entry type detection for all entries in the current archive,
+// comparing checking every type in turn against checking only the candidate
+// types from the classifier
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(benchmark_type_detection, 0, false)
+{
+	auto archive = maineditor::currentArchive();
+	if (!archive)
+	{
+		log::console("No archive open");
+		return;
+	}
+
+	const int iterations = args.empty() ? 10 : std::max(strutil::asInt(args[0]), 1);
+
+	// Get all (non-empty) entries and load their data
+	vector<ArchiveEntry*> all_entries, entries;
+	archive->putEntryTreeAsList(all_entries);
+	for (auto entry : all_entries)
+	{
+		if (entry->type() != etype_folder && entry->size() > 0)
+		{
+			entry->data();
+			entries.push_back(entry);
+		}
+	}
+
+	const auto         types      = detectionOrder();
+	const auto&        classifier = typeClassifier();
+	vector<EntryType*> linear_results(entries.size());
+	vector<EntryType*> classified_results(entries.size());
+	int                reliability = 0;
+
+	// Check all types
+	wxStopWatch sw;
+	for (int i = 0; i < iterations; ++i)
+		for (unsigned a = 0; a < entries.size(); ++a)
+			linear_results[a] = bestTypeMatch(
+				types, reliability, [&](EntryType* type) { return type->isThisType(*entries[a]); });
+	const auto linear_time = sw.Time();
+
+	// Check candidate types only
+	sw.Start();
+	for (int i = 0; i < iterations; ++i)
+		for (unsigned a = 0; a < entries.size(); ++a)
+			classified_results[a] = findEntryType(*entries[a], reliability, classifier);
+	const auto classified_time = sw.Time();
+
+	// Results should be identical
+	unsigned mismatches = 0;
+	for (unsigned a = 0; a < entries.size(); ++a)
+	{
+		if (linear_results[a] != classified_results[a])
+		{
+			log::console(fmt::format(
+				"{}: {} (all types) / {} (classifier)",
+				entries[a]->path(true),
+				linear_results[a]->id(),
+				classified_results[a]->id()));
+			++mismatches;
+		}
+	}
+
+	log::console(fmt::format(
+		"Detected {} entries x{}: all types {}ms, classifier {}ms, {} mismatches",
+		entries.size(),
+		iterations,
+		linear_time,
+		classified_time,
+		mismatches));
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// EntryTypeDetectBatch Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Adds [entry] to the batch, detecting types for the whole batch if it has
+// reached its size limit
+// -----------------------------------------------------------------------------
+void EntryTypeDetectBatch::add(ArchiveEntry* entry)
+{
+	entries_.push_back(entry);
+	data_size_ += entry->size();
+
+	if (data_size_ >= max_data_size_ || entries_.size() >= DETECT_BATCH_MAX_ENTRIES)
+		detect();
+}
+
+// -----------------------------------------------------------------------------
+// Detects types for all entries in the batch and clears it, unloading entry
+// data afterwards if needed
+// -----------------------------------------------------------------------------
+void EntryTypeDetectBatch::detect()
+{
+	if (entries_.empty())
+		return;
+
+	EntryType::detectEntryTypes(entries_);
+
+	if (unload_data_)
+		for (auto* entry : entries_)
+			entry->unloadData();
+
+	entries_.clear();
+	data_size_ = 0;
+}
@@ -23,6 +23,7 @@ public:
 	const string& icon() const { return icon_; }
 	int           index() const { return index_; }
 	uint8_t       reliability() const { return reliability_; }
+	int           compressionLevel() const { return compression_level_; }
 	PropertyList& extraProps() { return extra_; }
 	ColRGBA       colour() const { return colour_; }
 
@@ -31,14 +32,51 @@ public:
 	void   copyToType(EntryType& target) const;
 	string fileFilterString() const;
 
+	// Info about an entry being checked against entry types, worked out once
+	// per entry rather than once for each type checked
+	struct MatchContext
+	{
+		ArchiveEntry& entry;
+		string_view   full_name; // Upper-case name
+		string_view   name;      // Upper-case name without extension
+		string_view   extension; // Upper-case extension
+		bool          has_extension = false;
+
+		MatchContext(ArchiveEntry& entry);
+		MatchContext(ArchiveEntry& entry, MemChunk& prefix, std::function<bool(MemChunk&)> read_all);
+
+		const string& archiveFormat();
+		const string& section();
+		MemChunk&     data(unsigned size = 0);
+		bool          isText();
+		int           formatMatch(EntryDataFormat* format);
+
+	private:
+		MemChunk*                                data_ = nullptr; // Start of the entry data, if not using the entry's
+		std::function<bool(MemChunk&)>           read_all_;       // Reads all of the entry data, if data_ is partial
+		MemChunk                                 all_data_;
+		std::optional<string>                    archive_format_;
+		std::optional<string>                    section_;
+		std::optional<bool>                      is_text_;
+		vector<std::pair<EntryDataFormat*, int>> format_matches_;
+	};
+
+	// Reads the data of the entry at [index] in a list being detected into
+	// [mc]. Only the first [size] bytes (or a bit less, if compressed) need to
+	// be read, or all of it if [size] is 0
+	using DataReader = std::function<bool(size_t index, MemChunk& mc, unsigned size)>;
+
 	// Magic goes here
 	int isThisType(ArchiveEntry& entry) const;
+	int isThisType(MatchContext& context) const;
 
 	// Static functions
 	static void               initTypes();
 	static bool               readEntryTypeDefinitions(string_view definitions, string_view source);
 	static bool               loadEntryTypes();
 	static bool               detectEntryType(ArchiveEntry& entry);
+	static void               detectEntryTypes(const vector<ArchiveEntry*>& entries);
+	static void               detectEntryTypes(const vector<ArchiveEntry*>& entries, DataReader read, unsigned size);
 	static EntryType*         fromId(string_view id);
 	static EntryType*         unknownType();
 	static EntryType*         folderType();
@@ -67,6 +105,9 @@ private:
 								 // bool "patch": Can be used as a TEXTUREx patch
 								 // string "image_format": An SIFormat type id 'hint', mostly used for
 								 // misc::loadImageFromEntry
+	int compression_level_ = -1; // Compression level (0-9) for this type in compressed archives, -1 for default.
+								 // Types whose data is already compressed (png, ogg, zip etc.) use 1, since
+								 // deflating them again costs time for almost no size gain
 
 	// Type matching criteria
 	EntryDataFormat* format_;        // To be of this type, the entry data must match the specified format
@@ -80,5 +121,31 @@ private:
 	vector<string> section_;       // The 'section' of the archive the entry must be in, eg "sprites" for entries
 								   // between SS_START/SS_END in a wad, or the 'sprites' folder in a zip
 	vector<string> match_archive_; // The types of archive the entry can be found in (e.g., wad or zip)
+
+	friend class EntryTypeClassifier;
+};
+
+// Collects entries with loaded data and detects their types in parallel once
+// enough data has been gathered (or on detect()/destruction). Used when
+// opening archives to spread type detection across cores while keeping the
+// amount of entry data held in memory at once bounded
+class EntryTypeDetectBatch
+{
+public:
+	EntryTypeDetectBatch(bool unload_data, size_t max_data_size = 32 * 1024 * 1024) :
+		unload_data_{ unload_data },
+		max_data_size_{ max_data_size }
+	{
+	}
+	~EntryTypeDetectBatch() { detect(); }
+
+	void add(ArchiveEntry* entry);
+	void detect();
+
+private:
+	vector<ArchiveEntry*> entries_;
+	bool                  unload_data_   = false;
+	size_t                data_size_     = 0;
+	size_t                max_data_size_ = 0;
 };
 } // namespace slade
@@ -0,0 +1,218 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2022 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    EntryTypeClassifier.cpp
+// Description: EntryTypeClassifier class, narrows down the entry types an
+//              entry could be before they are checked during type detection
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "EntryTypeClassifier.h"
+#include "Archive/ArchiveEntry.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns true if [pattern] has no wildcards, ie. it only matches a name
+// exactly the same as it
+// -----------------------------------------------------------------------------
+bool isExactPattern(string_view pattern)
+{
+	return pattern.find_first_of("*?") == string_view::npos;
+}
+
+// -----------------------------------------------------------------------------
+// Appends all types in [bucket] to [list]
+// -----------------------------------------------------------------------------
+void addTypes(vector<EntryType*>& list, const vector<EntryType*>& bucket)
+{
+	list.insert(list.end(), bucket.begin(), bucket.end());
+}
+
+// -----------------------------------------------------------------------------
+// Appends all types in [map] under [key] (if any) to [list]
+// -----------------------------------------------------------------------------
+template<typename K>
+void addTypes(vector<EntryType*>& list, const std::unordered_map<K, vector<EntryType*>>& map, const K& key)
+{
+	auto i = map.find(key);
+	if (i != map.end())
+		addTypes(list, i->second);
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// EntryTypeClassifier Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Builds the classifier from [types], which should be in the order they are
+// to be checked in.
+// Each detectable type is added to the bucket for the most specific criteria
+// it requires an entry to match, or to the 'always' bucket if it has none
+// -----------------------------------------------------------------------------
+void EntryTypeClassifier::build(const vector<EntryType*>& types)
+{
+	always_.clear();
+	by_ext_.clear();
+	by_name_.clear();
+	by_name_8_.clear();
+	by_size_.clear();
+	for (auto& bucket : by_name_initial_)
+		bucket.clear();
+	for (auto& bucket : by_magic_)
+		bucket.clear();
+
+	for (auto type : types)
+	{
+		if (!type->detectable_)
+			continue;
+
+		// Type matches either name or extension
+		if (type->match_ext_or_name_ && !type->match_name_.empty() && !type->match_extension_.empty())
+		{
+			if (addByName(type))
+				for (const auto& ext : type->match_extension_)
+					by_ext_[ext].push_back(type);
+			else
+				always_.push_back(type);
+
+			continue;
+		}
+
+		// Type must match an extension
+		if (!type->match_extension_.empty())
+		{
+			for (const auto& ext : type->match_extension_)
+				by_ext_[ext].push_back(type);
+			continue;
+		}
+
+		// Type must match a name
+		if (!type->match_name_.empty() && addByName(type))
+			continue;
+
+		// Type must match a size
+		if (!type->match_size_.empty())
+		{
+			for (int size : type->match_size_)
+				by_size_[static_cast<unsigned>(size)].push_back(type);
+			continue;
+		}
+
+		// Type's data format has a magic signature
+		const auto& magic = type->format_->magic();
+		if (!magic.empty())
+		{
+			by_magic_[static_cast<uint8_t>(magic[0])].push_back(type);
+			continue;
+		}
+
+		always_.push_back(type);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds [type] to the name buckets, if all of its name patterns are either exact
+// or begin with a non-wildcard character.
+// Returns false if the type couldn't be added
+// -----------------------------------------------------------------------------
+bool EntryTypeClassifier::addByName(EntryType* type)
+{
+	for (const auto& pattern : type->match_name_)
+		if (!isExactPattern(pattern) && (pattern[0] == '*' || pattern[0] == '?'))
+			return false;
+
+	// Only the first 8 characters of the name are checked when there are 8 or
+	// less names to match (see EntryType::isThisType)
+	auto& exact_names = type->match_name_.size() <= 8 ? by_name_8_ : by_name_;
+
+	for (const auto& pattern : type->match_name_)
+	{
+		if (isExactPattern(pattern))
+			exact_names[pattern].push_back(type);
+		else
+			by_name_initial_[static_cast<uint8_t>(pattern[0])].push_back(type);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Fills [list] with all types the entry in [context] could possibly be, in the
+// order they should be checked
+// -----------------------------------------------------------------------------
+void EntryTypeClassifier::candidates(EntryType::MatchContext& context, vector<EntryType*>& list) const
+{
+	list.clear();
+	addTypes(list, always_);
+
+	// Extension
+	if (context.has_extension)
+		addTypes(list, by_ext_, string{ context.extension });
+
+	// Name
+	addTypes(list, by_name_, string{ context.name });
+	addTypes(list, by_name_8_, string{ context.name.substr(0, 8) });
+	if (!context.name.empty())
+		addTypes(list, by_name_initial_[static_cast<uint8_t>(context.name[0])]);
+
+	// Size
+	const unsigned size = context.entry.size();
+	addTypes(list, by_size_, size);
+
+	// Data format magic
+	if (size > 0)
+	{
+		for (auto type : by_magic_[std::as_const(context.data(1))[0]])
+		{
+			const auto& magic = type->format_->magic();
+			if (size < magic.size())
+				continue;
+
+			const auto& data = context.data(magic.size());
+			if (memcmp(data.data(), magic.data(), magic.size()) == 0)
+				list.push_back(type);
+		}
+	}
+
+	// Types must be checked in their original order
+	std::sort(list.begin(), list.end(), [](EntryType* a, EntryType* b) { return a->index() < b->index(); });
+	list.erase(std::unique(list.begin(), list.end()), list.end());
+}
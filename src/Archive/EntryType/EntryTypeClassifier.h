@@ -0,0 +1,35 @@
+#pragma once
+
+#include "EntryType.h"
+
+namespace slade
+{
+// Compiled form of the entry type definitions, used to quickly narrow down
+// which types an entry could possibly be before checking each of them.
+// Types are bucketed by the criteria that must match for the type to be
+// detected (extension, name, size or data format magic), so only the types in
+// buckets matching the entry (plus any types that can't be bucketed) need to
+// be checked
+class EntryTypeClassifier
+{
+public:
+	EntryTypeClassifier()  = default;
+	~EntryTypeClassifier() = default;
+
+	void build(const vector<EntryType*>& types);
+	void candidates(EntryType::MatchContext& context, vector<EntryType*>& list) const;
+
+private:
+	using TypeBucket = vector<EntryType*>;
+
+	TypeBucket                               always_;               // Types that must always be checked
+	std::unordered_map<string, TypeBucket>   by_ext_;               // Types by matching extension
+	std::unordered_map<string, TypeBucket>   by_name_;              // Types by exact matching name
+	std::unordered_map<string, TypeBucket>   by_name_8_;            // Types by exact matching name (first 8 chars)
+	std::unordered_map<unsigned, TypeBucket> by_size_;              // Types by matching size
+	TypeBucket                               by_name_initial_[256]; // Types by first character of matching name
+	TypeBucket                               by_magic_[256];        // Types by first byte of data format magic
+
+	bool addByName(EntryType* type);
+};
+} // namespace slade
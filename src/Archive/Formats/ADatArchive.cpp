@@ -323,20 +323,13 @@ bool ADatArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
-	// Open archive file
-	wxFile file(filename_);
-
-	// Check it opened
-	if (!file.IsOpened())
+	// Read the entry data from the file
+	if (!importEntryDataFromFile(entry, entry->exProp<int>("Offset")))
 	{
 		log::error("ADatArchive::loadEntryData: Unable to open archive file {}", filename_);
 		return false;
 	}
 
-	// Seek to entry offset in file and read it in
-	file.Seek(entry->exProp<int>("Offset"), wxFromStart);
-	entry->importFileStream(file, entry->size());
-
 	// Set the lump to loaded
 	entry->setLoaded();
 
@@ -71,7 +71,7 @@ bool DatArchive::open(MemChunk& mc)
 	if (!mc.hasData())
 		return false;
 
-	const uint8_t* mcdata = mc.data();
+	const uint8_t* mcdata = std::as_const(mc).data();
 
 	// Read dat header
 	mc.seek(0, SEEK_SET);
@@ -552,20 +552,13 @@ bool DatArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
-	// Open wadfile
-	wxFile file(filename_);
-
-	// Check if opening the file failed
-	if (!file.IsOpened())
+	// Read the entry data from the file
+	if (!importEntryDataFromFile(entry, getEntryOffset(entry)))
 	{
 		log::error("DatArchive::loadEntryData: Failed to open datfile {}", filename_);
 		return false;
 	}
 
-	// Seek to lump offset in file and read it in
-	file.Seek(getEntryOffset(entry), wxFromStart);
-	entry->importFileStream(file, entry->size());
-
 	// Set the lump to loaded
 	entry->setLoaded();
 
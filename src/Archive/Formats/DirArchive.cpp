@@ -98,6 +98,7 @@ bool DirArchive::open(string_view filename)
 	const ArchiveModSignalBlocker sig_blocker{ *this };
 
 	ui::setSplashProgressMessage("Reading files");
+	EntryTypeDetectBatch detect_batch(!archive_load_data);
 	for (unsigned a = 0; a < files.size(); a++)
 	{
 		ui::setSplashProgress(static_cast<float>(a) / static_cast<float>(files.size()));
@@ -130,13 +131,10 @@ bool DirArchive::open(string_view filename)
 
 		file_modification_times_[new_entry.get()] = fileutil::fileModifiedTime(files[a]);
 
-		// Detect entry type
-		EntryType::detectEntryType(*new_entry);
-
-		// Unload data if needed
-		if (!archive_load_data)
-			new_entry->unloadData();
+		// Queue for type detection (types are detected in parallel batches)
+		detect_batch.add(new_entry.get());
 	}
+	detect_batch.detect();
 
 	// Add empty directories
 	for (const auto& subdir : dirs)
@@ -275,20 +275,13 @@ bool GobArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
-	// Open gobfile
-	wxFile file(filename_);
-
-	// Check if opening the file failed
-	if (!file.IsOpened())
+	// Read the entry data from the file
+	if (!importEntryDataFromFile(entry, getEntryOffset(entry)))
 	{
 		log::error("GobArchive::loadEntryData: Failed to open gobfile {}", filename_);
 		return false;
 	}
 
-	// Seek to lump offset in file and read it in
-	file.Seek(getEntryOffset(entry), wxFromStart);
-	entry->importFileStream(file, entry->size());
-
 	// Set the lump to loaded
 	entry->setLoaded();
 
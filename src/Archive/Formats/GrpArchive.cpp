@@ -259,20 +259,13 @@ bool GrpArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
-	// Open grpfile
-	wxFile file(filename_);
-
-	// Check if opening the file failed
-	if (!file.IsOpened())
+	// Read the entry data from the file
+	if (!importEntryDataFromFile(entry, getEntryOffset(entry)))
 	{
 		log::error("GrpArchive::loadEntryData: Failed to open grpfile {}", filename_);
 		return false;
 	}
 
-	// Seek to lump offset in file and read it in
-	file.Seek(getEntryOffset(entry), wxFromStart);
-	entry->importFileStream(file, entry->size());
-
 	// Set the lump to loaded
 	entry->setLoaded();
 
@@ -62,7 +62,7 @@ namespace
 // -----------------------------------------------------------------------------
 void decodeTxb(MemChunk& mc)
 {
-	const uint8_t*       data    = mc.data();
+	const uint8_t*       data    = std::as_const(mc).data();
 	const uint8_t* const dataend = data + mc.size();
 	uint8_t*             odata   = new uint8_t[mc.size()];
 	uint8_t* const       ostart  = odata;
@@ -85,7 +85,7 @@ void decodeTxb(MemChunk& mc)
 // -----------------------------------------------------------------------------
 uint8_t* encodeTxb(MemChunk& mc)
 {
-	const uint8_t*       data    = mc.data();
+	const uint8_t*       data    = std::as_const(mc).data();
 	const uint8_t* const dataend = data + mc.size();
 	uint8_t*             odata   = new uint8_t[mc.size()];
 	uint8_t* const       ostart  = odata;
@@ -326,20 +326,13 @@ bool HogArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
-	// Open hogfile
-	wxFile file(filename_);
-
-	// Check if opening the file failed
-	if (!file.IsOpened())
+	// Read the entry data from the file
+	if (!importEntryDataFromFile(entry, getEntryOffset(entry)))
 	{
 		log::error("HogArchive::loadEntryData: Failed to open hogfile {}", filename_);
 		return false;
 	}
 
-	// Seek to lump offset in file and read it in
-	file.Seek(getEntryOffset(entry), wxFromStart);
-	entry->importFileStream(file, entry->size());
-
 	// Set the lump to loaded
 	entry->setLoaded();
 
@@ -305,20 +305,13 @@ bool LfdArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
-	// Open lfdfile
-	wxFile file(filename_);
-
-	// Check if opening the file failed
-	if (!file.IsOpened())
+	// Read the entry data from the file
+	if (!importEntryDataFromFile(entry, getEntryOffset(entry)))
 	{
 		log::error("LfdArchive::loadEntryData: Failed to open lfdfile {}", filename_);
 		return false;
 	}
 
-	// Seek to lump offset in file and read it in
-	file.Seek(getEntryOffset(entry), wxFromStart);
-	entry->importFileStream(file, entry->size());
-
 	// Set the lump to loaded
 	entry->setLoaded();
 
@@ -33,9 +33,13 @@
 #include "WadArchive.h"
 #include "General/Misc.h"
 #include "General/UI.h"
+#include "Utility/FileUtils.h"
+#include "Utility/MappedFile.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
 #include "WadJArchive.h"
+#include <filesystem>
+#include <unordered_set>
 
 using namespace slade;
 
@@ -46,6 +50,8 @@ using namespace slade;
 //
 // -----------------------------------------------------------------------------
 CVAR(Bool, iwad_lock, true, CVar::Flag::Save)
+CVAR(Bool, wad_incremental_save, true, CVar::Flag::Save)
+CVAR(Int, wad_compact_threshold, 25, CVar::Flag::Save) // Max % of wasted space in a wad before a full rewrite
 
 namespace
 {
@@ -120,6 +126,22 @@ bool isNamespaceEntry(ArchiveEntry* entry)
 {
 	return strutil::endsWith(entry->upperName(), "_START") || strutil::endsWith(entry->upperName(), "_END");
 }
+
+// -----------------------------------------------------------------------------
+// Writes a wad directory entry for [entry] at [offset] to [file].
+// Returns false if it couldn't be fully written
+// -----------------------------------------------------------------------------
+bool writeDirEntry(wxFile& file, ArchiveEntry* entry, uint32_t offset)
+{
+	char     name[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	uint32_t size    = wxUINT32_SWAP_ON_BE(entry->size());
+	offset           = wxUINT32_SWAP_ON_BE(offset);
+
+	for (size_t c = 0; c < entry->name().length() && c < 8; c++)
+		name[c] = entry->name()[c];
+
+	return file.Write(&offset, 4) == 4 && file.Write(&size, 4) == 4 && file.Write(name, 8) == 8;
+}
 } // namespace
 
 
@@ -147,7 +169,7 @@ uint32_t WadArchive::getEntryOffset(ArchiveEntry* entry)
 	if (!checkEntry(entry))
 		return 0;
 
-	return (uint32_t)entry->exProp<int>("Offset");
+	return entry->fileOffset();
 }
 
 // -----------------------------------------------------------------------------
@@ -159,7 +181,7 @@ void WadArchive::setEntryOffset(ArchiveEntry* entry, uint32_t offset)
 	if (!checkEntry(entry))
 		return;
 
-	entry->exProp("Offset") = (int)offset;
+	entry->setFileOffset(offset);
 }
 
 // -----------------------------------------------------------------------------
@@ -352,7 +374,13 @@ bool WadArchive::open(MemChunk& mc)
 	// Stop announcements (don't want to be announcing modification due to entries being added etc)
 	ArchiveModSignalBlocker sig_blocker{ *this };
 
-	vector<uint32_t> offsets;
+	// Offsets of lumps read so far, to detect clones of previous lumps. The
+	// header lump count can't be trusted for reserving space if the directory
+	// goes past the end of the data
+	const auto                   max_lumps = std::min<uint32_t>(num_lumps, mc.size() / 16);
+	std::unordered_set<uint32_t> offsets;
+	offsets.reserve(max_lumps);
+	rootDir()->reserveEntries(max_lumps);
 
 	// Read the directory
 	mc.seek(dir_offset, SEEK_SET);
@@ -360,7 +388,8 @@ bool WadArchive::open(MemChunk& mc)
 	for (uint32_t d = 0; d < num_lumps; d++)
 	{
 		// Update splash window progress
-		ui::setSplashProgress(((float)d / (float)num_lumps));
+		if (d % 500 == 0)
+			ui::setSplashProgress(((float)d / (float)num_lumps));
 
 		// Read lump info
 		char     name[9] = "";
@@ -384,12 +413,11 @@ bool WadArchive::open(MemChunk& mc)
 				log::info(2, "No.");
 				continue;
 			}
-			if (VECTOR_EXISTS(offsets, offset))
+			if (!offsets.insert(offset).second)
 			{
 				log::warning("Ignoring entry {}: {}, is a clone of a previous entry", d, name);
 				continue;
 			}
-			offsets.push_back(offset);
 		}
 
 		// Hack to open Operation: Rheingold WAD files
@@ -447,13 +475,13 @@ bool WadArchive::open(MemChunk& mc)
 		// Create & setup lump
 		auto nlump = std::make_shared<ArchiveEntry>(name, size);
 		nlump->setLoaded(false);
-		nlump->exProp("Offset") = (int)offset;
+		nlump->setFileOffset(offset);
 		nlump->setState(ArchiveEntry::State::Unmodified);
 
 		if (jaguarencrypt)
 		{
 			nlump->setEncryption(ArchiveEntry::Encryption::Jaguar);
-			nlump->exProp("FullSize") = (int)size;
+			nlump->setFullSize(size);
 		}
 
 		// Add to entry list
@@ -465,7 +493,8 @@ bool WadArchive::open(MemChunk& mc)
 	updateNamespaces();
 
 	// Detect all entry types
-	MemChunk edata;
+	MemChunk             edata;
+	EntryTypeDetectBatch detect_batch(!archive_load_data);
 	ui::setSplashProgressMessage("Detecting entry types");
 	for (size_t a = 0; a < numEntries(); a++)
 	{
@@ -482,9 +511,8 @@ bool WadArchive::open(MemChunk& mc)
 			mc.exportMemChunk(edata, getEntryOffset(entry), entry->size());
 			if (entry->encryption() != ArchiveEntry::Encryption::None)
 			{
-				if (entry->exProps().contains("FullSize")
-					&& static_cast<unsigned>(entry->exProp<int>("FullSize")) > entry->size())
-					edata.reSize((entry->exProp<int>("FullSize")), true);
+				if (entry->fullSize() > entry->size())
+					edata.reSize(entry->fullSize(), true);
 				if (!WadJArchive::jaguarDecode(edata))
 					log::warning(
 						"{}: {} (following {}), did not decode properly",
@@ -495,16 +523,14 @@ bool WadArchive::open(MemChunk& mc)
 			entry->importMemChunk(edata);
 		}
 
-		// Detect entry type
-		EntryType::detectEntryType(*entry);
-
-		// Unload entry data if needed
-		if (!archive_load_data)
-			entry->unloadData();
-
-		// Set entry to unchanged
-		entry->setState(ArchiveEntry::State::Unmodified);
+		// Queue for type detection (types are detected in parallel batches)
+		detect_batch.add(entry);
 	}
+	detect_batch.detect();
+
+	// Set all entries to unchanged
+	for (size_t a = 0; a < numEntries(); a++)
+		entryAt(a)->setState(ArchiveEntry::State::Unmodified);
 
 	// Identify #included lumps (DECORATE, GLDEFS, etc.)
 	detectIncludes();
@@ -513,6 +539,11 @@ bool WadArchive::open(MemChunk& mc)
 	ui::setSplashProgressMessage("Detecting maps");
 	detectMaps();
 
+	// Remember the file layout for incremental saving
+	file_size_  = mc.size();
+	dir_offset_ = dir_offset;
+	dir_lumps_  = num_lumps;
+
 	// Setup variables
 	sig_blocker.unblock();
 	setModified(false);
@@ -590,10 +621,14 @@ bool WadArchive::write(MemChunk& mc, bool update)
 		if (update)
 		{
 			entry->setState(ArchiveEntry::State::Unmodified);
-			entry->exProp("Offset") = (int)offset;
+			entry->setFileOffset(offset);
 		}
 	}
 
+	// Lump offsets no longer match the file on disk
+	if (update)
+		file_size_ = 0;
+
 	return true;
 }
 
@@ -610,6 +645,23 @@ bool WadArchive::write(string_view filename, bool update)
 		return false;
 	}
 
+	// Only write modified lumps if possible
+	if (canWriteIncremental(filename))
+	{
+		if (writeIncremental(filename, update))
+			return true;
+
+		// The header wasn't updated so the file is still intact, rewrite it in
+		// full instead (replacing it, since lump data may still reference it)
+		log::warning("Incremental save of wad {} failed ({}), rewriting in full", filename, global::error);
+		return MappedFile::writeFile(filename, [this, update](const string& path) { return write(path, update); });
+	}
+
+	// Make sure all lump data is loaded before the file is opened (and
+	// truncated), since it may be the file the data is loaded from
+	for (uint32_t l = 0; l < numEntries(); l++)
+		entryAt(l)->rawData();
+
 	// Open file for writing
 	wxFile file;
 	file.Open(wxString{ filename.data(), filename.size() }, wxFile::write);
@@ -620,13 +672,12 @@ bool WadArchive::write(string_view filename, bool update)
 	}
 
 	// Determine directory offset & individual lump offsets
-	uint32_t      dir_offset = 12;
-	ArchiveEntry* entry;
+	uint32_t         dir_offset = 12;
+	vector<uint32_t> offsets(numEntries());
 	for (uint32_t l = 0; l < numEntries(); l++)
 	{
-		entry = entryAt(l);
-		setEntryOffset(entry, dir_offset);
-		dir_offset += entry->size();
+		offsets[l] = dir_offset;
+		dir_offset += entryAt(l)->size();
 	}
 
 	// Setup wad type
@@ -641,6 +692,7 @@ bool WadArchive::write(string_view filename, bool update)
 	file.Write(&dir_offset, 4);
 
 	// Write the lumps
+	ArchiveEntry* entry;
 	for (uint32_t l = 0; l < num_lumps; l++)
 	{
 		entry = entryAt(l);
@@ -653,30 +705,232 @@ bool WadArchive::write(string_view filename, bool update)
 	// Write the directory
 	for (uint32_t l = 0; l < num_lumps; l++)
 	{
-		entry        = entryAt(l);
-		char name[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-		long offset  = getEntryOffset(entry);
-		long size    = entry->size();
-
-		for (size_t c = 0; c < entry->name().length() && c < 8; c++)
-			name[c] = entry->name()[c];
-
-		file.Write(&offset, 4);
-		file.Write(&size, 4);
-		file.Write(name, 8);
+		entry = entryAt(l);
+		writeDirEntry(file, entry, offsets[l]);
 
 		if (update)
 		{
 			entry->setState(ArchiveEntry::State::Unmodified);
-			entry->exProp("Offset") = (int)offset;
+			setEntryOffset(entry, offsets[l]);
 		}
 	}
 
 	file.Close();
 
+	// Remember the new file layout
+	file_size_  = update ? dir_offset + num_lumps * 16 : 0;
+	dir_offset_ = dir_offset;
+	dir_lumps_  = num_lumps;
+
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Compacts the wad file on disk, rewriting it in full to remove any unused
+// space left over from incremental saves.
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::compact()
+{
+	force_full_write_ = true;
+	const bool success = save();
+	force_full_write_ = false;
+
+	return success;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of bytes in the wad file on disk that aren't used by the
+// header, directory or (unmodified) lump data
+// -----------------------------------------------------------------------------
+unsigned WadArchive::wastedSpace()
+{
+	if (file_size_ == 0)
+		return 0;
+
+	uint64_t used = 12 + static_cast<uint64_t>(dir_lumps_) * 16;
+	for (uint32_t l = 0; l < numEntries(); l++)
+	{
+		auto entry = entryAt(l);
+		if (entry->state() == ArchiveEntry::State::Unmodified)
+			used += entry->size();
+	}
+
+	return used < file_size_ ? static_cast<unsigned>(file_size_ - used) : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the wad can be saved to [filename] incrementally, by
+// appending any modified or new lumps to the existing file and rewriting the
+// directory, leaving unmodified lump data where it is
+// -----------------------------------------------------------------------------
+bool WadArchive::canWriteIncremental(string_view filename)
+{
+	if (!wad_incremental_save || force_full_write_ || !on_disk_ || file_size_ == 0 || parent_.lock())
+		return false;
+
+	// Only plain wads (eg. not Jaguar wads), and only when overwriting the file
+	// the archive was opened from
+	std::error_code ec;
+	if (format_ != "wad" || !std::filesystem::equivalent(filename_, std::filesystem::path{ filename }, ec))
+		return false;
+
+	// Check the file hasn't been changed by anything else since it was read
+	if (std::filesystem::file_size(filename_, ec) != file_size_ || ec
+		|| fileutil::fileModifiedTime(filename_) != file_modified_)
+		return false;
+
+	// Check how much space would be wasted after appending the modified lumps
+	const auto num_lumps  = numEntries();
+	uint64_t   data_size  = 0;
+	uint64_t   append_end = file_size_;
+	for (uint32_t l = 0; l < num_lumps; l++)
+	{
+		auto entry = entryAt(l);
+		if (entry->encryption() != ArchiveEntry::Encryption::None)
+			return false;
+
+		data_size += entry->size();
+		if (entry->state() != ArchiveEntry::State::Unmodified)
+			append_end += entry->size();
+	}
+	const auto new_size = append_end + static_cast<uint64_t>(num_lumps) * 16;
+	const auto wasted   = new_size - (12 + data_size + static_cast<uint64_t>(num_lumps) * 16);
+	if (new_size > 0xFFFFFFFF || wasted * 100 > new_size * std::max<int>(wad_compact_threshold, 0))
+	{
+		log::info(2, "Wad {} has too much unused space, rewriting in full", filename_);
+		return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Saves the wad to [filename] incrementally - modified or new lumps are
+// appended to the end of the existing file, followed by the updated directory.
+// Unmodified lumps keep their existing offset in the file. The header is only
+// updated once everything else has been written, so the file remains valid
+// (with the old directory) if writing fails part way.
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::writeIncremental(string_view filename, bool update)
+{
+	// Determine lump offsets
+	const auto            num_lumps = numEntries();
+	vector<uint32_t>      offsets(num_lumps);
+	vector<ArchiveEntry*> appended;
+	uint32_t              dir_offset = file_size_;
+	for (uint32_t l = 0; l < num_lumps; l++)
+	{
+		auto entry = entryAt(l);
+		if (entry->state() == ArchiveEntry::State::Unmodified)
+		{
+			offsets[l] = getEntryOffset(entry);
+			continue;
+		}
+
+		// Modified or new, make sure the data is loaded before writing anything
+		offsets[l] = dir_offset;
+		dir_offset += entry->size();
+		if (entry->size() > 0)
+		{
+			entry->rawData();
+			appended.push_back(entry);
+		}
+	}
+
+	// Open the existing file for writing
+	wxFile file;
+	file.Open(wxString{ filename.data(), filename.size() }, wxFile::read_write);
+	if (!file.IsOpened())
+	{
+		global::error = "Unable to open file for writing";
+		return false;
+	}
+
+	// Write the modified lumps
+	if (file.Seek(file_size_, wxFromStart) != file_size_)
+	{
+		global::error = "Unable to seek to end of file";
+		return false;
+	}
+	for (auto entry : appended)
+		if (file.Write(entry->rawData(), entry->size()) != entry->size())
+		{
+			global::error = "Unable to write lump data";
+			return false;
+		}
+
+	// Write the directory
+	for (uint32_t l = 0; l < num_lumps; l++)
+		if (!writeDirEntry(file, entryAt(l), offsets[l]))
+		{
+			global::error = "Unable to write directory";
+			return false;
+		}
+
+	// Make sure the lumps and directory are on disk before the header points to them
+	if (!file.Flush())
+	{
+		global::error = "Unable to flush file";
+		return false;
+	}
+
+	// Update the header
+	char wad_type[4] = { 'P', 'W', 'A', 'D' };
+	if (iwad_)
+		wad_type[0] = 'I';
+	const uint32_t header_lumps  = wxUINT32_SWAP_ON_BE(num_lumps);
+	const uint32_t header_offset = wxUINT32_SWAP_ON_BE(dir_offset);
+	if (file.Seek(0, wxFromStart) != 0 || file.Write(wad_type, 4) != 4 || file.Write(&header_lumps, 4) != 4
+		|| file.Write(&header_offset, 4) != 4)
+	{
+		global::error = "Unable to write header";
+		return false;
+	}
+	file.Close();
+
+	// Only the header and data past the end of the old file have changed, so
+	// any lump data viewing the memory mapped file is still valid
+	MappedFile::fileUpdated(filename);
+
+	log::info(2, "Saved wad {} incrementally ({} of {} lumps written)", filename, appended.size(), num_lumps);
+
+	if (!update)
+	{
+		// Lump offsets/states no longer match the file on disk
+		file_size_ = 0;
+		return true;
+	}
+
+	for (uint32_t l = 0; l < num_lumps; l++)
+	{
+		auto entry = entryAt(l);
+		entry->setState(ArchiveEntry::State::Unmodified);
+		setEntryOffset(entry, offsets[l]);
+	}
+
+	file_size_  = dir_offset + num_lumps * 16;
+	dir_offset_ = dir_offset;
+	dir_lumps_  = num_lumps;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if writing to [filename] will be an incremental save, which
+// leaves the existing lump data in the file as-is
+// -----------------------------------------------------------------------------
+bool WadArchive::writeKeepsFileData(string_view filename)
+{
+#ifdef _WIN32
+	// Memory mapped files can't be written to at all on windows
+	return false;
+#else
+	return canWriteIncremental(filename);
+#endif
+}
+
 // -----------------------------------------------------------------------------
 // Loads an entry's data from the wadfile
 // Returns true if successful, false otherwise
@@ -695,20 +949,13 @@ bool WadArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
-	// Open wadfile
-	wxFile file(filename_);
-
-	// Check if opening the file failed
-	if (!file.IsOpened())
+	// Read the entry data from the file
+	if (!importEntryDataFromFile(entry, getEntryOffset(entry)))
 	{
 		log::error("WadArchive::loadEntryData: Failed to open wadfile {}", filename_);
 		return false;
 	}
 
-	// Seek to lump offset in file and read it in
-	file.Seek(getEntryOffset(entry), wxFromStart);
-	entry->importFileStream(file, entry->size());
-
 	// Set the lump to loaded
 	entry->setLoaded();
 	entry->setState(ArchiveEntry::State::Unmodified);
@@ -1561,3 +1808,85 @@ bool WadArchive::isWadArchive(const string& filename)
 	// If it's passed to here it's probably a wad file
 	return true;
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+#include "General/Console.h"
+#include "MainEditor/MainEditor.h"
+
+CONSOLE_COMMAND(wad_compact, 0, true)
+{
+	auto wad = dynamic_cast<WadArchive*>(maineditor::currentArchive());
+	if (!wad)
+	{
+		log::console("Current archive is not a wad");
+		return;
+	}
+
+	const auto wasted = wad->wastedSpace();
+	if (wad->compact())
+		log::console(fmt::format("Compacted {}, {} bytes reclaimed", wad->filename(), wasted));
+	else
+		log::console(fmt::format("Unable to compact {}: {}", wad->filename(), global::error));
+}
+
+CONSOLE_COMMAND(benchmark_wad_open, 0, true)
+{
+	const auto num_lumps  = args.empty() ? 100000 : std::max(strutil::asInt(args[0]), 1);
+	const auto iterations = args.size() < 2 ? 3 : std::max(strutil::asInt(args[1]), 1);
+
+	// Build a synthetic wad with [num_lumps] small lumps (every 10th being an
+	// empty marker), followed by the directory
+	const uint32_t  lump_size  = 16;
+	const uint32_t  dir_offset = 12 + num_lumps * lump_size;
+	vector<uint8_t> wad_data(dir_offset + num_lumps * 16, 0);
+	memcpy(wad_data.data(), "PWAD", 4);
+	const auto write_l32 = [&wad_data](size_t pos, uint32_t val)
+	{
+		for (int b = 0; b < 4; ++b)
+			wad_data[pos + b] = (val >> (b * 8)) & 0xFF;
+	};
+	write_l32(4, num_lumps);
+	write_l32(8, dir_offset);
+	for (int a = 0; a < num_lumps; ++a)
+	{
+		const uint32_t offset = 12 + a * lump_size;
+		const uint32_t size   = a % 10 == 0 ? 0 : lump_size;
+		write_l32(offset, a);
+
+		const auto dir_pos = dir_offset + a * 16;
+		const auto name    = fmt::format("L{:07d}", a);
+		write_l32(dir_pos, size > 0 ? offset : 0);
+		write_l32(dir_pos + 4, size);
+		memcpy(wad_data.data() + dir_pos + 8, name.data(), 8);
+	}
+	MemChunk mc(wad_data.data(), static_cast<uint32_t>(wad_data.size()));
+
+	// Open it
+	wxStopWatch sw;
+	long        total_ms = 0;
+	unsigned    entries  = 0;
+	for (int i = 0; i < iterations; ++i)
+	{
+		WadArchive wad;
+		sw.Start();
+		if (!wad.open(mc))
+		{
+			log::console(fmt::format("Unable to open synthetic wad: {}", global::error));
+			return;
+		}
+		total_ms += sw.Time();
+		entries = wad.numEntries();
+	}
+
+	log::console(fmt::format(
+		"Opened synthetic wad with {} lumps ({} entries) in {}ms average over {} iterations",
+		num_lumps,
+		entries,
+		total_ms / iterations,
+		iterations));
+}
@@ -21,8 +21,10 @@ public:
 	bool open(MemChunk& mc) override;
 
 	// Writing/Saving
-	bool write(MemChunk& mc, bool update = true) override;         // Write to MemChunk
-	bool write(string_view filename, bool update = true) override; // Write to File
+	bool     write(MemChunk& mc, bool update = true) override;         // Write to MemChunk
+	bool     write(string_view filename, bool update = true) override; // Write to File
+	bool     compact();
+	unsigned wastedSpace();
 
 	// Misc
 	bool loadEntryData(ArchiveEntry* entry) override;
@@ -90,5 +92,17 @@ private:
 
 	bool           iwad_ = false;
 	vector<NSPair> namespaces_;
+
+	// Layout of the wad file on disk, used for incremental saving
+	uint32_t file_size_        = 0;  // Size of the file (0 if unknown)
+	uint32_t dir_offset_       = 0;  // Offset of the directory
+	uint32_t dir_lumps_        = 0;  // Number of lumps in the directory
+	bool     force_full_write_ = false;
+
+	bool canWriteIncremental(string_view filename);
+	bool writeIncremental(string_view filename, bool update);
+
+protected:
+	bool writeKeepsFileData(string_view filename) override;
 };
 } // namespace slade
@@ -164,13 +164,13 @@ bool WadJArchive::open(MemChunk& mc)
 		// Create & setup lump
 		auto nlump = std::make_shared<ArchiveEntry>(name, actualsize);
 		nlump->setLoaded(false);
-		nlump->exProp("Offset") = (int)offset;
+		nlump->setFileOffset(offset);
 		nlump->setState(ArchiveEntry::State::Unmodified);
 
 		if (jaguarencrypt)
 		{
 			nlump->setEncryption(ArchiveEntry::Encryption::Jaguar);
-			nlump->exProp("FullSize") = (int)size;
+			nlump->setFullSize(size);
 		}
 
 		// Add to entry list
@@ -200,9 +200,8 @@ bool WadJArchive::open(MemChunk& mc)
 			mc.exportMemChunk(edata, getEntryOffset(entry), entry->size());
 			if (entry->encryption() != ArchiveEntry::Encryption::None)
 			{
-				if (entry->exProps().contains("FullSize")
-					&& (unsigned)(entry->exProp<int>("FullSize")) > entry->size())
-					edata.reSize((entry->exProp<int>("FullSize")), true);
+				if (entry->fullSize() > entry->size())
+					edata.reSize(entry->fullSize(), true);
 				if (!jaguarDecode(edata))
 					log::warning(
 						"{}: {} (following {}), did not decode properly",
@@ -299,7 +298,7 @@ bool WadJArchive::write(MemChunk& mc, bool update)
 		if (update)
 		{
 			entry->setState(ArchiveEntry::State::Unmodified);
-			entry->exProp("Offset") = (int)wxINT32_SWAP_ON_LE(offset);
+			entry->setFileOffset(wxINT32_SWAP_ON_LE(offset));
 		}
 	}
 
@@ -415,7 +414,7 @@ bool WadJArchive::jaguarDecode(MemChunk& mc)
 
 	// Get data
 	size_t         isize  = mc.size();
-	const uint8_t* istart = mc.data();
+	const uint8_t* istart = std::as_const(mc).data();
 	const uint8_t* input  = istart;
 	const uint8_t* iend   = input + isize;
 
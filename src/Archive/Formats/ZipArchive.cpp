@@ -35,10 +35,14 @@
 #include "General/Misc.h"
 #include "General/UI.h"
 #include "UI/WxUtils.h"
+#include "Utility/Compression.h"
 #include "Utility/FileUtils.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 #include "WadArchive.h"
+#include <ctime>
 #include <fstream>
+#include <wx/mstream.h>
 
 using namespace slade;
 
@@ -49,6 +53,231 @@ using namespace slade;
 //
 // -----------------------------------------------------------------------------
 CVAR(Bool, zip_allow_duplicate_names, false, CVar::Save)
+CVAR(Bool, zip_lazy_open, true, CVar::Save)
+CVAR(Int, zip_compression_level, 9, CVar::Save)
+
+namespace
+{
+// Zip format record signatures and sizes
+constexpr uint32_t ZIP_SIG_LOCAL_HEADER    = 0x04034b50;
+constexpr uint32_t ZIP_SIG_CENTRAL_DIR     = 0x02014b50;
+constexpr uint32_t ZIP_SIG_END_OF_CENTRAL  = 0x06054b50;
+constexpr uint32_t ZIP_LOCAL_HEADER_SIZE   = 30;
+constexpr uint32_t ZIP_CENTRAL_DIR_SIZE    = 46;
+constexpr uint32_t ZIP_END_OF_CENTRAL_SIZE = 22;
+constexpr uint32_t ZIP_MAX_COMMENT_SIZE    = 0xFFFF;
+constexpr uint16_t ZIP_METHOD_STORE        = 0;
+constexpr uint16_t ZIP_METHOD_DEFLATE      = 8;
+constexpr uint16_t ZIP_FLAG_ENCRYPTED      = 0x0001;
+constexpr uint16_t ZIP_FLAG_DEFLATE_OPTS   = 0x0006;
+constexpr uint16_t ZIP_FLAG_UTF8           = 0x0800;
+
+// Amount of data to read from the start of each entry for type detection when
+// opening a zip lazily. All of an entry's data is only read if detecting one of
+// its possible types needs more than this (see EntryType::detectEntryTypes)
+constexpr uint32_t ZIP_LAZY_DETECT_SIZE = 16 * 1024;
+
+// Max amount of uncompressed entry data to compress at once when writing
+constexpr size_t ZIP_WRITE_BATCH_SIZE = 64 * 1024 * 1024;
+
+// Info for writing an entry to a zip
+struct ZipWriteJob
+{
+	const MemChunk* data       = nullptr; // Entry data to compress, or null if not needed
+	int             copy_index = -1;      // Index in the old zip to copy compressed data from, or -1
+	int             level      = 9;
+	MemChunk        compressed;
+	bool            is_dir = false;
+	bool            failed = false;
+};
+
+// SeekableData interface to a wxFile, so zip data can be read from and written
+// to files and MemChunks the same way
+class WxFileData : public SeekableData
+{
+public:
+	WxFileData(wxFile& file) : file_{ file } {}
+
+	unsigned currentPos() const override { return static_cast<unsigned>(file_.Tell()); }
+	unsigned size() const override { return static_cast<unsigned>(file_.Length()); }
+
+	bool seek(unsigned offset) override { return file_.Seek(offset, wxFromCurrent) != wxInvalidOffset; }
+	bool seekFromStart(unsigned offset) override { return file_.Seek(offset, wxFromStart) != wxInvalidOffset; }
+	bool seekFromEnd(unsigned offset) override
+	{
+		return file_.Seek(-static_cast<wxFileOffset>(offset), wxFromEnd) != wxInvalidOffset;
+	}
+
+	bool read(void* buffer, unsigned count) override
+	{
+		return file_.Read(buffer, count) == static_cast<ssize_t>(count);
+	}
+	bool write(const void* buffer, unsigned count) override { return file_.Write(buffer, count) == count; }
+
+private:
+	wxFile& file_;
+};
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Writes little-endian values to [p]
+// -----------------------------------------------------------------------------
+void writeL16(uint8_t* p, uint16_t val)
+{
+	p[0] = val & 0xFF;
+	p[1] = val >> 8;
+}
+void writeL32(uint8_t* p, uint32_t val)
+{
+	writeL16(p, val & 0xFFFF);
+	writeL16(p + 2, val >> 16);
+}
+
+// -----------------------------------------------------------------------------
+// Returns [time] as an MS-DOS format (time, date) pair, as used in zip files
+// -----------------------------------------------------------------------------
+std::pair<uint16_t, uint16_t> dosDateTime(time_t time)
+{
+	const auto* tm = std::localtime(&time);
+	if (!tm || tm->tm_year < 80)
+		return { 0, (1 << 5) | 1 }; // 1980-01-01 00:00
+
+	return { static_cast<uint16_t>((tm->tm_hour << 11) | (tm->tm_min << 5) | (tm->tm_sec / 2)),
+			 static_cast<uint16_t>(((tm->tm_year - 80) << 9) | ((tm->tm_mon + 1) << 5) | tm->tm_mday) };
+}
+
+// -----------------------------------------------------------------------------
+// Strips any leading slash from [record]'s name and sets its UTF-8 flag if the
+// name isn't plain ASCII
+// -----------------------------------------------------------------------------
+void setZipEntryName(ZipArchive::CentralDirEntry& record)
+{
+	if (!record.name.empty() && record.name[0] == '/')
+		record.name.erase(0, 1);
+
+	for (auto c : record.name)
+		if (static_cast<uint8_t>(c) >= 0x80)
+		{
+			record.flags |= ZIP_FLAG_UTF8;
+			break;
+		}
+}
+
+// -----------------------------------------------------------------------------
+// Reads [size] bytes from the current position in [data] into [mc].
+// Returns false if there isn't enough data to read
+// -----------------------------------------------------------------------------
+bool readData(SeekableData& data, MemChunk& mc, uint32_t size)
+{
+	if (size == 0)
+	{
+		mc.clear();
+		return true;
+	}
+
+	return mc.reSize(size, false) && data.read(mc.data(), size);
+}
+
+// -----------------------------------------------------------------------------
+// Reads the local file header at [local_offset] in zip [data] and seeks to the
+// start of the entry data following it.
+// Returns false if the header is invalid or couldn't be read
+// -----------------------------------------------------------------------------
+bool seekToEntryData(SeekableData& data, uint32_t local_offset)
+{
+	// The name and extra field lengths in the local header can differ from the
+	// central directory, so it has to be read to find the data
+	MemChunk header;
+	if (local_offset + ZIP_LOCAL_HEADER_SIZE > data.size() || !data.seekFromStart(local_offset)
+		|| !readData(data, header, ZIP_LOCAL_HEADER_SIZE) || header.readL32(0) != ZIP_SIG_LOCAL_HEADER)
+		return false;
+
+	const auto data_offset = local_offset + ZIP_LOCAL_HEADER_SIZE + header.readL16(26) + header.readL16(28);
+	return data_offset <= data.size() && data.seekFromStart(data_offset);
+}
+
+// -----------------------------------------------------------------------------
+// Writes [record] to zip data [out], as a central directory record if
+// [central] is true or a local file header otherwise.
+// Returns false if writing failed
+// -----------------------------------------------------------------------------
+bool writeZipRecord(SeekableData& out, const ZipArchive::CentralDirEntry& record, bool central)
+{
+	const bool is_dir = !record.name.empty() && record.name.back() == '/';
+
+	uint8_t header[ZIP_CENTRAL_DIR_SIZE] = {};
+	auto    p                            = header;
+	writeL32(p, central ? ZIP_SIG_CENTRAL_DIR : ZIP_SIG_LOCAL_HEADER);
+	p += 4;
+	if (central)
+	{
+		writeL16(p, 20); // Version made by
+		p += 2;
+	}
+	writeL16(p, 20); // Version needed
+	writeL16(p + 2, record.flags);
+	writeL16(p + 4, record.method);
+	writeL16(p + 6, record.mod_time);
+	writeL16(p + 8, record.mod_date);
+	writeL32(p + 10, record.crc);
+	writeL32(p + 14, record.compressed_size);
+	writeL32(p + 18, record.size);
+	writeL16(p + 22, static_cast<uint16_t>(record.name.size()));
+	if (central)
+	{
+		writeL32(p + 32, is_dir ? 0x10 : 0); // External attributes (MS-DOS directory flag)
+		writeL32(p + 36, record.local_offset);
+	}
+
+	const auto header_size = central ? ZIP_CENTRAL_DIR_SIZE : ZIP_LOCAL_HEADER_SIZE;
+	return out.write(header, header_size)
+		   && out.write(record.name.data(), static_cast<unsigned>(record.name.size()));
+}
+
+// -----------------------------------------------------------------------------
+// Compresses the entry data for [job] and updates [record] with the resulting
+// compression info. Entries are stored uncompressed if compression level 0 is
+// used or compressing doesn't make the data any smaller.
+// Only accesses [job] and [record], so can be called for different entries on
+// multiple threads at once
+// -----------------------------------------------------------------------------
+void compressEntryData(ZipWriteJob& job, ZipArchive::CentralDirEntry& record)
+{
+	const auto size = job.data->size();
+	record.size     = size;
+	record.crc      = size > 0 ? misc::crc(job.data->data(), size) : 0;
+
+	if (size > 0 && job.level > 0)
+	{
+		if (!compression::zipDeflate(job.data->data(), size, job.compressed, job.level))
+		{
+			job.failed = true;
+			return;
+		}
+
+		if (job.compressed.size() < size)
+		{
+			record.method          = ZIP_METHOD_DEFLATE;
+			record.compressed_size = job.compressed.size();
+			return;
+		}
+
+		job.compressed.clear();
+	}
+
+	// Store
+	record.method          = ZIP_METHOD_STORE;
+	record.compressed_size = size;
+}
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -89,6 +318,18 @@ ZipArchive::~ZipArchive()
 // Returns true if successful, false otherwise
 // -----------------------------------------------------------------------------
 bool ZipArchive::open(string_view filename)
+{
+	// Only open lazily if entry data isn't wanted in memory anyway
+	return openFile(filename, zip_lazy_open && !archive_load_data);
+}
+
+// -----------------------------------------------------------------------------
+// Reads zip data from the file at [filename].
+// If [lazy] is true, only the zip central directory is read, and entry data is
+// loaded later as needed (see openLazy)
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::openFile(string_view filename, bool lazy)
 {
 	// Check the file exists
 	if (!fileutil::fileExists(filename))
@@ -97,18 +338,57 @@ bool ZipArchive::open(string_view filename)
 		return false;
 	}
 
-	// Copy the zip to a temp file (for use when saving)
-	generateTempFileName(filename);
-	fileutil::copyFile(filename, temp_file_);
+	// Entry data is read from the file rather than memory
+	zip_data_.clear();
 
-	// Open the file
-	wxFFileInputStream in(wxutil::strFromView(filename));
-	if (!in.IsOk())
+	// Open lazily if possible (needs a readable central directory)
+	if (lazy && readCentralDirectory(filename))
 	{
-		global::error = "Unable to open file";
-		return false;
+		// Entry data is read from the file from here on
+		filename_ = filename;
+		if (!openLazy())
+			return false;
+	}
+	else
+	{
+		// Copy the zip to a temp file (for use when saving)
+		generateTempFileName(filename);
+		fileutil::copyFile(filename, temp_file_);
+
+		// Open the file
+		wxFFileInputStream in(wxutil::strFromView(filename));
+		if (!in.IsOk())
+		{
+			global::error = "Unable to open file";
+			return false;
+		}
+
+		unsigned n_zip_entries = 0;
+		if (!openStream(in, n_zip_entries))
+			return false;
+
+		// Read the central directory for random access to entry data later
+		if (!readCentralDirectory(filename) || central_dir_.size() != n_zip_entries)
+			central_dir_.clear();
 	}
 
+	// Setup variables
+	filename_      = filename;
+	file_modified_ = fileutil::fileModifiedTime(filename);
+	setModified(false);
+	on_disk_ = true;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads all entries and their data from the zip data in stream [in].
+// [n_zip_entries] is set to the number of entries read from the zip,
+// including directories
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::openStream(wxInputStream& in, unsigned& n_zip_entries)
+{
 	// Create zip stream
 	wxZipInputStream zip(in);
 	if (!zip.IsOk())
@@ -121,8 +401,9 @@ bool ZipArchive::open(string_view filename)
 	const ArchiveModSignalBlocker sig_blocker{ *this };
 
 	// Go through all zip entries
-	int  entry_index = 0;
-	auto zip_entry   = zip.GetNextEntry();
+	int                  entry_index = 0;
+	auto                 zip_entry   = zip.GetNextEntry();
+	EntryTypeDetectBatch detect_batch(!archive_load_data);
 	ui::setSplashProgressMessage("Reading zip data");
 	while (zip_entry)
 	{
@@ -160,12 +441,8 @@ bool ZipArchive::open(string_view filename)
 				}
 				new_entry->setLoaded(true);
 
-				// Determine its type
-				EntryType::detectEntryType(*new_entry);
-
-				// Unload data if needed
-				if (!archive_load_data)
-					new_entry->unloadData();
+				// Queue for type detection (types are detected in parallel batches)
+				detect_batch.add(new_entry.get());
 			}
 			else
 			{
@@ -185,7 +462,9 @@ bool ZipArchive::open(string_view filename)
 		zip_entry = zip.GetNextEntry();
 		entry_index++;
 	}
+	detect_batch.detect();
 	ui::updateSplash();
+	n_zip_entries = entry_index;
 
 	// Set all entries/directories to unmodified
 	vector<ArchiveEntry*> entry_list;
@@ -196,11 +475,100 @@ bool ZipArchive::open(string_view filename)
 	// Enable announcements
 	sig_blocker.unblock();
 
-	// Setup variables
-	filename_      = filename;
-	file_modified_ = fileutil::fileModifiedTime(filename);
-	setModified(false);
-	on_disk_ = true;
+	ui::setSplashProgressMessage("");
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Opens the zip using only its central directory (which must already be read),
+// without loading any entry data.
+// Entry types are detected from the entry names and only the start of each
+// entry's data, read via the central directory index. All of an entry's data
+// is only read for detection if a possible type needs it, and isn't kept. Entry
+// data is loaded from the zip data in memory, or the file at filename_ if there
+// is none, as it is needed (see loadEntryData)
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::openLazy()
+{
+	// Check all compression methods are supported
+	for (const auto& cd_entry : central_dir_)
+		if (cd_entry.method != ZIP_METHOD_DEFLATE && cd_entry.method != ZIP_METHOD_STORE)
+		{
+			global::error = "Unsupported zip compression method";
+			return false;
+		}
+
+	// Stop announcements (don't want to be announcing modification due to entries being added etc)
+	const ArchiveModSignalBlocker sig_blocker{ *this };
+
+	// Go through all zip entries
+	vector<ArchiveEntry*> entries;
+	vector<unsigned>      zip_indices;
+	const auto            n_entries = central_dir_.size();
+	ui::setSplashProgressMessage("Reading zip directory");
+	for (unsigned index = 0; index < n_entries; ++index)
+	{
+		if (index % 500 == 0)
+			ui::setSplashProgress(static_cast<float>(index) / static_cast<float>(n_entries));
+
+		auto&         cd_entry = central_dir_[index];
+		strutil::Path fn(cd_entry.name);
+
+		// Zip entry is a directory, add it to the directory tree
+		if (!cd_entry.name.empty() && cd_entry.name.back() == '/')
+		{
+			createDir(fn.path(true));
+			continue;
+		}
+
+		if (cd_entry.size >= static_cast<uint32_t>(max_entry_size_mb) * 1024 * 1024)
+		{
+			global::error = fmt::format("Entry too large: {} is {} mb", fn.fullPath(), cd_entry.size / (1 << 20));
+			return false;
+		}
+
+		// Create entry (unloaded)
+		auto new_entry = std::make_shared<ArchiveEntry>(misc::fileNameToLumpName(fn.fileName()), cd_entry.size);
+		new_entry->setLoaded(false);
+		new_entry->exProp("ZipIndex") = static_cast<int>(index);
+
+		// Add entry and directory to directory tree
+		auto ndir = createDir(fn.path(true));
+		ndir->addEntry(new_entry, true);
+
+		entries.push_back(new_entry.get());
+		zip_indices.push_back(index);
+	}
+
+	// Detect entry types (in parallel) from the start of their data where possible
+	ui::setSplashProgressMessage("Detecting entry types");
+	vector<uint8_t> read_failed(entries.size(), 0);
+	EntryType::detectEntryTypes(
+		entries,
+		[this, &zip_indices, &read_failed](size_t index, MemChunk& mc, unsigned size)
+		{
+			if (readEntryData(central_dir_[zip_indices[index]], mc, size))
+				return true;
+
+			read_failed[index] = 1;
+			return false;
+		},
+		ZIP_LAZY_DETECT_SIZE);
+	for (unsigned a = 0; a < entries.size(); ++a)
+		if (read_failed[a])
+			log::warning("Unable to read data for zip entry {}", central_dir_[zip_indices[a]].name);
+	ui::updateSplash();
+
+	// Set all entries/directories to unmodified
+	vector<ArchiveEntry*> entry_list;
+	putEntryTreeAsList(entry_list);
+	for (auto& entry : entry_list)
+		entry->setState(ArchiveEntry::State::Unmodified);
+
+	// Enable announcements
+	sig_blocker.unblock();
 
 	ui::setSplashProgressMessage("");
 
@@ -213,17 +581,36 @@ bool ZipArchive::open(string_view filename)
 // -----------------------------------------------------------------------------
 bool ZipArchive::open(MemChunk& mc)
 {
-	// Write the MemChunk to a temp file
-	const auto tempfile = app::path("slade-temp-open.zip", app::Dir::Temp);
-	mc.exportFile(tempfile);
+	// Keep the zip data to load entry data from and to copy unmodified entries
+	// from when saving. If [mc] is viewing a memory mapped file the view is
+	// shared rather than the data copied
+	if (!zip_data_.importMem(mc))
+	{
+		global::error = "Invalid zip file";
+		return false;
+	}
 
-	// Load the file
-	const bool success = open(tempfile);
+	// Open lazily if possible (needs a readable central directory)
+	if (zip_lazy_open && !archive_load_data && readCentralDirectory(zip_data_))
+	{
+		if (!openLazy())
+			return false;
+	}
+	else
+	{
+		wxMemoryInputStream in(std::as_const(zip_data_).data(), zip_data_.size());
+		unsigned            n_zip_entries = 0;
+		if (!openStream(in, n_zip_entries))
+			return false;
 
-	// Clean up
-	fileutil::removeFile(tempfile);
+		// Read the central directory for random access to entry data later
+		if (!readCentralDirectory(zip_data_) || central_dir_.size() != n_zip_entries)
+			central_dir_.clear();
+	}
+
+	setModified(false);
 
-	return success;
+	return true;
 }
 
 // -----------------------------------------------------------------------------
@@ -232,27 +619,49 @@ bool ZipArchive::open(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool ZipArchive::write(MemChunk& mc, bool update)
 {
-	bool success = false;
+	return writeZip({}, &mc, update);
+}
 
-	// Write to a temporary file
-	const auto tempfile = app::path("slade-temp-write.zip", app::Dir::Temp);
-	if (write(tempfile, true))
-	{
-		// Load file into MemChunk
-		success = mc.importFile(tempfile);
-	}
+// -----------------------------------------------------------------------------
+// Writes the zip archive to a file
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::write(string_view filename, bool update)
+{
+	return writeZip(filename, nullptr, update);
+}
 
-	// Clean up
-	wxRemoveFile(tempfile);
+// -----------------------------------------------------------------------------
+// Returns the index in the central directory of the zip [entry] was last
+// opened from or written to, if its compressed data can be copied from there
+// when saving, or -1 if it needs (re)compressing
+// -----------------------------------------------------------------------------
+int ZipArchive::copyableIndex(ArchiveEntry* entry) const
+{
+	if (entry->state() != ArchiveEntry::State::Unmodified || !entry->exProps().contains("ZipIndex"))
+		return -1;
+
+	const int index = entry->exProp<int>("ZipIndex");
+	if (index < 0 || index >= static_cast<int>(central_dir_.size()))
+		return -1;
 
-	return success;
+	const auto& cd_entry = central_dir_[index];
+	if (cd_entry.size != entry->size() || cd_entry.flags & ZIP_FLAG_ENCRYPTED
+		|| (cd_entry.method != ZIP_METHOD_STORE && cd_entry.method != ZIP_METHOD_DEFLATE))
+		return -1;
+
+	return index;
 }
 
 // -----------------------------------------------------------------------------
-// Writes the zip archive to a file
+// Writes the zip archive to [mc] if it is given, or otherwise to the file at
+// [filename]. Compressed data for unmodified entries is copied from the zip
+// data the archive was opened from (or last written to), which is kept in
+// memory for zips opened from a MemChunk or in a temp file otherwise.
+// If [update] is true, entries are updated to refer to the written zip
 // Returns true if successful, false otherwise
 // -----------------------------------------------------------------------------
-bool ZipArchive::write(string_view filename, bool update)
+bool ZipArchive::writeZip(string_view filename, MemChunk* mc, bool update)
 {
 	// Check for entries with duplicate names (not allowed for zips)
 	auto all_dirs = rootDir()->allDirectories();
@@ -266,33 +675,343 @@ bool ZipArchive::write(string_view filename, bool update)
 		}
 	}
 
-	// Open the file
-	wxFFileOutputStream out(wxutil::strFromView(filename));
-	if (!out.IsOk())
+	// Close the zip file if it was open for loading entry data, it may be
+	// about to be overwritten
+	{
+		std::lock_guard lock(zip_file_mutex_);
+		zip_file_.Close();
+	}
+
+	// If the zip was opened lazily from a file there is no temp copy of it yet,
+	// make one now since it may be about to be overwritten
+	const bool in_memory = zip_data_.hasData();
+	if (!in_memory && on_disk_ && !fileutil::fileExists(temp_file_) && fileutil::fileExists(filename_))
+	{
+		generateTempFileName(filename_);
+		fileutil::copyFile(filename_, temp_file_);
+	}
+	const bool have_old_zip = in_memory || fileutil::fileExists(temp_file_);
+
+	// Get a linear list of all entries in the archive
+	vector<ArchiveEntry*> entries;
+	putEntryTreeAsList(entries);
+	const auto n_entries = entries.size();
+
+	// Very large zips need zip64 extensions, which are only supported when
+	// writing via a wxZipOutputStream
+	uint64_t est_size = ZIP_END_OF_CENTRAL_SIZE;
+	for (auto* entry : entries)
+		est_size += entry->size() + entry->size() / 1000 + 1024;
+	const bool use_stream = n_entries >= 0xFFFF || est_size >= 0xFFFFFFFF;
+
+	// Make sure data is loaded for any entries that can't be copied from the
+	// old zip, since the file it would be loaded from may be about to be
+	// overwritten
+	for (auto* entry : entries)
+		if (!have_old_zip
+			|| (use_stream ? entry->state() != ArchiveEntry::State::Unmodified : copyableIndex(entry) < 0))
+			entry->data();
+
+	// Write the zip
+	bool success;
+	if (use_stream)
+	{
+		// Open old zip for copying
+		unique_ptr<wxInputStream> old_zip;
+		if (in_memory)
+			old_zip = std::make_unique<wxMemoryInputStream>(std::as_const(zip_data_).data(), zip_data_.size());
+		else if (have_old_zip)
+			old_zip = std::make_unique<wxFFileInputStream>(temp_file_);
+
+		if (mc)
+		{
+			wxMemoryOutputStream out;
+			success = writeStream(out, old_zip.get(), entries, update);
+			if (success)
+			{
+				const auto size = out.GetSize();
+				success         = mc->reSize(static_cast<uint32_t>(size), false) && out.CopyTo(mc->data(), size) == size;
+			}
+		}
+		else
+		{
+			wxFFileOutputStream out(wxutil::strFromView(filename));
+			if (!out.IsOk())
+			{
+				global::error = "Unable to open file for saving. Make sure it isn't in use by another program.";
+				return false;
+			}
+			success = writeStream(out, old_zip.get(), entries, update) && out.Close();
+		}
+	}
+	else
+	{
+		// Open old zip for copying
+		wxFile                   old_file;
+		unique_ptr<SeekableData> old_file_data;
+		SeekableData*            old_zip = nullptr;
+		if (in_memory)
+			old_zip = &zip_data_;
+		else if (have_old_zip && old_file.Open(temp_file_))
+		{
+			old_file_data = std::make_unique<WxFileData>(old_file);
+			old_zip       = old_file_data.get();
+		}
+
+		if (mc)
+		{
+			// Allocate the (estimated) size of the zip up front rather than
+			// growing it with every write
+			mc->clear();
+			success = mc->reSize(static_cast<uint32_t>(est_size), false) && mc->seekFromStart(0)
+					  && writeDirect(*mc, old_zip, entries, update)
+					  && mc->reSize(mc->currentPos(), true);
+		}
+		else
+		{
+			wxFile file(wxutil::strFromView(filename), wxFile::write);
+			if (!file.IsOpened())
+			{
+				global::error = "Unable to open file for saving. Make sure it isn't in use by another program.";
+				return false;
+			}
+			WxFileData out{ file };
+			success = writeDirect(out, old_zip, entries, update) && file.Close();
+		}
+	}
+	if (!success)
+		return false;
+
+	// The written zip is now the one to load entry data and copy unmodified
+	// entries from, so re-read its central directory
+	if (update)
+	{
+		std::lock_guard lock(zip_file_mutex_);
+
+		bool cd_read;
+		if (mc)
+		{
+			zip_data_.importMem(*mc);
+			cd_read = readCentralDirectory(zip_data_);
+		}
+		else
+		{
+			zip_data_.clear();
+			cd_read = readCentralDirectory(filename);
+
+			// Update the temp file
+			if (temp_file_.empty())
+				generateTempFileName(filename);
+			fileutil::copyFile(filename, temp_file_);
+		}
+
+		if (!cd_read || central_dir_.size() != n_entries)
+			central_dir_.clear();
+	}
+
+	ui::setSplashProgressMessage("");
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes [entries] as zip data to [out], copying compressed data for
+// unmodified entries from [old_zip] if possible.
+// Entries that need (re)compressing are deflated in parallel, in batches, and
+// the compressed data is then written out in order.
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::writeDirect(
+	SeekableData&                out,
+	SeekableData*                old_zip,
+	const vector<ArchiveEntry*>& entries,
+	bool                         update)
+{
+	// Setup zip records for all entries
+	const auto              n_entries = entries.size();
+	const auto              dos_time  = dosDateTime(std::time(nullptr));
+	vector<CentralDirEntry> records(n_entries);
+	vector<ZipWriteJob>     jobs(n_entries);
+	for (size_t a = 0; a < n_entries; a++)
 	{
-		global::error = "Unable to open file for saving. Make sure it isn't in use by another program.";
+		auto* entry  = entries[a];
+		auto& record = records[a];
+		auto& job    = jobs[a];
+
+		record.mod_time = dos_time.first;
+		record.mod_date = dos_time.second;
+
+		// Folder
+		if (entry->type() == EntryType::folderType())
+		{
+			record.name = entry->path(true) + "/";
+			setZipEntryName(record);
+			job.is_dir = true;
+			continue;
+		}
+
+		record.name = entry->path() + misc::lumpNameToFileName(entry->name());
+		setZipEntryName(record);
+
+		// Check if the entry's compressed data can be copied from the old zip
+		if (const int index = old_zip ? copyableIndex(entry) : -1; index >= 0)
+		{
+			const auto& old_record = central_dir_[index];
+			job.copy_index         = index;
+			record.method          = old_record.method;
+			record.crc             = old_record.crc;
+			record.size            = old_record.size;
+			record.compressed_size = old_record.compressed_size;
+			record.mod_time        = old_record.mod_time;
+			record.mod_date        = old_record.mod_date;
+			record.flags |= old_record.flags & ZIP_FLAG_DEFLATE_OPTS;
+			continue;
+		}
+
+		// Otherwise it needs compressing
+		job.data  = &entry->data();
+		job.level = entry->type()->compressionLevel();
+		if (job.level < 0)
+			job.level = std::clamp<int>(zip_compression_level, 0, 9);
+	}
+
+	// Write entries in batches, compressing entries in each batch in parallel
+	ui::setSplashProgressMessage("Writing zip entries");
+	ui::setSplashProgress(0.0f);
+	ui::updateSplash();
+	size_t batch_start = 0;
+	while (batch_start < n_entries)
+	{
+		// Gather a batch of entries to compress, limiting the amount of
+		// compressed data held in memory at once
+		vector<size_t> to_compress;
+		size_t         batch_data = 0;
+		size_t         batch_end  = batch_start;
+		while (batch_end < n_entries && batch_data < ZIP_WRITE_BATCH_SIZE)
+		{
+			if (jobs[batch_end].data)
+			{
+				to_compress.push_back(batch_end);
+				batch_data += jobs[batch_end].data->size();
+			}
+			++batch_end;
+		}
+
+		// Compress
+		ThreadPool::global().parallelFor(
+			to_compress.size(), [&](size_t i) { compressEntryData(jobs[to_compress[i]], records[to_compress[i]]); });
+
+		// Write
+		for (auto a = batch_start; a < batch_end; ++a)
+		{
+			ui::setSplashProgress(static_cast<float>(a) / static_cast<float>(n_entries));
+
+			auto& job    = jobs[a];
+			auto& record = records[a];
+			if (job.failed)
+			{
+				global::error = fmt::format("Unable to compress entry {}", entries[a]->name());
+				return false;
+			}
+
+			// Get the data to write (the old zip may be the zip data entries
+			// are loaded from, so it can't be read while an entry is loading)
+			MemChunk        copied;
+			const MemChunk* data = &job.compressed;
+			if (job.copy_index >= 0)
+			{
+				std::lock_guard lock(zip_file_mutex_);
+				if (!seekToEntryData(*old_zip, central_dir_[job.copy_index].local_offset)
+					|| !readData(*old_zip, copied, record.compressed_size))
+				{
+					global::error = fmt::format("Unable to copy entry {} from previous zip", entries[a]->name());
+					return false;
+				}
+				data = &copied;
+			}
+			else if (record.method == ZIP_METHOD_STORE && job.data)
+				data = job.data;
+
+			// Write local header and data
+			record.local_offset = out.currentPos();
+			if (!writeZipRecord(out, record, false)
+				|| (record.compressed_size > 0 && !out.write(data->data(), record.compressed_size)))
+			{
+				global::error = "Error writing zip file";
+				return false;
+			}
+
+			// Free compressed data
+			job.compressed.clear();
+		}
+
+		batch_start = batch_end;
+	}
+
+	// Write central directory
+	const auto cd_offset = out.currentPos();
+	for (const auto& record : records)
+		if (!writeZipRecord(out, record, true))
+		{
+			global::error = "Error writing zip file";
+			return false;
+		}
+	const auto cd_size = out.currentPos() - cd_offset;
+
+	// Write end of central directory record
+	uint8_t eocd[ZIP_END_OF_CENTRAL_SIZE] = {};
+	writeL32(eocd, ZIP_SIG_END_OF_CENTRAL);
+	writeL16(eocd + 8, static_cast<uint16_t>(n_entries));
+	writeL16(eocd + 10, static_cast<uint16_t>(n_entries));
+	writeL32(eocd + 12, cd_size);
+	writeL32(eocd + 16, cd_offset);
+	if (!out.write(eocd, ZIP_END_OF_CENTRAL_SIZE))
+	{
+		global::error = "Error writing zip file";
 		return false;
 	}
 
+	// Update entry info
+	if (update)
+		for (size_t a = 0; a < n_entries; a++)
+		{
+			entries[a]->setState(ArchiveEntry::State::Unmodified);
+			if (!jobs[a].is_dir)
+				entries[a]->exProp("ZipIndex") = static_cast<int>(a);
+		}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes [entries] as zip data to stream [out] via a wxZipOutputStream,
+// copying unmodified entries from the zip in stream [old_zip] if given.
+// This is slower than writeDirect but supports zip64 extensions for very large
+// zips.
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::writeStream(
+	wxOutputStream&              out,
+	wxInputStream*               old_zip,
+	const vector<ArchiveEntry*>& entries,
+	bool                         update)
+{
 	// Open as zip for writing
-	wxZipOutputStream zip(out, 9);
+	wxZipOutputStream zip(out, std::clamp<int>(zip_compression_level, 0, 9));
 	if (!zip.IsOk())
 	{
 		global::error = "Unable to create zip for saving";
 		return false;
 	}
 
-	// Open old zip for copying, from the temp file that was copied on opening.
-	// This is used to copy any entries that have been previously saved/compressed
-	// and are unmodified, to greatly speed up zip file saving by not having to
-	// recompress unchanged entries
-	unique_ptr<wxZipInputStream>   inzip;
-	unique_ptr<wxFFileInputStream> in;
-	vector<wxZipEntry*>            c_entries;
-	if (fileutil::fileExists(temp_file_))
+	// Open old zip for copying. This is used to copy any entries that have been
+	// previously saved/compressed and are unmodified, to greatly speed up zip
+	// file saving by not having to recompress unchanged entries
+	unique_ptr<wxZipInputStream> inzip;
+	vector<wxZipEntry*>          c_entries;
+	if (old_zip && old_zip->IsOk())
 	{
-		in    = std::make_unique<wxFFileInputStream>(temp_file_);
-		inzip = std::make_unique<wxZipInputStream>(*in);
+		inzip = std::make_unique<wxZipInputStream>(*old_zip);
 
 		if (inzip->IsOk())
 		{
@@ -309,18 +1028,11 @@ bool ZipArchive::write(string_view filename, bool update)
 			inzip->Reset();
 		}
 		else
-		{
-			in    = nullptr;
 			inzip = nullptr;
-		}
 	}
 
-	// Get a linear list of all entries in the archive
-	vector<ArchiveEntry*> entries;
-	putEntryTreeAsList(entries);
-
 	// Go through all entries
-	auto n_entries = entries.size();
+	const auto n_entries = entries.size();
 	ui::setSplashProgressMessage("Writing zip entries");
 	ui::setSplashProgress(0.0f);
 	ui::updateSplash();
@@ -370,14 +1082,6 @@ bool ZipArchive::write(string_view filename, bool update)
 
 	// Clean up
 	zip.Close();
-	out.Close();
-
-	// Update the temp file
-	if (temp_file_.empty())
-		generateTempFileName(filename);
-	fileutil::copyFile(filename, temp_file_);
-
-	ui::setSplashProgressMessage("");
 
 	return true;
 }
@@ -414,19 +1118,55 @@ bool ZipArchive::loadEntryData(ArchiveEntry* entry)
 		return false;
 	}
 
-	// Open the file
-	wxFFileInputStream in(filename_);
-	if (!in.IsOk())
+	// Read the data directly using the central directory if possible
+	if (zip_index >= 0 && zip_index < static_cast<int>(central_dir_.size())
+		&& central_dir_[zip_index].size == entry->size())
 	{
-		log::error("ZipArchive::loadEntryData: Unable to open zip file \"{}\"!", filename_);
+		MemChunk mc;
+		if (!readEntryData(central_dir_[zip_index], mc))
+		{
+			log::error(
+				"ZipArchive::loadEntryData: Unable to read data for entry {} from \"{}\"", entry->name(), filename_);
+			return false;
+		}
+
+		entry->lockState();
+		entry->importMemChunk(mc);
+		entry->setLoaded();
+
+		entry->unlockState();
+
+		return true;
+	}
+
+	// Otherwise read it via a zip stream
+	return loadEntryDataStream(entry, zip_index);
+}
+
+// -----------------------------------------------------------------------------
+// Loads [entry]'s data by opening the zip file as a stream and skipping to the
+// zip entry at [zip_index]. This is much slower than reading via the central
+// directory, and is only used if that couldn't be read (eg. zip64 files)
+// -----------------------------------------------------------------------------
+bool ZipArchive::loadEntryDataStream(ArchiveEntry* entry, int zip_index)
+{
+	// Open the zip data in memory, or the file if there is none
+	unique_ptr<wxInputStream> in;
+	if (zip_data_.hasData())
+		in = std::make_unique<wxMemoryInputStream>(std::as_const(zip_data_).data(), zip_data_.size());
+	else
+		in = std::make_unique<wxFFileInputStream>(filename_);
+	if (!in->IsOk())
+	{
+		log::error("ZipArchive::loadEntryDataStream: Unable to open zip file \"{}\"!", filename_);
 		return false;
 	}
 
 	// Create zip stream
-	wxZipInputStream zip(in);
+	wxZipInputStream zip(*in);
 	if (!zip.IsOk())
 	{
-		log::error("ZipArchive::loadEntryData: Invalid zip file \"{}\"!", filename_);
+		log::error("ZipArchive::loadEntryDataStream: Invalid zip file \"{}\"!", filename_);
 		return false;
 	}
 
@@ -679,6 +1419,198 @@ void ZipArchive::generateTempFileName(string_view filename)
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Reads the central directory of the zip file at [filename]
+// Returns false if the file couldn't be read or isn't a (non-zip64) zip file
+// -----------------------------------------------------------------------------
+bool ZipArchive::readCentralDirectory(string_view filename)
+{
+	wxFile file(wxutil::strFromView(filename));
+	if (!file.IsOpened())
+	{
+		central_dir_.clear();
+		return false;
+	}
+
+	WxFileData data{ file };
+	return readCentralDirectory(data);
+}
+
+// -----------------------------------------------------------------------------
+// Reads the central directory of zip [data], which contains the location, size
+// and compression info of each entry in the zip.
+// Returns false if the data couldn't be read or isn't a (non-zip64) zip
+// -----------------------------------------------------------------------------
+bool ZipArchive::readCentralDirectory(SeekableData& data)
+{
+	central_dir_.clear();
+
+	// Read the end of the data, which should contain the end of central
+	// directory record (followed by a comment of up to 64kb)
+	const auto file_size = static_cast<uint32_t>(data.size());
+	if (file_size < ZIP_END_OF_CENTRAL_SIZE)
+		return false;
+	const auto tail_size = std::min(file_size, ZIP_END_OF_CENTRAL_SIZE + ZIP_MAX_COMMENT_SIZE);
+	MemChunk   tail;
+	if (!data.seekFromStart(file_size - tail_size) || !readData(data, tail, tail_size))
+		return false;
+
+	// Find the end of central directory record (searching backwards)
+	int eocd = -1;
+	for (int a = static_cast<int>(tail_size - ZIP_END_OF_CENTRAL_SIZE); a >= 0; --a)
+		if (tail.readL32(a) == ZIP_SIG_END_OF_CENTRAL)
+		{
+			eocd = a;
+			break;
+		}
+	if (eocd < 0)
+		return false;
+
+	const uint32_t n_entries = tail.readL16(eocd + 10);
+	const uint32_t cd_size   = tail.readL32(eocd + 12);
+	const uint32_t cd_offset = tail.readL32(eocd + 16);
+
+	// Zip64 files aren't supported here
+	if (n_entries == 0xFFFF || cd_size == 0xFFFFFFFF || cd_offset == 0xFFFFFFFF)
+		return false;
+
+	// Get the actual position of the central directory, any difference from
+	// the recorded offset means there is data prepended to the zip (eg. a
+	// self-extracting exe) that all recorded offsets need adjusting for
+	const auto eocd_pos = file_size - tail_size + eocd;
+	if (cd_size > eocd_pos)
+		return false;
+	const auto cd_pos = eocd_pos - cd_size;
+	if (cd_offset > cd_pos)
+		return false;
+	const auto offset_adjust = cd_pos - cd_offset;
+
+	// Read the central directory
+	MemChunk cd;
+	if (!data.seekFromStart(cd_pos) || !readData(data, cd, cd_size))
+		return false;
+
+	central_dir_.reserve(n_entries);
+	uint32_t pos = 0;
+	for (uint32_t a = 0; a < n_entries; ++a)
+	{
+		if (pos + ZIP_CENTRAL_DIR_SIZE > cd_size || cd.readL32(pos) != ZIP_SIG_CENTRAL_DIR)
+		{
+			central_dir_.clear();
+			return false;
+		}
+
+		const uint32_t name_len    = cd.readL16(pos + 28);
+		const uint32_t extra_len   = cd.readL16(pos + 30);
+		const uint32_t comment_len = cd.readL16(pos + 32);
+		if (pos + ZIP_CENTRAL_DIR_SIZE + name_len > cd_size)
+		{
+			central_dir_.clear();
+			return false;
+		}
+
+		auto& cd_entry           = central_dir_.emplace_back();
+		cd_entry.flags           = cd.readL16(pos + 8);
+		cd_entry.method          = cd.readL16(pos + 10);
+		cd_entry.mod_time        = cd.readL16(pos + 12);
+		cd_entry.mod_date        = cd.readL16(pos + 14);
+		cd_entry.crc             = cd.readL32(pos + 16);
+		cd_entry.compressed_size = cd.readL32(pos + 20);
+		cd_entry.size            = cd.readL32(pos + 24);
+		cd_entry.local_offset    = cd.readL32(pos + 42) + offset_adjust;
+		cd_entry.name.assign(
+			reinterpret_cast<const char*>(std::as_const(cd).data() + pos + ZIP_CENTRAL_DIR_SIZE), name_len);
+
+		pos += ZIP_CENTRAL_DIR_SIZE + name_len + extra_len + comment_len;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads and decompresses the data for [cd_entry] from the zip into [mc].
+// If [max_size] is given and smaller than the entry, only that much data from
+// the start of the entry is read (or possibly less, if it is compressed).
+// Data is read from the zip data in memory if the zip was opened from a
+// MemChunk, otherwise from the zip file, which is kept open afterwards to speed
+// up subsequent reads.
+// Returns false if the data couldn't be read
+// -----------------------------------------------------------------------------
+bool ZipArchive::readEntryData(const CentralDirEntry& cd_entry, MemChunk& mc, uint32_t max_size)
+{
+	if (cd_entry.flags & ZIP_FLAG_ENCRYPTED)
+		return false;
+	if (cd_entry.method != ZIP_METHOD_STORE && cd_entry.method != ZIP_METHOD_DEFLATE)
+		return false;
+
+	// Check if only the start of the data is wanted. It's impossible to know
+	// exactly how much compressed data will inflate to [max_size] bytes, but
+	// double plus a bit (for block headers) will be plenty in practice
+	const bool     partial = max_size > 0 && max_size < cd_entry.size;
+	const uint32_t size    = partial ? max_size : cd_entry.size;
+	const uint32_t csize   = partial ? std::min(cd_entry.compressed_size, max_size * 2 + 256) : cd_entry.compressed_size;
+
+	MemChunk compressed;
+	{
+		std::lock_guard lock(zip_file_mutex_);
+
+		WxFileData    file_data{ zip_file_ };
+		SeekableData* data = &zip_data_;
+		if (!zip_data_.hasData())
+		{
+			if (!zip_file_.IsOpened() && !zip_file_.Open(filename_))
+				return false;
+			data = &file_data;
+		}
+
+		if (!seekToEntryData(*data, cd_entry.local_offset))
+			return false;
+
+		// Data in memory is viewed rather than copied if it's memory mapped
+		const auto read_size = cd_entry.method == ZIP_METHOD_STORE ? size : csize;
+		auto&      target    = cd_entry.method == ZIP_METHOD_STORE ? mc : compressed;
+		if (data == &zip_data_ && read_size > 0)
+		{
+			if (!zip_data_.exportMemChunk(target, zip_data_.currentPos(), read_size))
+				return false;
+		}
+		else if (!readData(*data, target, read_size))
+			return false;
+	}
+
+	// Inflate if needed
+	if (cd_entry.method == ZIP_METHOD_DEFLATE)
+	{
+		if (!mc.reSize(size, false))
+			return false;
+
+		if (partial)
+		{
+			size_t inflated = size;
+			if (!compression::zipInflatePrefix(std::as_const(compressed).data(), compressed.size(), mc.data(), inflated)
+				|| inflated == 0)
+				return false;
+			if (inflated < size)
+				mc.reSize(static_cast<uint32_t>(inflated));
+		}
+		else if (!compression::zipInflate(std::as_const(compressed).data(), compressed.size(), mc.data(), mc.size()))
+			return false;
+	}
+
+	// Can't check partial data
+	if (partial)
+		return true;
+
+	// Check the data is intact
+	if (mc.crc() != cd_entry.crc)
+	{
+		log::warning("CRC mismatch reading zip entry {}", cd_entry.name);
+		return false;
+	}
+
+	return true;
+}
+
 
 // -----------------------------------------------------------------------------
 //
@@ -1,12 +1,27 @@
 #pragma once
 
 #include "Archive/Archive.h"
+#include <mutex>
 
 namespace slade
 {
 class ZipArchive : public Archive
 {
 public:
+	// Central directory record for an entry in a zip file
+	struct CentralDirEntry
+	{
+		string   name;
+		uint32_t local_offset    = 0;
+		uint32_t compressed_size = 0;
+		uint32_t size            = 0;
+		uint32_t crc             = 0;
+		uint16_t method          = 0;
+		uint16_t flags           = 0;
+		uint16_t mod_time        = 0;
+		uint16_t mod_date        = 0;
+	};
+
 	ZipArchive();
 	~ZipArchive() override;
 
@@ -38,8 +53,31 @@ public:
 	static bool isZipArchive(const string& filename);
 
 private:
-	string temp_file_;
+	string                  temp_file_;
+	MemChunk                zip_data_;    // Zip data, if opened from or last written to a MemChunk
+	vector<CentralDirEntry> central_dir_; // Central directory of the zip data, indexed by ZipIndex
+	wxFile                  zip_file_;    // Kept open between entry data loads
+	std::mutex              zip_file_mutex_;
 
+	bool openFile(string_view filename, bool lazy);
+	bool openStream(wxInputStream& in, unsigned& n_zip_entries);
+	bool openLazy();
 	void generateTempFileName(string_view filename);
+	bool readCentralDirectory(string_view filename);
+	bool readCentralDirectory(SeekableData& data);
+	bool readEntryData(const CentralDirEntry& cd_entry, MemChunk& mc, uint32_t max_size = 0);
+	int  copyableIndex(ArchiveEntry* entry) const;
+	bool writeZip(string_view filename, MemChunk* mc, bool update);
+	bool writeDirect(
+		SeekableData&                out,
+		SeekableData*                old_zip,
+		const vector<ArchiveEntry*>& entries,
+		bool                         update);
+	bool writeStream(
+		wxOutputStream&              out,
+		wxInputStream*               old_zip,
+		const vector<ArchiveEntry*>& entries,
+		bool                         update);
+	bool loadEntryDataStream(ArchiveEntry* entry, int zip_index);
 };
 } // namespace slade
@@ -540,6 +540,10 @@ bool Configuration::readConfiguration(
 	bool        ignore_game,
 	bool        clear)
 {
+	// Clear UDMF property key index, it's rebuilt once the configuration is read
+	for (auto& props : udmf_props_by_key_)
+		props.clear();
+
 	// Clear current configuration
 	if (clear)
 	{
@@ -878,6 +882,9 @@ bool Configuration::readConfiguration(
 			log::warning("Unexpected game configuration section \"{}\", skipping", node->name());
 	}
 
+	// Index UDMF properties by key
+	indexUDMFProperties();
+
 	return true;
 }
 
@@ -1773,6 +1780,44 @@ UDMFProperty* Configuration::getUDMFProperty(const string& name, MapObject::Type
 		return nullptr;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the UDMF property definition matching property [key] for MapObject
+// [type], or nullptr if there isn't one. Since keys are case-insensitive, so
+// is the match
+// -----------------------------------------------------------------------------
+UDMFProperty* Configuration::getUDMFProperty(property::Key key, MapObject::Type type)
+{
+	const auto& props = udmf_props_by_key_[static_cast<int>(type)];
+	return key < props.size() ? props[key] : nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Indexes the UDMF property definitions for each MapObject type by property
+// key, for getUDMFProperty
+// -----------------------------------------------------------------------------
+void Configuration::indexUDMFProperties()
+{
+	using Type = MapObject::Type;
+
+	for (auto type : { Type::Vertex, Type::Line, Type::Side, Type::Sector, Type::Thing })
+	{
+		auto& props = udmf_props_by_key_[static_cast<int>(type)];
+		props.clear();
+		for (auto& [name, prop] : allUDMFProperties(type))
+		{
+			// Skip empty entries added by looking up undefined properties by name
+			if (prop.propName().empty())
+				continue;
+
+			const auto key = property::key(name);
+			if (key >= props.size())
+				props.resize(key + 1, nullptr);
+			if (!props[key])
+				props[key] = &prop;
+		}
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Returns all defined UDMF properties for MapObject type [type]
 // -----------------------------------------------------------------------------
@@ -1822,7 +1867,8 @@ void Configuration::cleanObjectUDMFProps(MapObject* object)
 		const auto& udmf_prop = i.second;
 
 		// Check if the object even has this property
-		if (!object->hasProp(name))
+		const auto key = property::key(name);
+		if (!object->hasProp(key))
 			continue;
 
 		// Remove the property from the object if it is the default value
@@ -1831,19 +1877,19 @@ void Configuration::cleanObjectUDMFProps(MapObject* object)
 		{
 		case ValueType::Bool:
 			if (udmf_prop.isDefault<bool>(object->boolProperty(name)))
-				object->props().remove(name);
+				object->props().remove(key);
 			break;
 		case ValueType::Int:
 			if (udmf_prop.isDefault<int>(object->intProperty(name)))
-				object->props().remove(name);
+				object->props().remove(key);
 			break;
 		case ValueType::Float:
 			if (udmf_prop.isDefault<double>(object->floatProperty(name)))
-				object->props().remove(name);
+				object->props().remove(key);
 			break;
 		case ValueType::String:
 			if (udmf_prop.isDefault<string>(object->stringProperty(name)))
-				object->props().remove(name);
+				object->props().remove(key);
 			break;
 		default: break;
 		}
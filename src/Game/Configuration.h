@@ -107,6 +107,7 @@ namespace game
 		void readThingTypes(ParseTreeNode* node, const ThingType& group_defaults = ThingType::unknown());
 		void readUDMFProperties(const ParseTreeNode* block, UDMFPropMap& plist) const;
 		void readGameSection(const ParseTreeNode* node_game, bool port_section = false);
+		void indexUDMFProperties();
 		bool readConfiguration(
 			string_view cfg,
 			string_view source      = "",
@@ -166,6 +167,7 @@ namespace game
 
 		// UDMF properties
 		UDMFProperty* getUDMFProperty(const string& name, MapObject::Type type);
+		UDMFProperty* getUDMFProperty(property::Key key, MapObject::Type type);
 		UDMFPropMap&  allUDMFProperties(MapObject::Type type);
 		void          cleanObjectUDMFProps(MapObject* object);
 
@@ -249,6 +251,10 @@ namespace game
 		UDMFPropMap udmf_sector_props_;
 		UDMFPropMap udmf_thing_props_;
 
+		// UDMF property definitions by object type and property key (see
+		// indexUDMFProperties)
+		std::array<vector<UDMFProperty*>, 6> udmf_props_by_key_;
+
 		// Defaults
 		PropertyList defaults_line_;
 		PropertyList defaults_line_udmf_;
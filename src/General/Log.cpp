@@ -34,6 +34,7 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include <fstream>
+#include <mutex>
 
 using namespace slade;
 
@@ -47,10 +48,36 @@ namespace slade::log
 {
 vector<Message> log;
 std::ofstream   log_file;
+std::mutex      log_mutex; // Messages can be logged from any thread
 } // namespace slade::log
 CVAR(Int, log_verbosity, 1, CVar::Flag::Save)
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the current local time. std::localtime isn't thread-safe, as it
+// returns a pointer to a shared buffer
+// -----------------------------------------------------------------------------
+std::tm localTimeNow()
+{
+	const auto t  = std::time(nullptr);
+	std::tm    tm = {};
+#ifdef _WIN32
+	localtime_s(&tm, &t);
+#else
+	localtime_r(&t, &tm);
+#endif
+	return tm;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 // Formatter for fmt so that log::MessageType can be written to a string
 // -----------------------------------------------------------------------------
@@ -130,15 +157,14 @@ void log::init()
 	sf::err().rdbuf(log_file.rdbuf());
 
 	// Write logfile header
-	auto t  = std::time(nullptr);
-	auto tm = std::localtime(&t);
+	const auto tm = localTimeNow();
 	info("SLADE - It's a Doom Editor");
 	info(fmt::format("Version {}", app::version().toString()));
 	if (!global::sc_rev.empty())
 		info(fmt::format("Git Revision {}", global::sc_rev));
     if (app::platform() == app::Platform::Windows)
 		info(fmt::format("{} Windows Build", app::isWin64Build() ? "64bit" : "32bit"));
-	info(fmt::format("Written by Simon Judd, 2008-{:%Y}", *tm));
+	info(fmt::format("Written by Simon Judd, 2008-{:%Y}", tm));
 #ifdef SFML_VERSION_MAJOR
 	info(fmt::format(
 		"Compiled with wxWidgets {}.{}.{} and SFML {}.{}.{}",
@@ -158,11 +184,17 @@ void log::init()
 }
 
 // -----------------------------------------------------------------------------
-// Returns the log message history
+// Returns a copy of the log message history, starting from message index
+// [from]. A copy is returned since messages can be added by other threads
 // -----------------------------------------------------------------------------
-const vector<log::Message>& log::history()
+vector<log::Message> log::history(size_t from)
 {
-	return log;
+	std::lock_guard lock(log_mutex);
+
+	if (from >= log.size())
+		return {};
+
+	return vector<Message>(log.begin() + static_cast<ptrdiff_t>(from), log.end());
 }
 
 // -----------------------------------------------------------------------------
@@ -187,9 +219,11 @@ void log::setVerbosity(int verbosity)
 // -----------------------------------------------------------------------------
 void log::message(MessageType type, string_view text)
 {
+	const auto      timestamp = localTimeNow();
+	std::lock_guard lock(log_mutex);
+
 	// Add log message
-	auto t = std::time(nullptr);
-	log.emplace_back(text, type, *std::localtime(&t));
+	log.emplace_back(text, type, timestamp);
 
 	// Write to log file
 	if (log_file.is_open() && type != MessageType::Console) {
@@ -209,14 +243,17 @@ void log::message(MessageType type, string_view text, fmt::format_args args)
 }
 
 // -----------------------------------------------------------------------------
-// Returns a list of log messages of [type] that have been recorded since [time]
+// Returns a list of (copies of) log messages of [type] that have been recorded
+// since [time]
 // -----------------------------------------------------------------------------
-vector<log::Message*> log::since(time_t time, MessageType type)
+vector<log::Message> log::since(time_t time, MessageType type)
 {
-	vector<Message*> list;
+	std::lock_guard lock(log_mutex);
+
+	vector<Message> list;
 	for (auto& msg : log)
 		if (mktime(&msg.timestamp) >= time && (type == MessageType::Any || msg.type == type))
-			list.push_back(&msg);
+			list.push_back(msg);
 	return list;
 }
 
@@ -258,9 +295,11 @@ void log::message(MessageType type, int level, string_view text)
 	if (level > log_verbosity)
 		return;
 
+	const auto      timestamp = localTimeNow();
+	std::lock_guard lock(log_mutex);
+
 	// Add log message
-	auto t = std::time(nullptr);
-	log.emplace_back(text, type, *std::localtime(&t));
+	log.emplace_back(text, type, timestamp);
 
 	// Write to log file
 	if (log_file.is_open() && type != MessageType::Console)
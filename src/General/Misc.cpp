@@ -132,8 +132,9 @@ bool misc::loadImageFromEntry(SImage* image, ArchiveEntry* entry, int index)
 		return image->loadJaguarTexture(entry->rawData(), entry->size(), dimensions.x, dimensions.y);
 	}
 
-	// Firstly try SIFormat system
-	if (image->open(entry->data(), index, format_hint))
+	// Firstly try SIFormat system (the detected format is remembered per entry)
+	auto sif = SIFormat::determineFormat(*entry, format_hint);
+	if (sif != SIFormat::unknownFormat() && sif->loadImage(*image, entry->data(), index, false))
 		return true;
 
 	// Raw images are a special case (not reliably possible to detect just from data)
@@ -453,11 +454,8 @@ void misc::doMassRename(vector<string>& names, string_view name_filter)
 /* Table of CRCs of all 8-bit messages. */
 uint32_t crc_table[256];
 
-/* Flag: has the table been computed? Initially false. */
-int crc_table_computed = 0;
-
 /* Make the table for a fast CRC. */
-void make_crc_table(void)
+bool make_crc_table(void)
 {
 	uint32_t c;
 	int      n, k;
@@ -477,19 +475,20 @@ void make_crc_table(void)
 		crc_table[n] = c;
 	}
 
-	crc_table_computed = 1;
+	return true;
 }
 
 /* Update a running CRC with the bytes buf[0..len-1]--the CRC
 should be initialized to all 1's, and the transmitted value
 is the 1's complement of the final running CRC (see the
-crc() routine below)). */
+crc() routine below)). The table is computed on first use
+(thread-safe, since this can be called from worker threads). */
 uint32_t update_crc(uint32_t crc, const uint8_t* buf, uint32_t len)
 {
-	uint32_t c = crc;
+	static const bool crc_table_computed = make_crc_table();
+	(void)crc_table_computed;
 
-	if (!crc_table_computed)
-		make_crc_table();
+	uint32_t c = crc;
 
 	for (uint32_t n = 0; n < len; n++)
 		c = crc_table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
@@ -33,9 +33,9 @@
 #include "Main.h"
 #include "CTexture.h"
 #include "App.h"
-#include "General/Misc.h"
 #include "General/ResourceManager.h"
 #include "Graphics/SImage/SImage.h"
+#include "PatchCache.h"
 #include "TextureXList.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
@@ -920,7 +920,7 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 		// Add each patch to image
 		for (auto& patch : patches_)
 		{
-			if (misc::loadImageFromEntry(&p_img, patch->patchEntry(parent)))
+			if (patchcache::loadImage(p_img, patch->patchEntry(parent)))
 				image.drawImage(p_img, patch->xOffset(), patch->yOffset(), dp, pal, pal);
 		}
 	}
@@ -976,13 +976,13 @@ bool CTexture::loadPatchImage(unsigned pindex, SImage& image, Archive* parent, P
 
 	// Load entry to image if valid
 	if (entry)
-		return misc::loadImageFromEntry(&image, entry);
+		return patchcache::loadImage(image, entry);
 
 	// Maybe it's a texture?
 	entry = app::resources().getTextureEntry(patch->name(), "", parent);
 
 	if (entry)
-		return misc::loadImageFromEntry(&image, entry);
+		return patchcache::loadImage(image, entry);
 
 	return false;
 }
@@ -0,0 +1,233 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2022 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         https://slade.mancubus.net
+// Filename:    PatchCache.cpp
+// Description: Bounded LRU cache of decoded patch images. Composite textures
+//              tend to share a small number of patches, so this avoids
+//              re-reading and re-decoding the same patch entries over and over
+//              when building texture images
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "PatchCache.h"
+#include "Archive/ArchiveEntry.h"
+#include "General/Misc.h"
+#include "Graphics/SImage/SImage.h"
+#include <list>
+#include <mutex>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, patch_cache_size, 64, CVar::Flag::Save) // In MB, 0 to disable
+
+namespace slade::patchcache
+{
+struct CachedPatch
+{
+	ArchiveEntry*          entry;
+	weak_ptr<ArchiveEntry> entry_ref; // To detect a different entry at the same address
+	uint32_t               data_version;
+	SImage                 image;
+	size_t                 size;
+};
+
+// Most recently used first
+std::list<CachedPatch>                                              patches;
+std::unordered_map<ArchiveEntry*, std::list<CachedPatch>::iterator> patch_map;
+std::mutex                                                          patches_mutex;
+Stats                                                               cache_stats;
+} // namespace slade::patchcache
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the approximate memory used by [image]
+// -----------------------------------------------------------------------------
+size_t imageSize(const SImage& image)
+{
+	const size_t pixels = image.width() * image.height();
+	return image.type() == SImage::Type::PalMask ? pixels * 2 : pixels * image.bpp();
+}
+
+// -----------------------------------------------------------------------------
+// Removes the cached patch at [i] from the cache.
+// The cache mutex must be locked
+// -----------------------------------------------------------------------------
+void removeCached(std::list<patchcache::CachedPatch>::iterator i)
+{
+	patchcache::cache_stats.memory -= i->size;
+	patchcache::patch_map.erase(i->entry);
+	patchcache::patches.erase(i);
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// PatchCache Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Loads the image from [entry] into [image], from the cache if possible.
+// Entries not in an archive are loaded directly and aren't cached
+// -----------------------------------------------------------------------------
+bool patchcache::loadImage(SImage& image, ArchiveEntry* entry)
+{
+	if (!entry)
+		return false;
+
+	auto shared = entry->getShared();
+	if (!shared || patch_cache_size <= 0)
+		return misc::loadImageFromEntry(&image, entry);
+
+	// Check the cache
+	{
+		std::lock_guard lock(patches_mutex);
+
+		auto i = patch_map.find(entry);
+		if (i != patch_map.end())
+		{
+			auto cached = i->second;
+			if (cached->entry_ref.lock() == shared && cached->data_version == entry->dataVersion())
+			{
+				// Hit, move to front
+				cache_stats.hits++;
+				patches.splice(patches.begin(), patches, cached);
+				return image.copyImage(&cached->image);
+			}
+
+			// Stale
+			removeCached(cached);
+		}
+
+		cache_stats.misses++;
+	}
+
+	// Not cached, load it
+	const auto data_version = entry->dataVersion();
+	if (!misc::loadImageFromEntry(&image, entry))
+		return false;
+
+	// Add to cache
+	std::lock_guard lock(patches_mutex);
+	auto            i = patch_map.find(entry);
+	if (i != patch_map.end())
+		removeCached(i->second);
+	patches.push_front({ entry, shared, data_version, image, imageSize(image) });
+	patch_map[entry] = patches.begin();
+	cache_stats.memory += patches.front().size;
+
+	// Evict least recently used patches if over the size limit
+	const size_t max_size = static_cast<size_t>(patch_cache_size) * 1024 * 1024;
+	while (cache_stats.memory > max_size && patches.size() > 1)
+	{
+		removeCached(std::prev(patches.end()));
+		cache_stats.evictions++;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Removes the cached image for [entry], if any
+// -----------------------------------------------------------------------------
+void patchcache::remove(ArchiveEntry* entry)
+{
+	std::lock_guard lock(patches_mutex);
+
+	auto i = patch_map.find(entry);
+	if (i != patch_map.end())
+		removeCached(i->second);
+}
+
+// -----------------------------------------------------------------------------
+// Clears all cached images
+// -----------------------------------------------------------------------------
+void patchcache::clear()
+{
+	std::lock_guard lock(patches_mutex);
+
+	patches.clear();
+	patch_map.clear();
+	cache_stats.memory = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the cache hit/miss counters and current size
+// -----------------------------------------------------------------------------
+patchcache::Stats patchcache::stats()
+{
+	std::lock_guard lock(patches_mutex);
+
+	auto stats    = cache_stats;
+	stats.entries = patches.size();
+	return stats;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+#include "General/Console.h"
+
+CONSOLE_COMMAND(patch_cache, 0, true)
+{
+	if (!args.empty() && args[0] == "clear")
+	{
+		patchcache::clear();
+		log::console("Patch cache cleared");
+		return;
+	}
+
+	const auto stats = patchcache::stats();
+	const auto total = stats.hits + stats.misses;
+	log::console(fmt::format(
+		"Patch cache: {} images ({:.1f}MB of {}MB), {} hits, {} misses ({:.1f}% hit rate), {} evictions",
+		stats.entries,
+		stats.memory / (1024.0 * 1024.0),
+		static_cast<int>(patch_cache_size),
+		stats.hits,
+		stats.misses,
+		total > 0 ? stats.hits * 100.0 / total : 0.0,
+		stats.evictions));
+}
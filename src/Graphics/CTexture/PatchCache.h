@@ -0,0 +1,27 @@
+#pragma once
+
+namespace slade
+{
+class ArchiveEntry;
+class SImage;
+
+// Bounded LRU cache of decoded patch images, shared by everything that builds
+// composite textures or displays patches. Cached images are keyed by entry and
+// are invalidated when the entry data is modified
+namespace patchcache
+{
+	struct Stats
+	{
+		unsigned hits      = 0;
+		unsigned misses    = 0;
+		unsigned evictions = 0;
+		unsigned entries   = 0;
+		size_t   memory    = 0;
+	};
+
+	bool  loadImage(SImage& image, ArchiveEntry* entry);
+	void  remove(ArchiveEntry* entry);
+	void  clear();
+	Stats stats();
+} // namespace patchcache
+} // namespace slade
@@ -36,6 +36,7 @@
 #include "Graphics/Translation.h"
 #include "Utility/CIEDeltaEquations.h"
 #include "Utility/StringUtils.h"
+#include <atomic>
 
 using namespace slade;
 
@@ -55,6 +56,51 @@ CVAR(Float, col_match_l, 1.0, CVar::Flag::Save)
 EXTERN_CVAR(Float, col_greyscale_r)
 EXTERN_CVAR(Float, col_greyscale_g)
 EXTERN_CVAR(Float, col_greyscale_b)
+EXTERN_CVAR(Float, col_cie_kl)
+EXTERN_CVAR(Float, col_cie_k1)
+EXTERN_CVAR(Float, col_cie_k2)
+EXTERN_CVAR(Float, col_cie_kc)
+EXTERN_CVAR(Float, col_cie_kh)
+EXTERN_CVAR(Float, col_cie_tristim_x)
+EXTERN_CVAR(Float, col_cie_tristim_z)
+
+
+// -----------------------------------------------------------------------------
+//
+// Palette::NearestColourCache Struct
+//
+// -----------------------------------------------------------------------------
+
+// Direct-mapped cache of nearestColour results for a colour match method,
+// indexed by a hash of the RGB value being matched. Each slot packs a valid
+// flag, the RGB value and the nearest palette index into one atomic value, so
+// lookups need no locking and results can never be mixed up between colours.
+//
+// This is used rather than a fully precomputed RGB lookup table or a k-d tree:
+// a full 24-bit table would be 16MB per palette and match method and take far
+// longer to build than most conversions take, a reduced precision table would
+// change the results, and a k-d tree only works for the euclidean RGB match
+// methods (not HSL or the CIE ones). Images only use a small number of
+// distinct colours, so filling the cache as colours are matched gets the same
+// benefit with exact results for every match method
+struct Palette::NearestColourCache
+{
+	static constexpr unsigned SIZE_BITS = 15;
+	static constexpr uint64_t VALID     = uint64_t{ 1 } << 32;
+
+	std::array<double, 7>               settings; // Colour match cvar values the results were found with
+	vector<ColLAB>                      lab;      // Palette colours as CIE L*a*b* (for CIE colour matching only)
+	unique_ptr<std::atomic<uint64_t>[]> slots;
+
+	NearestColourCache(const std::array<double, 7>& settings, vector<ColLAB> lab) :
+		settings{ settings },
+		lab{ std::move(lab) },
+		slots{ std::make_unique<std::atomic<uint64_t>[]>(size_t{ 1 } << SIZE_BITS) }
+	{
+	}
+
+	std::atomic<uint64_t>& slot(uint32_t rgb) const { return slots[(rgb * 2654435761u) >> (32 - SIZE_BITS)]; }
+};
 
 
 // -----------------------------------------------------------------------------
@@ -67,18 +113,22 @@ EXTERN_CVAR(Float, col_greyscale_b)
 // -----------------------------------------------------------------------------
 // Palette class constructor
 // -----------------------------------------------------------------------------
-Palette::Palette(unsigned size) : colours_{ size }, colours_hsl_{ size }, colours_lab_{ size }, index_trans_{ -1 }
+Palette::Palette(unsigned size) : colours_{ size }, colours_hsl_{ size }, index_trans_{ -1 }
 {
 	// Init palette (to greyscale)
 	for (unsigned a = 0; a < size; a++)
 	{
 		double mult = (double)a / (double)size;
 		colours_[a].set(mult * 255, mult * 255, mult * 255, 255, -1, a);
-		colours_lab_[a].l = mult;
 		colours_hsl_[a].l = mult;
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Palette class destructor
+// -----------------------------------------------------------------------------
+Palette::~Palette() = default;
+
 // -----------------------------------------------------------------------------
 // Reads colour information from raw data (MemChunk)
 // -----------------------------------------------------------------------------
@@ -101,7 +151,6 @@ bool Palette::loadMem(MemChunk& mc)
 
 		// Set colour in palette
 		colours_[c].set(rgb[0], rgb[1], rgb[2], 255, -1, c);
-		colours_lab_[c] = colours_[c].asLAB();
 		colours_hsl_[c] = colours_[c].asHSL();
 
 		// If we have read 256 colours, finish
@@ -109,6 +158,7 @@ bool Palette::loadMem(MemChunk& mc)
 			break;
 	}
 	mc.seek(0, SEEK_SET);
+	clearNearestColourCache();
 
 	return true;
 }
@@ -128,13 +178,13 @@ bool Palette::loadMem(const uint8_t* data, uint32_t size)
 	{
 		// Set colour in palette
 		colours_[c].set(data[a], data[a + 1], data[a + 2], 255, -1, c);
-		colours_lab_[c] = colours_[c].asLAB();
 		colours_hsl_[c] = colours_[c].asHSL();
 
 		// If we have read 256 colours, finish
 		if (++c == 256)
 			break;
 	}
+	clearNearestColourCache();
 
 	return true;
 }
@@ -202,8 +252,9 @@ bool Palette::loadMem(MemChunk& mc, Format format)
 
 			// Color is validated, so add it
 			log::info(3, "Colour index {} / at {},{} / rgb {},{},{}", a, x, y, col.r, col.g, col.b);
-			setColour(a, col);
+			updateColour(a, col);
 		}
+		clearNearestColourCache();
 
 		return true;
 	}
@@ -266,7 +317,9 @@ bool Palette::loadMem(MemChunk& mc, Format format)
 			current = 2;
 		}
 
-		// Parse rgb triplets
+		// Parse rgb triplets (clearing the nearestColour cache first, since the
+		// colours can be partially replaced even if parsing fails)
+		clearNearestColourCache();
 		int val;
 		while (index < 256 && current < n_tokens)
 		{
@@ -310,7 +363,7 @@ bool Palette::loadMem(MemChunk& mc, Format format)
 
 				// Set colour
 				colour.index = index;
-				setColour(index++, colour);
+				updateColour(index++, colour);
 			}
 
 			// Skip to next line
@@ -458,10 +511,8 @@ bool Palette::loadFile(string_view filename, Format format)
 // -----------------------------------------------------------------------------
 void Palette::setColour(uint8_t index, const ColRGBA& col)
 {
-	colours_[index].set(col);
-	colours_[index].index = index;
-	colours_lab_[index]   = colours_[index].asLAB();
-	colours_hsl_[index]   = colours_[index].asHSL();
+	updateColour(index, col);
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -470,8 +521,8 @@ void Palette::setColour(uint8_t index, const ColRGBA& col)
 void Palette::setColourR(uint8_t index, uint8_t val)
 {
 	colours_[index].r   = val;
-	colours_lab_[index] = colours_[index].asLAB();
 	colours_hsl_[index] = colours_[index].asHSL();
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -480,8 +531,8 @@ void Palette::setColourR(uint8_t index, uint8_t val)
 void Palette::setColourG(uint8_t index, uint8_t val)
 {
 	colours_[index].g   = val;
-	colours_lab_[index] = colours_[index].asLAB();
 	colours_hsl_[index] = colours_[index].asHSL();
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -490,8 +541,19 @@ void Palette::setColourG(uint8_t index, uint8_t val)
 void Palette::setColourB(uint8_t index, uint8_t val)
 {
 	colours_[index].b   = val;
-	colours_lab_[index] = colours_[index].asLAB();
 	colours_hsl_[index] = colours_[index].asHSL();
+	clearNearestColourCache();
+}
+
+// -----------------------------------------------------------------------------
+// Sets the colour at [index] without clearing the nearestColour cache, for
+// functions that change multiple colours (which clear it once when done)
+// -----------------------------------------------------------------------------
+void Palette::updateColour(uint8_t index, const ColRGBA& col)
+{
+	colours_[index].set(col);
+	colours_[index].index = index;
+	colours_hsl_[index]   = colours_[index].asHSL();
 }
 
 // -----------------------------------------------------------------------------
@@ -525,8 +587,9 @@ void Palette::setGradient(uint8_t startIndex, uint8_t endIndex, const ColRGBA& s
 			255,
 			-1,
 			a + startIndex);
-		colours_[a + startIndex].set(gradCol);
+		updateColour(a + startIndex, gradCol);
 	}
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -539,7 +602,8 @@ void Palette::copyPalette(const Palette* copy)
 
 	unsigned n_copy = std::min(colours_.size(), copy->colours_.size());
 	for (unsigned a = 0; a < n_copy; a++)
-		setColour(a, copy->colour(a));
+		updateColour(a, copy->colour(a));
+	clearNearestColourCache();
 
 	index_trans_ = copy->transIndex();
 }
@@ -562,10 +626,17 @@ short Palette::findColour(const ColRGBA& colour)
 // -----------------------------------------------------------------------------
 // Returns the difference between the given colour [rgb]/[hsl]/[lab] and the
 // palette colour at [index], using the colour matching method specified in
-// [match]
+// [match] with the settings and palette L*a*b* values in [cache]
 // -----------------------------------------------------------------------------
-double Palette::colourDiff(const ColRGBA& rgb, const ColHSL& hsl, const ColLAB& lab, int index, ColourMatch match)
+double Palette::colourDiff(
+	const ColRGBA&            rgb,
+	const ColHSL&             hsl,
+	const ColLAB&             lab,
+	int                       index,
+	ColourMatch               match,
+	const NearestColourCache& cache) const
 {
+	const auto& weights = cache.settings;
 	double d1, d2, d3;
 	switch (match)
 	{
@@ -579,9 +650,9 @@ double Palette::colourDiff(const ColRGBA& rgb, const ColHSL& hsl, const ColLAB&
 		d1 = rgb.dr() - colours_[index].dr();
 		d2 = rgb.dg() - colours_[index].dg();
 		d3 = rgb.db() - colours_[index].db();
-		d1 *= col_match_r;
-		d2 *= col_match_g;
-		d3 *= col_match_b;
+		d1 *= weights[0];
+		d2 *= weights[1];
+		d3 *= weights[2];
 		break;
 	case ColourMatch::HSL:
 		d1 = hsl.h - colours_hsl_[index].h;
@@ -592,27 +663,24 @@ double Palette::colourDiff(const ColRGBA& rgb, const ColHSL& hsl, const ColLAB&
 			d1 += 1.0;
 		d2 = hsl.s - colours_hsl_[index].s;
 		d3 = hsl.l - colours_hsl_[index].l;
-		d1 *= col_match_h;
-		d2 *= col_match_s;
-		d3 *= col_match_l;
+		d1 *= weights[0];
+		d2 *= weights[1];
+		d3 *= weights[2];
 		break;
-	case ColourMatch::C76: return cie::CIE76(lab, colours_lab_[index]);
-	case ColourMatch::C94: return cie::CIE94(lab, colours_lab_[index]);
-	case ColourMatch::C2K: return cie::CIEDE2000(lab, colours_lab_[index]);
+	case ColourMatch::C76: return cie::CIE76(lab, cache.lab[index]);
+	case ColourMatch::C94: return cie::CIE94(lab, cache.lab[index]);
+	case ColourMatch::C2K: return cie::CIEDE2000(lab, cache.lab[index]);
 	}
 	return (d1 * d1) + (d2 * d2) + (d3 * d3);
 }
 
 // -----------------------------------------------------------------------------
-// Returns the index of the closest colour in the palette to [colour]
+// Returns the index of the closest colour in the palette to [colour].
+// Results are cached per colour match method, so matching the same colour
+// again (eg. for each pixel of an image) is much quicker
 // -----------------------------------------------------------------------------
 short Palette::nearestColour(const ColRGBA& colour, ColourMatch match)
 {
-	double min_d = 999999;
-	short  index = 0;
-	ColHSL chsl  = colour.asHSL();
-	ColLAB clab  = colour.asLAB();
-
 	// Be nice if there was an easier way to convert from int -> enum class,
 	// but then that's kind of the point of them I guess
 	static vector<ColourMatch> cm_convert = {
@@ -622,10 +690,37 @@ short Palette::nearestColour(const ColRGBA& colour, ColourMatch match)
 	if (match == ColourMatch::Default)
 		match = cm_convert[col_match];
 
+	// Check the cache
+	const uint32_t rgb    = (colour.r << 16) | (colour.g << 8) | colour.b;
+	const auto     cache  = nearestColourCache(match);
+	auto&          slot   = cache->slot(rgb);
+	const auto     cached = slot.load(std::memory_order_relaxed);
+	if ((cached >> 8) == ((NearestColourCache::VALID | (uint64_t{ rgb } << 8)) >> 8))
+		return static_cast<short>(cached & 0xFF);
+
+	// Not cached, search the palette
+	const auto index = findNearestColour(colour, match, *cache);
+	slot.store(NearestColourCache::VALID | (uint64_t{ rgb } << 8) | (index & 0xFF), std::memory_order_relaxed);
+
+	return index;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the index of the closest colour in the palette to [colour], checking
+// all palette colours using the colour matching method specified in [match]
+// (with the settings from [cache])
+// -----------------------------------------------------------------------------
+short Palette::findNearestColour(const ColRGBA& colour, ColourMatch match, const NearestColourCache& cache) const
+{
+	double min_d = 999999;
+	short  index = 0;
+	ColHSL chsl  = colour.asHSL();
+	ColLAB clab  = colour.asLAB();
+
 	double delta;
 	for (short a = 0; a < 256; a++)
 	{
-		delta = colourDiff(colour, chsl, clab, a, match);
+		delta = colourDiff(colour, chsl, clab, a, match, cache);
 
 		// Exact match?
 		if (delta == 0.0)
@@ -640,6 +735,58 @@ short Palette::nearestColour(const ColRGBA& colour, ColourMatch match)
 	return index;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the nearestColour cache for colour matching method [match], creating
+// it if needed (or if any colour match settings used by [match] have changed
+// since it was)
+// -----------------------------------------------------------------------------
+shared_ptr<Palette::NearestColourCache> Palette::nearestColourCache(ColourMatch match)
+{
+	// The CIE methods compare L*a*b* colours, which depend on the tristimulus
+	// values, using the CIE94/CIEDE2000 weighting factors
+	const bool cie = match == ColourMatch::C76 || match == ColourMatch::C94 || match == ColourMatch::C2K;
+
+	std::array<double, 7> settings = {};
+	if (match == ColourMatch::RGB)
+		settings = { col_match_r, col_match_g, col_match_b };
+	else if (match == ColourMatch::HSL)
+		settings = { col_match_h, col_match_s, col_match_l };
+	else if (cie)
+		settings = { col_cie_tristim_x, col_cie_tristim_z, col_cie_kl, col_cie_k1, col_cie_k2, col_cie_kc, col_cie_kh };
+
+	auto& current = nearest_cache_[static_cast<int>(match)];
+	auto  cache   = std::atomic_load(&current);
+	if (cache && cache->settings == settings)
+		return cache;
+
+	// Convert the palette colours to L*a*b* with the current tristimulus values
+	vector<ColLAB> lab;
+	if (cie)
+	{
+		lab.reserve(colours_.size());
+		for (const auto& colour : colours_)
+			lab.push_back(colour.asLAB());
+	}
+
+	// Create a new cache, unless another thread just did
+	auto created = std::make_shared<NearestColourCache>(settings, std::move(lab));
+	while (!std::atomic_compare_exchange_weak(&current, &cache, created))
+		if (cache && cache->settings == settings)
+			return cache;
+
+	return created;
+}
+
+// -----------------------------------------------------------------------------
+// Clears all cached nearestColour results, called whenever the palette colours
+// change. Any thread still using a previous cache keeps it alive until done
+// -----------------------------------------------------------------------------
+void Palette::clearNearestColourCache()
+{
+	for (auto& cache : nearest_cache_)
+		std::atomic_store(&cache, shared_ptr<NearestColourCache>{});
+}
+
 // -----------------------------------------------------------------------------
 // Returns the number of unique colors in a palette
 // -----------------------------------------------------------------------------
@@ -680,8 +827,9 @@ void Palette::applyTranslation(Translation* trans)
 	temp.copyPalette(this);
 
 	// Translate colors
+	const CompiledTranslation compiled(*trans, this);
 	for (size_t i = 0; i < 256; ++i)
-		temp.setColour(i, trans->translate(colours_[i], this));
+		temp.updateColour(i, compiled.colour(i));
 
 	// Load translated palette
 	copyPalette(&temp);
@@ -708,8 +856,9 @@ void Palette::colourise(const ColRGBA& colour, int start, int end)
 		ncol.r = (uint8_t)(colour.r * grey);
 		ncol.g = (uint8_t)(colour.g * grey);
 		ncol.b = (uint8_t)(colour.b * grey);
-		setColour(i, ncol);
+		updateColour(i, ncol);
 	}
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -742,8 +891,9 @@ void Palette::tint(const ColRGBA& colour, float amount, int start, int end)
 			colours_[i].g * inv_amt + colour.g * amount + round_delta,
 			colours_[i].b * inv_amt + colour.b * amount + round_delta,
 			colours_[i].a);
-		setColour(i, ncol);
+		updateColour(i, ncol);
 	}
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -778,8 +928,9 @@ void Palette::idtint(int r, int g, int b, int shift, int steps)
 			fb = 255;
 		// Set the result in the palette
 		ColRGBA col(fr, fg, fb, colours_[i].a, i);
-		setColour(i, col);
+		updateColour(i, col);
 	}
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -805,9 +956,9 @@ void Palette::saturate(float amount, int start, int end)
 		colours_hsl_[i].s *= amount;
 		if (colours_hsl_[i].s > 1.)
 			colours_hsl_[i].s = 1.;
-		colours_[i]     = colours_hsl_[i].asRGB();
-		colours_lab_[i] = colours_[i].asLAB();
+		colours_[i] = colours_hsl_[i].asRGB();
 	}
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -833,9 +984,9 @@ void Palette::illuminate(float amount, int start, int end)
 		colours_hsl_[i].l *= amount;
 		if (colours_hsl_[i].l > 1.)
 			colours_hsl_[i].l = 1.;
-		colours_[i]     = colours_hsl_[i].asRGB();
-		colours_lab_[i] = colours_[i].asLAB();
+		colours_[i] = colours_hsl_[i].asRGB();
 	}
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -861,9 +1012,9 @@ void Palette::shift(float amount, int start, int end)
 		colours_hsl_[i].h += amount;
 		if (colours_hsl_[i].h >= 1.)
 			colours_hsl_[i].h -= 1.;
-		colours_[i]     = colours_hsl_[i].asRGB();
-		colours_lab_[i] = colours_[i].asLAB();
+		colours_[i] = colours_hsl_[i].asRGB();
 	}
+	clearNearestColourCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -883,6 +1034,95 @@ void Palette::invert(int start, int end)
 		colours_[i].r = 255 - colours_[i].r;
 		colours_[i].g = 255 - colours_[i].g;
 		colours_[i].b = 255 - colours_[i].b;
-		setColour(i, colours_[i]); // Just to update the HSL values
+		updateColour(i, colours_[i]); // Just to update the HSL values
+	}
+	clearNearestColourCache();
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+#include "General/Console.h"
+
+// -----------------------------------------------------------------------------
+// Tests that cached nearest colour matches are redone when a colour match
+// setting changes. For each colour match method, the nearest colours to a grid
+// of colours are cached, then a setting is changed and the nearest colours are
+// compared against a copy of the palette with nothing cached, which has to
+// search all palette colours for each one
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_nearest_colour, 0, false)
+{
+	// Fill a palette with pseudo-random colours
+	Palette  palette;
+	uint32_t seed = 1;
+	for (unsigned a = 0; a < 256; ++a)
+	{
+		seed = seed * 1664525 + 1013904223;
+		const auto r = static_cast<uint8_t>(seed >> 24);
+		const auto g = static_cast<uint8_t>(seed >> 16);
+		const auto b = static_cast<uint8_t>(seed >> 8);
+		palette.setColour(a, { r, g, b });
 	}
+
+	// Colours to match
+	vector<ColRGBA> colours;
+	for (int r = 0; r < 256; r += 17)
+		for (int g = 0; g < 256; g += 17)
+			for (int b = 0; b < 256; b += 17)
+				colours.emplace_back(r, g, b);
+
+	struct SettingTest
+	{
+		string_view          method;
+		Palette::ColourMatch match;
+		CFloatCVar&          cvar;
+		double               value;
+	};
+	const SettingTest tests[] = {
+		{ "RGB", Palette::ColourMatch::RGB, col_match_r, 3.0 },
+		{ "HSL", Palette::ColourMatch::HSL, col_match_h, 3.0 },
+		{ "CIE76", Palette::ColourMatch::C76, col_cie_tristim_x, 109.85 },
+		{ "CIE94", Palette::ColourMatch::C94, col_cie_k1, 0.3 },
+		{ "CIE94", Palette::ColourMatch::C94, col_cie_tristim_z, 35.58 },
+		{ "CIEDE2000", Palette::ColourMatch::C2K, col_cie_kl, 4.0 },
+		{ "CIEDE2000", Palette::ColourMatch::C2K, col_cie_kh, 4.0 },
+	};
+
+	unsigned failed = 0;
+	for (const auto& test : tests)
+	{
+		// Cache matches with the current setting
+		for (const auto& colour : colours)
+			palette.nearestColour(colour, test.match);
+
+		// Change the setting and check the matches
+		const double old_value = test.cvar;
+		test.cvar              = test.value;
+		Palette  uncached{ palette };
+		unsigned mismatches = 0;
+		for (const auto& colour : colours)
+			if (palette.nearestColour(colour, test.match) != uncached.nearestColour(colour, test.match))
+				++mismatches;
+		test.cvar = old_value;
+
+		if (mismatches > 0)
+		{
+			log::console(fmt::format(
+				"{} with {} changed: {} of {} colours matched differently to an uncached palette",
+				test.method,
+				test.cvar.name,
+				mismatches,
+				colours.size()));
+			++failed;
+		}
+	}
+
+	if (failed == 0)
+		log::console(fmt::format("All {} nearest colour tests passed", std::size(tests)));
+	else
+		log::console(fmt::format("{} of {} nearest colour tests failed", failed, std::size(tests)));
 }
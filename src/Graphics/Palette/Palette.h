@@ -1,5 +1,6 @@
 #pragma once
 #include "Utility/Colour.h"
+#include <array>
 
 namespace slade
 {
@@ -30,7 +31,9 @@ public:
 
 	Palette(unsigned size = 256);
 	Palette(const Palette& pal) : Palette(pal.colours_.size()) { copyPalette(&pal); }
-	~Palette() = default;
+	~Palette();
+
+	Palette& operator=(const Palette& pal) = delete;
 
 	const vector<ColRGBA>& colours() const { return colours_; }
 	ColRGBA                colour(uint8_t index) const { return colours_[index]; }
@@ -69,11 +72,28 @@ public:
 	void idtint(int r, int g, int b, int shift, int steps);
 
 private:
+	struct NearestColourCache;
+
 	vector<ColRGBA> colours_;
 	vector<ColHSL>  colours_hsl_;
-	vector<ColLAB>  colours_lab_;
 	short           index_trans_;
 
-	double colourDiff(const ColRGBA& rgb, const ColHSL& hsl, const ColLAB& lab, int index, ColourMatch match);
+	// Cached nearestColour results for each colour match method, only ever
+	// accessed atomically since caches are replaced when the palette changes
+	// (possibly while other threads are still reading from the previous ones)
+	std::array<shared_ptr<NearestColourCache>, static_cast<int>(ColourMatch::Stop) + 1> nearest_cache_;
+
+	void   updateColour(uint8_t index, const ColRGBA& col);
+	double colourDiff(
+		const ColRGBA&            rgb,
+		const ColHSL&             hsl,
+		const ColLAB&             lab,
+		int                       index,
+		ColourMatch               match,
+		const NearestColourCache& cache) const;
+	short findNearestColour(const ColRGBA& colour, ColourMatch match, const NearestColourCache& cache) const;
+
+	shared_ptr<NearestColourCache> nearestColourCache(ColourMatch match);
+	void                           clearNearestColourCache();
 };
 } // namespace slade
@@ -0,0 +1,856 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2022 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         https://slade.mancubus.net
+// Filename:    PngOptimizer.cpp
+// Description: Lossless in-process PNG optimizer, used instead of running
+//              external tools (PNGCrush, PNGOut, DeflOpt) on exported files
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "PngOptimizer.h"
+#include "General/Misc.h"
+#include "Graphics/SImage/SIFormat.h"
+#include "Utility/Compression.h"
+#include "Utility/Memory.h"
+#include "Utility/ThreadPool.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+const uint8_t png_signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+enum class ColourType : uint8_t
+{
+	Grey      = 0,
+	RGB       = 2,
+	Palette   = 3,
+	GreyAlpha = 4,
+	RGBA      = 6
+};
+
+// Adam7 interlacing passes (start x/y, step x/y)
+struct InterlacePass
+{
+	unsigned x, y, dx, dy;
+};
+const InterlacePass adam7_passes[7] = { { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 },
+										{ 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+const InterlacePass no_interlace     = { 0, 0, 1, 1 };
+
+// Filter modes to try: the five PNG filter types, or the best per row
+constexpr int filter_adaptive = 5;
+constexpr int num_filters     = 6;
+
+const compression::DeflateStrategy deflate_strategies[] = { compression::DeflateStrategy::Default,
+															compression::DeflateStrategy::Filtered,
+															compression::DeflateStrategy::RLE };
+constexpr int                      num_strategies       = 3;
+
+// Largest images that will be decoded. Samples are unpacked to 16 bits each, so
+// this keeps each decode (one per pool worker) to ~128MB at most
+constexpr unsigned max_dimension = 16384;
+constexpr size_t   max_pixels    = 4096 * 4096;
+
+// The best compression ratio deflate can achieve (~1032:1), used to reject
+// image data that can't possibly inflate to the size given by IHDR
+constexpr size_t max_deflate_ratio = 1032;
+
+const char* filter_names[]   = { "none", "sub", "up", "average", "paeth", "adaptive" };
+const char* strategy_names[] = { "default", "filtered", "rle" };
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// A chunk within the source PNG data
+struct Chunk
+{
+	string         name;
+	const uint8_t* data;
+	uint32_t       size;
+};
+
+// A decoded PNG image, with each sample unpacked to its own value
+struct Image
+{
+	unsigned         width       = 0;
+	unsigned         height      = 0;
+	uint8_t          bit_depth   = 0;
+	ColourType       colour_type = ColourType::RGBA;
+	vector<uint16_t> samples;
+	vector<uint8_t>  palette; // PLTE chunk data
+	vector<uint8_t>  trns;    // tRNS chunk data
+
+	unsigned samplesPerPixel() const
+	{
+		switch (colour_type)
+		{
+		case ColourType::RGB: return 3;
+		case ColourType::GreyAlpha: return 2;
+		case ColourType::RGBA: return 4;
+		default: return 1;
+		}
+	}
+
+	size_t   rowBytes(unsigned row_width) const { return (row_width * samplesPerPixel() * bit_depth + 7) / 8; }
+	unsigned pixelBytes() const { return std::max(1u, samplesPerPixel() * bit_depth / 8); }
+};
+
+// -----------------------------------------------------------------------------
+// Returns true if [bit_depth] is valid for [colour_type]
+// -----------------------------------------------------------------------------
+bool validFormat(ColourType colour_type, uint8_t bit_depth)
+{
+	switch (colour_type)
+	{
+	case ColourType::Grey:
+		return bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8 || bit_depth == 16;
+	case ColourType::Palette: return bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8;
+	case ColourType::RGB:
+	case ColourType::GreyAlpha:
+	case ColourType::RGBA: return bit_depth == 8 || bit_depth == 16;
+	default: return false;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if SLADE loads PNGs of [colour_type] and [bit_depth] as paletted
+// images. FreeImage has no 2bpp bitmaps, so 2bit paletted and greyscale PNGs
+// are loaded as 8bpp with a palette like 8bit ones. Everything else is loaded
+// as RGBA
+// -----------------------------------------------------------------------------
+bool loadsAsPaletted(ColourType colour_type, uint8_t bit_depth)
+{
+	return (colour_type == ColourType::Grey || colour_type == ColourType::Palette)
+		   && (bit_depth == 2 || bit_depth == 8);
+}
+
+// -----------------------------------------------------------------------------
+// Returns a description of the colour type and bit depth of [image]
+// -----------------------------------------------------------------------------
+string formatName(const Image& image)
+{
+	switch (image.colour_type)
+	{
+	case ColourType::Grey: return fmt::format("greyscale {}bit", image.bit_depth);
+	case ColourType::RGB: return fmt::format("RGB {}bit", image.bit_depth);
+	case ColourType::Palette: return fmt::format("paletted {}bit", image.bit_depth);
+	case ColourType::GreyAlpha: return fmt::format("greyscale+alpha {}bit", image.bit_depth);
+	default: return fmt::format("RGBA {}bit", image.bit_depth);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of pixels in a row/column of [size] pixels that are part
+// of an interlace pass starting at [start] with [step]
+// -----------------------------------------------------------------------------
+unsigned passSize(unsigned size, unsigned start, unsigned step)
+{
+	return size > start ? (size - start + step - 1) / step : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Reads all chunks from [png] into [chunks].
+// Returns false if [png] isn't valid PNG data
+// -----------------------------------------------------------------------------
+bool readChunks(const MemChunk& png, vector<Chunk>& chunks)
+{
+	if (png.size() < 8 || memcmp(png.data(), png_signature, 8) != 0)
+		return false;
+
+	size_t pos = 8;
+	while (pos + 12 <= png.size())
+	{
+		const auto size = memory::readB32(png.data(), pos);
+		if (size > png.size() - pos - 12)
+			return false;
+
+		const auto name = reinterpret_cast<const char*>(png.data() + pos + 4);
+		chunks.push_back({ string(name, 4), png.data() + pos + 8, size });
+		pos += size + 12;
+
+		if (chunks.back().name == "IEND")
+			return true;
+	}
+
+	// No IEND chunk
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the Paeth predictor for [a] (left), [b] (above) and [c] (above left)
+// -----------------------------------------------------------------------------
+uint8_t paeth(int a, int b, int c)
+{
+	const int p  = a + b - c;
+	const int pa = std::abs(p - a);
+	const int pb = std::abs(p - b);
+	const int pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return static_cast<uint8_t>(a);
+	return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+// -----------------------------------------------------------------------------
+// Reverses the PNG filtering of [height] rows of [row_bytes] bytes in [data]
+// (each row starts with its filter type byte), in place
+// -----------------------------------------------------------------------------
+bool unfilterRows(uint8_t* data, unsigned height, size_t row_bytes, unsigned pixel_bytes)
+{
+	const uint8_t* prev = nullptr;
+	for (unsigned y = 0; y < height; ++y)
+	{
+		const auto filter = data[0];
+		auto       row    = data + 1;
+		if (filter > 4)
+			return false;
+
+		for (size_t x = 0; x < row_bytes; ++x)
+		{
+			const int a = x >= pixel_bytes ? row[x - pixel_bytes] : 0;
+			const int b = prev ? prev[x] : 0;
+			const int c = prev && x >= pixel_bytes ? prev[x - pixel_bytes] : 0;
+
+			switch (filter)
+			{
+			case 1: row[x] = static_cast<uint8_t>(row[x] + a); break;
+			case 2: row[x] = static_cast<uint8_t>(row[x] + b); break;
+			case 3: row[x] = static_cast<uint8_t>(row[x] + (a + b) / 2); break;
+			case 4: row[x] = static_cast<uint8_t>(row[x] + paeth(a, b, c)); break;
+			default: break;
+			}
+		}
+
+		prev = row;
+		data += row_bytes + 1;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Applies PNG [filter] type to [row] (with [prev] being the row above, or
+// nullptr for the first row), writing the filtered bytes to [out]
+// -----------------------------------------------------------------------------
+void filterRow(
+	int            filter,
+	const uint8_t* row,
+	const uint8_t* prev,
+	size_t         row_bytes,
+	unsigned       pixel_bytes,
+	uint8_t*       out)
+{
+	for (size_t x = 0; x < row_bytes; ++x)
+	{
+		const int a = x >= pixel_bytes ? row[x - pixel_bytes] : 0;
+		const int b = prev ? prev[x] : 0;
+		const int c = prev && x >= pixel_bytes ? prev[x - pixel_bytes] : 0;
+
+		switch (filter)
+		{
+		case 1: out[x] = static_cast<uint8_t>(row[x] - a); break;
+		case 2: out[x] = static_cast<uint8_t>(row[x] - b); break;
+		case 3: out[x] = static_cast<uint8_t>(row[x] - (a + b) / 2); break;
+		case 4: out[x] = static_cast<uint8_t>(row[x] - paeth(a, b, c)); break;
+		default: out[x] = row[x]; break;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Filters [height] unfiltered rows of [row_bytes] bytes in [rows] with filter
+// [mode], writing the result (with filter type bytes) to [out].
+// The adaptive mode picks the filter with the lowest sum of absolute
+// differences for each row
+// -----------------------------------------------------------------------------
+void filterRows(
+	const vector<uint8_t>& rows,
+	unsigned               height,
+	size_t                 row_bytes,
+	unsigned               pixel_bytes,
+	int                    mode,
+	vector<uint8_t>&       out)
+{
+	out.resize(height * (row_bytes + 1));
+	vector<uint8_t> candidate(mode == filter_adaptive ? row_bytes : 0);
+
+	for (unsigned y = 0; y < height; ++y)
+	{
+		const auto row  = rows.data() + y * row_bytes;
+		const auto prev = y > 0 ? row - row_bytes : nullptr;
+		const auto dest = out.data() + y * (row_bytes + 1);
+
+		if (mode != filter_adaptive)
+		{
+			dest[0] = static_cast<uint8_t>(mode);
+			filterRow(mode, row, prev, row_bytes, pixel_bytes, dest + 1);
+			continue;
+		}
+
+		size_t best_sum = std::numeric_limits<size_t>::max();
+		for (int filter = 0; filter < 5; ++filter)
+		{
+			filterRow(filter, row, prev, row_bytes, pixel_bytes, candidate.data());
+
+			size_t sum = 0;
+			for (auto value : candidate)
+				sum += std::abs(static_cast<int8_t>(value));
+
+			if (sum < best_sum)
+			{
+				best_sum = sum;
+				dest[0]  = static_cast<uint8_t>(filter);
+				memcpy(dest + 1, candidate.data(), row_bytes);
+			}
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Unpacks [count] samples of [bit_depth] from [row] to [out]
+// -----------------------------------------------------------------------------
+void unpackRow(const uint8_t* row, unsigned count, uint8_t bit_depth, uint16_t* out)
+{
+	if (bit_depth == 16)
+	{
+		for (unsigned a = 0; a < count; ++a)
+			out[a] = memory::readB16(row, a * 2);
+	}
+	else if (bit_depth == 8)
+	{
+		for (unsigned a = 0; a < count; ++a)
+			out[a] = row[a];
+	}
+	else
+	{
+		const unsigned per_byte = 8 / bit_depth;
+		const unsigned mask     = (1 << bit_depth) - 1;
+		for (unsigned a = 0; a < count; ++a)
+			out[a] = (row[a / per_byte] >> (8 - bit_depth * (a % per_byte + 1))) & mask;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Packs [count] samples from [samples] into [out] at [bit_depth]
+// -----------------------------------------------------------------------------
+void packRow(const uint16_t* samples, unsigned count, uint8_t bit_depth, uint8_t* out)
+{
+	if (bit_depth == 16)
+	{
+		for (unsigned a = 0; a < count; ++a)
+		{
+			out[a * 2]     = samples[a] >> 8;
+			out[a * 2 + 1] = samples[a] & 0xFF;
+		}
+	}
+	else if (bit_depth == 8)
+	{
+		for (unsigned a = 0; a < count; ++a)
+			out[a] = static_cast<uint8_t>(samples[a]);
+	}
+	else
+	{
+		const unsigned per_byte = 8 / bit_depth;
+		memset(out, 0, (count + per_byte - 1) / per_byte);
+		for (unsigned a = 0; a < count; ++a)
+			out[a / per_byte] |= samples[a] << (8 - bit_depth * (a % per_byte + 1));
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the PNG image made up of [chunks] into [image].
+// Returns false if the image is invalid, unsupported or too large to decode
+// -----------------------------------------------------------------------------
+bool decode(const vector<Chunk>& chunks, Image& image)
+{
+	// Read IHDR (must be the first chunk)
+	if (chunks.empty() || chunks[0].name != "IHDR" || chunks[0].size != 13)
+		return false;
+	const auto ihdr   = chunks[0].data;
+	image.width       = memory::readB32(ihdr, 0);
+	image.height      = memory::readB32(ihdr, 4);
+	image.bit_depth   = ihdr[8];
+	image.colour_type = static_cast<ColourType>(ihdr[9]);
+	if (image.width == 0 || image.height == 0 || image.width > max_dimension || image.height > max_dimension
+		|| static_cast<size_t>(image.width) * image.height > max_pixels)
+		return false;
+	if (!validFormat(image.colour_type, image.bit_depth) || ihdr[10] != 0 || ihdr[11] != 0 || ihdr[12] > 1)
+		return false;
+	const bool interlaced = ihdr[12] == 1;
+
+	// Get palette, transparency and image data
+	vector<uint8_t> idat;
+	for (const auto& chunk : chunks)
+	{
+		if (chunk.name == "PLTE")
+			image.palette.assign(chunk.data, chunk.data + chunk.size);
+		else if (chunk.name == "tRNS")
+			image.trns.assign(chunk.data, chunk.data + chunk.size);
+		else if (chunk.name == "IDAT")
+			idat.insert(idat.end(), chunk.data, chunk.data + chunk.size);
+	}
+	if (image.colour_type == ColourType::Palette && image.palette.empty())
+		return false;
+
+	// Inflate image data
+	const auto passes     = interlaced ? adam7_passes : &no_interlace;
+	const auto num_passes = interlaced ? 7 : 1;
+	size_t     raw_size   = 0;
+	for (int p = 0; p < num_passes; ++p)
+	{
+		const auto pass_width  = passSize(image.width, passes[p].x, passes[p].dx);
+		const auto pass_height = passSize(image.height, passes[p].y, passes[p].dy);
+		if (pass_width > 0 && pass_height > 0)
+			raw_size += pass_height * (image.rowBytes(pass_width) + 1);
+	}
+	if (raw_size > idat.size() * max_deflate_ratio)
+		return false;
+	vector<uint8_t> raw(raw_size);
+	if (!compression::zlibInflate(idat.data(), idat.size(), raw.data(), raw.size()))
+		return false;
+
+	// Unfilter and unpack each pass
+	const auto       spp = image.samplesPerPixel();
+	vector<uint16_t> row_samples(image.width * spp);
+	auto             pos = raw.data();
+	image.samples.resize(static_cast<size_t>(image.width) * image.height * spp);
+	for (int p = 0; p < num_passes; ++p)
+	{
+		const auto& pass        = passes[p];
+		const auto  pass_width  = passSize(image.width, pass.x, pass.dx);
+		const auto  pass_height = passSize(image.height, pass.y, pass.dy);
+		if (pass_width == 0 || pass_height == 0)
+			continue;
+
+		const auto row_bytes = image.rowBytes(pass_width);
+		if (!unfilterRows(pos, pass_height, row_bytes, image.pixelBytes()))
+			return false;
+
+		for (unsigned y = 0; y < pass_height; ++y)
+		{
+			unpackRow(pos + y * (row_bytes + 1) + 1, pass_width * spp, image.bit_depth, row_samples.data());
+
+			auto dest = image.samples.data() + (static_cast<size_t>(pass.y + y * pass.dy) * image.width + pass.x) * spp;
+			for (unsigned x = 0; x < pass_width; ++x)
+				memcpy(dest + x * pass.dx * spp, row_samples.data() + x * spp, spp * sizeof(uint16_t));
+		}
+
+		pos += pass_height * (row_bytes + 1);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Converts [image] to 8bit RGBA pixels in [rgba].
+// Returns false if this would lose information (16bit samples that can't be
+// reduced to 8bit) or [image] contains invalid palette indices
+// -----------------------------------------------------------------------------
+bool toRGBA(const Image& image, vector<uint8_t>& rgba)
+{
+	// 16bit samples can only be reduced if both bytes are the same
+	if (image.bit_depth == 16)
+		for (auto sample : image.samples)
+			if ((sample >> 8) != (sample & 0xFF))
+				return false;
+
+	const auto to8bit = [&image](uint16_t value) -> uint8_t
+	{
+		if (image.bit_depth == 16)
+			return value >> 8;
+		if (image.bit_depth == 8)
+			return static_cast<uint8_t>(value);
+		return value * 255 / ((1 << image.bit_depth) - 1);
+	};
+
+	// Get tRNS colour key (greyscale and RGB)
+	const bool has_key = (image.colour_type == ColourType::Grey && image.trns.size() >= 2)
+						 || (image.colour_type == ColourType::RGB && image.trns.size() >= 6);
+	uint16_t   key[3]  = { 0, 0, 0 };
+	for (unsigned a = 0; has_key && a < image.trns.size() / 2 && a < 3; ++a)
+		key[a] = memory::readB16(image.trns.data(), a * 2);
+
+	const auto count = static_cast<size_t>(image.width) * image.height;
+	const auto spp   = image.samplesPerPixel();
+	rgba.resize(count * 4);
+	for (size_t a = 0; a < count; ++a)
+	{
+		const auto sample = image.samples.data() + a * spp;
+		const auto pixel  = rgba.data() + a * 4;
+
+		switch (image.colour_type)
+		{
+		case ColourType::Grey:
+			pixel[0] = pixel[1] = pixel[2] = to8bit(sample[0]);
+			pixel[3]                       = has_key && sample[0] == key[0] ? 0 : 255;
+			break;
+		case ColourType::RGB:
+			pixel[0] = to8bit(sample[0]);
+			pixel[1] = to8bit(sample[1]);
+			pixel[2] = to8bit(sample[2]);
+			pixel[3] = has_key && sample[0] == key[0] && sample[1] == key[1] && sample[2] == key[2] ? 0 : 255;
+			break;
+		case ColourType::Palette:
+			if (sample[0] * 3u + 2 >= image.palette.size())
+				return false;
+			pixel[0] = image.palette[sample[0] * 3];
+			pixel[1] = image.palette[sample[0] * 3 + 1];
+			pixel[2] = image.palette[sample[0] * 3 + 2];
+			pixel[3] = sample[0] < image.trns.size() ? image.trns[sample[0]] : 255;
+			break;
+		case ColourType::GreyAlpha:
+			pixel[0] = pixel[1] = pixel[2] = to8bit(sample[0]);
+			pixel[3]                       = to8bit(sample[1]);
+			break;
+		default:
+			pixel[0] = to8bit(sample[0]);
+			pixel[1] = to8bit(sample[1]);
+			pixel[2] = to8bit(sample[2]);
+			pixel[3] = to8bit(sample[3]);
+			break;
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the smallest lossless representation of the [width]x[height] 8bit
+// RGBA pixels in [rgba] that SLADE will still load as an RGBA image.
+// Greyscale and paletted formats that are loaded as paletted images (see
+// loadsAsPaletted) aren't considered here
+// -----------------------------------------------------------------------------
+Image reduce(const vector<uint8_t>& rgba, unsigned width, unsigned height)
+{
+	const auto count  = static_cast<size_t>(width) * height;
+	bool       opaque = true;
+	bool       grey   = true;
+	for (size_t a = 0; a < count * 4; a += 4)
+	{
+		opaque = opaque && rgba[a + 3] == 255;
+		grey   = grey && rgba[a] == rgba[a + 1] && rgba[a] == rgba[a + 2];
+	}
+
+	Image image;
+	image.width  = width;
+	image.height = height;
+
+	// Opaque greyscale at 1 or 4 bits
+	if (grey && opaque)
+	{
+		for (uint8_t depth : { 1, 4 })
+		{
+			const unsigned scale = 255 / ((1 << depth) - 1);
+			bool           fits  = true;
+			for (size_t a = 0; a < count * 4 && fits; a += 4)
+				fits = rgba[a] % scale == 0;
+
+			if (fits)
+			{
+				image.colour_type = ColourType::Grey;
+				image.bit_depth   = depth;
+				image.samples.resize(count);
+				for (size_t a = 0; a < count; ++a)
+					image.samples[a] = rgba[a * 4] / scale;
+				return image;
+			}
+		}
+	}
+
+	// Paletted at 1 or 4 bits, if there are few enough colours
+	vector<uint32_t> colours;
+	for (size_t a = 0; a < count * 4 && colours.size() <= 16; a += 4)
+	{
+		uint32_t colour;
+		memcpy(&colour, rgba.data() + a, 4);
+		if (std::find(colours.begin(), colours.end(), colour) == colours.end())
+			colours.push_back(colour);
+	}
+	if (colours.size() <= 16)
+	{
+		// Put translucent colours first so the tRNS chunk is as short as possible
+		const auto alpha = [](uint32_t colour) { return reinterpret_cast<const uint8_t*>(&colour)[3]; };
+		std::stable_partition(colours.begin(), colours.end(), [&](uint32_t c) { return alpha(c) < 255; });
+
+		image.colour_type = ColourType::Palette;
+		image.bit_depth   = colours.size() <= 2 ? 1 : 4;
+		for (auto colour : colours)
+		{
+			const auto bytes = reinterpret_cast<const uint8_t*>(&colour);
+			image.palette.insert(image.palette.end(), bytes, bytes + 3);
+			if (bytes[3] < 255)
+				image.trns.push_back(bytes[3]);
+		}
+
+		image.samples.resize(count);
+		for (size_t a = 0; a < count; ++a)
+		{
+			uint32_t colour;
+			memcpy(&colour, rgba.data() + a * 4, 4);
+			const auto index = std::find(colours.begin(), colours.end(), colour) - colours.begin();
+			image.samples[a] = static_cast<uint16_t>(index);
+		}
+		return image;
+	}
+
+	// Greyscale with alpha
+	if (grey)
+	{
+		image.colour_type = ColourType::GreyAlpha;
+		image.bit_depth   = 8;
+		image.samples.resize(count * 2);
+		for (size_t a = 0; a < count; ++a)
+		{
+			image.samples[a * 2]     = rgba[a * 4];
+			image.samples[a * 2 + 1] = rgba[a * 4 + 3];
+		}
+		return image;
+	}
+
+	// RGB (without alpha if all opaque)
+	image.colour_type = opaque ? ColourType::RGB : ColourType::RGBA;
+	image.bit_depth   = 8;
+	const auto spp    = image.samplesPerPixel();
+	image.samples.resize(count * spp);
+	for (size_t a = 0; a < count; ++a)
+		for (unsigned s = 0; s < spp; ++s)
+			image.samples[a * spp + s] = rgba[a * 4 + s];
+
+	return image;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the PNG data [original] and [optimized] are loaded by SLADE's
+// PNG format as identical images (type, size, offsets and pixels)
+// -----------------------------------------------------------------------------
+bool loadsIdentically(const MemChunk& original, const MemChunk& optimized)
+{
+	auto     format = SIFormat::getFormat("png");
+	MemChunk original_data(original.data(), original.size());
+	MemChunk optimized_data(optimized.data(), optimized.size());
+	SImage   original_image;
+	SImage   optimized_image;
+	if (!format->loadImage(original_image, original_data) || !format->loadImage(optimized_image, optimized_data))
+		return false;
+
+	if (original_image.type() != optimized_image.type() || original_image.width() != optimized_image.width()
+		|| original_image.height() != optimized_image.height() || original_image.offset() != optimized_image.offset())
+		return false;
+
+	const auto paletted = original_image.type() != SImage::Type::RGBA;
+	for (int y = 0; y < original_image.height(); ++y)
+		for (int x = 0; x < original_image.width(); ++x)
+		{
+			if (!original_image.pixelAt(x, y).equals(optimized_image.pixelAt(x, y), true))
+				return false;
+			if (paletted && original_image.pixelIndexAt(x, y) != optimized_image.pixelIndexAt(x, y))
+				return false;
+		}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes a PNG chunk [name] with [size] bytes of [data] to [out]
+// -----------------------------------------------------------------------------
+void writeChunk(MemChunk& out, string_view name, const uint8_t* data, uint32_t size)
+{
+	vector<uint8_t> chunk(size + 4);
+	memcpy(chunk.data(), name.data(), 4);
+	if (size > 0)
+		memcpy(chunk.data() + 4, data, size);
+
+	const uint32_t size_be = wxUINT32_SWAP_ON_LE(size);
+	const uint32_t crc_be  = wxUINT32_SWAP_ON_LE(misc::crc(chunk.data(), chunk.size()));
+	out.write(&size_be, 4);
+	out.write(chunk.data(), chunk.size());
+	out.write(&crc_be, 4);
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// PngOptimizer Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Optimizes the PNG [png_data], writing the result to [out] if it is smaller.
+// The optimized image is decoded and checked against the original before it is
+// accepted, so the result is always pixel-identical
+// -----------------------------------------------------------------------------
+pngoptimizer::Result pngoptimizer::optimize(const MemChunk& png_data, MemChunk& out)
+{
+	Result result;
+	result.size_in = png_data.size();
+
+	// Read source PNG
+	vector<Chunk> chunks;
+	Image         source;
+	if (!readChunks(png_data, chunks) || !decode(chunks, source))
+	{
+		result.error = "Invalid or unsupported PNG data";
+		return result;
+	}
+
+	// Find chunks to keep. Other ancillary chunks are stripped, but unknown
+	// critical chunks mean the image can't be safely rewritten
+	vector<const Chunk*> keep_chunks;
+	bool                 alph = false;
+	for (const auto& chunk : chunks)
+	{
+		if (chunk.name == "grAb" || chunk.name == "alPh")
+		{
+			keep_chunks.push_back(&chunk);
+			alph = alph || chunk.name == "alPh";
+		}
+		else if (
+			chunk.name[0] >= 'A' && chunk.name[0] <= 'Z' && chunk.name != "IHDR" && chunk.name != "PLTE"
+			&& chunk.name != "IDAT" && chunk.name != "IEND")
+		{
+			result.error = fmt::format("Unknown critical chunk {}", chunk.name);
+			return result;
+		}
+	}
+
+	// SLADE loads some paletted and greyscale PNGs as paletted images (or alpha
+	// maps with an alPh chunk), and everything else as RGBA. The format can
+	// only be changed for the latter, and only if it's lossless
+	vector<uint8_t> rgba;
+	const bool      keep_format = alph || loadsAsPaletted(source.colour_type, source.bit_depth)
+							 || !toRGBA(source, rgba);
+	const auto image = keep_format ? source : reduce(rgba, source.width, source.height);
+
+	// Pack image rows (not interlaced)
+	const auto      row_bytes   = image.rowBytes(image.width);
+	const auto      pixel_bytes = image.pixelBytes();
+	const auto      spp         = image.samplesPerPixel();
+	vector<uint8_t> rows(row_bytes * image.height);
+	for (unsigned y = 0; y < image.height; ++y)
+		packRow(
+			image.samples.data() + static_cast<size_t>(y) * image.width * spp,
+			image.width * spp,
+			image.bit_depth,
+			rows.data() + y * row_bytes);
+
+	// Filter and compress with each combination of filter mode and zlib
+	// strategy in parallel
+	vector<vector<uint8_t>> filtered(num_filters);
+	ThreadPool::global().parallelFor(
+		num_filters,
+		[&](size_t filter) { filterRows(rows, image.height, row_bytes, pixel_bytes, filter, filtered[filter]); });
+
+	vector<MemChunk> compressed(num_filters * num_strategies);
+	ThreadPool::global().parallelFor(
+		compressed.size(),
+		[&](size_t index)
+		{
+			const auto& data = filtered[index / num_strategies];
+			if (!compression::zlibDeflate(
+					data.data(), data.size(), compressed[index], 9, deflate_strategies[index % num_strategies]))
+				compressed[index].clear();
+		});
+
+	size_t best = 0;
+	for (size_t a = 0; a < compressed.size(); ++a)
+		if (compressed[a].size() > 0
+			&& (compressed[best].size() == 0 || compressed[a].size() < compressed[best].size()))
+			best = a;
+	if (compressed[best].size() == 0)
+	{
+		result.error = "Compression failed";
+		return result;
+	}
+
+	// Write PNG
+	MemChunk       png;
+	uint8_t        ihdr[13] = {};
+	const uint32_t width_be  = wxUINT32_SWAP_ON_LE(image.width);
+	const uint32_t height_be = wxUINT32_SWAP_ON_LE(image.height);
+	memcpy(ihdr, &width_be, 4);
+	memcpy(ihdr + 4, &height_be, 4);
+	ihdr[8] = image.bit_depth;
+	ihdr[9] = static_cast<uint8_t>(image.colour_type);
+	png.write(png_signature, 8);
+	writeChunk(png, "IHDR", ihdr, 13);
+	for (auto chunk : keep_chunks)
+		writeChunk(png, chunk->name, chunk->data, chunk->size);
+	if (!image.palette.empty() && image.colour_type == ColourType::Palette)
+		writeChunk(png, "PLTE", image.palette.data(), image.palette.size());
+	if (!image.trns.empty())
+		writeChunk(png, "tRNS", image.trns.data(), image.trns.size());
+	writeChunk(png, "IDAT", compressed[best].data(), compressed[best].size());
+	writeChunk(png, "IEND", nullptr, 0);
+
+	result.size_out = png.size();
+	result.method   = fmt::format(
+		"{}, {} filter, {} strategy",
+		formatName(image),
+		filter_names[best / num_strategies],
+		strategy_names[best % num_strategies]);
+
+	if (png.size() >= png_data.size())
+		return result;
+
+	// Check the optimized image is identical to the original, both decoded here
+	// and as loaded by SLADE
+	vector<Chunk> check_chunks;
+	Image         check;
+	bool          identical = readChunks(png, check_chunks) && decode(check_chunks, check);
+	if (identical && keep_format)
+		identical = check.samples == source.samples && check.trns == source.trns
+					&& (source.colour_type != ColourType::Palette || check.palette == source.palette);
+	else if (identical)
+	{
+		vector<uint8_t> check_rgba;
+		identical = toRGBA(check, check_rgba) && check_rgba == rgba;
+	}
+	identical = identical && loadsIdentically(png_data, png);
+	if (!identical)
+	{
+		result.error = "Optimized image doesn't match the original";
+		return result;
+	}
+
+	out.importMem(png.data(), png.size());
+	result.optimized = true;
+	return result;
+}
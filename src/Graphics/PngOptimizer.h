@@ -0,0 +1,23 @@
+#pragma once
+
+namespace slade
+{
+// Lossless in-process PNG optimizer.
+// Reduces the colour type and bit depth where this doesn't change how SLADE
+// loads the image, strips ancillary chunks SLADE doesn't use and recompresses
+// the image data with several filter and zlib strategy combinations (in
+// parallel), keeping the smallest result. grAb and alPh chunks are preserved
+namespace pngoptimizer
+{
+	struct Result
+	{
+		bool     optimized = false;
+		unsigned size_in   = 0;
+		unsigned size_out  = 0;
+		string   method; // Output format, filter and zlib strategy used
+		string   error;
+	};
+
+	Result optimize(const MemChunk& png_data, MemChunk& out);
+} // namespace pngoptimizer
+} // namespace slade
@@ -2,16 +2,13 @@
 class SIFPlanar : public SIFormat
 {
 public:
-	SIFPlanar() : SIFormat("planar", "Planar", "lmp", 240) {}
+	SIFPlanar() : SIFormat("planar", "Planar", "lmp", 240) { sizes_ = { 153648 }; }
 	~SIFPlanar() = default;
 
 	bool isThisFormat(MemChunk& mc) override
 	{
 		// Can only go by image size
-		if (mc.size() == 153648)
-			return true;
-		else
-			return false;
+		return matchesSignature(mc);
 	}
 
 	SImage::Info info(MemChunk& mc, int index) override
@@ -241,13 +238,13 @@ protected:
 class SIF4BitChunk : public SIFormat
 {
 public:
-	SIF4BitChunk() : SIFormat("4bit", "4-bit", "lmp", 80) {}
+	SIF4BitChunk() : SIFormat("4bit", "4-bit", "lmp", 80) { sizes_ = { 32, 184 }; }
 	~SIF4BitChunk() = default;
 
 	bool isThisFormat(MemChunk& mc) override
 	{
 		// Can only detect by size
-		return (mc.size() == 32 || mc.size() == 184);
+		return matchesSignature(mc);
 	}
 
 	SImage::Info info(MemChunk& mc, int index) override
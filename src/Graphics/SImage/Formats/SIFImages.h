@@ -77,7 +77,7 @@ private:
 class SIFPng : public SIFormat
 {
 public:
-	SIFPng() : SIFormat("png", "PNG", "png") {}
+	SIFPng() : SIFormat("png", "PNG", "png") { magic_ = "\x89PNG\r\n\x1A\n"; }
 
 	bool isThisFormat(MemChunk& mc) override
 	{
@@ -121,7 +121,7 @@ private:
 class SIFQuakeSprite : public SIFormat
 {
 public:
-	SIFQuakeSprite() : SIFormat("qspr", "Quake Sprite", "dat") {}
+	SIFQuakeSprite() : SIFormat("qspr", "Quake Sprite", "dat") { magic_ = "IDSP"; }
 	~SIFQuakeSprite() = default;
 
 	bool isThisFormat(MemChunk& mc) override { return EntryDataFormat::format("img_qspr")->isThisFormat(mc); }
@@ -343,10 +343,10 @@ protected:
 class SIFRottWall : public SIFormat
 {
 public:
-	SIFRottWall() : SIFormat("rottwall", "ROTT Flat", "dat", 10) {}
+	SIFRottWall() : SIFormat("rottwall", "ROTT Flat", "dat", 10) { sizes_ = { 4096, 51200 }; }
 	~SIFRottWall() = default;
 
-	bool isThisFormat(MemChunk& mc) override { return (mc.size() == 4096 || mc.size() == 51200); }
+	bool isThisFormat(MemChunk& mc) override { return matchesSignature(mc); }
 
 	SImage::Info info(MemChunk& mc, int index) override
 	{
@@ -2,7 +2,7 @@
 class SIFImgz : public SIFormat
 {
 public:
-	SIFImgz() : SIFormat("imgz", "IMGZ", "imgz") {}
+	SIFImgz() : SIFormat("imgz", "IMGZ", "imgz") { magic_ = "IMGZ"; }
 	~SIFImgz() = default;
 
 	bool isThisFormat(MemChunk& mc) override { return EntryDataFormat::format("img_imgz")->isThisFormat(mc); }
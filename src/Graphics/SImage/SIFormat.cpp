@@ -35,7 +35,9 @@
 #include "Archive/Archive.h"
 #include "Archive/EntryType/EntryType.h"
 #include "General/Misc.h"
+#include "MainEditor/MainEditor.h"
 #include "SIFormat.h"
+#include <mutex>
 
 using namespace slade;
 
@@ -52,6 +54,19 @@ SIFormat*         sif_raw     = nullptr;
 SIFormat*         sif_flat    = nullptr;
 SIFormat*         sif_general = nullptr;
 SIFormat*         sif_unknown = nullptr;
+vector<SIFormat*> magic_formats; // Formats with a magic signature, checked first
+
+// Per-entry detection results, valid until the entry data changes
+struct DetectedFormat
+{
+	weak_ptr<ArchiveEntry> entry_ref; // To detect a different entry at the same address
+	uint32_t               data_version;
+	string                 type_hint;
+	SIFormat*              format;
+};
+std::unordered_map<ArchiveEntry*, DetectedFormat> detected_formats;
+std::mutex                                        detected_formats_mutex;
+size_t                                            detected_formats_prune = 8192; // Size to remove expired results at
 } // namespace
 
 
@@ -78,6 +93,38 @@ EXTERN_CVAR(Bool, gfx_extraconv)
 #include "Formats/SIFZDoom.h"
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Determines the format of the image data in [mc] by checking every registered
+// format in order. This was the original detection method, it's kept to verify
+// the results of SIFormat::determineFormat
+// -----------------------------------------------------------------------------
+SIFormat* determineFormatLinear(MemChunk& mc)
+{
+	SIFormat* format = sif_unknown;
+	for (auto& simage_format : simage_formats)
+	{
+		if (simage_format->reliability() < format->reliability())
+			continue;
+
+		if (simage_format->isThisFormat(mc))
+			format = simage_format;
+
+		if (format->reliability() == 255)
+			break;
+	}
+
+	return format;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 // SIFUnknown Class
 //
@@ -111,7 +158,7 @@ public:
 
 	bool isThisFormat(MemChunk& mc) override
 	{
-		auto mem = FreeImage_OpenMemory((BYTE*)mc.data(), mc.size());
+		auto mem = FreeImage_OpenMemory((BYTE*)std::as_const(mc).data(), mc.size());
 		auto fif = FreeImage_GetFileTypeFromMemory(mem, 0);
 		FreeImage_CloseMemory(mem);
 		return fif != FIF_UNKNOWN;
@@ -495,6 +542,22 @@ SIFormat::SIFormat(string_view id, string_view name, string_view ext, uint8_t re
 	simage_formats.push_back(this);
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if [mc] matches the quick detection signature (magic bytes
+// and/or exact sizes) of this format. Formats without a signature always match
+// -----------------------------------------------------------------------------
+bool SIFormat::matchesSignature(const MemChunk& mc) const
+{
+	if (!magic_.empty()
+		&& (mc.size() < magic_.size() || memcmp(mc.data(), magic_.data(), magic_.size()) != 0))
+		return false;
+
+	if (!sizes_.empty() && std::find(sizes_.begin(), sizes_.end(), mc.size()) == sizes_.end())
+		return false;
+
+	return true;
+}
+
 
 // -----------------------------------------------------------------------------
 //
@@ -567,6 +630,14 @@ void SIFormat::initFormats()
 	new SIFHeretic2M32();
 	new SIFWolfPic();
 	new SIFWolfSprite();
+
+	// Get formats that can be identified by magic bytes
+	magic_formats.clear();
+	for (auto format : simage_formats)
+		if (!format->magic_.empty())
+			magic_formats.push_back(format);
+
+	clearDetectionCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -598,7 +669,13 @@ SIFormat* SIFormat::getFormat(string_view id)
 // -----------------------------------------------------------------------------
 SIFormat* SIFormat::determineFormat(MemChunk& mc)
 {
-	// Go through all registered formats
+	// Fast pass: a matching magic signature identifies the format without
+	// having to run the (potentially expensive) checks of every other format
+	for (auto magic_format : magic_formats)
+		if (magic_format->reliability_ == 255 && magic_format->matchesSignature(mc) && magic_format->isThisFormat(mc))
+			return magic_format;
+
+	// Go through all remaining registered formats
 	SIFormat* format = sif_unknown;
 	for (auto& simage_format : simage_formats)
 	{
@@ -606,8 +683,12 @@ SIFormat* SIFormat::determineFormat(MemChunk& mc)
 		if (simage_format->reliability_ < format->reliability_)
 			continue;
 
-		// Check if data matches format
-		if (simage_format->isThisFormat(mc))
+		// Skip formats already checked in the fast pass
+		if (!simage_format->magic_.empty() && simage_format->reliability_ == 255)
+			continue;
+
+		// Check if data matches format (if it can't be ruled out by signature)
+		if (simage_format->matchesSignature(mc) && simage_format->isThisFormat(mc))
 			format = simage_format;
 
 		// Stop if format detected is 100% reliable
@@ -619,6 +700,74 @@ SIFormat* SIFormat::determineFormat(MemChunk& mc)
 	return format;
 }
 
+// -----------------------------------------------------------------------------
+// Determines the image format of [entry]'s data, checking the format matching
+// [type_hint] first (if given).
+// The result is remembered until the entry's data is modified
+// -----------------------------------------------------------------------------
+SIFormat* SIFormat::determineFormat(ArchiveEntry& entry, string_view type_hint)
+{
+	auto       shared       = entry.getShared();
+	const auto data_version = entry.dataVersion();
+
+	// Check for a previous result
+	if (shared)
+	{
+		std::lock_guard lock(detected_formats_mutex);
+
+		auto i = detected_formats.find(&entry);
+		if (i != detected_formats.end() && i->second.data_version == data_version
+			&& i->second.type_hint == type_hint && i->second.entry_ref.lock() == shared)
+			return i->second.format;
+	}
+
+	// Check with type hint format first
+	auto&     data   = entry.data();
+	SIFormat* format = sif_unknown;
+	if (!type_hint.empty())
+	{
+		auto hint_format = getFormat(type_hint);
+		if (hint_format != sif_unknown && hint_format->isThisFormat(data))
+			format = hint_format;
+	}
+
+	// No type hint given or didn't match, autodetect
+	if (format == sif_unknown)
+		format = determineFormat(data);
+
+	// Remember the result (entries not in an archive aren't remembered)
+	if (shared)
+	{
+		std::lock_guard lock(detected_formats_mutex);
+
+		// Remove results for entries that no longer exist
+		if (detected_formats.size() >= detected_formats_prune)
+		{
+			for (auto i = detected_formats.begin(); i != detected_formats.end();)
+			{
+				if (i->second.entry_ref.expired())
+					i = detected_formats.erase(i);
+				else
+					++i;
+			}
+			detected_formats_prune = std::max<size_t>(8192, detected_formats.size() * 2);
+		}
+
+		detected_formats[&entry] = { shared, data_version, string{ type_hint }, format };
+	}
+
+	return format;
+}
+
+// -----------------------------------------------------------------------------
+// Clears all remembered per-entry format detection results
+// -----------------------------------------------------------------------------
+void SIFormat::clearDetectionCache()
+{
+	std::lock_guard lock(detected_formats_mutex);
+	detected_formats.clear();
+}
+
 // -----------------------------------------------------------------------------
 // Returns the 'unknown' image format
 // -----------------------------------------------------------------------------
@@ -668,3 +817,84 @@ void SIFormat::putAllFormats(vector<SIFormat*>& list)
 	list.push_back(sif_raw);
 	list.push_back(sif_flat);
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+#include "General/Console.h"
+
+CONSOLE_COMMAND(benchmark_image_detection, 0, false)
+{
+	auto archive = maineditor::currentArchive();
+	if (!archive)
+	{
+		log::console("No archive open");
+		return;
+	}
+
+	const int iterations = args.empty() ? 10 : std::max(strutil::asInt(args[0]), 1);
+
+	// Get all (non-empty) entries and load their data
+	vector<ArchiveEntry*> all_entries, entries;
+	archive->putEntryTreeAsList(all_entries);
+	for (auto entry : all_entries)
+	{
+		if (entry->type() != EntryType::folderType() && entry->size() > 0)
+		{
+			entry->data();
+			entries.push_back(entry);
+		}
+	}
+
+	vector<SIFormat*> linear_results(entries.size());
+	vector<SIFormat*> results(entries.size());
+
+	// Check all formats
+	wxStopWatch sw;
+	for (int i = 0; i < iterations; ++i)
+		for (unsigned a = 0; a < entries.size(); ++a)
+			linear_results[a] = determineFormatLinear(entries[a]->data());
+	const auto linear_time = sw.Time();
+
+	// Magic/size signatures first
+	sw.Start();
+	for (int i = 0; i < iterations; ++i)
+		for (unsigned a = 0; a < entries.size(); ++a)
+			results[a] = SIFormat::determineFormat(entries[a]->data());
+	const auto signature_time = sw.Time();
+
+	// Remembered per entry
+	SIFormat::clearDetectionCache();
+	sw.Start();
+	for (int i = 0; i < iterations; ++i)
+		for (auto entry : entries)
+			SIFormat::determineFormat(*entry);
+	const auto cached_time = sw.Time();
+
+	// Results should be identical
+	unsigned mismatches = 0;
+	for (unsigned a = 0; a < entries.size(); ++a)
+	{
+		if (linear_results[a] != results[a])
+		{
+			log::console(fmt::format(
+				"{}: {} (all formats) / {} (signatures)",
+				entries[a]->path(true),
+				linear_results[a]->id(),
+				results[a]->id()));
+			++mismatches;
+		}
+	}
+
+	log::console(fmt::format(
+		"Detected {} entries x{}: all formats {}ms, signatures {}ms, remembered {}ms, {} mismatches",
+		entries.size(),
+		iterations,
+		linear_time,
+		signature_time,
+		cached_time,
+		mismatches));
+}
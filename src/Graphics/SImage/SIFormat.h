@@ -33,16 +33,17 @@ public:
 	const string& id() const { return id_; }
 	const string& name() const { return name_; }
 	const string& extension() const { return extension_; }
+	uint8_t       reliability() const { return reliability_; }
 
 	virtual bool isThisFormat(MemChunk& mc) = 0;
 
 	// Reading
 	virtual SImage::Info info(MemChunk& mc, int index = 0) = 0;
 
-	bool loadImage(SImage& image, MemChunk& data, int index = 0)
+	bool loadImage(SImage& image, MemChunk& data, int index = 0, bool check_format = true)
 	{
-		// Check format
-		if (!isThisFormat(data))
+		// Check format (can be skipped if the data was already detected as this format)
+		if (check_format && !isThisFormat(data))
 			return false;
 
 		// Attempt to read image data
@@ -91,6 +92,8 @@ public:
 	static void      initFormats();
 	static SIFormat* getFormat(string_view name);
 	static SIFormat* determineFormat(MemChunk& mc);
+	static SIFormat* determineFormat(ArchiveEntry& entry, string_view type_hint = {});
+	static void      clearDetectionCache();
 	static SIFormat* unknownFormat();
 	static SIFormat* rawFormat();
 	static SIFormat* flatFormat();
@@ -103,6 +106,12 @@ protected:
 	string  extension_   = "dat";
 	uint8_t reliability_ = 255;
 
+	// Quick detection signature, checked before isThisFormat
+	string           magic_; // Bytes the data must begin with (if any)
+	vector<unsigned> sizes_; // Exact sizes the data must be (if any)
+
+	bool matchesSignature(const MemChunk& mc) const;
+
 	// Stuff to access protected image data
 	uint8_t* imageData(SImage& image) const { return image.data_.data(); }
 	uint8_t* imageMask(SImage& image) const { return image.mask_.data(); }
@@ -35,12 +35,34 @@
 #include "SImage.h"
 #include "Graphics/Translation.h"
 #include "SIFormat.h"
+#include "SImageBlit.h"
 #include "Utility/MathStuff.h"
 #undef BOOL
 
 using namespace slade;
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Per-thread scratch buffers for temporary pixel data, reused between image
+// operations so that chained conversions/transforms don't allocate each time
+enum class Scratch
+{
+	Data,
+	Mask,
+	Count
+};
+thread_local vector<uint8_t> scratch_buffers[static_cast<int>(Scratch::Count)];
+thread_local unsigned        scratch_alloc_count = 0;                // Number of times a scratch buffer has grown
+constexpr size_t             scratch_keep_size   = 16 * 1024 * 1024; // Bigger buffers are freed after use
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // External Variables
@@ -51,6 +73,64 @@ EXTERN_CVAR(Float, col_greyscale_g)
 EXTERN_CVAR(Float, col_greyscale_b)
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Gives access to one of the calling thread's scratch buffers, at least [size]
+// bytes long, for the lifetime of the object.
+// Each scratch buffer must only be in use by one object at a time
+// -----------------------------------------------------------------------------
+class ScratchBuffer
+{
+public:
+	ScratchBuffer(Scratch buffer, size_t size) : buffer_{ scratch_buffers[static_cast<int>(buffer)] }
+	{
+		if (buffer_.capacity() < size)
+			scratch_alloc_count++;
+		if (buffer_.size() < size)
+			buffer_.resize(size);
+	}
+
+	~ScratchBuffer()
+	{
+		if (buffer_.size() > scratch_keep_size)
+		{
+			buffer_.clear();
+			buffer_.shrink_to_fit();
+		}
+	}
+
+	uint8_t* data() { return buffer_.data(); }
+
+private:
+	vector<uint8_t>& buffer_;
+};
+
+// -----------------------------------------------------------------------------
+// Reverses the order of the [count] pixels of [bpp] bytes each at [pixels]
+// -----------------------------------------------------------------------------
+void reversePixels(uint8_t* pixels, size_t count, unsigned bpp)
+{
+	if (count < 2)
+		return;
+
+	if (bpp == 1)
+	{
+		std::reverse(pixels, pixels + count);
+		return;
+	}
+
+	for (size_t a = 0, b = count - 1; a < b; ++a, --b)
+		std::swap_ranges(pixels + a * bpp, pixels + (a + 1) * bpp, pixels + b * bpp);
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // SImage Class Functions
@@ -87,9 +167,6 @@ bool SImage::putRGBAData(MemChunk& mc, Palette* pal) const
 	if (!isValid())
 		return false;
 
-	// Init rgba data
-	mc.reSize(width_ * height_ * 4, false);
-
 	// If data is already in RGBA format just return a copy
 	if (type_ == Type::RGBA)
 	{
@@ -97,47 +174,13 @@ bool SImage::putRGBAData(MemChunk& mc, Palette* pal) const
 		return true;
 	}
 
-	// Convert paletted
-	else if (type_ == Type::PalMask)
-	{
-		// Get palette to use
-		const auto& palette = (has_palette_ || !pal) ? palette_ : *pal;
-
-		uint8_t rgba[4];
-		for (int a = 0; a < width_ * height_; a++)
-		{
-			// Get colour
-			ColRGBA col = palette.colour(data_[a]);
-
-			// Set alpha
-			if (mask_.data())
-				col.a = mask_[a];
-			else
-				col.a = 255;
-
-			col.write(rgba);   // Write colour to array
-			mc.write(rgba, 4); // Write array to MemChunk
-		}
-
-		return true;
-	}
-
-	// Convert if alpha map
-	else if (type_ == Type::AlphaMap)
-	{
-		uint8_t rgba[4];
-		ColRGBA col;
-		for (int a = 0; a < width_ * height_; a++)
-		{
-			// Get pixel as colour (greyscale)
-			col.set(data_[a], data_[a], data_[a], data_[a]);
-
-			col.write(rgba);   // Write colour to array
-			mc.write(rgba, 4); // Write array to MemChunk
-		}
-	}
+	// Convert
+	mc.reSize(width_ * height_ * 4, false);
+	if (!writeRGBA(mc.data(), pal))
+		return false;
+	mc.seek(mc.size(), SEEK_SET);
 
-	return false; // Invalid image type
+	return true;
 }
 
 // -----------------------------------------------------------------------------
@@ -343,6 +386,53 @@ void SImage::setYOffset(int offset)
 	signals_.offsets_changed(offset_x_, offset_y_);
 }
 
+// -----------------------------------------------------------------------------
+// Writes the image as RGBA data to [dest], which must have room for
+// width * height * 4 bytes. [pal] is used if the image doesn't have its own
+// palette.
+// Returns false if the image type can't be converted, true otherwise
+// -----------------------------------------------------------------------------
+bool SImage::writeRGBA(uint8_t* dest, Palette* pal) const
+{
+	const unsigned numpixels = width_ * height_;
+
+	switch (type_)
+	{
+	case Type::RGBA: memcpy(dest, data_.data(), numpixels * 4); return true;
+
+	case Type::PalMask:
+	{
+		// Get palette to use
+		const auto& palette  = (has_palette_ || !pal) ? palette_ : *pal;
+		const bool  has_mask = mask_.hasData();
+
+		for (unsigned a = 0; a < numpixels; a++)
+		{
+			const auto col = palette.colour(data_[a]);
+			dest[0]        = col.r;
+			dest[1]        = col.g;
+			dest[2]        = col.b;
+			dest[3]        = has_mask ? mask_[a] : 255;
+			dest += 4;
+		}
+
+		return true;
+	}
+
+	case Type::AlphaMap:
+		// Pixel as colour (greyscale)
+		for (unsigned a = 0; a < numpixels; a++)
+		{
+			memset(dest, data_[a], 4);
+			dest += 4;
+		}
+
+		return true;
+
+	default: return false; // Invalid image type
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Deletes/clears any existing image data
 // -----------------------------------------------------------------------------
@@ -568,9 +658,6 @@ bool SImage::copyImage(SImage* image)
 	if (!image)
 		return false;
 
-	// Clear current data
-	clearData();
-
 	// Copy image properties
 	width_  = image->width_;
 	height_ = image->height_;
@@ -581,12 +668,17 @@ bool SImage::copyImage(SImage* image)
 	offset_y_    = image->offset_y_;
 	imgindex_    = image->imgindex_;
 	numimages_   = image->numimages_;
+	format_      = image->format_;
 
-	// Copy image data
+	// Copy image data (the current data buffers are reused if the size matches)
 	if (image->data_.hasData())
 		data_.importMem(image->data_);
+	else
+		data_.clear();
 	if (image->mask_.hasData())
 		mask_.importMem(image->mask_);
+	else
+		mask_.clear();
 
 	// Announce change
 	signals_.image_changed();
@@ -605,11 +697,12 @@ bool SImage::open(MemChunk& data, int index, string_view type_hint)
 	{
 		auto format = SIFormat::getFormat(type_hint);
 		if (format != SIFormat::unknownFormat() && format->isThisFormat(data))
-			return format->loadImage(*this, data, index);
+			return format->loadImage(*this, data, index, false);
 	}
 
 	// No type hint given or didn't match, autodetect format with SIFormat system instead
-	return SIFormat::determineFormat(data)->loadImage(*this, data, index);
+	auto format = SIFormat::determineFormat(data);
+	return format != SIFormat::unknownFormat() && format->loadImage(*this, data, index, false);
 }
 
 // -----------------------------------------------------------------------------
@@ -622,15 +715,17 @@ bool SImage::convertRGBA(Palette* pal)
 	if (type_ == Type::RGBA)
 		return false;
 
-	// Get 32bit data
-	MemChunk rgba_data;
-	putRGBAData(rgba_data, pal);
-
-	// Clear current data
-	clearData(true);
-
-	// Copy it
-	data_.importMem(rgba_data);
+	// Get 32bit data and copy it
+	if (isValid())
+	{
+		const unsigned size = width_ * height_ * 4;
+		ScratchBuffer  rgba(Scratch::Data, size);
+		writeRGBA(rgba.data(), pal);
+		data_.importMem(rgba.data(), size);
+		mask_.clear();
+	}
+	else
+		clearData(true);
 
 	// Set new type & update variables
 	type_        = Type::RGBA;
@@ -656,44 +751,51 @@ bool SImage::convertPaletted(Palette* pal_target, Palette* pal_current)
 	if (!isValid() || !pal_target)
 		return false;
 
-	// Get image data as RGBA
-	MemChunk rgba_data;
-	putRGBAData(rgba_data, pal_current);
+	const unsigned numpixels = width_ * height_;
+	uint8_t*       data      = data_.data();
 
-	// Create mask from alpha info (if converting from RGBA)
-	if (type_ == Type::RGBA || type_ == Type::AlphaMap)
+	// Paletted images only need their indices remapped to the new palette
+	if (type_ == Type::PalMask)
 	{
-		// Clear current mask
-		mask_.clear();
+		const auto& palette = (has_palette_ || !pal_current) ? palette_ : *pal_current;
+		uint8_t     remap[256];
+		for (unsigned c = 0; c < 256; c++)
+		{
+			const auto col = palette.colour(c);
+			remap[c]       = pal_target->nearestColour(ColRGBA(col.r, col.g, col.b));
+		}
 
-		// Init mask
-		mask_.reSize(width_ * height_);
+		for (unsigned a = 0; a < numpixels; a++)
+			data[a] = remap[data[a]];
+	}
 
-		// Get values from alpha channel
-		int c = 0;
-		for (int a = 3; a < width_ * height_ * 4; a += 4)
-			mask_[c++] = rgba_data[a];
+	// Otherwise create the mask from alpha info and convert in place (each
+	// index is written at or before the pixel it was converted from)
+	else
+	{
+		const unsigned bpp = this->bpp();
+		mask_.reSize(numpixels, false);
+		for (unsigned a = 0; a < numpixels; a++)
+		{
+			const uint8_t* pixel = data + a * bpp;
+			if (bpp == 4)
+			{
+				mask_[a] = pixel[3];
+				data[a]  = pal_target->nearestColour(ColRGBA(pixel[0], pixel[1], pixel[2]));
+			}
+			else
+			{
+				mask_[a] = pixel[0];
+				data[a]  = pal_target->nearestColour(ColRGBA(pixel[0], pixel[0], pixel[0]));
+			}
+		}
+
+		data_.reSize(numpixels, true);
 	}
 
 	// Load given palette
 	palette_.copyPalette(pal_target);
 
-	// Clear current image data (but not mask)
-	clearData(false);
-
-	// Do conversion
-	data_.reSize(width_ * height_);
-	unsigned i = 0;
-	ColRGBA  col;
-	for (int a = 0; a < width_ * height_; a++)
-	{
-		col.r    = rgba_data[i++];
-		col.g    = rgba_data[i++];
-		col.b    = rgba_data[i++];
-		data_[a] = palette_.nearestColour(col);
-		i++; // Skip alpha
-	}
-
 	// Update variables
 	type_        = Type::PalMask;
 	has_palette_ = true;
@@ -712,23 +814,26 @@ bool SImage::convertPaletted(Palette* pal_target, Palette* pal_current)
 bool SImage::convertAlphaMap(AlphaSource alpha_source, Palette* pal)
 {
 	// Get RGBA data
-	MemChunk rgba;
-	putRGBAData(rgba, pal);
+	const unsigned numpixels = width_ * height_;
+	ScratchBuffer  rgba(Scratch::Data, numpixels * 4);
+	const bool     valid = isValid() && writeRGBA(rgba.data(), pal);
 
 	// Recreate image
 	create(width_, height_, Type::AlphaMap);
+	if (!valid)
+		memset(rgba.data(), 0, numpixels * 4);
 
 	// Generate alpha mask
 	unsigned c = 0;
-	for (int a = 0; a < width_ * height_; a++)
+	for (unsigned a = 0; a < numpixels; a++)
 	{
 		// Determine alpha for this pixel
 		uint8_t alpha;
 		if (alpha_source == AlphaSource::Brightness) // Pixel brightness
-			alpha = static_cast<double>(rgba[c]) * 0.3 + static_cast<double>(rgba[c + 1]) * 0.59
-					+ static_cast<double>(rgba[c + 2]) * 0.11;
+			alpha = static_cast<double>(rgba.data()[c]) * 0.3 + static_cast<double>(rgba.data()[c + 1]) * 0.59
+					+ static_cast<double>(rgba.data()[c + 2]) * 0.11;
 		else // Existing alpha
-			alpha = rgba[c + 3];
+			alpha = rgba.data()[c + 3];
 
 		// Set pixel
 		data_[a] = alpha;
@@ -1034,42 +1139,35 @@ bool SImage::rotate(int angle)
 	else
 		return false;
 
-	// Create new data and mask
-	vector<uint8_t> new_data(numpixels * numbpp);
-	vector<uint8_t> new_mask;
-	if (mask_.hasData())
-		new_mask.resize(numpixels * numbpp, 0);
-
-	// Remapping loop
-	int i, j, k;
-	for (i = 0; i < numpixels; ++i)
+	const bool has_mask = mask_.hasData();
+	if (angle == 180)
+	{
+		// Just reverse the pixel order in place
+		reversePixels(data_.data(), numpixels, numbpp);
+		if (has_mask)
+			reversePixels(mask_.data(), numpixels, 1);
+	}
+	else
 	{
-		switch (angle)
+		// Remap pixels from a copy of the current data and mask
+		ScratchBuffer old_data(Scratch::Data, numpixels * numbpp);
+		ScratchBuffer old_mask(Scratch::Mask, has_mask ? numpixels : 0);
+		memcpy(old_data.data(), data_.data(), numpixels * numbpp);
+		if (has_mask)
+			memcpy(old_mask.data(), mask_.data(), numpixels);
+
+		for (int i = 0; i < numpixels; ++i)
 		{
 			// Urgh maths...
-		case 90: j = (((new_height - 1) - (i % width_)) * new_width) + (i / width_); break;
-		case 180: j = (numpixels - 1) - i; break;
-		case 270: j = ((i % width_) * new_width) + ((new_width - 1) - (i / width_)); break;
-		default: return false;
-		}
-		if (j >= numpixels)
-		{
-			log::error("Pixel {} remapped to {}, how did this even happen?", i, j);
-			return false;
-		}
-		for (k = 0; k < numbpp; ++k)
-		{
-			new_data[(j * numbpp) + k] = data_[(i * numbpp) + k];
-			if (mask_.hasData())
-				new_mask[(j * numbpp) + k] = mask_[(i * numbpp) + k];
+			const int j = angle == 90 ? (((new_height - 1) - (i % width_)) * new_width) + (i / width_) :
+										((i % width_) * new_width) + ((new_width - 1) - (i / width_));
+			memcpy(data_.data() + j * numbpp, old_data.data() + i * numbpp, numbpp);
+			if (has_mask)
+				mask_[j] = old_mask.data()[i];
 		}
 	}
 
 	// It worked, yay
-	clearData();
-	data_.importMem(new_data.data(), new_data.size());
-	if (!new_mask.empty())
-		mask_.importMem(new_mask.data(), new_mask.size());
 	width_  = new_width;
 	height_ = new_height;
 
@@ -1083,9 +1181,11 @@ bool SImage::rotate(int angle)
 // -----------------------------------------------------------------------------
 bool SImage::mirror(bool vertical)
 {
-	// Compute numbers of pixels and bytes
-	const int numpixels = width_ * height_;
-	int       numbpp;
+	if (!data_.hasData())
+		return false;
+
+	// Compute number of bytes per pixel
+	int numbpp;
 	if (type_ == Type::PalMask)
 		numbpp = 1;
 	else if (type_ == Type::RGBA)
@@ -1093,39 +1193,32 @@ bool SImage::mirror(bool vertical)
 	else
 		return false;
 
-	// Create new data and mask
-	vector<uint8_t> new_data(numpixels * numbpp);
-	vector<uint8_t> new_mask;
-	if (mask_.hasData())
-		new_mask.resize(numpixels * numbpp);
-
-	// Remapping loop
-	int i, j, k;
-	for (i = 0; i < numpixels; ++i)
-	{
-		if (vertical)
-			j = (((height_ - 1) - (i / width_)) * width_) + (i % width_);
-		else // horizontal
-			j = ((i / width_) * width_) + ((width_ - 1) - (i % width_));
-		if (j >= numpixels)
+	// Mirror in place
+	const bool has_mask = mask_.hasData();
+	const int  rowlen   = width_ * numbpp;
+	if (vertical)
+	{
+		// Swap rows from the top and bottom towards the middle
+		for (int y = 0; y < height_ / 2; ++y)
 		{
-			log::error("Pixel {} remapped to {}, how did this even happen?", i, j);
-			return false;
+			const int y2 = height_ - 1 - y;
+			std::swap_ranges(data_.data() + y * rowlen, data_.data() + (y + 1) * rowlen, data_.data() + y2 * rowlen);
+			if (has_mask)
+				std::swap_ranges(
+					mask_.data() + y * width_, mask_.data() + (y + 1) * width_, mask_.data() + y2 * width_);
 		}
-		for (k = 0; k < numbpp; ++k)
+	}
+	else // horizontal
+	{
+		// Reverse each row
+		for (int y = 0; y < height_; ++y)
 		{
-			new_data[(j * numbpp) + k] = data_[(i * numbpp) + k];
-			if (mask_.hasData())
-				new_mask[(j * numbpp) + k] = mask_[(i * numbpp) + k];
+			reversePixels(data_.data() + y * rowlen, width_, numbpp);
+			if (has_mask)
+				reversePixels(mask_.data() + y * width_, width_, 1);
 		}
 	}
 
-	// It worked, yay
-	clearData();
-	data_.importMem(new_data.data(), new_data.size());
-	if (!new_mask.empty())
-		mask_.importMem(new_mask.data(), new_mask.size());
-
 	// Announce change
 	signals_.image_changed();
 	return true;
@@ -1171,28 +1264,22 @@ bool SImage::crop(long x1, long y1, long x2, long y2)
 	else
 		return false;
 
-	// Create new data and mask
-	vector<uint8_t> new_data(numpixels * numbpp);
-	vector<uint8_t> new_mask;
-	if (mask_.hasData())
-		new_mask.resize(numpixels * numbpp);
-
-	// Remapping loop
-	size_t i, a, b;
-	for (i = 0; i < new_height; ++i)
+	// Move the cropped rows to the start of the data and mask (each row moves
+	// towards the start, so this can be done in place), then truncate them
+	const bool has_mask = mask_.hasData();
+	for (size_t i = 0; i < new_height; ++i)
 	{
-		a = i * new_width * numbpp;
-		b = (((i + y1) * width_) + x1) * numbpp;
-		memcpy(new_data.data() + a, data_.data() + b, new_width * numbpp);
-		if (mask_.hasData())
-			memcpy(new_mask.data() + a, mask_.data() + b, new_width * numbpp);
+		const size_t a = i * new_width;
+		const size_t b = ((i + y1) * width_) + x1;
+		memmove(data_.data() + a * numbpp, data_.data() + b * numbpp, new_width * numbpp);
+		if (has_mask)
+			memmove(mask_.data() + a, mask_.data() + b, new_width);
 	}
+	data_.reSize(numpixels * numbpp, true);
+	if (has_mask)
+		mask_.reSize(numpixels, true);
 
 	// It worked, yay
-	clearData();
-	data_.importMem(new_data.data(), new_data.size());
-	if (!new_mask.empty())
-		mask_.importMem(new_mask.data(), new_mask.size());
 	width_  = new_width;
 	height_ = new_height;
 
@@ -1320,26 +1407,31 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 	if (has_palette_ || !pal)
 		pal = &palette_;
 
-	uint8_t* newdata;
-	if (truecolor && type_ == Type::PalMask)
+	// Translating a paletted image to truecolour goes via a scratch buffer
+	const bool    to_rgba = truecolor && type_ == Type::PalMask;
+	ScratchBuffer rgba(Scratch::Data, to_rgba ? width_ * height_ * 4 : 0);
+	uint8_t*      newdata = data_.data();
+	if (to_rgba)
 	{
-		newdata = new uint8_t[width_ * height_ * 4];
+		newdata = rgba.data();
 		memset(newdata, 0, width_ * height_ * 4);
 	}
-	else
-		newdata = data_.data();
+
+	// Resolve the translation against the palette once for all pixels
+	const CompiledTranslation compiled(*tr, pal);
 
 	// Go through pixels
+	const bool has_mask = mask_.hasData();
 	for (int p = 0; p < width_ * height_; p++)
 	{
 		// No need to process transparent pixels
-		if (mask_.hasData() && mask_[p] == 0)
+		if (has_mask && mask_[p] == 0)
 			continue;
 
 		ColRGBA col;
 		int     q = p * bpp;
 		if (type_ == Type::PalMask)
-			col.set(pal->colour(data_[p]));
+			col = compiled.colour(data_[p]);
 		else if (type_ == Type::RGBA)
 		{
 			col.set(data_[q], data_[q + 1], data_[q + 2], data_[q + 3]);
@@ -1348,9 +1440,9 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 			col.index = pal->nearestColour(col);
 			if (!col.equals(pal->colour(col.index)))
 				continue;
-		}
 
-		col = tr->translate(col, pal);
+			col = compiled.translate(col);
+		}
 
 		if (truecolor)
 		{
@@ -1358,15 +1450,15 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 			newdata[q + 0] = col.r;
 			newdata[q + 1] = col.g;
 			newdata[q + 2] = col.b;
-			newdata[q + 3] = mask_.hasData() ? mask_[p] : col.a;
+			newdata[q + 3] = has_mask ? mask_[p] : col.a;
 		}
 		else
 			data_[p] = col.index;
 	}
 
-	if (truecolor && type_ == Type::PalMask)
+	if (to_rgba)
 	{
-		clearData(true);
+		mask_.clear();
 		data_.importMem(newdata, width_ * height_ * 4);
 		type_ = Type::RGBA;
 	}
@@ -1507,6 +1599,71 @@ bool SImage::drawPixel(int x, int y, ColRGBA colour, DrawProps& properties, Pale
 // for the destination image, if either is paletted
 // -----------------------------------------------------------------------------
 bool SImage::drawImage(SImage& img, int x_pos, int y_pos, DrawProps& properties, Palette* pal_src, Palette* pal_dest)
+{
+	// Alpha map destinations (and drawing an image onto itself) go pixel by pixel
+	if ((type_ != Type::RGBA && type_ != Type::PalMask) || &img == this)
+		return drawImagePixels(img, x_pos, y_pos, properties, pal_src, pal_dest);
+
+	// Check images
+	if (!data_.hasData() || !img.data_.hasData())
+		return false;
+
+	// Setup palettes
+	if (img.has_palette_ || !pal_src)
+		pal_src = &(img.palette_);
+	if (has_palette_ || !pal_dest)
+		pal_dest = &palette_;
+
+	// Clip source image to this image
+	const int x1 = std::max(x_pos, 0);
+	const int x2 = std::min(x_pos + img.width_, width_);
+	const int y1 = std::max(y_pos, 0);
+	const int y2 = std::min(y_pos + img.height_, height_);
+	if (x1 >= x2 || y1 >= y2 || img.type_ == Type::Unknown)
+		return true;
+
+	// Setup source row expansion
+	const unsigned    count = x2 - x1;
+	blit::PaletteRGBA src_pal;
+	ScratchBuffer     src_row(Scratch::Data, img.type_ != Type::RGBA ? count * 4 : 0);
+	if (img.type_ == Type::PalMask)
+		blit::buildPaletteRGBA(*pal_src, src_pal);
+
+	// Go through rows
+	for (int y = y1; y < y2; y++)
+	{
+		// Get source row as RGBA
+		const unsigned sp  = (y - y_pos) * img.width_ + (x1 - x_pos);
+		const uint8_t* src = src_row.data();
+		if (img.type_ == Type::PalMask)
+			blit::fetchRowPalMask(img.data_.data() + sp, img.mask_.data() + sp, src_pal, src_row.data(), count);
+		else if (img.type_ == Type::AlphaMap)
+			blit::fetchRowAlphaMap(img.data_.data() + sp, src_row.data(), count);
+		else
+			src = img.data_.data() + sp * 4;
+
+		// Blend onto destination row
+		const unsigned dp = y * width_ + x1;
+		if (type_ == Type::RGBA)
+			blit::blendRowRGBA(src, data_.data() + dp * 4, count, properties);
+		else
+			blit::blendRowPalMask(src, data_.data() + dp, mask_.data() + dp, count, properties, *pal_dest);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Same as drawImage, but draws each pixel individually via drawPixel rather
+// than using the row kernels in SImageBlit.cpp
+// -----------------------------------------------------------------------------
+bool SImage::drawImagePixels(
+	SImage&    img,
+	int        x_pos,
+	int        y_pos,
+	DrawProps& properties,
+	Palette*   pal_src,
+	Palette*   pal_dest)
 {
 	// Check images
 	if (!data_.hasData() || !img.data_.hasData())
@@ -1850,3 +2007,297 @@ bool SImage::mirrorpad()
 	}
 	return success;
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+#include "General/Console.h"
+#include "MainEditor/MainEditor.h"
+#include "Utility/StringUtils.h"
+#include <random>
+
+CONSOLE_COMMAND(benchmark_composite, 0, true)
+{
+	const auto num_textures = args.empty() ? 200 : std::max(strutil::asInt(args[0]), 1);
+	const auto iterations   = args.size() < 2 ? 3 : std::max(strutil::asInt(args[1]), 1);
+	const auto pal          = maineditor::currentPalette();
+	std::mt19937 rng(1234);
+	const auto   rand_int = [&rng](int min, int max) { return std::uniform_int_distribution<int>(min, max)(rng); };
+
+	// Generate patches, half paletted and half truecolour, with some
+	// transparent and translucent pixels
+	vector<unique_ptr<SImage>> patches;
+	for (int a = 0; a < 32; ++a)
+	{
+		const auto type  = a % 2 == 0 ? SImage::Type::PalMask : SImage::Type::RGBA;
+		auto       patch = std::make_unique<SImage>(type);
+		patch->create(rand_int(8, 128), rand_int(8, 128), type);
+		for (int y = 0; y < patch->height(); ++y)
+			for (int x = 0; x < patch->width(); ++x)
+			{
+				const auto    r     = rand_int(0, 9);
+				const uint8_t alpha = r < 2 ? 0 : (r < 4 ? rand_int(1, 254) : 255);
+				if (type == SImage::Type::PalMask)
+					patch->setPixel(x, y, rand_int(0, 255), alpha);
+				else
+					patch->setPixel(x, y, ColRGBA(rand_int(0, 255), rand_int(0, 255), rand_int(0, 255), alpha));
+			}
+		patches.push_back(std::move(patch));
+	}
+
+	// Generate multi-patch texture definitions, with patch styles as they are
+	// set up for TEXTURES definitions in CTexture::toImage
+	struct PatchDef
+	{
+		SImage*           image;
+		int               x, y;
+		SImage::DrawProps props;
+	};
+	struct TextureDef
+	{
+		int              width, height;
+		vector<PatchDef> patches;
+	};
+	vector<TextureDef> textures(num_textures);
+	for (auto& tex : textures)
+	{
+		tex.width  = 64 << rand_int(0, 2);
+		tex.height = 64 << rand_int(0, 1);
+		for (int p = rand_int(2, 8); p > 0; --p)
+		{
+			PatchDef def{ patches[rand_int(0, 31)].get(), rand_int(-32, tex.width - 8), rand_int(-32, tex.height - 8) };
+			def.props.src_alpha = false;
+			switch (rand_int(0, 7))
+			{
+			case 0: def.props.src_alpha = true; break; // CopyAlpha
+			case 1: def.props.alpha = 0.5f; break;     // Translucent
+			case 2:
+				def.props.blend = SImage::BlendType::Add;
+				def.props.alpha = 0.75f;
+				break;
+			case 3:
+				def.props.blend = SImage::BlendType::Subtract;
+				def.props.alpha = 0.5f;
+				break;
+			case 4:
+				def.props.blend = SImage::BlendType::ReverseSubtract;
+				def.props.alpha = 0.5f;
+				break;
+			case 5:
+				def.props.blend = SImage::BlendType::Modulate;
+				def.props.alpha = 1.0f;
+				break;
+			default: break; // Copy
+			}
+			tex.patches.push_back(def);
+		}
+	}
+
+	// Composite all textures into both truecolour and paletted images, with the
+	// row kernels and per-pixel, and check the results match
+	wxStopWatch sw;
+	for (auto type : { SImage::Type::RGBA, SImage::Type::PalMask })
+	{
+		long     kernel_ms  = 0;
+		long     pixel_ms   = 0;
+		unsigned mismatches = 0;
+		for (int i = 0; i < iterations; ++i)
+		{
+			vector<unique_ptr<SImage>> kernel_images;
+			vector<unique_ptr<SImage>> pixel_images;
+			for (const auto& tex : textures)
+			{
+				kernel_images.push_back(std::make_unique<SImage>(type));
+				kernel_images.back()->create(tex.width, tex.height, type);
+				pixel_images.push_back(std::make_unique<SImage>(type));
+				pixel_images.back()->create(tex.width, tex.height, type);
+			}
+
+			sw.Start();
+			for (unsigned t = 0; t < textures.size(); ++t)
+				for (auto& patch : textures[t].patches)
+					kernel_images[t]->drawImage(*patch.image, patch.x, patch.y, patch.props, pal, pal);
+			kernel_ms += sw.Time();
+
+			sw.Start();
+			for (unsigned t = 0; t < textures.size(); ++t)
+				for (auto& patch : textures[t].patches)
+					pixel_images[t]->drawImagePixels(*patch.image, patch.x, patch.y, patch.props, pal, pal);
+			pixel_ms += sw.Time();
+
+			// Compare (RGBA and palette indices, if any)
+			const auto same = [](const MemChunk& mc1, const MemChunk& mc2)
+			{ return mc1.size() == mc2.size() && memcmp(mc1.data(), mc2.data(), mc1.size()) == 0; };
+			for (unsigned t = 0; t < textures.size(); ++t)
+			{
+				MemChunk kernel_rgba, pixel_rgba, kernel_indices, pixel_indices;
+				kernel_images[t]->putRGBAData(kernel_rgba, pal);
+				pixel_images[t]->putRGBAData(pixel_rgba, pal);
+				kernel_images[t]->putIndexedData(kernel_indices);
+				pixel_images[t]->putIndexedData(pixel_indices);
+				if (!same(kernel_rgba, pixel_rgba) || !same(kernel_indices, pixel_indices))
+					mismatches++;
+			}
+		}
+
+		log::console(fmt::format(
+			"{} textures ({}): row kernels {}ms, per-pixel {}ms average over {} iterations, {} mismatched",
+			num_textures,
+			type == SImage::Type::RGBA ? "truecolour" : "paletted",
+			kernel_ms / iterations,
+			pixel_ms / iterations,
+			iterations,
+			mismatches));
+	}
+}
+
+CONSOLE_COMMAND(benchmark_texture_build, 0, true)
+{
+	const auto num_textures = args.empty() ? 200 : std::max(strutil::asInt(args[0]), 1);
+	const auto iterations   = args.size() < 2 ? 3 : std::max(strutil::asInt(args[1]), 1);
+	const auto pal          = maineditor::currentPalette();
+	std::mt19937 rng(1234);
+	const auto   rand_int = [&rng](int min, int max) { return std::uniform_int_distribution<int>(min, max)(rng); };
+
+	// Generate paletted patches with some transparent pixels
+	vector<unique_ptr<SImage>> patches;
+	for (int a = 0; a < 32; ++a)
+	{
+		auto patch = std::make_unique<SImage>(SImage::Type::PalMask);
+		patch->create(rand_int(8, 128), rand_int(8, 128), SImage::Type::PalMask);
+		for (int y = 0; y < patch->height(); ++y)
+			for (int x = 0; x < patch->width(); ++x)
+				patch->setPixel(x, y, rand_int(0, 255), rand_int(0, 4) == 0 ? 0 : 255);
+		patches.push_back(std::move(patch));
+	}
+
+	// Generate extended texture definitions with flipped and rotated patches
+	struct PatchDef
+	{
+		SImage* image;
+		int     x, y;
+		bool    flip_x, flip_y;
+		int     rotation;
+	};
+	struct TextureDef
+	{
+		int              width, height;
+		vector<PatchDef> patches;
+	};
+	vector<TextureDef> textures(num_textures);
+	for (auto& tex : textures)
+	{
+		tex.width  = 64 << rand_int(0, 2);
+		tex.height = 64 << rand_int(0, 1);
+		for (int p = rand_int(2, 8); p > 0; --p)
+			tex.patches.push_back({ patches[rand_int(0, 31)].get(),
+									rand_int(-32, tex.width - 8),
+									rand_int(-32, tex.height - 8),
+									rand_int(0, 1) == 1,
+									rand_int(0, 3) == 0,
+									rand_int(0, 3) * 90 });
+	}
+
+	// Copies the pixels of [image] to a new buffer, remapped by [remap], which
+	// gives the new position of each pixel
+	const auto remap_copy = [](SImage& image, int width, int height, auto remap)
+	{
+		MemChunk out(image.width() * image.height() * 4);
+		for (int y = 0; y < image.height(); ++y)
+			for (int x = 0; x < image.width(); ++x)
+				image.pixelAt(x, y).write(out.data() + remap(x, y) * 4);
+		image.setImageData(out.data(), out.size(), width, height, SImage::Type::RGBA);
+	};
+
+	// Build all textures once with a straightforward per-pixel reference of the
+	// patch conversions, to check the results of the SImage operations against
+	SImage::DrawProps dp;
+	dp.src_alpha = false;
+	vector<unique_ptr<SImage>> reference;
+	for (const auto& tex : textures)
+	{
+		auto image = std::make_unique<SImage>(SImage::Type::RGBA);
+		image->create(tex.width, tex.height, SImage::Type::RGBA);
+		for (const auto& patch : tex.patches)
+		{
+			const int w = patch.image->width();
+			const int h = patch.image->height();
+
+			SImage   p_img(SImage::Type::RGBA);
+			MemChunk rgba;
+			patch.image->putRGBAData(rgba, pal);
+			p_img.setImageData(rgba.data(), rgba.size(), w, h, SImage::Type::RGBA);
+
+			if (patch.flip_x)
+				remap_copy(p_img, w, h, [w](int x, int y) { return y * w + (w - 1 - x); });
+			if (patch.flip_y)
+				remap_copy(p_img, w, h, [w, h](int x, int y) { return (h - 1 - y) * w + x; });
+			if (patch.rotation == 90)
+				remap_copy(p_img, h, w, [h](int x, int y) { return x * h + (h - 1 - y); });
+			else if (patch.rotation == 180)
+				remap_copy(p_img, w, h, [w, h](int x, int y) { return (h - 1 - y) * w + (w - 1 - x); });
+			else if (patch.rotation == 270)
+				remap_copy(p_img, h, w, [w, h](int x, int y) { return (w - 1 - x) * h + y; });
+
+			image->drawImage(p_img, patch.x, patch.y, dp, pal, pal);
+		}
+		reference.push_back(std::move(image));
+	}
+
+	// Build all textures as CTexture::toImage does with force_rgba, counting
+	// pixel buffer allocations (MemChunks and SImage scratch buffers). The
+	// first iteration includes growing the scratch buffers
+	wxStopWatch sw;
+	long        time_ms    = 0;
+	unsigned    allocs     = 0;
+	unsigned    mismatches = 0;
+	for (int i = 0; i < iterations; ++i)
+	{
+		vector<unique_ptr<SImage>> results;
+		SImage                     p_img(SImage::Type::RGBA);
+		const auto                 allocs_start = MemChunk::allocationCount() + scratch_alloc_count;
+		sw.Start();
+		for (const auto& tex : textures)
+		{
+			auto image = std::make_unique<SImage>(SImage::Type::RGBA);
+			image->create(tex.width, tex.height, SImage::Type::RGBA);
+			for (const auto& patch : tex.patches)
+			{
+				p_img.copyImage(patch.image);
+				p_img.convertRGBA(pal);
+				if (patch.flip_x)
+					p_img.mirror(false);
+				if (patch.flip_y)
+					p_img.mirror(true);
+				if (patch.rotation != 0)
+					p_img.rotate(patch.rotation);
+
+				image->drawImage(p_img, patch.x, patch.y, dp, pal, pal);
+			}
+			results.push_back(std::move(image));
+		}
+		time_ms += sw.Time();
+		allocs += MemChunk::allocationCount() + scratch_alloc_count - allocs_start;
+
+		for (unsigned t = 0; t < textures.size(); ++t)
+		{
+			MemChunk rgba1, rgba2;
+			results[t]->putRGBAData(rgba1);
+			reference[t]->putRGBAData(rgba2);
+			if (rgba1.size() != rgba2.size() || memcmp(rgba1.data(), rgba2.data(), rgba1.size()) != 0)
+				mismatches++;
+		}
+	}
+
+	log::console(fmt::format(
+		"{} textures: {}ms, {:.1f} pixel buffer allocations per texture (average over {} iterations), "
+		"{} mismatched against reference",
+		num_textures,
+		time_ms / iterations,
+		allocs / (static_cast<double>(num_textures) * iterations),
+		iterations,
+		mismatches));
+}
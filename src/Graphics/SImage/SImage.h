@@ -161,6 +161,13 @@ public:
 		DrawProps& properties,
 		Palette*   pal_src  = nullptr,
 		Palette*   pal_dest = nullptr);
+	bool drawImagePixels(
+		SImage&    img,
+		int        x,
+		int        y,
+		DrawProps& properties,
+		Palette*   pal_src  = nullptr,
+		Palette*   pal_dest = nullptr);
 	bool colourise(ColRGBA colour, Palette* pal = nullptr, int start = -1, int stop = -1);
 	bool tint(ColRGBA colour, float amount, Palette* pal = nullptr, int start = -1, int stop = -1);
 	bool adjust();
@@ -193,5 +200,6 @@ private:
 
 	// Internal functions
 	void clearData(bool clear_mask = true);
+	bool writeRGBA(uint8_t* dest, Palette* pal) const;
 };
 } // namespace slade
@@ -0,0 +1,377 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2022 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         https://slade.mancubus.net
+// Filename:    SImageBlit.cpp
+// Description: Row kernels for compositing SImages (see SImage::drawImage).
+//              There is a kernel for each blend mode and source alpha setting,
+//              with SSE2 versions for truecolour destinations where available.
+//              All kernels give exactly the same results as SImage::drawPixel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "SImageBlit.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SLADE_BLIT_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace slade;
+using BlendType = SImage::BlendType;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Clamps [val] to 0-255 and truncates it to a byte
+// -----------------------------------------------------------------------------
+inline uint8_t clampByte(double val)
+{
+	return static_cast<uint8_t>(val < 0. ? 0. : (val > 255. ? 255. : val));
+}
+
+// -----------------------------------------------------------------------------
+// Returns the alpha to draw a source pixel with alpha [src_alpha] with, or 0 if
+// it shouldn't be drawn at all
+// -----------------------------------------------------------------------------
+template<bool SrcAlpha> inline uint8_t drawAlpha(uint8_t src_alpha, float alpha, uint8_t const_alpha)
+{
+	if (src_alpha == 0)
+		return 0;
+
+	if constexpr (SrcAlpha)
+		return static_cast<uint8_t>(src_alpha * alpha);
+	else
+		return const_alpha;
+}
+
+// -----------------------------------------------------------------------------
+// Blends RGBA pixel [src] with alpha [a] onto RGBA pixel [dest]
+// -----------------------------------------------------------------------------
+template<BlendType B> inline void blendPixel(const uint8_t* src, uint8_t a, uint8_t* dest)
+{
+	const float alpha = static_cast<float>(a) / 255.0f;
+
+	for (int c = 0; c < 3; ++c)
+	{
+		if constexpr (B == BlendType::Add)
+			dest[c] = clampByte(dest[c] + src[c] * alpha);
+		else if constexpr (B == BlendType::Subtract)
+			dest[c] = clampByte(dest[c] - src[c] * alpha);
+		else if constexpr (B == BlendType::ReverseSubtract)
+			dest[c] = clampByte((-dest[c]) + src[c] * alpha);
+		else if constexpr (B == BlendType::Modulate)
+			dest[c] = clampByte(src[c] * static_cast<double>(dest[c]) / 255.);
+		else
+			dest[c] = static_cast<uint8_t>(dest[c] * (1.0f - alpha) + src[c] * alpha);
+	}
+
+	dest[3] = std::min(255, dest[3] + a);
+}
+
+#ifdef SLADE_BLIT_SSE2
+// -----------------------------------------------------------------------------
+// Blends one colour channel of 4 pixels, [s] onto [d] (each 0-255 in 32bit
+// lanes) with per-pixel [alpha] and [inv_alpha].
+// Float operations are done in the same order as in blendPixel, so results
+// are identical
+// -----------------------------------------------------------------------------
+template<BlendType B> inline __m128i blendChannelSSE2(__m128i s, __m128i d, __m128 alpha, __m128 inv_alpha)
+{
+	const __m128 sf = _mm_cvtepi32_ps(s);
+	const __m128 df = _mm_cvtepi32_ps(d);
+
+	__m128 res;
+	if constexpr (B == BlendType::Add)
+		res = _mm_add_ps(df, _mm_mul_ps(sf, alpha));
+	else if constexpr (B == BlendType::Subtract)
+		res = _mm_sub_ps(df, _mm_mul_ps(sf, alpha));
+	else if constexpr (B == BlendType::ReverseSubtract)
+		res = _mm_sub_ps(_mm_mul_ps(sf, alpha), df);
+	else if constexpr (B == BlendType::Modulate)
+		res = _mm_div_ps(_mm_mul_ps(sf, df), _mm_set1_ps(255.0f)); // s * d is exact, so float is enough
+	else
+		res = _mm_add_ps(_mm_mul_ps(df, inv_alpha), _mm_mul_ps(sf, alpha));
+
+	res = _mm_min_ps(_mm_max_ps(res, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+	return _mm_cvttps_epi32(res);
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Blends [count] RGBA pixels from [src] onto RGBA row [dest]
+// -----------------------------------------------------------------------------
+template<BlendType B, bool SrcAlpha> void rowKernelRGBA(const uint8_t* src, uint8_t* dest, unsigned count, float alpha)
+{
+	const uint8_t const_alpha = 255 * alpha;
+	unsigned      i           = 0;
+
+#ifdef SLADE_BLIT_SSE2
+	const __m128i zero       = _mm_setzero_si128();
+	const __m128i byte_mask  = _mm_set1_epi32(0xFF);
+	const __m128  prop_alpha = _mm_set1_ps(alpha);
+	for (; i + 4 <= count; i += 4)
+	{
+		const auto    sp = reinterpret_cast<const __m128i*>(src + i * 4);
+		const auto    dp = reinterpret_cast<__m128i*>(dest + i * 4);
+		const __m128i s  = _mm_loadu_si128(sp);
+		const __m128i d  = _mm_loadu_si128(dp);
+
+		// Determine alpha to draw each pixel with
+		const __m128i s_a = _mm_srli_epi32(s, 24);
+		__m128i       a;
+		if constexpr (SrcAlpha)
+			a = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(s_a), prop_alpha)), byte_mask);
+		else
+			a = _mm_set1_epi32(const_alpha);
+
+		// Skip if all 4 pixels are transparent
+		const __m128i skip = _mm_or_si128(_mm_cmpeq_epi32(s_a, zero), _mm_cmpeq_epi32(a, zero));
+		if (_mm_movemask_epi8(skip) == 0xFFFF)
+			continue;
+
+		const __m128 fa     = _mm_div_ps(_mm_cvtepi32_ps(a), _mm_set1_ps(255.0f));
+		const __m128 inv_fa = _mm_sub_ps(_mm_set1_ps(1.0f), fa);
+
+		// Blend
+		const __m128i r = blendChannelSSE2<B>(_mm_and_si128(s, byte_mask), _mm_and_si128(d, byte_mask), fa, inv_fa);
+		const __m128i g = blendChannelSSE2<B>(
+			_mm_and_si128(_mm_srli_epi32(s, 8), byte_mask), _mm_and_si128(_mm_srli_epi32(d, 8), byte_mask), fa, inv_fa);
+		const __m128i b = blendChannelSSE2<B>(
+			_mm_and_si128(_mm_srli_epi32(s, 16), byte_mask),
+			_mm_and_si128(_mm_srli_epi32(d, 16), byte_mask),
+			fa,
+			inv_fa);
+		const __m128i out_a = _mm_min_epi16(_mm_add_epi32(_mm_srli_epi32(d, 24), a), byte_mask);
+
+		// Pack and write, keeping skipped destination pixels
+		__m128i out = _mm_or_si128(
+			_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(out_a, 24)));
+		out = _mm_or_si128(_mm_and_si128(skip, d), _mm_andnot_si128(skip, out));
+		_mm_storeu_si128(dp, out);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const auto a = drawAlpha<SrcAlpha>(src[i * 4 + 3], alpha, const_alpha);
+		if (a > 0)
+			blendPixel<B>(src + i * 4, a, dest + i * 4);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Copies [count] RGBA pixels from [src] to RGBA row [dest] as fully opaque,
+// skipping fully transparent source pixels.
+// This is normal blending at full alpha without source alpha, which is how
+// most composite texture patches are drawn
+// -----------------------------------------------------------------------------
+void copyRowOpaque(const uint8_t* src, uint8_t* dest, unsigned count)
+{
+	unsigned i = 0;
+
+#ifdef SLADE_BLIT_SSE2
+	const __m128i zero       = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32(0xFF000000);
+	for (; i + 4 <= count; i += 4)
+	{
+		const auto    sp          = reinterpret_cast<const __m128i*>(src + i * 4);
+		const auto    dp          = reinterpret_cast<__m128i*>(dest + i * 4);
+		const __m128i s           = _mm_loadu_si128(sp);
+		const __m128i d           = _mm_loadu_si128(dp);
+		const __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), zero);
+		const __m128i opaque      = _mm_or_si128(s, alpha_mask);
+		_mm_storeu_si128(dp, _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, opaque)));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const auto p = i * 4;
+		if (src[p + 3] == 0)
+			continue;
+
+		dest[p]     = src[p];
+		dest[p + 1] = src[p + 1];
+		dest[p + 2] = src[p + 2];
+		dest[p + 3] = 255;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Blends [count] RGBA pixels from [src] onto paletted row [dest] (with alpha
+// [dest_mask]), using [pal] for the destination colours
+// -----------------------------------------------------------------------------
+template<BlendType B, bool SrcAlpha>
+void rowKernelPalMask(const uint8_t* src, uint8_t* dest, uint8_t* dest_mask, unsigned count, float alpha, Palette& pal)
+{
+	const uint8_t const_alpha = 255 * alpha;
+	uint8_t       d[4];
+
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const auto a = drawAlpha<SrcAlpha>(src[i * 4 + 3], alpha, const_alpha);
+		if (a == 0)
+			continue;
+
+		pal.colour(dest[i]).write(d);
+		blendPixel<B>(src + i * 4, a, d);
+		dest[i]      = pal.nearestColour(ColRGBA(d[0], d[1], d[2], d[3]));
+		dest_mask[i] = d[3];
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Selects the RGBA row kernel for blend mode [B] and the [props] alpha setup
+// -----------------------------------------------------------------------------
+template<BlendType B>
+void blendRowRGBAMode(const uint8_t* src, uint8_t* dest, unsigned count, const SImage::DrawProps& props)
+{
+	if (props.src_alpha)
+		rowKernelRGBA<B, true>(src, dest, count, props.alpha);
+	else if (B == BlendType::Normal && static_cast<uint8_t>(255 * props.alpha) == 255)
+		copyRowOpaque(src, dest, count);
+	else
+		rowKernelRGBA<B, false>(src, dest, count, props.alpha);
+}
+
+// -----------------------------------------------------------------------------
+// Selects the paletted row kernel for blend mode [B] and the [props] alpha
+// setup
+// -----------------------------------------------------------------------------
+template<BlendType B>
+void blendRowPalMaskMode(
+	const uint8_t*           src,
+	uint8_t*                 dest,
+	uint8_t*                 dest_mask,
+	unsigned                 count,
+	const SImage::DrawProps& props,
+	Palette&                 pal)
+{
+	if (props.src_alpha)
+		rowKernelPalMask<B, true>(src, dest, dest_mask, count, props.alpha, pal);
+	else
+		rowKernelPalMask<B, false>(src, dest, dest_mask, count, props.alpha, pal);
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Blit Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Writes the colours of [pal] to [out] as consecutive RGBA values
+// -----------------------------------------------------------------------------
+void blit::buildPaletteRGBA(const Palette& pal, PaletteRGBA& out)
+{
+	for (unsigned i = 0; i < 256; ++i)
+		pal.colour(i).write(out.data() + i * 4);
+}
+
+// -----------------------------------------------------------------------------
+// Expands [count] paletted pixels ([data] indices with alpha [mask]) to RGBA
+// in [out], using palette colours [pal]
+// -----------------------------------------------------------------------------
+void blit::fetchRowPalMask(
+	const uint8_t*     data,
+	const uint8_t*     mask,
+	const PaletteRGBA& pal,
+	uint8_t*           out,
+	unsigned           count)
+{
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const auto c = pal.data() + data[i] * 4;
+		out[0]       = c[0];
+		out[1]       = c[1];
+		out[2]       = c[2];
+		out[3]       = mask[i];
+		out += 4;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Expands [count] alpha map pixels from [data] to RGBA in [out]
+// -----------------------------------------------------------------------------
+void blit::fetchRowAlphaMap(const uint8_t* data, uint8_t* out, unsigned count)
+{
+	for (unsigned i = 0; i < count; ++i)
+	{
+		memset(out, data[i], 4);
+		out += 4;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Blends [count] RGBA pixels from [src] onto RGBA row [dest], according to
+// the blending options in [props]
+// -----------------------------------------------------------------------------
+void blit::blendRowRGBA(const uint8_t* src, uint8_t* dest, unsigned count, const SImage::DrawProps& props)
+{
+	switch (props.blend)
+	{
+	case BlendType::Add: blendRowRGBAMode<BlendType::Add>(src, dest, count, props); break;
+	case BlendType::Subtract: blendRowRGBAMode<BlendType::Subtract>(src, dest, count, props); break;
+	case BlendType::ReverseSubtract: blendRowRGBAMode<BlendType::ReverseSubtract>(src, dest, count, props); break;
+	case BlendType::Modulate: blendRowRGBAMode<BlendType::Modulate>(src, dest, count, props); break;
+	default: blendRowRGBAMode<BlendType::Normal>(src, dest, count, props); break;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Blends [count] RGBA pixels from [src] onto paletted row [dest] (with alpha
+// [dest_mask]), according to the blending options in [props]. Resulting
+// colours are converted to their nearest match in [pal]
+// -----------------------------------------------------------------------------
+void blit::blendRowPalMask(
+	const uint8_t*           src,
+	uint8_t*                 dest,
+	uint8_t*                 dest_mask,
+	unsigned                 count,
+	const SImage::DrawProps& props,
+	Palette&                 pal)
+{
+	switch (props.blend)
+	{
+	case BlendType::Add: blendRowPalMaskMode<BlendType::Add>(src, dest, dest_mask, count, props, pal); break;
+	case BlendType::Subtract: blendRowPalMaskMode<BlendType::Subtract>(src, dest, dest_mask, count, props, pal); break;
+	case BlendType::ReverseSubtract:
+		blendRowPalMaskMode<BlendType::ReverseSubtract>(src, dest, dest_mask, count, props, pal);
+		break;
+	case BlendType::Modulate: blendRowPalMaskMode<BlendType::Modulate>(src, dest, dest_mask, count, props, pal); break;
+	default: blendRowPalMaskMode<BlendType::Normal>(src, dest, dest_mask, count, props, pal); break;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "SImage.h"
+#include <array>
+
+namespace slade
+{
+// Row kernels used by SImage::drawImage to composite one image onto another.
+// Source rows are first expanded to RGBA (a source alpha of 0 means the pixel
+// is not drawn), then blended onto the destination row according to the
+// DrawProps blend mode and alpha settings
+namespace blit
+{
+	using PaletteRGBA = std::array<uint8_t, 1024>;
+
+	void buildPaletteRGBA(const Palette& pal, PaletteRGBA& out);
+
+	// Source row expansion
+	void fetchRowPalMask(
+		const uint8_t*     data,
+		const uint8_t*     mask,
+		const PaletteRGBA& pal,
+		uint8_t*           out,
+		unsigned           count);
+	void fetchRowAlphaMap(const uint8_t* data, uint8_t* out, unsigned count);
+
+	// Destination row blending
+	void blendRowRGBA(const uint8_t* src, uint8_t* dest, unsigned count, const SImage::DrawProps& props);
+	void blendRowPalMask(
+		const uint8_t*           src,
+		uint8_t*                 dest,
+		uint8_t*                 dest_mask,
+		unsigned                 count,
+		const SImage::DrawProps& props,
+		Palette&                 pal);
+} // namespace blit
+} // namespace slade
@@ -87,6 +87,160 @@ enum SpecialBlend
 	Gold,
 	Invalid,
 };
+
+// -----------------------------------------------------------------------------
+// Returns the SpecialBlend type for the ZDoom built-in translation [name]
+// -----------------------------------------------------------------------------
+uint8_t builtInBlendType(string_view name, uint8_t desat_amount)
+{
+	if (strutil::equalCI(name, "ice"))
+		return SpecialBlend::Ice;
+	if (strutil::equalCI(name, "inverse"))
+		return SpecialBlend::Inverse;
+	if (strutil::equalCI(name, "red"))
+		return SpecialBlend::Red;
+	if (strutil::equalCI(name, "green"))
+		return SpecialBlend::Green;
+	if (strutil::equalCI(name, "blue"))
+		return SpecialBlend::Blue;
+	if (strutil::equalCI(name, "gold"))
+		return SpecialBlend::Gold;
+	if (strutil::equalCI(name, "desaturate"))
+		return desat_amount; // min 1, max 31 required
+
+	return SpecialBlend::Invalid;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the SpecialBlend type for the special range definition [spec]
+// -----------------------------------------------------------------------------
+uint8_t specialRangeBlendType(string_view spec)
+{
+	if (strutil::equalCI(spec, "ice"))
+		return SpecialBlend::Ice;
+	if (strutil::equalCI(spec, "inverse"))
+		return SpecialBlend::Inverse;
+	if (strutil::equalCI(spec, "red"))
+		return SpecialBlend::Red;
+	if (strutil::equalCI(spec, "green"))
+		return SpecialBlend::Green;
+	if (strutil::equalCI(spec, "blue"))
+		return SpecialBlend::Blue;
+	if (strutil::equalCI(spec, "gold"))
+		return SpecialBlend::Gold;
+	if (strutil::startsWithCI(spec, "desat"))
+	{
+		// This relies on SpecialBlend::1 to ::31 being occupied with desat
+		int temp;
+		if (strutil::toInt(strutil::rightV(spec, 2), temp) && temp < 32 && temp > 0)
+			return temp;
+	}
+
+	return SpecialBlend::Invalid;
+}
+
+// -----------------------------------------------------------------------------
+// Applies the (non-special) translation [range] to [col] (at palette index
+// [i]), writing the result to [colour]
+// -----------------------------------------------------------------------------
+void applyRange(const TransRange& range, const ColRGBA& col, uint8_t i, ColRGBA& colour, Palette* pal)
+{
+	// Palette range translation
+	if (range.type() == TransRange::Type::Palette)
+	{
+		const auto& tp = static_cast<const TransRangePalette&>(range);
+
+		// Figure out how far along the range this colour is
+		double range_frac = 0;
+		if (tp.start() != tp.end())
+			range_frac = static_cast<double>(i - tp.start()) / static_cast<double>(tp.end() - tp.start());
+
+		// Determine destination palette index
+		const uint8_t di = tp.dStart() + range_frac * (tp.dEnd() - tp.dStart());
+
+		// Apply new colour
+		const auto c = pal->colour(di);
+		colour.r     = c.r;
+		colour.g     = c.g;
+		colour.b     = c.b;
+		colour.a     = c.a;
+		colour.index = di;
+	}
+
+	// Colour range
+	else if (range.type() == TransRange::Type::Colour)
+	{
+		const auto& tc = static_cast<const TransRangeColour&>(range);
+
+		// Figure out how far along the range this colour is
+		double range_frac = 0;
+		if (tc.start() != tc.end())
+			range_frac = static_cast<double>(i - tc.start()) / static_cast<double>(tc.end() - tc.start());
+
+		// Apply new colour
+		colour.r     = tc.startColour().r + range_frac * (tc.endColour().r - tc.startColour().r);
+		colour.g     = tc.startColour().g + range_frac * (tc.endColour().g - tc.startColour().g);
+		colour.b     = tc.startColour().b + range_frac * (tc.endColour().b - tc.startColour().b);
+		colour.index = pal->nearestColour(colour);
+	}
+
+	// Desaturated colour range
+	else if (range.type() == TransRange::Type::Desat)
+	{
+		const auto& td = static_cast<const TransRangeDesat&>(range);
+
+		// Get greyscale colour
+		const auto  gcol = pal->colour(i);
+		const float grey = (gcol.r * 0.3f + gcol.g * 0.59f + gcol.b * 0.11f) / 255.0f;
+
+		// Apply new colour
+		auto& start  = td.rgbStart();
+		auto& end    = td.rgbEnd();
+		colour.r     = std::min(255, static_cast<int>((start.r + grey * (end.r - start.r)) * 255.0f));
+		colour.g     = std::min(255, static_cast<int>((start.g + grey * (end.g - start.g)) * 255.0f));
+		colour.b     = std::min(255, static_cast<int>((start.b + grey * (end.b - start.b)) * 255.0f));
+		colour.index = pal->nearestColour(colour);
+	}
+
+	// Blended range
+	else if (range.type() == TransRange::Type::Blend)
+	{
+		const auto& tc = static_cast<const TransRangeBlend&>(range);
+
+		// Get colours
+		const auto& blend = tc.colour();
+
+		// Colourise
+		float grey = (col.r * col_greyscale_r + col.g * col_greyscale_g + col.b * col_greyscale_b) / 255.0f;
+		if (grey > 1.0f)
+			grey = 1.0f;
+
+		// Apply new colour
+		colour.r     = blend.r * grey;
+		colour.g     = blend.g * grey;
+		colour.b     = blend.b * grey;
+		colour.index = pal->nearestColour(colour);
+	}
+
+	// Tinted range
+	else if (range.type() == TransRange::Type::Tint)
+	{
+		const auto& tt = static_cast<const TransRangeTint&>(range);
+
+		// Get colours
+		const auto tint = tt.colour();
+
+		// Colourise
+		const float amount  = tt.amount() * 0.01f;
+		const float inv_amt = 1.0f - amount;
+
+		// Apply new colour
+		colour.r     = col.r * inv_amt + tint.r * amount;
+		colour.g     = col.g * inv_amt + tint.g * amount;
+		colour.b     = col.b * inv_amt + tint.b * amount;
+		colour.index = pal->nearestColour(colour);
+	}
+}
 } // namespace
 
 
@@ -464,43 +618,22 @@ TransRange* Translation::range(unsigned index)
 // -----------------------------------------------------------------------------
 ColRGBA Translation::translate(const ColRGBA& col, Palette* pal)
 {
-	ColRGBA colour(col);
 	if (pal == nullptr)
 		pal = maineditor::currentPalette();
-	const uint8_t i = (col.index == -1) ? pal->nearestColour(col) : col.index;
 
 	// Handle ZDoom's predefined texture blending:
 	// blue, gold, green, red, ice, inverse, and desaturate
 	if (!built_in_name_.empty())
-	{
-		int type = SpecialBlend::Invalid;
-		if (strutil::equalCI(built_in_name_, "ice"))
-			type = SpecialBlend::Ice;
-		else if (strutil::equalCI(built_in_name_, "inverse"))
-			type = SpecialBlend::Inverse;
-		else if (strutil::equalCI(built_in_name_, "red"))
-			type = SpecialBlend::Red;
-		else if (strutil::equalCI(built_in_name_, "green"))
-			type = SpecialBlend::Green;
-		else if (strutil::equalCI(built_in_name_, "blue"))
-			type = SpecialBlend::Blue;
-		else if (strutil::equalCI(built_in_name_, "gold"))
-			type = SpecialBlend::Gold;
-		else if (strutil::equalCI(built_in_name_, "desaturate"))
-			type = desat_amount_; // min 1, max 31 required
-
-		return specialBlend(col, type, pal);
-	}
+		return specialBlend(col, builtInBlendType(built_in_name_, desat_amount_), pal);
 
 	// Check for perfect palette matches
-	const bool match = col.equals(pal->colour(i));
+	const uint8_t i     = (col.index == -1) ? pal->nearestColour(col) : col.index;
+	const bool    match = col.equals(pal->colour(i));
 
 	// Go through each translation component
-	// for (unsigned a = 0; a < nRanges(); a++)
+	ColRGBA colour(col);
 	for (auto& range : translations_)
 	{
-		// unique_ptr<TransRange>& range = translations_[a];
-
 		// Check pixel is within translation range
 		if (i < range->start() || i > range->end())
 			continue;
@@ -509,129 +642,14 @@ ColRGBA Translation::translate(const ColRGBA& col, Palette* pal)
 		if (!match && range->start() != 0 && range->end() != 255)
 			continue;
 
-		// Palette range translation
-		if (range->type() == TransRange::Type::Palette)
-		{
-			const auto tp = dynamic_cast<TransRangePalette*>(range.get());
-
-			// Figure out how far along the range this colour is
-			double range_frac = 0;
-			if (tp->start() != tp->end())
-				range_frac = static_cast<double>(i - tp->start()) / static_cast<double>(tp->end() - tp->start());
-
-			// Determine destination palette index
-			const uint8_t di = tp->dStart() + range_frac * (tp->dEnd() - tp->dStart());
-
-			// Apply new colour
-			const auto c = pal->colour(di);
-			colour.r     = c.r;
-			colour.g     = c.g;
-			colour.b     = c.b;
-			colour.a     = c.a;
-			colour.index = di;
-		}
-
-		// Colour range
-		else if (range->type() == TransRange::Type::Colour)
-		{
-			const auto tc = dynamic_cast<TransRangeColour*>(range.get());
-
-			// Figure out how far along the range this colour is
-			double range_frac = 0;
-			if (tc->start() != tc->end())
-				range_frac = static_cast<double>(i - tc->start()) / static_cast<double>(tc->end() - tc->start());
-
-			// Apply new colour
-			colour.r     = tc->startColour().r + range_frac * (tc->endColour().r - tc->startColour().r);
-			colour.g     = tc->startColour().g + range_frac * (tc->endColour().g - tc->startColour().g);
-			colour.b     = tc->startColour().b + range_frac * (tc->endColour().b - tc->startColour().b);
-			colour.index = pal->nearestColour(colour);
-		}
-
-		// Desaturated colour range
-		else if (range->type() == TransRange::Type::Desat)
-		{
-			const auto td = dynamic_cast<TransRangeDesat*>(range.get());
-
-			// Get greyscale colour
-			const auto  gcol = pal->colour(i);
-			const float grey = (gcol.r * 0.3f + gcol.g * 0.59f + gcol.b * 0.11f) / 255.0f;
-
-			// Apply new colour
-			auto& start  = td->rgbStart();
-			auto& end    = td->rgbEnd();
-			colour.r     = std::min(255, static_cast<int>((start.r + grey * (end.r - start.r)) * 255.0f));
-			colour.g     = std::min(255, static_cast<int>((start.g + grey * (end.g - start.g)) * 255.0f));
-			colour.b     = std::min(255, static_cast<int>((start.b + grey * (end.b - start.b)) * 255.0f));
-			colour.index = pal->nearestColour(colour);
-		}
-
-		// Blended range
-		else if (range->type() == TransRange::Type::Blend)
-		{
-			const auto tc = dynamic_cast<TransRangeBlend*>(range.get());
-
-			// Get colours
-			const auto& blend = tc->colour();
-
-			// Colourise
-			float grey = (col.r * col_greyscale_r + col.g * col_greyscale_g + col.b * col_greyscale_b) / 255.0f;
-			if (grey > 1.0f)
-				grey = 1.0f;
-
-			// Apply new colour
-			colour.r     = blend.r * grey;
-			colour.g     = blend.g * grey;
-			colour.b     = blend.b * grey;
-			colour.index = pal->nearestColour(colour);
-		}
-
-		// Tinted range
-		else if (range->type() == TransRange::Type::Tint)
-		{
-			const auto tt = dynamic_cast<TransRangeTint*>(range.get());
-
-			// Get colours
-			const auto tint = tt->colour();
-
-			// Colourise
-			const float amount  = tt->amount() * 0.01f;
-			const float inv_amt = 1.0f - amount;
-
-			// Apply new colour
-			colour.r     = col.r * inv_amt + tint.r * amount;
-			colour.g     = col.g * inv_amt + tint.g * amount;
-			colour.b     = col.b * inv_amt + tint.b * amount;
-			colour.index = pal->nearestColour(colour);
-		}
-
 		// Special range
-		else if (range->type() == TransRange::Type::Special)
+		if (range->type() == TransRange::Type::Special)
 		{
-			const auto  ts   = dynamic_cast<TransRangeSpecial*>(range.get());
-			const auto& spec = ts->special();
-			uint8_t     type = Invalid;
-			if (strutil::equalCI(spec, "ice"))
-				type = SpecialBlend::Ice;
-			else if (strutil::equalCI(spec, "inverse"))
-				type = SpecialBlend::Inverse;
-			else if (strutil::equalCI(spec, "red"))
-				type = SpecialBlend::Red;
-			else if (strutil::equalCI(spec, "green"))
-				type = SpecialBlend::Green;
-			else if (strutil::equalCI(spec, "blue"))
-				type = SpecialBlend::Blue;
-			else if (strutil::equalCI(spec, "gold"))
-				type = SpecialBlend::Gold;
-			else if (strutil::startsWithCI(spec, "desat"))
-			{
-				// This relies on SpecialBlend::1 to ::31 being occupied with desat
-				int temp;
-				if (strutil::toInt(strutil::rightV(spec, 2), temp) && temp < 32 && temp > 0)
-					type = temp;
-			}
-			return specialBlend(col, type, pal);
+			const auto ts = dynamic_cast<TransRangeSpecial*>(range.get());
+			return specialBlend(col, specialRangeBlendType(ts->special()), pal);
 		}
+
+		applyRange(*range, col, i, colour, pal);
 	}
 	return colour;
 }
@@ -877,3 +895,77 @@ string Translation::getPredefined(string_view def)
 
 	return string{ def };
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// CompiledTranslation Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// CompiledTranslation class constructor.
+// Resolves [translation] against [pal] (or the current palette if none given)
+// -----------------------------------------------------------------------------
+CompiledTranslation::CompiledTranslation(const Translation& translation, Palette* pal) :
+	palette_{ pal ? pal : maineditor::currentPalette() }
+{
+	// Resolve built-in translation or range kernels
+	if (!translation.builtInName().empty())
+	{
+		built_in_       = true;
+		built_in_blend_ = builtInBlendType(translation.builtInName(), translation.desaturationAmount());
+	}
+	else
+	{
+		kernels_.reserve(translation.nRanges());
+		for (const auto& range : translation.ranges())
+		{
+			uint8_t blend = SpecialBlend::Invalid;
+			if (range->type() == TransRange::Type::Special)
+				blend = specialRangeBlendType(static_cast<TransRangeSpecial*>(range.get())->special());
+
+			kernels_.push_back({ range.get(), blend });
+		}
+	}
+
+	// Build remap table for paletted pixels
+	for (unsigned i = 0; i < 256; ++i)
+		table_[i] = translate(palette_->colour(i));
+}
+
+// -----------------------------------------------------------------------------
+// Applies the translation to the given colour.
+// Gives the same result as Translation::translate with the compiled palette
+// -----------------------------------------------------------------------------
+ColRGBA CompiledTranslation::translate(const ColRGBA& col) const
+{
+	if (built_in_)
+		return Translation::specialBlend(col, built_in_blend_, palette_);
+
+	// Check for perfect palette matches
+	const uint8_t i     = (col.index == -1) ? palette_->nearestColour(col) : col.index;
+	const bool    match = col.equals(palette_->colour(i));
+
+	// Go through each translation kernel
+	ColRGBA colour(col);
+	for (const auto& kernel : kernels_)
+	{
+		const auto& range = *kernel.range;
+
+		// Check pixel is within translation range
+		if (i < range.start() || i > range.end())
+			continue;
+
+		// Only allow exact matches unless the translation applies to all colours
+		if (!match && range.start() != 0 && range.end() != 255)
+			continue;
+
+		if (range.type() == TransRange::Type::Special)
+			return Translation::specialBlend(col, kernel.blend, palette_);
+
+		applyRange(range, col, i, colour, palette_);
+	}
+	return colour;
+}
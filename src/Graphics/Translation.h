@@ -1,5 +1,6 @@
 #pragma once
 #include "Utility/Colour.h"
+#include <array>
 
 namespace slade
 {
@@ -294,4 +295,32 @@ private:
 	string                         built_in_name_;
 	uint8_t                        desat_amount_ = 0;
 };
+
+// A Translation resolved against a specific palette, for applying it in bulk.
+// Paletted pixels are looked up in a flat 256-entry table, truecolour pixels
+// go through the ranges with their types and special blends pre-resolved
+class CompiledTranslation
+{
+public:
+	CompiledTranslation(const Translation& translation, Palette* pal = nullptr);
+	~CompiledTranslation() = default;
+
+	Palette*       palette() const { return palette_; }
+	const ColRGBA& colour(uint8_t index) const { return table_[index]; }
+
+	ColRGBA translate(const ColRGBA& col) const;
+
+private:
+	struct Kernel
+	{
+		const TransRange* range;
+		uint8_t           blend; // Special ranges only
+	};
+
+	Palette*                 palette_        = nullptr;
+	bool                     built_in_       = false;
+	uint8_t                  built_in_blend_ = 0;
+	vector<Kernel>           kernels_;
+	std::array<ColRGBA, 256> table_;
+};
 } // namespace slade
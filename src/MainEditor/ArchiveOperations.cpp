@@ -37,6 +37,7 @@
 #include "Archive/Formats/WadArchive.h"
 #include "General/Console.h"
 #include "General/ResourceManager.h"
+#include "Graphics/CTexture/PatchCache.h"
 #include "Graphics/CTexture/TextureXList.h"
 #include "MainEditor/MainEditor.h"
 #include "MainEditor/UI/MainWindow.h"
@@ -110,8 +111,8 @@ bool archiveoperations::save(Archive& archive)
 		{
 			auto   messages = log::since(time);
 			string msg_log_str;
-			for (const auto* msg : messages)
-				msg_log_str += msg->formattedMessageLine() + "\n";
+			for (const auto& msg : messages)
+				msg_log_str += msg.formattedMessageLine() + "\n";
 
 			ExtMessageDialog dlg(maineditor::windowWx(), "Directory Save Issues");
 			dlg.CenterOnParent();
@@ -222,6 +223,7 @@ bool archiveoperations::removeUnusedPatches(Archive* archive)
 	for (auto& a : to_remove)
 	{
 		log::info(wxString::Format("Removed entry %s", a->name()));
+		patchcache::remove(a);
 		archive->removeEntry(a);
 	}
 
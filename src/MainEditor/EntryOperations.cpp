@@ -38,9 +38,13 @@
 #include "BinaryControlLump.h"
 #include "General/Console.h"
 #include "General/Misc.h"
+#include "General/UI.h"
+#include "General/UndoRedo.h"
 #include "Graphics/Graphics.h"
+#include "Graphics/PngOptimizer.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "MainEditor/MainEditor.h"
+#include "MainEditor/UI/ArchivePanel.h"
 #include "SLADEWxApp.h"
 #include "UI/Dialogs/ExtMessageDialog.h"
 #include "UI/Dialogs/Preferences/PreferencesDialog.h"
@@ -48,6 +52,7 @@
 #include "Utility/FileMonitor.h"
 #include "Utility/Memory.h"
 #include "Utility/SFileDialog.h"
+#include "Utility/ThreadPool.h"
 #include "Utility/Tokenizer.h"
 
 using namespace slade;
@@ -63,6 +68,7 @@ CVAR(String, path_acc_libs, "", CVar::Flag::Save);
 CVAR(String, path_pngout, "", CVar::Flag::Save);
 CVAR(String, path_pngcrush, "", CVar::Flag::Save);
 CVAR(String, path_deflopt, "", CVar::Flag::Save);
+CVAR(Bool, png_optimize_external, false, CVar::Flag::Save);
 CVAR(String, path_db2, "", CVar::Flag::Save)
 CVAR(Bool, acc_always_show_output, false, CVar::Flag::Save);
 
@@ -1179,7 +1185,8 @@ bool entryoperations::exportAsPNG(ArchiveEntry* entry, const wxString& filename)
 }
 
 // -----------------------------------------------------------------------------
-// Attempts to optimize [entry] using external PNG optimizers.
+// Attempts to optimize [entry] using the built-in PNG optimizer, or external
+// PNG optimizers if png_optimize_external is enabled
 // -----------------------------------------------------------------------------
 bool entryoperations::optimizePNG(ArchiveEntry* entry)
 {
@@ -1198,6 +1205,25 @@ bool entryoperations::optimizePNG(ArchiveEntry* entry)
 		return false;
 	}
 
+	// Built-in optimizer
+	if (!png_optimize_external)
+	{
+		MemChunk optimized;
+		auto     result = pngoptimizer::optimize(entry->data(), optimized);
+		if (!result.error.empty())
+		{
+			log::error("PNG {}: {}", entry->name(), result.error);
+			return false;
+		}
+
+		if (result.optimized)
+			entry->importMemChunk(optimized);
+
+		log::info("PNG {} size {} => {} ({})", entry->name(), result.size_in, entry->size(), result.method);
+
+		return true;
+	}
+
 	// Check if the PNG tools path are set up, at least one of them should be
 	wxString pngpathc = path_pngcrush;
 	wxString pngpatho = path_pngout;
@@ -1393,6 +1419,98 @@ bool entryoperations::optimizePNG(ArchiveEntry* entry)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Optimizes all PNG [entries] with the built-in PNG optimizer, in parallel.
+// The changes are recorded as a single undo level in [undo_manager] (if given)
+// and a report of the size savings is shown afterwards
+// -----------------------------------------------------------------------------
+bool entryoperations::optimizePNGs(const vector<ArchiveEntry*>& entries, UndoManager* undo_manager)
+{
+	// Get PNG entries (data must be loaded on this thread)
+	vector<ArchiveEntry*> png_entries;
+	for (auto entry : entries)
+	{
+		if (entry->type()->formatId() == "img_png")
+		{
+			entry->data();
+			png_entries.push_back(entry);
+		}
+	}
+	if (png_entries.empty())
+		return false;
+
+	// Optimize
+	ui::showSplash(fmt::format("Optimizing {} PNG entries, please wait...", png_entries.size()));
+	vector<pngoptimizer::Result> results(png_entries.size());
+	vector<MemChunk>             optimized(png_entries.size());
+	wxStopWatch                  sw;
+	ThreadPool::global().parallelFor(
+		png_entries.size(),
+		[&](size_t index) { results[index] = pngoptimizer::optimize(png_entries[index]->data(), optimized[index]); });
+	const auto time = sw.Time();
+	ui::hideSplash();
+
+	// Apply optimized data
+	if (undo_manager)
+		undo_manager->beginRecord("Optimize PNG");
+
+	size_t   size_in = 0, size_out = 0;
+	unsigned n_optimized = 0;
+	wxString report;
+	for (unsigned a = 0; a < png_entries.size(); ++a)
+	{
+		const auto& result = results[a];
+		if (!result.error.empty())
+		{
+			report += wxString::Format("%s: %s\n", png_entries[a]->name(), result.error);
+			continue;
+		}
+
+		size_in += result.size_in;
+		if (!result.optimized)
+		{
+			size_out += result.size_in;
+			report += wxString::Format("%s: %d bytes, already optimal\n", png_entries[a]->name(), result.size_in);
+			continue;
+		}
+
+		if (undo_manager)
+			undo_manager->recordUndoStep(std::make_unique<EntryDataUS>(png_entries[a]));
+		png_entries[a]->importMemChunk(optimized[a]);
+
+		size_out += result.size_out;
+		++n_optimized;
+		report += wxString::Format(
+			"%s: %d => %d bytes (-%.1f%%), %s\n",
+			png_entries[a]->name(),
+			result.size_in,
+			result.size_out,
+			100.0 - result.size_out * 100.0 / result.size_in,
+			result.method);
+	}
+
+	if (undo_manager)
+		undo_manager->endRecord(n_optimized > 0);
+
+	// Show report
+	const auto summary = fmt::format(
+		"Optimized {} of {} PNG entries in {}ms, {} => {} bytes ({} bytes saved)",
+		n_optimized,
+		png_entries.size(),
+		time,
+		size_in,
+		size_out,
+		size_in - size_out);
+	log::info(summary);
+
+	ExtMessageDialog dlg(nullptr, "Optimizing Report");
+	dlg.setMessage(summary);
+	dlg.setExt(report);
+	dlg.ShowModal();
+
+	return n_optimized > 0;
+}
+
 // -----------------------------------------------------------------------------
 // Converts ANIMATED data in [entry] to ANIMDEFS format, written to [animdata]
 // -----------------------------------------------------------------------------
@@ -7,6 +7,7 @@ class wxFrame;
 namespace slade
 {
 class ModifyOffsetsDialog;
+class UndoManager;
 
 namespace entryoperations
 {
@@ -25,6 +26,7 @@ namespace entryoperations
 	bool compileACS(ArchiveEntry* entry, bool hexen = false, ArchiveEntry* target = nullptr, wxFrame* parent = nullptr);
 	bool exportAsPNG(ArchiveEntry* entry, const wxString& filename);
 	bool optimizePNG(ArchiveEntry* entry);
+	bool optimizePNGs(const vector<ArchiveEntry*>& entries, UndoManager* undo_manager = nullptr);
 
 	// ANIMATED/SWITCHES
 	bool convertAnimated(ArchiveEntry* entry, MemChunk* animdata, bool animdefs);
@@ -0,0 +1,386 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2022 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         https://slade.mancubus.net
+// Filename:    GfxConversion.cpp
+// Description: Batch image format conversion, used by the gfx conversion dialog
+//              and scripts
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "GfxConversion.h"
+#include "Archive/ArchiveEntry.h"
+#include "Archive/EntryType/EntryType.h"
+#include "General/Misc.h"
+#include "General/UndoRedo.h"
+#include "MainEditor/UI/ArchivePanel.h"
+#include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns true if images in [entry] must be loaded on the main thread.
+// Fonts and Jaguar formats are loaded manually, and the Jaguar ones read other
+// entries in the archive
+// -----------------------------------------------------------------------------
+bool loadOnMainThread(ArchiveEntry* entry)
+{
+	const auto& format = entry->type()->formatId();
+	return strutil::startsWith(format, "font_") || strutil::startsWith(format, "img_jaguar");
+}
+
+// -----------------------------------------------------------------------------
+// Adds the error for [item] (if any) to [result] and logs it
+// -----------------------------------------------------------------------------
+void addError(gfxconversion::Result& result, const gfxconversion::Item& item)
+{
+	if (item.error.empty())
+		return;
+
+	auto error = fmt::format("{}: {}", item.entry ? item.entry->name() : "Image", item.error);
+	log::warning("Unable to convert {}", error);
+	result.errors.push_back(error);
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// GfxConversion Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Sets the item's conversion palettes to copies of [current] and [target].
+// The palettes given by palette choosers are shared and reloaded per entry, so
+// each item needs its own to be converted in parallel
+// -----------------------------------------------------------------------------
+void gfxconversion::Item::setPalettes(const Palette* current, const Palette* target)
+{
+	palette_current = current ? std::make_shared<Palette>(*current) : nullptr;
+	palette_target  = target ? std::make_shared<Palette>(*target) : nullptr;
+
+	options.convert.pal_current = palette_current.get();
+	options.convert.pal_target  = palette_target.get();
+}
+
+// -----------------------------------------------------------------------------
+// Returns a summary of the conversion result, including throughput
+// -----------------------------------------------------------------------------
+string gfxconversion::Result::summary() const
+{
+	const double seconds = time_ms > 0 ? time_ms / 1000.0 : 0.001;
+	return fmt::format(
+		"Converted {} images ({} skipped) in {}ms - {:.1f} images/s, {:.1f}MB/s in, {:.1f}MB/s out",
+		converted,
+		skipped,
+		time_ms,
+		converted / seconds,
+		bytes_in / (1024.0 * 1024.0) / seconds,
+		bytes_out / (1024.0 * 1024.0) / seconds);
+}
+
+// -----------------------------------------------------------------------------
+// Converts [image] so it can be written in the target format of [options].
+// Returns false if the image can't be written in that format
+// -----------------------------------------------------------------------------
+bool gfxconversion::convertImage(SImage& image, const Options& options)
+{
+	if (!options.format || !image.isValid())
+		return false;
+
+	if (options.format->canWrite(image) == SIFormat::Writable::No)
+		return false;
+
+	return options.format->convertWritable(image, options.convert);
+}
+
+// -----------------------------------------------------------------------------
+// Converts all [items] in parallel, loading their images from their entries
+// first where needed. If [encode] is true, converted images are also written
+// to each item's data in the target format
+// -----------------------------------------------------------------------------
+gfxconversion::Result gfxconversion::convertItems(vector<Item>& items, bool encode)
+{
+	Result      result;
+	wxStopWatch sw;
+
+	// Entry data and types must be loaded on the main thread, along with any
+	// images that can't be loaded in parallel
+	for (auto& item : items)
+	{
+		item.converted = false;
+		item.data.clear();
+		item.error.clear();
+
+		if (!item.entry || item.image.isValid())
+			continue;
+
+		result.bytes_in += item.entry->data().size();
+		if (item.entry->type() == EntryType::unknownType())
+			EntryType::detectEntryType(*item.entry);
+		if (loadOnMainThread(item.entry) && !misc::loadImageFromEntry(&item.image, item.entry))
+			item.error = global::error;
+	}
+
+	// Load, convert and encode
+	ThreadPool::global().parallelFor(
+		items.size(),
+		[&items, encode](size_t index)
+		{
+			// global::error is per thread, so errors are kept with the item
+			auto& item = items[index];
+			if (!item.error.empty())
+				return;
+			if (!item.image.isValid() && item.entry && !loadOnMainThread(item.entry)
+				&& !misc::loadImageFromEntry(&item.image, item.entry))
+			{
+				item.error = global::error;
+				return;
+			}
+
+			global::error.clear();
+			if (!convertImage(item.image, item.options))
+			{
+				item.error = global::error;
+				if (item.error.empty())
+					item.error = fmt::format("Image can't be converted to {}", item.options.format->name());
+				return;
+			}
+
+			if (encode && !item.options.format->saveImage(item.image, item.data, item.options.convert.pal_target))
+			{
+				item.error = fmt::format("Failed to write image as {}: {}", item.options.format->name(), global::error);
+				return;
+			}
+
+			item.converted = true;
+		});
+
+	for (const auto& item : items)
+	{
+		if (item.converted)
+		{
+			result.converted++;
+			result.bytes_out += item.data.size();
+		}
+		else
+			result.skipped++;
+
+		addError(result, item);
+	}
+
+	result.time_ms = sw.Time();
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the converted images in [items] back to their entries, encoding any
+// that haven't been yet. If [undo_manager] is given, all changes are recorded
+// as a single undo level. Any encoding errors are added to [result] if given,
+// and logged
+// -----------------------------------------------------------------------------
+void gfxconversion::writeItems(vector<Item>& items, UndoManager* undo_manager, Result* result)
+{
+	// Encode any converted images that haven't been yet
+	vector<uint8_t> failed(items.size(), 0);
+	ThreadPool::global().parallelFor(
+		items.size(),
+		[&items, &failed](size_t index)
+		{
+			auto& item = items[index];
+			if (!item.converted || !item.entry || item.data.hasData())
+				return;
+
+			global::error.clear();
+			if (!item.options.format->saveImage(item.image, item.data, item.options.convert.pal_target))
+			{
+				item.error = fmt::format(
+					"Failed to write image as {}: {}", item.options.format->name(), global::error);
+				item.converted = false;
+				failed[index]  = 1;
+			}
+		});
+
+	// Report encoding errors
+	Result errors;
+	for (unsigned a = 0; a < items.size(); ++a)
+		if (failed[a])
+			addError(errors, items[a]);
+	if (result)
+	{
+		result->converted -= errors.errors.size();
+		result->skipped += errors.errors.size();
+		result->errors.insert(result->errors.end(), errors.errors.begin(), errors.errors.end());
+	}
+
+	if (undo_manager)
+		undo_manager->beginRecord("Gfx Format Conversion");
+
+	// Write to entries
+	for (auto& item : items)
+	{
+		if (!item.converted || !item.entry || !item.data.hasData())
+			continue;
+
+		if (undo_manager)
+			undo_manager->recordUndoStep(std::make_unique<EntryDataUS>(item.entry));
+
+		item.entry->importMemChunk(item.data);
+		EntryType::detectEntryType(*item.entry);
+		item.entry->setExtensionByType();
+	}
+
+	if (undo_manager)
+		undo_manager->endRecord(true);
+}
+
+// -----------------------------------------------------------------------------
+// Converts all image [entries] using [options] and writes the results back to
+// them. Entries that aren't images or can't be converted are skipped
+// -----------------------------------------------------------------------------
+gfxconversion::Result gfxconversion::convertEntries(
+	const vector<ArchiveEntry*>& entries,
+	const Options&               options,
+	UndoManager*                 undo_manager)
+{
+	vector<Item> items(entries.size());
+	for (unsigned a = 0; a < entries.size(); ++a)
+	{
+		items[a].entry   = entries[a];
+		items[a].options = options;
+		items[a].setPalettes(options.convert.pal_current, options.convert.pal_target);
+	}
+
+	auto        result = convertItems(items);
+	wxStopWatch sw;
+	writeItems(items, undo_manager, &result);
+	result.time_ms += sw.Time();
+
+	log::info(2, result.summary());
+
+	return result;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+#include "General/Console.h"
+
+// -----------------------------------------------------------------------------
+// Tests converting several images in one batch. Images of different sizes are
+// converted to paletted Doom Gfx with their own palette copies, and each result
+// is compared against the same image converted and encoded on its own
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_gfx_convert_batch, 0, false)
+{
+	// Fill a palette with pseudo-random colours
+	Palette  palette;
+	uint32_t seed = 1;
+	for (unsigned a = 0; a < 256; ++a)
+	{
+		seed = seed * 1664525 + 1013904223;
+		palette.setColour(
+			a, { static_cast<uint8_t>(seed >> 24), static_cast<uint8_t>(seed >> 16), static_cast<uint8_t>(seed >> 8) });
+	}
+
+	// Setup truecolour gradient images to convert
+	gfxconversion::Options options;
+	options.format             = SIFormat::getFormat("doom");
+	options.convert.col_format = SImage::Type::PalMask;
+	vector<gfxconversion::Item> items(16);
+	for (unsigned a = 0; a < items.size(); ++a)
+	{
+		auto&     image = items[a].image;
+		const int w     = 8 + a * 5;
+		const int h     = 4 + a * 3;
+		image.create(w, h, SImage::Type::RGBA);
+		for (int y = 0; y < h; ++y)
+			for (int x = 0; x < w; ++x)
+				image.setPixel(x, y, ColRGBA(x * 255 / w, y * 255 / h, a * 16, x > y ? 255 : 0));
+
+		items[a].options = options;
+		items[a].setPalettes(&palette, &palette);
+	}
+
+	// Keep the originals to convert one at a time
+	vector<SImage> originals(items.size());
+	for (unsigned a = 0; a < items.size(); ++a)
+		originals[a].copyImage(&items[a].image);
+
+	auto result = gfxconversion::convertItems(items);
+	log::console(result.summary());
+
+	unsigned failed = 0;
+	for (unsigned a = 0; a < items.size(); ++a)
+	{
+		auto&    expected = originals[a];
+		MemChunk expected_data;
+		auto     opt = options;
+
+		opt.convert.pal_current = &palette;
+		opt.convert.pal_target  = &palette;
+		if (!gfxconversion::convertImage(expected, opt)
+			|| !options.format->saveImage(expected, expected_data, &palette))
+		{
+			log::console(fmt::format("Image {} couldn't be converted on its own", a));
+			++failed;
+			continue;
+		}
+
+		const auto& item = items[a];
+		if (!item.converted)
+		{
+			log::console(fmt::format("Image {} wasn't converted in the batch: {}", a, item.error));
+			++failed;
+		}
+		else if (
+			item.data.size() != expected_data.size()
+			|| memcmp(item.data.data(), expected_data.data(), expected_data.size()) != 0)
+		{
+			log::console(fmt::format("Image {} was converted differently in the batch", a));
+			++failed;
+		}
+	}
+
+	if (failed == 0)
+		log::console(fmt::format("All {} images converted correctly in one batch", items.size()));
+	else
+		log::console(fmt::format("{} of {} images failed batch conversion", failed, items.size()));
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Graphics/SImage/SIFormat.h"
+#include "Graphics/SImage/SImage.h"
+
+namespace slade
+{
+class ArchiveEntry;
+class UndoManager;
+
+// Batch conversion of images to another image format. Images are decoded,
+// converted and encoded in parallel on the global thread pool, then written
+// back to their entries on the calling thread
+namespace gfxconversion
+{
+	struct Options
+	{
+		SIFormat*                format = nullptr; // Target image format
+		SIFormat::ConvertOptions convert;          // Colour format, palettes and transparency options
+	};
+
+	struct Item
+	{
+		ArchiveEntry*       entry = nullptr; // Entry to load the image from (if not already loaded) and write it to
+		SImage              image;
+		Options             options;
+		bool                converted = false;
+		MemChunk            data;  // Encoded image data
+		string              error; // Why the image wasn't converted or encoded, if it wasn't
+		shared_ptr<Palette> palette_current;
+		shared_ptr<Palette> palette_target;
+
+		void setPalettes(const Palette* current, const Palette* target);
+	};
+
+	struct Result
+	{
+		unsigned converted = 0;
+		unsigned skipped   = 0; // Not an image, or not writable in the target format
+		size_t   bytes_in  = 0;
+		size_t   bytes_out = 0;
+		long     time_ms   = 0;
+
+		vector<string> errors; // "<entry>: <error>" for each image that failed to convert or encode
+
+		string summary() const;
+	};
+
+	bool   convertImage(SImage& image, const Options& options);
+	Result convertItems(vector<Item>& items, bool encode = true);
+	void   writeItems(vector<Item>& items, UndoManager* undo_manager = nullptr, Result* result = nullptr);
+	Result convertEntries(
+		const vector<ArchiveEntry*>& entries,
+		const Options&               options,
+		UndoManager*                 undo_manager = nullptr);
+} // namespace gfxconversion
+} // namespace slade
@@ -56,6 +56,7 @@
 #include "MainEditor/ArchiveOperations.h"
 #include "MainEditor/Conversions.h"
 #include "MainEditor/EntryOperations.h"
+#include "MainEditor/GfxConversion.h"
 #include "MainEditor/MainEditor.h"
 #include "MainEditor/UI/MainWindow.h"
 #include "MapEditor/MapEditor.h"
@@ -64,6 +65,7 @@
 #include "UI/Controls/PaletteChooser.h"
 #include "UI/Controls/SIconButton.h"
 #include "UI/Controls/Splitter.h"
+#include "UI/Dialogs/ExtMessageDialog.h"
 #include "UI/Dialogs/GfxColouriseDialog.h"
 #include "UI/Dialogs/GfxConvDialog.h"
 #include "UI/Dialogs/GfxTintDialog.h"
@@ -115,6 +117,7 @@ CVAR(Bool, elist_no_tree, false, CVar::Flag::Save)
 EXTERN_CVAR(String, path_pngout)
 EXTERN_CVAR(String, path_pngcrush)
 EXTERN_CVAR(String, path_deflopt)
+EXTERN_CVAR(Bool, png_optimize_external)
 EXTERN_CVAR(Bool, confirm_entry_revert)
 EXTERN_CVAR(Bool, archive_dir_ignore_hidden)
 
@@ -1979,41 +1982,44 @@ bool ArchivePanel::gfxConvert() const
 	gcd.ShowModal();
 
 	// Show splash window
-	ui::showSplash("Writing converted image data...", true);
-
-	// Begin recording undo level
-	undo_manager_->beginRecord("Gfx Format Conversion");
+	ui::showSplash("Writing converted image data...");
 
 	// Write any changes
+	vector<gfxconversion::Item> items;
 	for (unsigned a = 0; a < selection.size(); a++)
 	{
-		// Update splash window
-		ui::setSplashProgressMessage(selection[a]->name());
-		ui::setSplashProgress((float)a / (float)selection.size());
-
 		// Skip if the image wasn't converted
 		if (!gcd.itemModified(a))
 			continue;
 
 		// Get image and conversion info
-		auto image  = gcd.itemImage(a);
-		auto format = gcd.itemFormat(a);
-
-		// Write converted image back to entry
-		MemChunk mc;
-		format->saveImage(*image, mc, gcd.itemPalette(a));
-		selection[a]->importMemChunk(mc);
-		EntryType::detectEntryType(*selection[a]);
-		selection[a]->setExtensionByType();
+		auto& item = items.emplace_back();
+		item.entry = selection[a];
+		item.image.copyImage(gcd.itemImage(a));
+		item.options.format = gcd.itemFormat(a);
+		item.setPalettes(nullptr, gcd.itemPalette(a));
+		item.converted = true;
 	}
-
-	// Finish recording undo level
-	undo_manager_->endRecord(true);
+	gfxconversion::Result result;
+	gfxconversion::writeItems(items, undo_manager_.get(), &result);
 
 	// Hide splash window
 	ui::hideSplash();
 	maineditor::currentEntryPanel()->callRefresh();
 
+	// Show any errors
+	if (!result.errors.empty())
+	{
+		wxString errors;
+		for (const auto& error : result.errors)
+			errors += error + "\n";
+
+		ExtMessageDialog dlg(theMainWindow, "Gfx Conversion Errors");
+		dlg.setMessage("The following images could not be written:");
+		dlg.setExt(errors);
+		dlg.ShowModal();
+	}
+
 	return true;
 }
 
@@ -2680,6 +2686,10 @@ bool ArchivePanel::compileACS(bool hexen) const
 // -----------------------------------------------------------------------------
 bool ArchivePanel::optimizePNG() const
 {
+	// Use the built-in optimizer unless external tools are enabled
+	if (!png_optimize_external)
+		return entryoperations::optimizePNGs(entry_tree_->selectedEntries(), undo_manager_.get());
+
 	// Check if the PNG tools path are set up, at least one of them should be
 	wxString pngpathc = path_pngcrush;
 	wxString pngpatho = path_pngout;
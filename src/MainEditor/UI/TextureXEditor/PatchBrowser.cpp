@@ -37,9 +37,9 @@
 #include "PatchBrowser.h"
 #include "App.h"
 #include "Archive/ArchiveManager.h"
-#include "General/Misc.h"
 #include "General/ResourceManager.h"
 #include "Graphics/CTexture/CTexture.h"
+#include "Graphics/CTexture/PatchCache.h"
 #include "Graphics/CTexture/TextureXList.h"
 #include "Graphics/SImage/SImage.h"
 #include "MainEditor/MainEditor.h"
@@ -81,7 +81,7 @@ bool PatchBrowserItem::loadImage()
 
 		// Load entry to image, if it exists
 		if (entry)
-			misc::loadImageFromEntry(&img, entry);
+			patchcache::loadImage(img, entry);
 		else
 			return false;
 	}
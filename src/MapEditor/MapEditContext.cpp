@@ -50,7 +50,9 @@
 #include "UI/MapCanvas.h"
 #include "UI/MapEditorWindow.h"
 #include "UndoSteps.h"
+#include "Utility/MathStuff.h"
 #include "Utility/StringUtils.h"
+#include <random>
 
 using namespace slade;
 
@@ -2490,6 +2492,271 @@ CONSOLE_COMMAND(m_test_sector, 0, false)
 	log::info("Took {}ms", ms);
 }
 
+CONSOLE_COMMAND(m_check_spatial_index, 0, false)
+{
+	auto&      map       = mapeditor::editContext().map();
+	const auto n_queries = args.empty() ? 1000 : std::max(strutil::asInt(args[0]), 1);
+
+	// Get area to query (a bit larger than the map itself)
+	auto bbox = map.bounds();
+	if (!bbox.isValid())
+	{
+		log::console("Map is empty");
+		return;
+	}
+	bbox.min.set(bbox.min.x - 256., bbox.min.y - 256.);
+	bbox.max.set(bbox.max.x + 256., bbox.max.y + 256.);
+
+	std::mt19937 rng(1234);
+	const auto   rand_point = [&rng, &bbox]()
+	{
+		return Vec2d{ std::uniform_real_distribution<double>(bbox.min.x, bbox.max.x)(rng),
+					  std::uniform_real_distribution<double>(bbox.min.y, bbox.max.y)(rng) };
+	};
+
+	// Run queries with both the spatial index and brute-force, counting any
+	// differences in the results
+	int       mismatches = 0;
+	int64_t   us_grid    = 0;
+	int64_t   us_linear  = 0;
+	sf::Clock clock;
+	for (int a = 0; a < n_queries; ++a)
+	{
+		auto point  = rand_point();
+		auto cutter = Seg2d{ point, rand_point() };
+		auto vertex = map.nVertices() > 0 ? map.vertex(rng() % map.nVertices()) : nullptr;
+
+		clock.restart();
+		auto v_nearest  = map.vertices().nearest(point);
+		auto v_at       = vertex ? map.vertices().vertexAt(vertex->xPos(), vertex->yPos()) : nullptr;
+		auto v_crossed  = map.vertices().firstCrossed(cutter);
+		auto l_nearest  = map.lines().nearest(point);
+		auto l_cuts     = map.lines().cutPoints(cutter);
+		auto t_nearest  = map.things().nearest(point);
+		auto t_multi    = map.things().multiNearest(point);
+		auto s_at       = map.sectors().atPos(point);
+		us_grid        += clock.getElapsedTime().asMicroseconds();
+
+		clock.restart();
+		auto v_nearest_bf = map.vertices().nearestLinear(point);
+		auto v_at_bf      = vertex ? map.vertices().vertexAtLinear(vertex->xPos(), vertex->yPos()) : nullptr;
+		auto v_crossed_bf = map.vertices().firstCrossedLinear(cutter);
+		auto l_nearest_bf = map.lines().nearestLinear(point);
+		auto l_cuts_bf    = map.lines().cutPointsLinear(cutter);
+		auto t_nearest_bf = map.things().nearestLinear(point);
+		auto t_multi_bf   = map.things().multiNearestLinear(point);
+		auto s_at_bf      = map.sectors().atPosLinear(point);
+		us_linear        += clock.getElapsedTime().asMicroseconds();
+
+		mismatches += (v_nearest != v_nearest_bf) + (v_at != v_at_bf) + (v_crossed != v_crossed_bf)
+					  + (l_nearest != l_nearest_bf) + (l_cuts != l_cuts_bf) + (t_nearest != t_nearest_bf)
+					  + (t_multi != t_multi_bf) + (s_at != s_at_bf);
+	}
+
+	log::console(fmt::format(
+		"{} queries: {} mismatches, spatial index {}ms, brute-force {}ms",
+		n_queries,
+		mismatches,
+		us_grid / 1000,
+		us_linear / 1000));
+}
+
+CONSOLE_COMMAND(m_check_geometry_arrays, 0, false)
+{
+	auto&      map          = mapeditor::editContext().map();
+	const auto index_or_none = [](const MapObject* object) { return object ? static_cast<int>(object->index()) : -1; };
+
+	// Compare the geometry arrays of each list with the objects themselves
+	int v_errors = 0;
+	for (unsigned a = 0; a < map.nVertices(); ++a)
+		if (map.vertices().xPositions()[a] != map.vertex(a)->xPos()
+			|| map.vertices().yPositions()[a] != map.vertex(a)->yPos())
+			++v_errors;
+
+	int l_errors = 0;
+	for (unsigned a = 0; a < map.nLines(); ++a)
+	{
+		auto line = map.line(a);
+		if (map.lines().v1Indices()[a] != index_or_none(line->v1())
+			|| map.lines().v2Indices()[a] != index_or_none(line->v2())
+			|| map.lines().s1Indices()[a] != index_or_none(line->s1())
+			|| map.lines().s2Indices()[a] != index_or_none(line->s2()))
+			++l_errors;
+	}
+
+	int s_errors = 0;
+	for (unsigned a = 0; a < map.nSides(); ++a)
+		if (map.sides().sectorIndices()[a] != index_or_none(map.side(a)->sector()))
+			++s_errors;
+
+	int t_errors = 0;
+	for (unsigned a = 0; a < map.nThings(); ++a)
+	{
+		auto thing = map.thing(a);
+		if (map.things().xPositions()[a] != thing->xPos() || map.things().yPositions()[a] != thing->yPos()
+			|| map.things().types()[a] != thing->type() || map.things().angles()[a] != thing->angle())
+			++t_errors;
+	}
+
+	log::console(fmt::format(
+		"Geometry array mismatches: {} vertices, {} lines, {} sides, {} things",
+		v_errors,
+		l_errors,
+		s_errors,
+		t_errors));
+}
+
+CONSOLE_COMMAND(benchmark_map_draw, 0, true)
+{
+	const auto grid_size = args.empty() ? 150 : std::max(strutil::asInt(args[0]), 2);
+	const auto n_shapes  = args.size() < 2 ? 10 : std::max(strutil::asInt(args[1]), 1);
+	constexpr double cell_size = 64.;
+	constexpr int    n_points  = 200;
+
+	std::mt19937 rng(1234);
+	const auto   rand_pos = [&rng, grid_size](double margin)
+	{
+		return std::uniform_real_distribution<double>(margin, grid_size * cell_size - margin)(rng);
+	};
+
+	// Build a large map (a grid of square cells) to draw and paste into
+	SLADEMap           map;
+	sf::Clock          clock;
+	vector<MapVertex*> grid_verts;
+	for (int y = 0; y <= grid_size; ++y)
+		for (int x = 0; x <= grid_size; ++x)
+			grid_verts.push_back(map.createVertex({ x * cell_size, y * cell_size }));
+	for (int y = 0; y <= grid_size; ++y)
+		for (int x = 0; x <= grid_size; ++x)
+		{
+			auto* vertex = grid_verts[y * (grid_size + 1) + x];
+			if (x < grid_size)
+				map.createLine(vertex, grid_verts[y * (grid_size + 1) + x + 1]);
+			if (y < grid_size)
+				map.createLine(vertex, grid_verts[(y + 1) * (grid_size + 1) + x]);
+		}
+	log::console(fmt::format(
+		"Built map with {} vertices and {} lines in {}ms",
+		map.nVertices(),
+		map.nLines(),
+		clock.getElapsedTime().asMilliseconds()));
+
+	// Draw shapes (circles crossing many lines), creating vertices the same
+	// way line drawing does. Also check the split lines found for each vertex
+	// against a scan of every line
+	int64_t us_draw    = 0;
+	int64_t us_linear  = 0;
+	int     mismatches = 0;
+	for (int a = 0; a < n_shapes; ++a)
+	{
+		const double radius = 100. + rng() % 400;
+		const Vec2d  centre{ rand_pos(radius), rand_pos(radius) };
+
+		vector<Vec2d> points;
+		for (int p = 0; p < n_points; ++p)
+		{
+			const double angle = math::PI * 2. * p / n_points;
+			points.push_back({ std::round(centre.x + std::cos(angle) * radius),
+							   std::round(centre.y + std::sin(angle) * radius) });
+		}
+
+		clock.restart();
+		for (const auto& point : points)
+			if (map.lines().allNear(point, 1.) != map.lines().allNearLinear(point, 1.))
+				++mismatches;
+		us_linear += clock.getElapsedTime().asMicroseconds();
+
+		clock.restart();
+		vector<MapVertex*> verts;
+		for (const auto& point : points)
+			verts.push_back(map.createVertex(point, 1.));
+		for (unsigned p = 0; p < verts.size(); ++p)
+			map.createLine(verts[p], verts[(p + 1) % verts.size()]);
+		us_draw += clock.getElapsedTime().asMicroseconds();
+	}
+	log::console(fmt::format(
+		"Drew {} {}-vertex shapes in {}ms ({} split check mismatches, {}ms to check)",
+		n_shapes,
+		n_points,
+		us_draw / 1000,
+		mismatches,
+		us_linear / 1000));
+
+	// Paste blocks of architecture (5x5 grids offset from the map grid) and
+	// merge them into the map
+	int64_t us_paste = 0;
+	for (int a = 0; a < n_shapes; ++a)
+	{
+		const Vec2d origin{ std::round(rand_pos(400.)), std::round(rand_pos(400.)) };
+
+		clock.restart();
+		vector<MapVertex*> verts;
+		for (int y = 0; y <= 5; ++y)
+			for (int x = 0; x <= 5; ++x)
+				verts.push_back(map.createVertex({ origin.x + x * 48., origin.y + y * 48. }));
+		for (int y = 0; y <= 5; ++y)
+			for (int x = 0; x <= 5; ++x)
+			{
+				if (x < 5)
+					map.createLine(verts[y * 6 + x], verts[y * 6 + x + 1]);
+				if (y < 5)
+					map.createLine(verts[y * 6 + x], verts[(y + 1) * 6 + x]);
+			}
+		map.mergeArch(verts);
+		us_paste += clock.getElapsedTime().asMicroseconds();
+	}
+	log::console(fmt::format("Pasted and merged {} 5x5 blocks in {}ms", n_shapes, us_paste / 1000));
+	log::console(fmt::format("Final map has {} vertices and {} lines", map.nVertices(), map.nLines()));
+}
+
+CONSOLE_COMMAND(benchmark_map_props, 0, true)
+{
+	auto&      map        = mapeditor::editContext().map();
+	const auto iterations = args.empty() ? 100 : std::max(strutil::asInt(args[0]), 1);
+
+	// Read a mix of set and unset (default) UDMF properties from every line,
+	// side, sector and thing in the map, the way flag checks and the
+	// properties panel do
+	sf::Clock clock;
+	int64_t   reads = 0;
+	double    total = 0.;
+	for (int a = 0; a < iterations; ++a)
+	{
+		for (unsigned i = 0; i < map.nLines(); ++i)
+		{
+			auto line = map.line(i);
+			total += line->boolProperty("blocking") + line->intProperty("arg0") + line->floatProperty("alpha");
+			total += line->stringProperty("renderstyle").size();
+		}
+		for (unsigned i = 0; i < map.nSides(); ++i)
+		{
+			auto side = map.side(i);
+			total += side->floatProperty("offsetx_mid") + side->intProperty("light")
+					 + side->boolProperty("lightabsolute");
+		}
+		for (unsigned i = 0; i < map.nSectors(); ++i)
+		{
+			auto sector = map.sector(i);
+			total += sector->intProperty("lightfloor") + sector->floatProperty("gravity");
+		}
+		for (unsigned i = 0; i < map.nThings(); ++i)
+		{
+			auto thing = map.thing(i);
+			total += thing->boolProperty("skill1") + thing->floatProperty("alpha") + thing->intProperty("arg0");
+		}
+		reads += map.nLines() * 4 + map.nSides() * 3 + map.nSectors() * 2 + map.nThings() * 3;
+	}
+
+	const auto us = clock.getElapsedTime().asMicroseconds();
+	log::console(fmt::format(
+		"{} property reads in {}ms ({:.1f}ns per read, checksum {})",
+		reads,
+		us / 1000,
+		reads > 0 ? us * 1000. / reads : 0.,
+		total));
+	log::console(fmt::format("{} interned property keys", property::numKeys()));
+}
+
 CONSOLE_COMMAND(m_test_mobj_backup, 0, false)
 {
 	sf::Clock clock;
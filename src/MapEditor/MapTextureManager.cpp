@@ -35,11 +35,15 @@
 #include "App.h"
 #include "Archive/ArchiveEntry.h"
 #include "Archive/ArchiveManager.h"
+#include "Archive/EntryType/EntryType.h"
 #include "Game/Configuration.h"
 #include "General/Misc.h"
 #include "General/ResourceManager.h"
 #include "Graphics/CTexture/CTexture.h"
+#include "Graphics/CTexture/PatchCache.h"
+#include "Graphics/SImage/SIFormat.h"
 #include "Graphics/SImage/SImage.h"
+#include "Graphics/Translation.h"
 #include "MainEditor/MainEditor.h"
 #include "MainEditor/UI/MainWindow.h"
 #include "MapEditContext.h"
@@ -47,6 +51,7 @@
 #include "OpenGL/OpenGL.h"
 #include "UI/Controls/PaletteChooser.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 
 using namespace slade;
 
@@ -61,6 +66,33 @@ namespace
 MapTextureManager::Texture tex_invalid;
 }
 CVAR(Int, map_tex_filter, 0, CVar::Flag::Save)
+CVAR(Bool, map_tex_async, false, CVar::Flag::Save)
+CVAR(Int, map_tex_upload_budget, 8, CVar::Flag::Save) // Max ms per frame spent uploading background-loaded textures
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the OpenGL texture filter to use for map textures (or sprites if
+// [sprite] is true), depending on the map_tex_filter cvar
+// -----------------------------------------------------------------------------
+gl::TexFilter textureFilter(bool sprite)
+{
+	switch (map_tex_filter)
+	{
+	case 0: return gl::TexFilter::NearestLinearMin;
+	case 1: return gl::TexFilter::Linear;
+	case 2: return sprite ? gl::TexFilter::Linear : gl::TexFilter::LinearMipmap;
+	case 3: return gl::TexFilter::NearestMipmap;
+	default: return gl::TexFilter::Linear;
+	}
+}
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -73,7 +105,23 @@ CVAR(Int, map_tex_filter, 0, CVar::Flag::Save)
 // -----------------------------------------------------------------------------
 // MapTextureManager class constructor
 // -----------------------------------------------------------------------------
-MapTextureManager::MapTextureManager(shared_ptr<Archive> archive) : archive_{ archive }, palette_{ new Palette() } {}
+MapTextureManager::MapTextureManager(shared_ptr<Archive> archive) :
+	archive_{ archive },
+	palette_{ new Palette() },
+	async_{ std::make_shared<AsyncState>() }
+{
+}
+
+// -----------------------------------------------------------------------------
+// MapTextureManager class destructor
+// -----------------------------------------------------------------------------
+MapTextureManager::~MapTextureManager()
+{
+	// Discard any images still being decoded in the background
+	std::lock_guard lock(async_->mutex);
+	async_->generation++;
+	async_->decoded.clear();
+}
 
 // -----------------------------------------------------------------------------
 // Initialises the texture manager
@@ -88,6 +136,7 @@ void MapTextureManager::init()
 	// Load palette
 	if (auto pal = resourcePalette(); pal != palette_.get())
 		palette_->copyPalette(pal);
+	decode_palette_.reset();
 }
 
 // -----------------------------------------------------------------------------
@@ -110,6 +159,19 @@ Palette* MapTextureManager::resourcePalette() const
 		return theMainWindow->paletteChooser()->selectedPalette();
 }
 
+// -----------------------------------------------------------------------------
+// Returns a copy of the current palette for decoding images in the background.
+// The copy is shared by all decoding tasks and never modified, a new one is
+// made when the palette changes
+// -----------------------------------------------------------------------------
+shared_ptr<Palette> MapTextureManager::decodePalette()
+{
+	if (!decode_palette_)
+		decode_palette_ = std::make_shared<Palette>(*palette_);
+
+	return decode_palette_;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the texture matching [name], loading it from resources if necessary.
 // If [mixed] is true, flats are also searched if no matching texture is found
@@ -117,24 +179,18 @@ Palette* MapTextureManager::resourcePalette() const
 const MapTextureManager::Texture& MapTextureManager::texture(string_view name, bool mixed)
 {
 	// Get texture matching name
-	auto& mtex = textures_[strutil::upper(name)];
-
-	// Get desired filter type
-	auto filter = gl::TexFilter::Linear;
-	if (map_tex_filter == 0)
-		filter = gl::TexFilter::NearestLinearMin;
-	else if (map_tex_filter == 1)
-		filter = gl::TexFilter::Linear;
-	else if (map_tex_filter == 2)
-		filter = gl::TexFilter::LinearMipmap;
-	else if (map_tex_filter == 3)
-		filter = gl::TexFilter::NearestMipmap;
+	auto  key  = strutil::upper(name);
+	auto& mtex = textures_[key];
+
+	// Still loading or not found
+	if (mtex.pending || mtex.missing)
+		return mtex;
 
 	// If the texture is loaded
 	if (mtex.gl_id)
 	{
 		// If the texture filter matches the desired one, return it
-		if (gl::Texture::info(mtex.gl_id).filter == filter)
+		if (gl::Texture::info(mtex.gl_id).filter == textureFilter(false))
 			return mtex;
 
 		// Otherwise, reload the texture
@@ -143,108 +199,70 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 	}
 
 	// Texture not found or unloaded, look for it
+	loadImage(textures_, key, false, resolveTexture(name, mixed, archive_.lock().get(), palette_.get()));
 
-	// Look for composite textures first
-	auto  archive = archive_.lock().get();
-	auto* ctex    = app::resources().getTexture(name, "WallTexture", archive);
-	if (!ctex)
-		ctex = app::resources().getTexture(name, "", archive);
-	if (ctex)
-	{
-		SImage image;
-		if (ctex->toImage(image, archive, palette_.get(), true))
-		{
-			mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
+	return mtex;
+}
 
-			double sx = ctex->scaleX();
-			if (sx == 0.0)
-				sx = 1.0;
-			double sy = ctex->scaleY();
-			if (sy == 0.0)
-				sy = 1.0;
+// -----------------------------------------------------------------------------
+// Returns the flat matching [name], loading it from resources if necessary.
+// If [mixed] is true, textures are also searched if no matching flat is found
+// -----------------------------------------------------------------------------
+const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool mixed)
+{
+	// Get flat matching name
+	auto  key  = strutil::upper(name);
+	auto& mtex = flats_[key];
 
-			mtex.world_panning = ctex->worldPanning();
-			mtex.scale         = { 1.0 / sx, 1.0 / sy };
-		}
-	}
+	// Still loading or not found
+	if (mtex.pending || mtex.missing)
+		return mtex;
 
-	// No composite match, look for stand-alone textures
-	else
+	// If the texture is loaded
+	if (mtex.gl_id)
 	{
-		// HIRES
-		if (auto* etex = app::resources().getHiresEntry(name, archive))
-		{
-			SImage image;
-			if (misc::loadImageFromEntry(&image, etex))
-			{
-				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
-
-				if (auto* ref = app::resources().getTextureEntry(name, "textures", archive))
-				{
-					SImage imgref;
-					if (misc::loadImageFromEntry(&imgref, ref))
-					{
-						int w, h, sw, sh;
-						w                  = image.width();
-						h                  = image.height();
-						sw                 = imgref.width();
-						sh                 = imgref.height();
-						mtex.world_panning = true;
-						mtex.scale         = { (double)sw / (double)w, (double)sh / (double)h };
-					}
-				}
-			}
-		}
+		// If the texture filter matches the desired one, return it
+		if (gl::Texture::info(mtex.gl_id).filter == textureFilter(false))
+			return mtex;
 
-		// TEXTURES
-		else
-		{
-			SImage image;
-			etex = app::resources().getTextureEntry(name, "textures", archive);
-			if (misc::loadImageFromEntry(&image, etex))
-				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
-		}
+		// Otherwise, reload the texture
+		gl::Texture::clear(mtex.gl_id);
+		mtex.gl_id = 0;
 	}
 
-	// Not found
-	if (!mtex.gl_id)
-	{
-		// Try flats if mixed
-		if (mixed)
-			return flat(name, false);
-
-		// Otherwise use missing texture
-		mtex.gl_id = gl::Texture::missingTexture();
-	}
+	// Flat not found or unloaded, look for it
+	loadImage(flats_, key, false, resolveFlat(name, mixed, archive_.lock().get(), palette_.get()));
 
 	return mtex;
 }
 
 // -----------------------------------------------------------------------------
-// Returns the flat matching [name], loading it from resources if necessary.
-// If [mixed] is true, textures are also searched if no matching flat is found
+// Returns the sprite matching [name], loading it from resources if necessary.
+// Sprite name also supports wildcards (?)
 // -----------------------------------------------------------------------------
-const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool mixed)
+const MapTextureManager::Texture& MapTextureManager::sprite(
+	string_view name,
+	string_view translation,
+	string_view palette)
 {
-	// Get flat matching name
-	auto& mtex = flats_[strutil::upper(name)];
-
-	// Get desired filter type
-	auto filter = gl::TexFilter::Linear;
-	if (map_tex_filter == 0)
-		filter = gl::TexFilter::NearestLinearMin;
-	else if (map_tex_filter == 1)
-		filter = gl::TexFilter::Linear;
-	else if (map_tex_filter == 2)
-		filter = gl::TexFilter::LinearMipmap;
-	else if (map_tex_filter == 3)
-		filter = gl::TexFilter::NearestMipmap;
+	// Don't bother looking for nameless sprites
+	if (name.empty())
+		return tex_invalid;
+
+	// Get sprite matching name
+	auto hashname = fmt::format("{}{}{}", name, translation, palette);
+	strutil::upperIP(hashname);
+	auto& mtex = sprites_[hashname];
+
+	// Still loading or not found
+	if (mtex.pending || mtex.missing)
+		return mtex;
 
 	// If the texture is loaded
 	if (mtex.gl_id)
 	{
 		// If the texture filter matches the desired one, return it
-		if (gl::Texture::info(mtex.gl_id).filter == filter)
+		if (gl::Texture::info(mtex.gl_id).filter == textureFilter(true))
 			return mtex;
 
 		// Otherwise, reload the texture
@@ -252,136 +270,253 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 		mtex.gl_id = 0;
 	}
 
-	// Prioritize standalone textures
-	auto archive = archive_.lock().get();
-	if (mixed && app::resources().getTextureEntry(name, "textures", archive))
+	// Sprite not found or unloaded, look for it
+	loadImage(
+		sprites_, hashname, true, resolveSprite(name, translation, palette, archive_.lock().get(), palette_.get()));
+
+	return mtex;
+}
+
+// -----------------------------------------------------------------------------
+// Loads the image for [key] in [map] from [source].
+// If async loading is disabled the image is decoded and uploaded immediately,
+// otherwise it is decoded in the background and the texture is marked as
+// pending until it's uploaded in processUploads
+// -----------------------------------------------------------------------------
+void MapTextureManager::loadImage(MapTexHashMap& map, string_view key, bool sprite, ImageSource source)
+{
+	auto& mtex = map[string{ key }];
+
+	// Synchronous (or nothing to decode)
+	if (!map_tex_async || !source.found)
 	{
-		return texture(name, false);
+		upload(mtex, decode(source, palette_.get()), sprite);
+		return;
 	}
 
-	// Try composite flat texture
-	if (mixed)
-	{
-		if (auto* ctex = app::resources().getTexture(name, "Flat", archive))
+	// Use a placeholder until the decoded image is uploaded
+	mtex.pending = true;
+	mtex.gl_id   = sprite ? 0 : gl::Texture::missingTexture();
+	++n_pending_;
+
+	// Decode in the background
+	ThreadPool::global().queue(
+		[state      = async_,
+		 generation = async_->generation,
+		 pal        = decodePalette(),
+		 source     = std::make_shared<ImageSource>(std::move(source)),
+		 map        = &map,
+		 key        = string{ key },
+		 sprite]
 		{
-			SImage image;
-			if (ctex->toImage(image, archive, palette_.get(), true))
-			{
-				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
+			auto decoded = decode(*source, pal.get());
 
-				double sx = ctex->scaleX();
-				if (sx == 0.0)
-					sx = 1.0;
-				double sy = ctex->scaleY();
-				if (sy == 0.0)
-					sy = 1.0;
+			std::lock_guard lock(state->mutex);
+			if (state->generation == generation)
+				state->decoded.push_back({ map, key, sprite, std::move(decoded) });
+		});
+}
 
-				mtex.world_panning = ctex->worldPanning();
-				mtex.scale         = { 1.0 / sx, 1.0 / sy };
+// -----------------------------------------------------------------------------
+// Uploads the [decoded] image to an OpenGL texture for [mtex]
+// -----------------------------------------------------------------------------
+void MapTextureManager::upload(Texture& mtex, const DecodedImage& decoded, bool sprite) const
+{
+	mtex.pending = false;
 
-				return mtex;
-			}
-		}
+	// Not found
+	if (!decoded.image)
+	{
+		mtex.gl_id   = sprite ? 0 : gl::Texture::missingTexture();
+		mtex.missing = true;
+		return;
 	}
 
-	// Try to search for an actual flat
-	if (!mtex.gl_id)
+	mtex.gl_id         = gl::Texture::createFromImage(*decoded.image, nullptr, textureFilter(sprite), !sprite);
+	mtex.world_panning = decoded.world_panning;
+	mtex.scale         = decoded.scale;
+}
+
+// -----------------------------------------------------------------------------
+// Uploads decoded images from the background loading tasks to OpenGL textures,
+// stopping once the per-frame time budget (map_tex_upload_budget) is used up.
+// Must be called from the thread owning the OpenGL context.
+// Returns true if any textures were uploaded
+// -----------------------------------------------------------------------------
+bool MapTextureManager::processUploads()
+{
+	if (n_pending_ == 0)
+		return false;
+
+	// Get decoded images
+	vector<DecodedUpload> decoded;
 	{
-		auto* entry       = app::resources().getFlatEntry(name, archive);
-		auto* hires_entry = app::resources().getHiresEntry(name, archive);
-		auto* image_entry = hires_entry;
-		auto* scale_entry = entry;
+		std::lock_guard lock(async_->mutex);
+		decoded.swap(async_->decoded);
+	}
 
-		// No high-res texture found
-		if (!image_entry)
-		{
-			image_entry = entry;
-			scale_entry = nullptr;
-		}
+	// Upload as many as the budget allows (always at least one)
+	wxStopWatch sw;
+	size_t      uploaded = 0;
+	for (; uploaded < decoded.size(); ++uploaded)
+	{
+		if (uploaded > 0 && sw.Time() >= map_tex_upload_budget)
+			break;
 
-		// Load the image
-		SImage image;
-		if (misc::loadImageFromEntry(&image, image_entry))
-			mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
+		auto& item = decoded[uploaded];
+		if (auto i = item.map->find(item.key); i != item.map->end() && i->second.pending)
+			upload(i->second, item.decoded, item.sprite);
+
+		if (n_pending_ > 0)
+			--n_pending_;
+	}
 
-		// Get high-res texture scale
-		if (scale_entry)
+	// Put back any that didn't fit in this frame
+	if (uploaded < decoded.size())
+	{
+		std::lock_guard lock(async_->mutex);
+		async_->decoded.insert(
+			async_->decoded.begin(),
+			std::make_move_iterator(decoded.begin() + uploaded),
+			std::make_move_iterator(decoded.end()));
+	}
+
+	// Keep redrawing while there are still textures loading
+	if (n_pending_ > 0)
+		mapeditor::forceRefresh(false);
+
+	if (uploaded == 0)
+		return false;
+
+	signals_.textures_uploaded();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Resolves the texture matching [name] from resources, using [archive] as the
+// base for resource lookups and [pal] for any images that have to be built
+// here. If [mixed] is true, flats are also searched if no matching texture is
+// found
+// -----------------------------------------------------------------------------
+MapTextureManager::ImageSource MapTextureManager::resolveTexture(
+	string_view name,
+	bool        mixed,
+	Archive*    archive,
+	Palette*    pal)
+{
+	ImageSource source;
+
+	// Look for composite textures first
+	auto* ctex = app::resources().getTexture(name, "WallTexture", archive);
+	if (!ctex)
+		ctex = app::resources().getTexture(name, "", archive);
+	if (ctex)
+		source.found = resolveComposite(source, *ctex, archive, pal);
+
+	// No composite match, look for stand-alone textures
+	else
+	{
+		// HIRES
+		if (auto* etex = app::resources().getHiresEntry(name, archive))
 		{
-			SImage lores_image;
-			if (misc::loadImageFromEntry(&lores_image, scale_entry))
+			source.found = resolveEntry(source, etex);
+			if (source.found)
 			{
-				double scale_x     = static_cast<double>(lores_image.width()) / static_cast<double>(image.width());
-				double scale_y     = static_cast<double>(lores_image.height()) / static_cast<double>(image.height());
-				mtex.world_panning = true;
-				mtex.scale         = { scale_x, scale_y };
+				SImage imgref;
+				if (misc::loadImageFromEntry(&imgref, app::resources().getTextureEntry(name, "textures", archive)))
+					source.scale_size = { imgref.width(), imgref.height() };
 			}
 		}
-	}
 
-	// Not found
-	if (!mtex.gl_id)
-	{
-		// Try to search for a composite texture instead
-		if (mixed)
-			return texture(name, false);
-
-		// Otherwise use missing texture
-		mtex.gl_id = gl::Texture::missingTexture();
+		// TEXTURES
+		else
+			source.found = resolveEntry(source, app::resources().getTextureEntry(name, "textures", archive));
 	}
 
-	return mtex;
+	// Not found, try flats if mixed
+	if (!source.found && mixed)
+		return resolveFlat(name, false, archive, pal);
+
+	return source;
 }
 
 // -----------------------------------------------------------------------------
-// Returns the sprite matching [name], loading it from resources if necessary.
-// Sprite name also supports wildcards (?)
+// Resolves the flat matching [name] from resources, using [archive] as the
+// base for resource lookups and [pal] for any images that have to be built
+// here. If [mixed] is true, textures are also searched if no matching flat is
+// found
 // -----------------------------------------------------------------------------
-const MapTextureManager::Texture& MapTextureManager::sprite(
+MapTextureManager::ImageSource MapTextureManager::resolveFlat(
 	string_view name,
-	string_view translation,
-	string_view palette)
+	bool        mixed,
+	Archive*    archive,
+	Palette*    pal)
 {
-	// Don't bother looking for nameless sprites
-	if (name.empty())
-		return tex_invalid;
-
-	// Get sprite matching name
-	auto hashname = fmt::format("{}{}{}", name, translation, palette);
-	strutil::upperIP(hashname);
-	auto& mtex = sprites_[hashname];
+	// Prioritize standalone textures
+	if (mixed && app::resources().getTextureEntry(name, "textures", archive))
+		return resolveTexture(name, false, archive, pal);
 
-	// Get desired filter type
-	auto filter = gl::TexFilter::Linear;
-	if (map_tex_filter == 0)
-		filter = gl::TexFilter::NearestLinearMin;
-	else if (map_tex_filter == 1)
-		filter = gl::TexFilter::Linear;
-	else if (map_tex_filter == 2)
-		filter = gl::TexFilter::Linear;
-	else if (map_tex_filter == 3)
-		filter = gl::TexFilter::NearestMipmap;
+	ImageSource source;
 
-	// If the texture is loaded
-	if (mtex.gl_id)
+	// Try composite flat texture
+	if (mixed)
 	{
-		// If the texture filter matches the desired one, return it
-		auto& tex_info = gl::Texture::info(mtex.gl_id);
-		if (tex_info.filter == filter)
-			return mtex;
-		else
+		auto* ctex = app::resources().getTexture(name, "Flat", archive);
+		if (ctex && resolveComposite(source, *ctex, archive, pal))
 		{
-			// Otherwise, reload the texture
-			gl::Texture::clear(mtex.gl_id);
-			mtex.gl_id = 0;
+			source.found = true;
+			return source;
 		}
 	}
 
-	// Sprite not found, look for it
-	bool   found  = false;
-	bool   mirror = false;
-	SImage image;
-	auto   archive = archive_.lock().get();
-	auto   entry   = app::resources().getPatchEntry(name, "sprites", archive);
+	// Try to search for an actual flat
+	auto* entry       = app::resources().getFlatEntry(name, archive);
+	auto* hires_entry = app::resources().getHiresEntry(name, archive);
+	auto* image_entry = hires_entry;
+	auto* scale_entry = entry;
+
+	// No high-res texture found
+	if (!image_entry)
+	{
+		image_entry = entry;
+		scale_entry = nullptr;
+	}
+
+	// Get the image and high-res texture scale
+	source.found = resolveEntry(source, image_entry);
+	if (source.found && scale_entry)
+	{
+		SImage lores_image;
+		if (misc::loadImageFromEntry(&lores_image, scale_entry))
+			source.scale_size = { lores_image.width(), lores_image.height() };
+	}
+
+	// Not found, try to search for a composite texture instead if mixed
+	if (!source.found && mixed)
+		return resolveTexture(name, false, archive, pal);
+
+	return source;
+}
+
+// -----------------------------------------------------------------------------
+// Resolves the sprite matching [name] from resources, using [archive] as the
+// base for resource lookups and [pal] for any images that have to be built
+// here. [translation] and [palette] (a palette entry name) are applied when
+// decoding if given. Sprite name also supports wildcards (?)
+// -----------------------------------------------------------------------------
+MapTextureManager::ImageSource MapTextureManager::resolveSprite(
+	string_view name,
+	string_view translation,
+	string_view palette,
+	Archive*    archive,
+	Palette*    pal)
+{
+	ImageSource source;
+	if (name.empty())
+		return source;
+
+	// Look for sprite entry
+	auto entry = app::resources().getPatchEntry(name, "sprites", archive);
 	if (!entry)
 		entry = app::resources().getPatchEntry(name, "", archive);
 	if (!entry && name.length() == 8)
@@ -393,71 +528,201 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 		newname[7] = name[5];
 		entry      = app::resources().getPatchEntry(newname, "sprites", archive);
 		if (entry)
-			mirror = true;
+			source.mirror = true;
 	}
 	if (entry)
-	{
-		found = true;
-		misc::loadImageFromEntry(&image, entry);
-	}
+		source.found = resolveEntry(source, entry);
 	else // Try composite textures then
 	{
-		auto ctex = app::resources().getTexture(name, "", archive);
-		if (ctex && ctex->toImage(image, archive, palette_.get(), true))
-			found = true;
+		auto ctex    = app::resources().getTexture(name, "", archive);
+		source.found = ctex && resolveComposite(source, *ctex, archive, pal);
 	}
 
 	// We have a valid image either from an entry or a composite texture.
-	if (found)
+	if (source.found)
 	{
-		auto pal = palette_.get();
-
-		// Apply translation
+		// Translation
 		if (!translation.empty())
-			image.applyTranslation(translation, pal, true);
+		{
+			source.translation = std::make_shared<Translation>();
+			source.translation->parse(translation);
+		}
 
-		// Apply palette override
+		// Palette override
 		if (!palette.empty())
 		{
 			auto newpal = app::resources().getPaletteEntry(palette, archive);
 			if (newpal && newpal->size() == 768)
 			{
-				pal = image.palette();
-				pal->loadMem(newpal->data());
+				source.palette = std::make_shared<Palette>();
+				source.palette->loadMem(newpal->data());
 			}
 		}
-
-		// Apply mirroring
-		if (mirror)
-			image.mirror(false);
-
-		// Turn into GL texture
-		mtex.gl_id = gl::Texture::createFromImage(image, pal, filter, false);
-		return mtex;
 	}
 	else if (name.back() == '?')
 	{
 		name.remove_suffix(1);
-		auto stex = &sprite(fmt::format("{}0", name), translation, palette);
-		if (!stex->gl_id)
-			stex = &sprite(fmt::format("{}1", name), translation, palette);
-		if (stex->gl_id)
-			return *stex;
-		if (!stex->gl_id && name.length() == 5)
+		source = resolveSprite(fmt::format("{}0", name), translation, palette, archive, pal);
+		if (!source.found)
+			source = resolveSprite(fmt::format("{}1", name), translation, palette, archive, pal);
+		if (!source.found && name.length() == 5)
 		{
-			for (char chr = 'A'; chr <= ']'; ++chr)
+			for (char chr = 'A'; chr <= ']' && !source.found; ++chr)
 			{
-				stex = &sprite(fmt::format("{}0{}0", name, chr), translation, palette);
-				if (stex->gl_id)
-					return *stex;
-				stex = &sprite(fmt::format("{}1{}1", name, chr), translation, palette);
-				if (stex->gl_id)
-					return *stex;
+				source = resolveSprite(fmt::format("{}0{}0", name, chr), translation, palette, archive, pal);
+				if (!source.found)
+					source = resolveSprite(fmt::format("{}1{}1", name, chr), translation, palette, archive, pal);
 			}
 		}
 	}
 
-	return tex_invalid;
+	return source;
+}
+
+// -----------------------------------------------------------------------------
+// Sets [source] to load its image from [entry]. The entry data is copied and
+// its image format determined here, so the image itself can be loaded on any
+// thread. Images that can't be loaded that way are loaded immediately.
+// Returns false if [entry] isn't a valid image
+// -----------------------------------------------------------------------------
+bool MapTextureManager::resolveEntry(ImageSource& source, ArchiveEntry* entry)
+{
+	if (!entry)
+		return false;
+
+	// Detect entry type if it isn't already
+	if (entry->type() == EntryType::unknownType())
+		EntryType::detectEntryType(*entry);
+	if (!entry->type()->extraProps().contains("image"))
+		return false;
+
+	// Fonts and Jaguar formats are loaded manually, and the Jaguar ones read
+	// other entries in the archive
+	const auto& format_id = entry->type()->formatId();
+	if (!strutil::startsWith(format_id, "font_") && !strutil::startsWith(format_id, "img_jaguar"))
+	{
+		auto  hint   = entry->type()->extraProps().getOr<string>("image_format", {});
+		auto* format = SIFormat::determineFormat(*entry, hint);
+		if (format == SIFormat::unknownFormat() && format_id == "img_raw"
+			&& SIFormat::rawFormat()->isThisFormat(entry->data()))
+			format = SIFormat::rawFormat();
+		if (format == SIFormat::unknownFormat() && SIFormat::generalFormat()->isThisFormat(entry->data()))
+			format = SIFormat::generalFormat();
+
+		if (format != SIFormat::unknownFormat())
+		{
+			source.format = format;
+			source.data.importMem(std::as_const(entry->data()).data(), entry->size());
+			return true;
+		}
+	}
+
+	// Otherwise load the image here
+	auto image = std::make_shared<SImage>();
+	if (!misc::loadImageFromEntry(image.get(), entry))
+		return false;
+
+	source.image = image;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Sets [source] to build its image from the composite texture [ctex], using
+// [archive] as the base for resource lookups. Regular (TEXTUREx) textures have
+// their patch images loaded here to be drawn when decoding, extended textures
+// are built here using [pal].
+// Returns false if the texture image couldn't be built
+// -----------------------------------------------------------------------------
+bool MapTextureManager::resolveComposite(ImageSource& source, CTexture& ctex, Archive* archive, Palette* pal)
+{
+	if (ctex.isExtended())
+	{
+		auto image = std::make_shared<SImage>();
+		if (!ctex.toImage(*image, archive, pal, true))
+			return false;
+
+		source.image = image;
+	}
+	else
+	{
+		source.size = { ctex.width(), ctex.height() };
+		for (const auto& patch : ctex.patches())
+		{
+			ImageSource::Patch patch_image;
+			if (!patchcache::loadImage(patch_image.image, patch->patchEntry(archive)))
+				continue;
+
+			patch_image.x = patch->xOffset();
+			patch_image.y = patch->yOffset();
+			source.patches.push_back(std::move(patch_image));
+		}
+	}
+
+	double sx = ctex.scaleX();
+	if (sx == 0.0)
+		sx = 1.0;
+	double sy = ctex.scaleY();
+	if (sy == 0.0)
+		sy = 1.0;
+
+	source.world_panning = ctex.worldPanning();
+	source.scale         = { 1.0 / sx, 1.0 / sy };
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the image from [source] to an RGBA image, using [pal] for paletted
+// images (unless [source] has its own palette). Only pixel work is done here,
+// so this can be called from any thread
+// -----------------------------------------------------------------------------
+MapTextureManager::DecodedImage MapTextureManager::decode(ImageSource& source, Palette* pal)
+{
+	DecodedImage decoded;
+	if (!source.found)
+		return decoded;
+
+	auto image = source.image ? source.image : std::make_shared<SImage>();
+
+	// Load image data
+	if (source.format)
+	{
+		if (!source.format->loadImage(*image, source.data, 0, false))
+			return decoded;
+	}
+
+	// Draw regular composite texture patches
+	else if (!source.image)
+	{
+		SImage::DrawProps dp;
+		dp.src_alpha = false;
+		image->resize(source.size.x, source.size.y);
+		for (auto& patch : source.patches)
+			image->drawImage(patch.image, patch.x, patch.y, dp, pal, pal);
+	}
+
+	// Apply translation
+	if (source.translation)
+		image->applyTranslation(source.translation.get(), pal, true);
+
+	// Apply mirroring
+	if (source.mirror)
+		image->mirror(false);
+
+	// Get high-res texture scale
+	decoded.world_panning = source.world_panning;
+	decoded.scale         = source.scale;
+	if (source.scale_size.x > 0 && image->width() > 0 && image->height() > 0)
+	{
+		decoded.world_panning = true;
+		decoded.scale         = { static_cast<double>(source.scale_size.x) / static_cast<double>(image->width()),
+								  static_cast<double>(source.scale_size.y) / static_cast<double>(image->height()) };
+	}
+
+	image->convertRGBA(source.palette ? source.palette.get() : pal);
+	decoded.image = image;
+
+	return decoded;
 }
 
 // -----------------------------------------------------------------------------
@@ -479,7 +744,7 @@ int MapTextureManager::verticalOffset(string_view name) const
 	if (entry)
 	{
 		SImage image;
-		misc::loadImageFromEntry(&image, entry);
+		patchcache::loadImage(image, entry);
 		int h = image.height();
 		int o = image.offset().y;
 		if (o > h)
@@ -549,6 +814,14 @@ const MapTextureManager::Texture& MapTextureManager::editorImage(string_view nam
 // -----------------------------------------------------------------------------
 void MapTextureManager::refreshResources()
 {
+	// Discard any images still being decoded in the background
+	{
+		std::lock_guard lock(async_->mutex);
+		async_->generation++;
+		async_->decoded.clear();
+		n_pending_ = 0;
+	}
+
 	// Clear all cached textures
 	textures_.clear();
 	flats_.clear();
@@ -558,6 +831,7 @@ void MapTextureManager::refreshResources()
 	theMainWindow->paletteChooser()->setGlobalFromArchive(archive_.lock().get());
 	mapeditor::forceRefresh(true);
 	palette_->copyPalette(resourcePalette());
+	decode_palette_.reset();
 
 	// Clear texture info
 	tex_info_.clear();
@@ -646,3 +920,102 @@ void MapTextureManager::setArchive(shared_ptr<Archive> archive)
 	archive_ = archive;
 	refreshResources();
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+#include "General/Console.h"
+
+// -----------------------------------------------------------------------------
+// Decodes all available textures and flats both serially and in the background
+// thread pool, checks the results match and reports the times taken.
+// No OpenGL textures are created
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(map_tex_decode_test, 0, false)
+{
+	auto& manager = mapeditor::textureManager();
+	auto  archive = app::archiveManager().baseResourceArchive();
+	auto  pal     = manager.resourcePalette();
+
+	// Get all texture and flat names
+	vector<std::pair<string, bool>> names; // name, flat
+	for (const auto& info : manager.allTexturesInfo())
+		names.emplace_back(info.short_name, false);
+	for (const auto& info : manager.allFlatsInfo())
+		names.emplace_back(info.short_name, true);
+
+	// Resolve sources (on the main thread, once for each run)
+	vector<MapTextureManager::ImageSource> sources_serial(names.size());
+	vector<MapTextureManager::ImageSource> sources_pooled(names.size());
+	wxStopWatch                            sw;
+	for (size_t a = 0; a < names.size(); ++a)
+	{
+		const auto& [name, is_flat] = names[a];
+		sources_serial[a] = is_flat ? MapTextureManager::resolveFlat(name, false, archive, pal) :
+									  MapTextureManager::resolveTexture(name, false, archive, pal);
+	}
+	auto time_resolve = sw.Time();
+	for (size_t a = 0; a < names.size(); ++a)
+	{
+		const auto& [name, is_flat] = names[a];
+		sources_pooled[a] = is_flat ? MapTextureManager::resolveFlat(name, false, archive, pal) :
+									  MapTextureManager::resolveTexture(name, false, archive, pal);
+	}
+
+	// Serial
+	vector<MapTextureManager::DecodedImage> serial(names.size());
+	sw.Start();
+	for (size_t a = 0; a < names.size(); ++a)
+		serial[a] = MapTextureManager::decode(sources_serial[a], pal);
+	auto time_serial = sw.Time();
+
+	// Background (all tasks share a palette copy, as in async mode)
+	vector<MapTextureManager::DecodedImage> pooled(names.size());
+	auto                                    task_pal = manager.decodePalette();
+	sw.Start();
+	ThreadPool::global().parallelFor(
+		names.size(),
+		[&](size_t index) { pooled[index] = MapTextureManager::decode(sources_pooled[index], task_pal.get()); });
+	auto time_pooled = sw.Time();
+
+	// Compare
+	unsigned found      = 0;
+	unsigned mismatches = 0;
+	for (size_t a = 0; a < names.size(); ++a)
+	{
+		auto* img_s = serial[a].image.get();
+		auto* img_p = pooled[a].image.get();
+		if (img_s)
+			found++;
+
+		bool match = (img_s == nullptr) == (img_p == nullptr);
+		if (match && img_s)
+		{
+			MemChunk data_s, data_p;
+			img_s->putRGBAData(data_s);
+			img_p->putRGBAData(data_p);
+			match = img_s->width() == img_p->width() && img_s->height() == img_p->height()
+					&& serial[a].scale == pooled[a].scale && data_s.size() == data_p.size()
+					&& memcmp(data_s.data(), data_p.data(), data_s.size()) == 0;
+		}
+
+		if (!match)
+		{
+			log::console(fmt::format("Mismatch decoding {}", names[a].first));
+			mismatches++;
+		}
+	}
+
+	log::console(fmt::format(
+		"Decoded {} images ({} found): resolve {}ms, serial {}ms, {} threads {}ms, {} mismatches",
+		names.size(),
+		found,
+		time_resolve,
+		time_serial,
+		ThreadPool::global().numThreads(),
+		time_pooled,
+		mismatches));
+}
@@ -1,12 +1,18 @@
 #pragma once
 
+#include "Graphics/SImage/SImage.h"
 #include "OpenGL/GLTexture.h"
+#include <mutex>
 
 namespace slade
 {
 class ArchiveDir;
+class ArchiveEntry;
 class Archive;
+class CTexture;
 class Palette;
+class SIFormat;
+class Translation;
 
 class MapTextureManager
 {
@@ -26,8 +32,44 @@ public:
 		unsigned gl_id         = 0;
 		bool     world_panning = false;
 		Vec2d    scale         = { 1., 1. };
+		bool     pending       = false; // Being decoded in the background (async mode only)
+		bool     missing       = false; // Not found in resources
 		~Texture() { gl::Texture::clear(gl_id); }
 	};
+
+	// Everything needed to decode a texture/flat/sprite image. Resources are
+	// looked up and read on the main thread (see resolveTexture etc.), so the
+	// image can then be decoded on any thread (see decode)
+	struct ImageSource
+	{
+		struct Patch
+		{
+			SImage image;
+			int    x = 0;
+			int    y = 0;
+		};
+
+		bool                    found = false;
+		shared_ptr<SImage>      image;             // Image already loaded on the main thread
+		MemChunk                data;              // Image data to load (copied from the entry)
+		SIFormat*               format = nullptr;  // Format of [data]
+		Vec2i                   size;              // Size of a regular composite texture
+		vector<Patch>           patches;           // Patches of a regular composite texture
+		Vec2i                   scale_size;        // Size to scale a hires image to (if any)
+		shared_ptr<Translation> translation;       // Translation to apply
+		shared_ptr<Palette>     palette;           // Palette to use instead of the resource palette
+		bool                    mirror        = false;
+		bool                    world_panning = false;
+		Vec2d                   scale         = { 1., 1. };
+	};
+
+	// A texture/flat/sprite image decoded from resources, ready to be uploaded
+	struct DecodedImage
+	{
+		shared_ptr<SImage> image; // RGBA, null if not found
+		bool               world_panning = false;
+		Vec2d              scale         = { 1., 1. };
+	};
 	typedef std::map<string, Texture> MapTexHashMap;
 
 	struct TexInfo
@@ -52,19 +94,45 @@ public:
 	};
 
 	MapTextureManager(shared_ptr<Archive> archive = nullptr);
-	~MapTextureManager() = default;
+	~MapTextureManager();
 
 	void init();
 	void setArchive(shared_ptr<Archive> archive);
 	void refreshResources();
 
-	Palette*       resourcePalette() const;
+	shared_ptr<Archive> archive() const { return archive_.lock(); }
+
+	Palette*            resourcePalette() const;
+	shared_ptr<Palette> decodePalette();
 	const Texture& texture(string_view name, bool mixed);
 	const Texture& flat(string_view name, bool mixed);
 	const Texture& sprite(string_view name, string_view translation = "", string_view palette = "");
 	const Texture& editorImage(string_view name);
 	int            verticalOffset(string_view name) const;
 
+	// Asynchronous loading
+	bool     processUploads();
+	unsigned numPending() const { return n_pending_; }
+
+	// Image decoding. Sources must be resolved on the main thread, but decoding
+	// them involves no resources or OpenGL and is safe from any thread
+	static ImageSource  resolveTexture(string_view name, bool mixed, Archive* archive, Palette* pal);
+	static ImageSource  resolveFlat(string_view name, bool mixed, Archive* archive, Palette* pal);
+	static ImageSource  resolveSprite(
+		string_view name,
+		string_view translation,
+		string_view palette,
+		Archive*    archive,
+		Palette*    pal);
+	static DecodedImage decode(ImageSource& source, Palette* pal);
+
+	// Signals
+	struct Signals
+	{
+		sigslot::signal<> textures_uploaded; // Pending textures were uploaded (async mode only)
+	};
+	Signals& signals() { return signals_; }
+
 	vector<TexInfo>& allTexturesInfo()
 	{
 		if (tex_info_.empty() && flat_info_.empty())
@@ -82,6 +150,21 @@ public:
 	}
 
 private:
+	// Decoded images waiting to be uploaded, shared with the decoding tasks
+	struct DecodedUpload
+	{
+		MapTexHashMap* map;
+		string         key;
+		bool           sprite;
+		DecodedImage   decoded;
+	};
+	struct AsyncState
+	{
+		std::mutex            mutex;
+		vector<DecodedUpload> decoded;
+		unsigned              generation = 0;
+	};
+
 	weak_ptr<Archive>   archive_;
 	MapTexHashMap       textures_;
 	MapTexHashMap       flats_;
@@ -89,14 +172,25 @@ private:
 	MapTexHashMap       editor_images_;
 	bool                editor_images_loaded_ = false;
 	unique_ptr<Palette> palette_;
+	shared_ptr<Palette> decode_palette_; // Copy of palette_ shared by background decoding tasks
 	vector<TexInfo>     tex_info_;
 	vector<TexInfo>     flat_info_;
+	Signals             signals_;
+
+	shared_ptr<AsyncState> async_;
+	unsigned               n_pending_ = 0;
 
 	// Signal connections
 	sigslot::scoped_connection sc_resources_updated_;
 	sigslot::scoped_connection sc_palette_changed_;
 
 	void buildTexInfoList();
+	void loadImage(MapTexHashMap& map, string_view key, bool sprite, ImageSource source);
+
+	static bool resolveEntry(ImageSource& source, ArchiveEntry* entry);
+	static bool resolveComposite(ImageSource& source, CTexture& ctex, Archive* archive, Palette* pal);
+
+	void upload(Texture& mtex, const DecodedImage& decoded, bool sprite) const;
 	void importEditorImages(MapTexHashMap& map, const ArchiveDir* dir, string_view path) const;
 };
 } // namespace slade
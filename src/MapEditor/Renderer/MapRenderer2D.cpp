@@ -229,9 +229,11 @@ void MapRenderer2D::renderVerticesImmediate()
 		glNewList(list_vertices_, GL_COMPILE_AND_EXECUTE);
 
 		// Draw all vertices
+		const auto& vx = map_->vertices().xPositions();
+		const auto& vy = map_->vertices().yPositions();
 		glBegin(GL_POINTS);
 		for (unsigned a = 0; a < map_->nVertices(); a++)
-			glVertex2d(map_->vertex(a)->xPos(), map_->vertex(a)->yPos());
+			glVertex2d(vx[a], vy[a]);
 		glEnd();
 
 		glEndList();
@@ -2054,32 +2056,32 @@ void MapRenderer2D::renderFlatsImmediate(int type, bool texture, float alpha)
 				{
 					if (game::configuration().featureSupported(UDMFFeature::FlatPanning))
 					{
-						ox = sector->floatProperty("xpanningfloor");
-						oy = sector->floatProperty("ypanningfloor");
+						ox = sector->floatProperty(property::keys::XPanningFloor);
+						oy = sector->floatProperty(property::keys::YPanningFloor);
 					}
 					if (game::configuration().featureSupported(UDMFFeature::FlatScaling))
 					{
-						sx *= (1.0 / sector->floatProperty("xscalefloor"));
-						sy *= (1.0 / sector->floatProperty("yscalefloor"));
+						sx *= (1.0 / sector->floatProperty(property::keys::XScaleFloor));
+						sy *= (1.0 / sector->floatProperty(property::keys::YScaleFloor));
 					}
 					if (game::configuration().featureSupported(UDMFFeature::FlatRotation))
-						rot = sector->floatProperty("rotationfloor");
+						rot = sector->floatProperty(property::keys::RotationFloor);
 				}
 				// Ceiling
 				else
 				{
 					if (game::configuration().featureSupported(UDMFFeature::FlatPanning))
 					{
-						ox = sector->floatProperty("xpanningceiling");
-						oy = sector->floatProperty("ypanningceiling");
+						ox = sector->floatProperty(property::keys::XPanningCeiling);
+						oy = sector->floatProperty(property::keys::YPanningCeiling);
 					}
 					if (game::configuration().featureSupported(UDMFFeature::FlatScaling))
 					{
-						sx *= (1.0 / sector->floatProperty("xscaleceiling"));
-						sy *= (1.0 / sector->floatProperty("yscaleceiling"));
+						sx *= (1.0 / sector->floatProperty(property::keys::XScaleCeiling));
+						sy *= (1.0 / sector->floatProperty(property::keys::YScaleCeiling));
 					}
 					if (game::configuration().featureSupported(UDMFFeature::FlatRotation))
-						rot = sector->floatProperty("rotationceiling");
+						rot = sector->floatProperty(property::keys::RotationCeiling);
 				}
 			}
 
@@ -2209,32 +2211,32 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 				{
 					if (game::configuration().featureSupported(UDMFFeature::FlatPanning))
 					{
-						ox = sector->floatProperty("xpanningfloor");
-						oy = sector->floatProperty("ypanningfloor");
+						ox = sector->floatProperty(property::keys::XPanningFloor);
+						oy = sector->floatProperty(property::keys::YPanningFloor);
 					}
 					if (game::configuration().featureSupported(UDMFFeature::FlatScaling))
 					{
-						sx *= (1.0 / sector->floatProperty("xscalefloor"));
-						sy *= (1.0 / sector->floatProperty("yscalefloor"));
+						sx *= (1.0 / sector->floatProperty(property::keys::XScaleFloor));
+						sy *= (1.0 / sector->floatProperty(property::keys::YScaleFloor));
 					}
 					if (game::configuration().featureSupported(UDMFFeature::FlatRotation))
-						rot = sector->floatProperty("rotationfloor");
+						rot = sector->floatProperty(property::keys::RotationFloor);
 				}
 				// Ceiling
 				else
 				{
 					if (game::configuration().featureSupported(UDMFFeature::FlatPanning))
 					{
-						ox = sector->floatProperty("xpanningceiling");
-						oy = sector->floatProperty("ypanningceiling");
+						ox = sector->floatProperty(property::keys::XPanningCeiling);
+						oy = sector->floatProperty(property::keys::YPanningCeiling);
 					}
 					if (game::configuration().featureSupported(UDMFFeature::FlatScaling))
 					{
-						sx *= (1.0 / sector->floatProperty("xscaleceiling"));
-						sy *= (1.0 / sector->floatProperty("yscaleceiling"));
+						sx *= (1.0 / sector->floatProperty(property::keys::XScaleCeiling));
+						sy *= (1.0 / sector->floatProperty(property::keys::YScaleCeiling));
 					}
 					if (game::configuration().featureSupported(UDMFFeature::FlatRotation))
-						rot = sector->floatProperty("rotationceiling");
+						rot = sector->floatProperty(property::keys::RotationCeiling);
 				}
 			}
 			// Scaling applies to offsets as well.
@@ -3016,13 +3018,15 @@ void MapRenderer2D::updateVerticesVBO()
 		glGenBuffers(1, &vbo_vertices_);
 
 	// Fill vertices VBO
+	const auto&     vx      = map_->vertices().xPositions();
+	const auto&     vy      = map_->vertices().yPositions();
 	int             nfloats = map_->nVertices() * 2;
 	vector<GLfloat> verts(nfloats);
 	unsigned        i = 0;
 	for (unsigned a = 0; a < map_->nVertices(); a++)
 	{
-		verts[i++] = map_->vertex(a)->xPos();
-		verts[i++] = map_->vertex(a)->yPos();
+		verts[i++] = vx[a];
+		verts[i++] = vy[a];
 	}
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices_);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * nfloats, verts.data(), GL_STATIC_DRAW);
@@ -3051,6 +3055,10 @@ void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
 		vpl = 4;
 
 	// Fill lines VBO
+	const auto&    vx     = map_->vertices().xPositions();
+	const auto&    vy     = map_->vertices().yPositions();
+	const auto&    v1     = map_->lines().v1Indices();
+	const auto&    v2     = map_->lines().v2Indices();
 	int            nverts = map_->nLines() * vpl;
 	vector<GLVert> lines(nverts);
 	unsigned       v = 0;
@@ -3065,10 +3073,10 @@ void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
 		alpha = base_alpha * col.fa();
 
 		// Set line vertices
-		lines[v].x     = line->v1()->xPos();
-		lines[v].y     = line->v1()->yPos();
-		lines[v + 1].x = line->v2()->xPos();
-		lines[v + 1].y = line->v2()->yPos();
+		lines[v].x     = vx[v1[a]];
+		lines[v].y     = vy[v1[a]];
+		lines[v + 1].x = vx[v2[a]];
+		lines[v + 1].y = vy[v2[a]];
 
 		// Set line colour(s)
 		lines[v].r = lines[v + 1].r = col.fr();
@@ -141,6 +141,10 @@ MapRenderer3D::MapRenderer3D(SLADEMap* map) : map_{ map }
 	sc_resources_updated_ = app::resources().signals().resources_updated.connect([this]() { refreshTextures(); });
 	sc_palette_changed_   = theMainWindow->paletteChooser()->signals().palette_changed.connect([this]()
                                                                                              { refreshTextures(); });
+
+	// Replace placeholders when background-loaded textures are uploaded
+	sc_textures_uploaded_ = mapeditor::textureManager().signals().textures_uploaded.connect(
+		[this]() { refreshPlaceholderTextures(); });
 }
 
 // -----------------------------------------------------------------------------
@@ -229,6 +233,48 @@ void MapRenderer3D::refreshTextures()
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Clears texture related data for anything currently using a placeholder
+// texture, so it is updated with the real texture once loaded
+// -----------------------------------------------------------------------------
+void MapRenderer3D::refreshPlaceholderTextures()
+{
+	auto tex_missing = gl::Texture::missingTexture();
+
+	// Refresh lines
+	for (auto& line : lines_)
+	{
+		for (auto& quad : line.quads)
+		{
+			if (quad.texture == tex_missing)
+			{
+				quad.texture      = 0;
+				line.updated_time = 0;
+			}
+		}
+	}
+
+	// Refresh flats
+	for (auto& sector : sector_flats_)
+	{
+		for (auto& flat : sector)
+		{
+			if (flat.texture == tex_missing)
+			{
+				flat.texture      = 0;
+				flat.updated_time = 0;
+			}
+		}
+	}
+
+	// Refresh things (sprite placeholders are editor images)
+	for (auto& thing : things_)
+	{
+		thing.sprite       = 0;
+		thing.updated_time = 0;
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Clears all cached rendering data
 // -----------------------------------------------------------------------------
@@ -939,31 +985,31 @@ void MapRenderer3D::updateFlatTexCoords(unsigned index, unsigned flat_index) con
 		{
 			if (game::configuration().featureSupported(UDMFFeature::FlatPanning))
 			{
-				ox = sector->floatProperty("xpanningfloor");
-				oy = sector->floatProperty("ypanningfloor");
+				ox = sector->floatProperty(property::keys::XPanningFloor);
+				oy = sector->floatProperty(property::keys::YPanningFloor);
 			}
 			if (game::configuration().featureSupported(UDMFFeature::FlatScaling))
 			{
-				sx *= (1.0 / sector->floatProperty("xscalefloor"));
-				sy *= (1.0 / sector->floatProperty("yscalefloor"));
+				sx *= (1.0 / sector->floatProperty(property::keys::XScaleFloor));
+				sy *= (1.0 / sector->floatProperty(property::keys::YScaleFloor));
 			}
 			if (game::configuration().featureSupported(UDMFFeature::FlatRotation))
-				rot = sector->floatProperty("rotationfloor");
+				rot = sector->floatProperty(property::keys::RotationFloor);
 		}
 		else
 		{
 			if (game::configuration().featureSupported(UDMFFeature::FlatPanning))
 			{
-				ox = sector->floatProperty("xpanningceiling");
-				oy = sector->floatProperty("ypanningceiling");
+				ox = sector->floatProperty(property::keys::XPanningCeiling);
+				oy = sector->floatProperty(property::keys::YPanningCeiling);
 			}
 			if (game::configuration().featureSupported(UDMFFeature::FlatScaling))
 			{
-				sx *= (1.0 / sector->floatProperty("xscaleceiling"));
-				sy *= (1.0 / sector->floatProperty("yscaleceiling"));
+				sx *= (1.0 / sector->floatProperty(property::keys::XScaleCeiling));
+				sy *= (1.0 / sector->floatProperty(property::keys::YScaleCeiling));
 			}
 			if (game::configuration().featureSupported(UDMFFeature::FlatRotation))
-				rot = sector->floatProperty("rotationceiling");
+				rot = sector->floatProperty(property::keys::RotationCeiling);
 		}
 	}
 
@@ -1512,8 +1558,8 @@ void MapRenderer3D::updateLine(unsigned index)
 	bool   mixed       = game::configuration().featureSupported(Feature::MixTexFlats);
 	lines_[index].line = line;
 	double alpha       = 1.0;
-	if (line->hasProp("alpha"))
-		alpha = line->floatProperty("alpha");
+	if (line->hasProp(property::keys::Alpha))
+		alpha = line->floatProperty(property::keys::Alpha);
 	else if (line_translucent) // TranslucentLine special
 		alpha = map_->mapSpecials()->translucentLineAlpha(line);
 
@@ -1561,10 +1607,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map_->currentFormat() == MapFormat::UDMF
 			&& game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
-			if (line->s1()->hasProp("offsetx_mid"))
-				xoff += line->s1()->floatProperty("offsetx_mid");
-			if (line->s1()->hasProp("offsety_mid"))
-				yoff += line->s1()->floatProperty("offsety_mid");
+			if (line->s1()->hasProp(property::keys::OffsetXMid))
+				xoff += line->s1()->floatProperty(property::keys::OffsetXMid);
+			if (line->s1()->hasProp(property::keys::OffsetYMid))
+				yoff += line->s1()->floatProperty(property::keys::OffsetYMid);
 		}
 
 		// Texture scale
@@ -1574,10 +1620,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		sy           = tex.scale.y;
 		if (game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
-			if (line->s1()->hasProp("scalex_mid"))
-				lsx = 1.0 / line->s1()->floatProperty("scalex_mid");
-			if (line->s1()->hasProp("scaley_mid"))
-				lsy = 1.0 / line->s1()->floatProperty("scaley_mid");
+			if (line->s1()->hasProp(property::keys::ScaleXMid))
+				lsx = 1.0 / line->s1()->floatProperty(property::keys::ScaleXMid);
+			if (line->s1()->hasProp(property::keys::ScaleYMid))
+				lsy = 1.0 / line->s1()->floatProperty(property::keys::ScaleYMid);
 		}
 		if (!tex.world_panning)
 		{
@@ -1653,10 +1699,10 @@ void MapRenderer3D::updateLine(unsigned index)
 			&& game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
 			// UDMF extra offsets
-			if (line->s1()->hasProp("offsetx_bottom"))
-				xoff += line->s1()->floatProperty("offsetx_bottom");
-			if (line->s1()->hasProp("offsety_bottom"))
-				yoff += line->s1()->floatProperty("offsety_bottom");
+			if (line->s1()->hasProp(property::keys::OffsetXBottom))
+				xoff += line->s1()->floatProperty(property::keys::OffsetXBottom);
+			if (line->s1()->hasProp(property::keys::OffsetYBottom))
+				yoff += line->s1()->floatProperty(property::keys::OffsetYBottom);
 		}
 
 		// Texture scale
@@ -1667,10 +1713,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map_->currentFormat() == MapFormat::UDMF
 			&& game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
-			if (line->s1()->hasProp("scalex_bottom"))
-				lsx = 1.0 / line->s1()->floatProperty("scalex_bottom");
-			if (line->s1()->hasProp("scaley_bottom"))
-				lsy = 1.0 / line->s1()->floatProperty("scaley_bottom");
+			if (line->s1()->hasProp(property::keys::ScaleXBottom))
+				lsx = 1.0 / line->s1()->floatProperty(property::keys::ScaleXBottom);
+			if (line->s1()->hasProp(property::keys::ScaleYBottom))
+				lsy = 1.0 / line->s1()->floatProperty(property::keys::ScaleYBottom);
 		}
 		if (!tex.world_panning)
 		{
@@ -1716,10 +1762,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map_->currentFormat() == MapFormat::UDMF
 			&& game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
-			if (line->s1()->hasProp("offsetx_mid"))
-				xoff += line->s1()->floatProperty("offsetx_mid");
-			if (line->s1()->hasProp("offsety_mid"))
-				yoff += line->s1()->floatProperty("offsety_mid");
+			if (line->s1()->hasProp(property::keys::OffsetXMid))
+				xoff += line->s1()->floatProperty(property::keys::OffsetXMid);
+			if (line->s1()->hasProp(property::keys::OffsetYMid))
+				yoff += line->s1()->floatProperty(property::keys::OffsetYMid);
 		}
 
 		// Texture scale
@@ -1728,10 +1774,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map_->currentFormat() == MapFormat::UDMF
 			&& game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
-			if (line->s1()->hasProp("scalex_mid"))
-				lsx = 1.0 / line->s1()->floatProperty("scalex_mid");
-			if (line->s1()->hasProp("scaley_mid"))
-				lsy = 1.0 / line->s1()->floatProperty("scaley_mid");
+			if (line->s1()->hasProp(property::keys::ScaleXMid))
+				lsx = 1.0 / line->s1()->floatProperty(property::keys::ScaleXMid);
+			if (line->s1()->hasProp(property::keys::ScaleYMid))
+				lsy = 1.0 / line->s1()->floatProperty(property::keys::ScaleYMid);
 		}
 		if (!tex.world_panning)
 		{
@@ -1749,7 +1795,7 @@ void MapRenderer3D::updateLine(unsigned index)
 			|| ((
 				map_->currentFormat() == MapFormat::UDMF
 				&& game::configuration().featureSupported(UDMFFeature::SideMidtexWrapping)
-				&& line->boolProperty("wrapmidtex"))))
+				&& line->boolProperty(property::keys::WrapMidTex))))
 		{
 			top    = lowceil;
 			bottom = highfloor;
@@ -1787,7 +1833,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.light     = light1;
 		setupQuadTexCoords(&quad, length, xoff, ytex, top, bottom, false, sx, sy);
 		quad.flags |= MIDTEX;
-		if (line->hasProp("renderstyle") && line->stringProperty("renderstyle") == "add")
+		if (line->hasProp(property::keys::RenderStyle) && line->stringProperty(property::keys::RenderStyle) == "add")
 			quad.flags |= TRANSADD;
 		else if (line_translucent && map_->mapSpecials()->translucentLineAdditive(line)) // TranslucentLine special
 			quad.flags |= TRANSADD;
@@ -1810,10 +1856,10 @@ void MapRenderer3D::updateLine(unsigned index)
 			&& game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
 			// UDMF extra offsets
-			if (line->s1()->hasProp("offsetx_top"))
-				xoff += line->s1()->floatProperty("offsetx_top");
-			if (line->s1()->hasProp("offsety_top"))
-				yoff += line->s1()->floatProperty("offsety_top");
+			if (line->s1()->hasProp(property::keys::OffsetXTop))
+				xoff += line->s1()->floatProperty(property::keys::OffsetXTop);
+			if (line->s1()->hasProp(property::keys::OffsetYTop))
+				yoff += line->s1()->floatProperty(property::keys::OffsetYTop);
 		}
 
 		// Texture scale
@@ -1824,10 +1870,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map_->currentFormat() == MapFormat::UDMF
 			&& game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
-			if (line->s1()->hasProp("scalex_top"))
-				lsx = 1.0 / line->s1()->floatProperty("scalex_top");
-			if (line->s1()->hasProp("scaley_top"))
-				lsy = 1.0 / line->s1()->floatProperty("scaley_top");
+			if (line->s1()->hasProp(property::keys::ScaleXTop))
+				lsx = 1.0 / line->s1()->floatProperty(property::keys::ScaleXTop);
+			if (line->s1()->hasProp(property::keys::ScaleYTop))
+				lsy = 1.0 / line->s1()->floatProperty(property::keys::ScaleYTop);
 		}
 		if (!tex.world_panning)
 		{
@@ -1869,10 +1915,10 @@ void MapRenderer3D::updateLine(unsigned index)
 			&& game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
 			// UDMF extra offsets
-			if (line->s2()->hasProp("offsetx_bottom"))
-				xoff += line->s2()->floatProperty("offsetx_bottom");
-			if (line->s2()->hasProp("offsety_bottom"))
-				yoff += line->s2()->floatProperty("offsety_bottom");
+			if (line->s2()->hasProp(property::keys::OffsetXBottom))
+				xoff += line->s2()->floatProperty(property::keys::OffsetXBottom);
+			if (line->s2()->hasProp(property::keys::OffsetYBottom))
+				yoff += line->s2()->floatProperty(property::keys::OffsetYBottom);
 		}
 
 		// Texture scale
@@ -1883,10 +1929,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map_->currentFormat() == MapFormat::UDMF
 			&& game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
-			if (line->s2()->hasProp("scalex_bottom"))
-				lsx = 1.0 / line->s2()->floatProperty("scalex_bottom");
-			if (line->s2()->hasProp("scaley_bottom"))
-				lsy = 1.0 / line->s2()->floatProperty("scaley_bottom");
+			if (line->s2()->hasProp(property::keys::ScaleXBottom))
+				lsx = 1.0 / line->s2()->floatProperty(property::keys::ScaleXBottom);
+			if (line->s2()->hasProp(property::keys::ScaleYBottom))
+				lsy = 1.0 / line->s2()->floatProperty(property::keys::ScaleYBottom);
 		}
 		if (!tex.world_panning)
 		{
@@ -1935,10 +1981,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map_->currentFormat() == MapFormat::UDMF
 			&& game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
-			if (line->s2()->hasProp("offsetx_mid"))
-				xoff += line->s2()->floatProperty("offsetx_mid");
-			if (line->s2()->hasProp("offsety_mid"))
-				yoff += line->s2()->floatProperty("offsety_mid");
+			if (line->s2()->hasProp(property::keys::OffsetXMid))
+				xoff += line->s2()->floatProperty(property::keys::OffsetXMid);
+			if (line->s2()->hasProp(property::keys::OffsetYMid))
+				yoff += line->s2()->floatProperty(property::keys::OffsetYMid);
 		}
 
 		// Texture scale
@@ -1947,10 +1993,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map_->currentFormat() == MapFormat::UDMF
 			&& game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
-			if (line->s2()->hasProp("scalex_mid"))
-				lsx = 1.0 / line->s2()->floatProperty("scalex_mid");
-			if (line->s2()->hasProp("scaley_mid"))
-				lsy = 1.0 / line->s2()->floatProperty("scaley_mid");
+			if (line->s2()->hasProp(property::keys::ScaleXMid))
+				lsx = 1.0 / line->s2()->floatProperty(property::keys::ScaleXMid);
+			if (line->s2()->hasProp(property::keys::ScaleYMid))
+				lsy = 1.0 / line->s2()->floatProperty(property::keys::ScaleYMid);
 		}
 		if (!tex.world_panning)
 		{
@@ -1967,7 +2013,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		if ((map_->currentFormat() == MapFormat::Doom64)
 			|| (map_->currentFormat() == MapFormat::UDMF
 				&& game::configuration().featureSupported(UDMFFeature::SideMidtexWrapping)
-				&& line->boolProperty("wrapmidtex")))
+				&& line->boolProperty(property::keys::WrapMidTex)))
 		{
 			top    = lowceil;
 			bottom = highfloor;
@@ -2006,7 +2052,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		setupQuadTexCoords(&quad, length, xoff, ytex, top, bottom, false, sx, sy);
 		quad.flags |= BACK;
 		quad.flags |= MIDTEX;
-		if (line->hasProp("renderstyle") && line->stringProperty("renderstyle") == "add")
+		if (line->hasProp(property::keys::RenderStyle) && line->stringProperty(property::keys::RenderStyle) == "add")
 			quad.flags |= TRANSADD;
 		else if (line_translucent && map_->mapSpecials()->translucentLineAdditive(line)) // TranslucentLine special
 			quad.flags |= TRANSADD;
@@ -2029,10 +2075,10 @@ void MapRenderer3D::updateLine(unsigned index)
 			&& game::configuration().featureSupported(UDMFFeature::TextureOffsets))
 		{
 			// UDMF extra offsets
-			if (line->s2()->hasProp("offsetx_top"))
-				xoff += line->s2()->floatProperty("offsetx_top");
-			if (line->s2()->hasProp("offsety_top"))
-				yoff += line->s2()->floatProperty("offsety_top");
+			if (line->s2()->hasProp(property::keys::OffsetXTop))
+				xoff += line->s2()->floatProperty(property::keys::OffsetXTop);
+			if (line->s2()->hasProp(property::keys::OffsetYTop))
+				yoff += line->s2()->floatProperty(property::keys::OffsetYTop);
 		}
 
 		// Texture scale
@@ -2043,10 +2089,10 @@ void MapRenderer3D::updateLine(unsigned index)
 		if (map_->currentFormat() == MapFormat::UDMF
 			&& game::configuration().featureSupported(UDMFFeature::TextureScaling))
 		{
-			if (line->s2()->hasProp("scalex_top"))
-				lsx = 1.0 / line->s2()->floatProperty("scalex_top");
-			if (line->s2()->hasProp("scaley_top"))
-				lsy = 1.0 / line->s2()->floatProperty("scaley_top");
+			if (line->s2()->hasProp(property::keys::ScaleXTop))
+				lsx = 1.0 / line->s2()->floatProperty(property::keys::ScaleXTop);
+			if (line->s2()->hasProp(property::keys::ScaleYTop))
+				lsy = 1.0 / line->s2()->floatProperty(property::keys::ScaleYTop);
 		}
 		if (!tex.world_panning)
 		{
@@ -109,6 +109,7 @@ public:
 	bool init();
 	void refresh();
 	void refreshTextures();
+	void refreshPlaceholderTextures();
 	void clearData();
 	void buildSkyCircle();
 
@@ -248,5 +249,6 @@ private:
 	// Signal connections
 	sigslot::scoped_connection sc_resources_updated_;
 	sigslot::scoped_connection sc_palette_changed_;
+	sigslot::scoped_connection sc_textures_uploaded_;
 };
 } // namespace slade
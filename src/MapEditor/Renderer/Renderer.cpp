@@ -38,6 +38,7 @@
 #include "General/ColourConfiguration.h"
 #include "MapEditor/Edit/LineDraw.h"
 #include "MapEditor/MapEditContext.h"
+#include "MapEditor/MapTextureManager.h"
 #include "OpenGL/Drawing.h"
 #include "OpenGL/OpenGL.h"
 #include "Overlays/MCOverlay.h"
@@ -1228,6 +1229,9 @@ void Renderer::drawMap3d()
 // -----------------------------------------------------------------------------
 void Renderer::draw()
 {
+	// Upload any textures loaded in the background
+	mapeditor::textureManager().processUploads();
+
 	// Setup the viewport
 	glViewport(0, 0, view_.size().x, view_.size().y);
 
@@ -32,12 +32,17 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "MapTextureBrowser.h"
+#include "App.h"
+#include "Archive/Archive.h"
 #include "Game/Configuration.h"
 #include "General/ResourceManager.h"
+#include "Graphics/CTexture/CTexture.h"
 #include "MapEditor/MapEditor.h"
 #include "MapEditor/MapTextureManager.h"
 #include "SLADEMap/SLADEMap.h"
+#include "UI/Browser/ThumbnailCache.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 
 using namespace slade;
 using namespace mapeditor;
@@ -54,6 +59,85 @@ const wxString MapTexBrowserItem::TEXTURE = "texture";
 const wxString MapTexBrowserItem::FLAT    = "flat";
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the thumbnail cache key for texture (or flat if [flat] is true)
+// [name], based on the resource entries it would be built from. Resources are
+// looked up the same way as MapTextureManager::resolveTexture/resolveFlat.
+// Returns an empty string if no matching texture/flat was found, or it can't
+// be cached (see thumbnailcache::sourceId)
+// -----------------------------------------------------------------------------
+string thumbnailKey(string_view name, bool flat, Archive* archive, Palette* pal)
+{
+	ArchiveEntry* entry       = nullptr;
+	ArchiveEntry* scale_entry = nullptr; // Entry a hires image is scaled to match
+	CTexture*     ctex        = nullptr;
+
+	if (flat)
+	{
+		entry = app::resources().getHiresEntry(name, archive);
+		if (entry)
+			scale_entry = app::resources().getFlatEntry(name, archive);
+		else
+			entry = app::resources().getFlatEntry(name, archive);
+	}
+	else
+	{
+		ctex = app::resources().getTexture(name, "WallTexture", archive);
+		if (!ctex)
+			ctex = app::resources().getTexture(name, "", archive);
+		if (!ctex)
+		{
+			entry = app::resources().getHiresEntry(name, archive);
+			if (entry)
+				scale_entry = app::resources().getTextureEntry(name, "textures", archive);
+			else
+				entry = app::resources().getTextureEntry(name, "textures", archive);
+		}
+	}
+
+	// Composite texture, use the definition and all its patch entries
+	if (ctex)
+	{
+		auto sources = ctex->asText();
+		for (const auto& patch : ctex->patches())
+		{
+			auto source = thumbnailcache::sourceId(patch->patchEntry(archive));
+			if (source.empty())
+				return {};
+
+			sources += '\n';
+			sources += source;
+		}
+
+		return thumbnailcache::key(ctex->name(), sources, pal);
+	}
+
+	// Standalone texture/flat entry
+	auto sources = thumbnailcache::sourceId(entry);
+	if (sources.empty())
+		return {};
+	if (scale_entry)
+	{
+		auto scale_source = thumbnailcache::sourceId(scale_entry);
+		if (scale_source.empty())
+			return {};
+
+		sources += '\n';
+		sources += scale_source;
+	}
+
+	return thumbnailcache::key(name, sources, pal);
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // MapTexBrowserItem Class Functions
@@ -72,11 +156,24 @@ MapTexBrowserItem::MapTexBrowserItem(const wxString& name, const wxString& type,
 		blank_ = true;
 }
 
+// -----------------------------------------------------------------------------
+// MapTexBrowserItem class destructor
+// -----------------------------------------------------------------------------
+MapTexBrowserItem::~MapTexBrowserItem()
+{
+	if (owns_image_)
+		gl::Texture::clear(image_tex_);
+}
+
 // -----------------------------------------------------------------------------
 // Loads the item image
 // -----------------------------------------------------------------------------
 bool MapTexBrowserItem::loadImage()
 {
+	// Use a cached thumbnail if possible
+	if (thumbnailcache::enabled())
+		return loadThumbnail();
+
 	const MapTextureManager::Texture* tex = nullptr;
 
 	// Get texture or flat depending on type
@@ -95,6 +192,84 @@ bool MapTexBrowserItem::loadImage()
 		return false;
 }
 
+// -----------------------------------------------------------------------------
+// Loads the item image from the thumbnail cache. If it isn't cached, the full
+// image is decoded in the background and added to the cache, and the thumbnail
+// will be loaded on a later call once it's ready
+// -----------------------------------------------------------------------------
+bool MapTexBrowserItem::loadThumbnail()
+{
+	// Check if the background load has finished
+	if (thumb_load_.valid())
+	{
+		if (thumb_load_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+
+		thumb_load_.get();
+	}
+
+	// Look in the cache
+	else
+	{
+		auto&      manager = mapeditor::textureManager();
+		auto       archive = manager.archive();
+		auto       pal     = manager.resourcePalette();
+		const bool flat    = type_ == FLAT;
+		const auto name    = name_.ToStdString();
+		const auto key     = thumbnailKey(name, flat, archive.get(), pal);
+
+		thumb_ = std::make_shared<thumbnailcache::Thumbnail>();
+		if (key.empty() || !thumbnailcache::get(key, *thumb_))
+		{
+			// Not cached (or can't be), resolve the image from resources here
+			// and decode it in the background
+			auto source = std::make_shared<MapTextureManager::ImageSource>(
+				flat ? MapTextureManager::resolveFlat(name, false, archive.get(), pal) :
+					   MapTextureManager::resolveTexture(name, false, archive.get(), pal));
+			if (source->found)
+			{
+				thumb_load_ = ThreadPool::global().queue(
+					[thumb = thumb_, key, source, pal = manager.decodePalette()]
+					{
+						auto decoded = MapTextureManager::decode(*source, pal.get());
+						if (decoded.image)
+							thumbnailcache::put(key, *decoded.image, decoded.scale, *thumb);
+					});
+
+				return false;
+			}
+		}
+	}
+
+	// Create texture from thumbnail, or use the missing texture if not found
+	clearImage();
+	if (thumb_->image.isValid())
+	{
+		image_tex_  = gl::Texture::createFromImage(thumb_->image, nullptr, gl::TexFilter::Linear);
+		image_size_ = thumb_->size;
+		scale_      = thumb_->scale;
+		owns_image_ = true;
+	}
+	else
+		image_tex_ = gl::Texture::missingTexture();
+	thumb_.reset();
+
+	return image_tex_ != 0;
+}
+
+// -----------------------------------------------------------------------------
+// Clears the item image
+// -----------------------------------------------------------------------------
+void MapTexBrowserItem::clearImage()
+{
+	if (owns_image_)
+		gl::Texture::clear(image_tex_);
+
+	image_tex_  = 0;
+	image_size_ = { 0, 0 };
+	owns_image_ = false;
+}
+
 // -----------------------------------------------------------------------------
 // Returns a string with extra information about the texture/flat
 // -----------------------------------------------------------------------------
@@ -107,9 +282,12 @@ wxString MapTexBrowserItem::itemInfo()
 		return "No Texture";
 
 	// Add dimensions if known
-	auto& tex_info = gl::Texture::info(image_tex_);
 	if (image_tex_ || loadImage())
-		info += wxString::Format("%dx%d", tex_info.size.x, tex_info.size.y);
+	{
+		auto& tex_info = gl::Texture::info(image_tex_);
+		auto  size     = image_size_.x > 0 ? image_size_ : tex_info.size;
+		info += wxString::Format("%dx%d", size.x, size.y);
+	}
 	else
 		info += "Unknown size";
 
@@ -3,11 +3,16 @@
 #include "MapEditor/MapEditor.h"
 #include "MapEditor/MapTextureManager.h"
 #include "UI/Browser/BrowserWindow.h"
+#include <future>
 
 namespace slade
 {
 class SLADEMap;
 class Archive;
+namespace thumbnailcache
+{
+	struct Thumbnail;
+}
 
 class MapTexBrowserItem : public BrowserItem
 {
@@ -16,16 +21,24 @@ public:
 	static const wxString FLAT;
 
 	MapTexBrowserItem(const wxString& name, const wxString& type, unsigned index = 0);
-	~MapTexBrowserItem() = default;
+	~MapTexBrowserItem() override;
 
 	bool     loadImage() override;
 	wxString itemInfo() override;
+	void     clearImage() override;
 	int      usageCount() const { return usage_count_; }
 	void     setUsage(int count) { usage_count_ = count; }
 
 private:
 	int   usage_count_ = 0;
 	Vec2d scale_       = { 1., 1. };
+
+	// Thumbnail (if the thumbnail cache is enabled)
+	bool                                  owns_image_ = false;
+	std::future<void>                     thumb_load_;
+	shared_ptr<thumbnailcache::Thumbnail> thumb_;
+
+	bool loadThumbnail();
 };
 
 class MapTextureBrowser : public BrowserWindow
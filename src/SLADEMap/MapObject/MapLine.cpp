@@ -123,7 +123,7 @@ MapLine::MapLine(MapVertex* v1, MapVertex* v2, MapSide* s1, MapSide* s2, ParseTr
 		else if (prop->nameIsCI(PROP_ARG4))
 			args_[4] = prop->intValue();
 		else
-			properties_[prop->name()] = prop->value();
+			properties_.set(prop->name(), prop->value());
 	}
 }
 
@@ -477,7 +477,11 @@ bool MapLine::scriptCanModifyProp(string_view key)
 void MapLine::setS1(MapSide* side)
 {
 	if (!side)
+	{
 		side1_ = nullptr;
+		if (parent_map_)
+			parent_map_->lines().updateGeometry(this);
+	}
 
 	else if (!side1_ && parent_map_)
 		parent_map_->setLineSide(this, side, true);
@@ -489,7 +493,11 @@ void MapLine::setS1(MapSide* side)
 void MapLine::setS2(MapSide* side)
 {
 	if (!side)
+	{
 		side2_ = nullptr;
+		if (parent_map_)
+			parent_map_->lines().updateGeometry(this);
+	}
 
 	else if (!side2_ && parent_map_)
 		parent_map_->setLineSide(this, side, false);
@@ -838,6 +846,10 @@ void MapLine::resetInternals()
 	length_ = -1;
 	front_vec_.set(0, 0);
 
+	// Update spatial index and geometry arrays
+	if (parent_map_)
+		parent_map_->lines().updateGeometry(this);
+
 	// Reset front sector internals
 	auto s1 = frontSector();
 	if (s1)
@@ -944,6 +956,7 @@ void MapLine::readBackup(Backup* backup)
 		side1_->parent_ = this;
 	if (side2_)
 		side2_->parent_ = this;
+	parent_map_->lines().updateGeometry(this);
 
 	// Flags
 	flags_ = backup->props_internal.get<int>(PROP_FLAGS);
@@ -70,6 +70,11 @@ public:
 	int s1Index() const;
 	int s2Index() const;
 
+	using MapObject::boolProperty;
+	using MapObject::floatProperty;
+	using MapObject::intProperty;
+	using MapObject::stringProperty;
+
 	bool   boolProperty(string_view key) override;
 	int    intProperty(string_view key) override;
 	double floatProperty(string_view key) override;
@@ -134,13 +134,21 @@ void MapObject::copy(MapObject* c)
 // Returns the value of the boolean property matching [key]
 // -----------------------------------------------------------------------------
 bool MapObject::boolProperty(string_view key)
+{
+	return boolProperty(property::key(key));
+}
+
+// -----------------------------------------------------------------------------
+// Returns the value of the boolean property [key]
+// -----------------------------------------------------------------------------
+bool MapObject::boolProperty(property::Key key)
 {
 	// If the property exists already, return it
 	if (auto val = properties_.getIf<bool>(key))
 		return *val;
 
 	// Otherwise check the game configuration for a default value
-	if (auto* prop = game::configuration().getUDMFProperty(string{ key }, type_))
+	if (auto* prop = game::configuration().getUDMFProperty(key, type_))
 		return property::value<bool>(prop->defaultValue(), false);
 
 	return false;
@@ -150,6 +158,14 @@ bool MapObject::boolProperty(string_view key)
 // Returns the value of the integer property matching [key]
 // -----------------------------------------------------------------------------
 int MapObject::intProperty(string_view key)
+{
+	return intProperty(property::key(key));
+}
+
+// -----------------------------------------------------------------------------
+// Returns the value of the integer property [key]
+// -----------------------------------------------------------------------------
+int MapObject::intProperty(property::Key key)
 {
 	// If the property exists already (as int or float), return it
 	if (auto ival = properties_.getIf<int>(key))
@@ -158,7 +174,7 @@ int MapObject::intProperty(string_view key)
 		return std::floor(*fval);
 
 	// Otherwise check the game configuration for a default value
-	if (auto* prop = game::configuration().getUDMFProperty(string{ key }, type_))
+	if (auto* prop = game::configuration().getUDMFProperty(key, type_))
 		return property::value<int>(prop->defaultValue(), 0);
 
 	return 0;
@@ -168,6 +184,14 @@ int MapObject::intProperty(string_view key)
 // Returns the value of the float property matching [key]
 // -----------------------------------------------------------------------------
 double MapObject::floatProperty(string_view key)
+{
+	return floatProperty(property::key(key));
+}
+
+// -----------------------------------------------------------------------------
+// Returns the value of the float property [key]
+// -----------------------------------------------------------------------------
+double MapObject::floatProperty(property::Key key)
 {
 	// If the property exists already (as float or int), return it
 	if (auto fval = properties_.getIf<double>(key))
@@ -176,7 +200,7 @@ double MapObject::floatProperty(string_view key)
 		return *ival;
 
 	// Otherwise check the game configuration for a default value
-	if (auto* prop = game::configuration().getUDMFProperty(string{ key }, type_))
+	if (auto* prop = game::configuration().getUDMFProperty(key, type_))
 		return property::value<double>(prop->defaultValue(), 0.);
 
 	return 0.;
@@ -186,13 +210,21 @@ double MapObject::floatProperty(string_view key)
 // Returns the value of the string property matching [key]
 // -----------------------------------------------------------------------------
 string MapObject::stringProperty(string_view key)
+{
+	return stringProperty(property::key(key));
+}
+
+// -----------------------------------------------------------------------------
+// Returns the value of the string property [key]
+// -----------------------------------------------------------------------------
+string MapObject::stringProperty(property::Key key)
 {
 	// If the property exists already, return it
 	if (auto val = properties_.getIf<string>(key))
 		return *val;
 
 	// Otherwise check the game configuration for a default value
-	if (auto* prop = game::configuration().getUDMFProperty(string{ key }, type_))
+	if (auto* prop = game::configuration().getUDMFProperty(key, type_))
 		return property::value<string>(prop->defaultValue(), {});
 
 	return {};
@@ -207,7 +239,7 @@ void MapObject::setBoolProperty(string_view key, bool value)
 	setModified();
 
 	// Set property
-	properties_[key] = value;
+	properties_.set(key, value);
 }
 
 // -----------------------------------------------------------------------------
@@ -219,7 +251,7 @@ void MapObject::setIntProperty(string_view key, int value)
 	setModified();
 
 	// Set property
-	properties_[key] = value;
+	properties_.set(key, value);
 }
 
 // -----------------------------------------------------------------------------
@@ -231,7 +263,7 @@ void MapObject::setFloatProperty(string_view key, double value)
 	setModified();
 
 	// Set property
-	properties_[key] = value;
+	properties_.set(key, value);
 }
 
 // -----------------------------------------------------------------------------
@@ -243,7 +275,7 @@ void MapObject::setStringProperty(string_view key, string_view value)
 	setModified();
 
 	// Set property
-	properties_[key] = string{ value };
+	properties_.set(key, string{ value });
 }
 
 // -----------------------------------------------------------------------------
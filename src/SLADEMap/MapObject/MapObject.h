@@ -44,10 +44,10 @@ public:
 
 	struct Backup
 	{
-		PropertyList properties;
-		PropertyList props_internal;
-		unsigned     id   = 0;
-		Type         type = Type::Object;
+		KeyedPropertyList properties;
+		PropertyList      props_internal;
+		unsigned          id   = 0;
+		Type              type = Type::Object;
 	};
 
 	typedef std::array<int, 5> ArgSet;
@@ -70,8 +70,9 @@ public:
 	void      setModified();
 	void      setIndex(unsigned index) { index_ = index; }
 
-	PropertyList& props() { return properties_; }
-	bool          hasProp(string_view key) const { return properties_.contains(key); }
+	KeyedPropertyList& props() { return properties_; }
+	bool               hasProp(string_view key) const { return properties_.contains(key); }
+	bool               hasProp(property::Key key) const { return properties_.contains(key); }
 
 	// Generic property modification
 	virtual bool   boolProperty(string_view key);
@@ -84,6 +85,13 @@ public:
 	virtual void   setStringProperty(string_view key, string_view value);
 	virtual bool   scriptCanModifyProp(string_view key) { return true; }
 
+	// Property access by key, for properties kept in the property list (see
+	// property::keys). These skip any properties a MapObject type handles itself
+	bool   boolProperty(property::Key key);
+	int    intProperty(property::Key key);
+	double floatProperty(property::Key key);
+	string stringProperty(property::Key key);
+
 	virtual Vec2d getPoint(Point point) { return { 0, 0 }; }
 
 	void filter(bool f = true) { filtered_ = f; }
@@ -111,7 +119,7 @@ public:
 protected:
 	unsigned           index_      = 0;
 	SLADEMap*          parent_map_ = nullptr;
-	PropertyList       properties_;
+	KeyedPropertyList  properties_;
 	bool               filtered_      = false;
 	long               modified_time_ = 0;
 	unsigned           obj_id_        = 0;
@@ -98,7 +98,7 @@ MapSector::MapSector(string_view f_tex, string_view c_tex, const ParseTreeNode*
 		else if (prop->nameIsCI(PROP_ID))
 			id_ = prop->intValue();
 		else
-			properties_[prop->name()] = prop->value();
+			properties_.set(prop->name(), prop->value());
 	}
 }
 
@@ -375,6 +375,18 @@ void MapSector::updateBBox()
 	setGeometryUpdated();
 }
 
+// -----------------------------------------------------------------------------
+// Resets the sector's bounding box, so it is recalculated when next needed
+// -----------------------------------------------------------------------------
+void MapSector::resetBBox()
+{
+	bbox_.reset();
+
+	// Bounding box changed, so update spatial index
+	if (parent_map_)
+		parent_map_->sectors().updateSpatialIndex(this);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the sector bounding box
 // -----------------------------------------------------------------------------
@@ -576,8 +588,8 @@ uint8_t MapSector::lightAt(int where, int extra_floor_index)
 		if (where == 1)
 		{
 			// Floor
-			int fl = intProperty("lightfloor");
-			if (boolProperty("lightfloorabsolute"))
+			int fl = intProperty(property::keys::LightFloor);
+			if (boolProperty(property::keys::LightFloorAbsolute))
 				l = fl;
 			else
 				l += fl;
@@ -585,8 +597,8 @@ uint8_t MapSector::lightAt(int where, int extra_floor_index)
 		else if (where == 2)
 		{
 			// Ceiling
-			int cl = intProperty("lightceiling");
-			if (boolProperty("lightceilingabsolute"))
+			int cl = intProperty(property::keys::LightCeiling);
+			if (boolProperty(property::keys::LightCeilingAbsolute))
 				l = cl;
 			else
 				l += cl;
@@ -634,12 +646,12 @@ void MapSector::changeLight(int amount, int where)
 	// Change light level by amount
 	if (where == 1 && separate)
 	{
-		int cur = intProperty("lightfloor");
+		int cur = intProperty(property::keys::LightFloor);
 		setIntProperty("lightfloor", cur + amount);
 	}
 	else if (where == 2 && separate)
 	{
-		int cur = intProperty("lightceiling");
+		int cur = intProperty(property::keys::LightCeiling);
 		setIntProperty("lightceiling", cur + amount);
 	}
 	else
@@ -691,7 +703,7 @@ ColRGBA MapSector::colourAt(int where, bool fullbright)
 		wxColour wxcol;
 		if (game::configuration().featureSupported(UDMFFeature::SectorColor))
 		{
-			int intcol = MapObject::intProperty("lightcolor");
+			int intcol = MapObject::intProperty(property::keys::LightColor);
 			wxcol      = wxColour(intcol);
 		}
 		else
@@ -711,8 +723,8 @@ ColRGBA MapSector::colourAt(int where, bool fullbright)
 			if (where == 1)
 			{
 				// Floor
-				int fl = MapObject::intProperty("lightfloor");
-				if (boolProperty("lightfloorabsolute"))
+				int fl = MapObject::intProperty(property::keys::LightFloor);
+				if (boolProperty(property::keys::LightFloorAbsolute))
 					ll = fl;
 				else
 					ll += fl;
@@ -720,8 +732,8 @@ ColRGBA MapSector::colourAt(int where, bool fullbright)
 			else if (where == 2)
 			{
 				// Ceiling
-				int cl = MapObject::intProperty("lightceiling");
-				if (boolProperty("lightceilingabsolute"))
+				int cl = MapObject::intProperty(property::keys::LightCeiling);
+				if (boolProperty(property::keys::LightCeilingAbsolute))
 					ll = cl;
 				else
 					ll += cl;
@@ -779,7 +791,7 @@ ColRGBA MapSector::fogColour()
 	if (parent_map_->currentFormat() == MapFormat::UDMF
 		&& game::configuration().featureSupported(game::UDMFFeature::SectorFog))
 	{
-		int intcol = MapObject::intProperty("fadecolor");
+		int intcol = MapObject::intProperty(property::keys::FadeColor);
 
 		wxColour wxcol(intcol);
 		color = ColRGBA(wxcol.Blue(), wxcol.Green(), wxcol.Red(), 0);
@@ -852,7 +864,7 @@ void MapSector::connectSide(MapSide* side)
 	setModified();
 	connected_sides_.push_back(side);
 	poly_needsupdate_ = true;
-	bbox_.reset();
+	resetBBox();
 	setGeometryUpdated();
 }
 
@@ -872,7 +884,7 @@ void MapSector::disconnectSide(const MapSide* side)
 	}
 
 	poly_needsupdate_ = true;
-	bbox_.reset();
+	resetBBox();
 	setGeometryUpdated();
 }
 
@@ -932,7 +944,7 @@ void MapSector::readBackup(Backup* backup)
 
 	// Update geometry info
 	poly_needsupdate_ = true;
-	bbox_.reset();
+	resetBBox();
 	setGeometryUpdated();
 }
 
@@ -1008,10 +1020,10 @@ void MapSector::writeUDMF(string& def)
 		def += fmt::format("floorplane_c = {};", floor_c);
 		def += fmt::format("floorplane_d = {};", floor_d);
 		// Persist between multiple saves
-		properties_["floorplane_a"] = floor_a;
-		properties_["floorplane_b"] = floor_b;
-		properties_["floorplane_c"] = floor_c;
-		properties_["floorplane_d"] = floor_d;
+		properties_.set("floorplane_a", floor_a);
+		properties_.set("floorplane_b", floor_b);
+		properties_.set("floorplane_c", floor_c);
+		properties_.set("floorplane_d", floor_d);
 	}
 	if (hasCeilingPlane)
 	{
@@ -1020,10 +1032,10 @@ void MapSector::writeUDMF(string& def)
 		def += fmt::format("ceilingplane_c = {};", ceiling_c);
 		def += fmt::format("ceilingplane_d = {};", ceiling_d);
 		// Persist between multiple saves
-		properties_["ceilingplane_a"] = ceiling_a;
-		properties_["ceilingplane_b"] = ceiling_b;
-		properties_["ceilingplane_c"] = ceiling_c;
-		properties_["ceilingplane_d"] = ceiling_d;
+		properties_.set("ceilingplane_a", ceiling_a);
+		properties_.set("ceilingplane_b", ceiling_b);
+		properties_.set("ceilingplane_c", ceiling_c);
+		properties_.set("ceilingplane_d", ceiling_d);
 	}
 
 	def += "}\n\n";
@@ -99,6 +99,9 @@ public:
 	short          tag() const { return id_; }
 	short          id() const { return id_; }
 
+	using MapObject::intProperty;
+	using MapObject::stringProperty;
+
 	string stringProperty(string_view key) override;
 	int    intProperty(string_view key) override;
 
@@ -121,7 +124,7 @@ public:
 	template<SurfaceType p> void  setPlane(const Plane& plane);
 
 	Vec2d             getPoint(Point point) override;
-	void              resetBBox() { bbox_.reset(); }
+	void              resetBBox();
 	BBox              boundingBox();
 	vector<MapSide*>& connectedSides() { return connected_sides_; }
 	void              resetPolygon() { poly_needsupdate_ = true; }
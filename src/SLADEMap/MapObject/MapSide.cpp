@@ -95,7 +95,7 @@ MapSide::MapSide(MapSector* sector, ParseTreeNode* udmf_def) : MapObject{ Type::
 		else if (prop->nameIsCI(PROP_OFFSETY))
 			tex_offset_.y = prop->intValue();
 		else
-			properties_[prop->name()] = prop->value();
+			properties_.set(prop->name(), prop->value());
 		// log::info(1, "Property %s type %s (%s)", prop->getName(), prop->getValue().typeString(),
 		// prop->getValue().getStringValue());
 	}
@@ -257,6 +257,9 @@ void MapSide::setSector(MapSector* sector)
 	// Add side to new sector
 	sector_ = sector;
 	sector->connectSide(this);
+
+	if (parent_map_)
+		parent_map_->sides().updateGeometry(this);
 }
 
 // -----------------------------------------------------------------------------
@@ -378,6 +381,7 @@ void MapSide::readBackup(Backup* backup)
 			sector_->disconnectSide(this);
 		sector_ = nullptr;
 	}
+	parent_map_->sides().updateGeometry(this);
 
 	// Textures
 	setTexUpper(backup->props_internal.get<string>(PROP_TEXUPPER), false);
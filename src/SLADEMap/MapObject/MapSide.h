@@ -53,6 +53,9 @@ public:
 	void setTexOffsetX(int offset);
 	void setTexOffsetY(int offset);
 
+	using MapObject::intProperty;
+	using MapObject::stringProperty;
+
 	int    intProperty(string_view key) override;
 	void   setIntProperty(string_view key, int value) override;
 	string stringProperty(string_view key) override;
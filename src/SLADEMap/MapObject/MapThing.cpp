@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "MapThing.h"
+#include "SLADEMap/SLADEMap.h"
 #include "Utility/Parser.h"
 
 using namespace slade;
@@ -100,7 +101,7 @@ MapThing::MapThing(const Vec3d& pos, short type, ParseTreeNode* def) :
 		else if (prop->name() == PROP_SPECIAL)
 			special_ = prop->intValue();
 		else
-			properties_[prop->name()] = prop->value();
+			properties_.set(prop->name(), prop->value());
 	}
 }
 
@@ -172,15 +173,27 @@ void MapThing::setIntProperty(string_view key, int value)
 	setModified();
 
 	if (key == PROP_TYPE)
+	{
 		type_ = value;
+		updateGeometry();
+	}
 	else if (key == PROP_X)
+	{
 		position_.x = value;
+		updateGeometry();
+	}
 	else if (key == PROP_Y)
+	{
 		position_.y = value;
+		updateGeometry();
+	}
 	else if (key == PROP_Z)
 		z_ = value;
 	else if (key == PROP_ANGLE)
+	{
 		angle_ = value;
+		updateGeometry();
+	}
 	else if (key == PROP_FLAGS)
 		flags_ = value;
 	else if (key == PROP_ARG0)
@@ -210,9 +223,15 @@ void MapThing::setFloatProperty(string_view key, double value)
 	setModified();
 
 	if (key == PROP_X)
+	{
 		position_.x = value;
+		updateGeometry();
+	}
 	else if (key == PROP_Y)
+	{
 		position_.y = value;
+		updateGeometry();
+	}
 	else if (key == PROP_Z)
 		z_ = value;
 	else
@@ -242,6 +261,7 @@ void MapThing::copy(MapObject* c)
 	special_    = thing->special_;
 	for (unsigned i = 0; i < 5; ++i)
 		args_[i] = thing->args_[i];
+	updateGeometry();
 
 	// Other properties
 	MapObject::copy(c);
@@ -256,6 +276,7 @@ void MapThing::move(Vec2d pos, bool modify)
 	if (modify)
 		setModified();
 	position_ = pos;
+	updateGeometry();
 }
 
 // -----------------------------------------------------------------------------
@@ -274,6 +295,7 @@ void MapThing::setType(int type)
 {
 	setModified();
 	type_ = type;
+	updateGeometry();
 }
 
 // -----------------------------------------------------------------------------
@@ -285,6 +307,7 @@ void MapThing::setAngle(int angle, bool modify)
 	if (modify)
 		setModified();
 	angle_ = angle;
+	updateGeometry();
 }
 
 // -----------------------------------------------------------------------------
@@ -322,6 +345,7 @@ void MapThing::setAnglePoint(Vec2d point, bool modify)
 	if (modify)
 		setModified();
 	angle_ = angle;
+	updateGeometry();
 }
 
 // -----------------------------------------------------------------------------
@@ -419,6 +443,8 @@ void MapThing::readBackup(Backup* backup)
 	args_[4]    = backup->props_internal.get<int>(PROP_ARG4);
 	id_         = backup->props_internal.get<int>(PROP_ID);
 	special_    = backup->props_internal.get<int>(PROP_SPECIAL);
+
+	updateGeometry();
 }
 
 // -----------------------------------------------------------------------------
@@ -450,3 +476,13 @@ void MapThing::writeUDMF(string& def)
 
 	def += "}\n\n";
 }
+
+// -----------------------------------------------------------------------------
+// Updates the thing in the parent map's spatial index and geometry arrays,
+// after its position, type or angle has changed
+// -----------------------------------------------------------------------------
+void MapThing::updateGeometry()
+{
+	if (parent_map_)
+		parent_map_->things().updateGeometry(this);
+}
@@ -51,6 +51,9 @@ public:
 
 	Vec2d getPoint(Point point) override;
 
+	using MapObject::floatProperty;
+	using MapObject::intProperty;
+
 	int    intProperty(string_view key) override;
 	double floatProperty(string_view key) override;
 	void   setIntProperty(string_view key, int value) override;
@@ -93,5 +96,7 @@ private:
 	ArgSet args_    = {};
 	int    id_      = 0;
 	int    special_ = 0;
+
+	void updateGeometry();
 };
 } // namespace slade
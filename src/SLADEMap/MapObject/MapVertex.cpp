@@ -64,7 +64,7 @@ MapVertex::MapVertex(const Vec2d& pos, ParseTreeNode* udmf_def) : MapObject(Type
 		if (prop->name() == PROP_X || prop->name() == PROP_Y)
 			continue;
 
-		properties_[prop->name()] = prop->value();
+		properties_.set(prop->name(), prop->value());
 	}
 }
 
@@ -91,6 +91,7 @@ void MapVertex::move(double nx, double ny)
 	for (auto& connected_line : connected_lines_)
 		connected_line->resetInternals();
 
+	updateGeometry();
 	parent_map_->setGeometryUpdated();
 }
 
@@ -133,12 +134,14 @@ void MapVertex::setIntProperty(string_view key, int value)
 		position_.x = value;
 		for (auto& connected_line : connected_lines_)
 			connected_line->resetInternals();
+		updateGeometry();
 	}
 	else if (key == PROP_Y)
 	{
 		position_.y = value;
 		for (auto& connected_line : connected_lines_)
 			connected_line->resetInternals();
+		updateGeometry();
 	}
 	else
 		return MapObject::setIntProperty(key, value);
@@ -158,6 +161,8 @@ void MapVertex::setFloatProperty(string_view key, double value)
 		position_.y = value;
 	else
 		return MapObject::setFloatProperty(key, value);
+
+	updateGeometry();
 }
 
 // -----------------------------------------------------------------------------
@@ -223,6 +228,8 @@ void MapVertex::readBackup(Backup* backup)
 	// Position
 	position_.x = backup->props_internal.get<double>(PROP_X);
 	position_.y = backup->props_internal.get<double>(PROP_Y);
+
+	updateGeometry();
 }
 
 // -----------------------------------------------------------------------------
@@ -241,3 +248,17 @@ void MapVertex::writeUDMF(string& def)
 
 	def += "}\n\n";
 }
+
+// -----------------------------------------------------------------------------
+// Updates the vertex and its connected lines in the parent map's spatial
+// indices and geometry arrays, after the vertex has been moved
+// -----------------------------------------------------------------------------
+void MapVertex::updateGeometry()
+{
+	if (!parent_map_)
+		return;
+
+	parent_map_->vertices().updateGeometry(this);
+	for (auto* line : connected_lines_)
+		parent_map_->lines().updateGeometry(line);
+}
@@ -27,6 +27,9 @@ public:
 
 	void move(double nx, double ny);
 
+	using MapObject::floatProperty;
+	using MapObject::intProperty;
+
 	int    intProperty(string_view key) override;
 	double floatProperty(string_view key) override;
 	void   setIntProperty(string_view key, int value) override;
@@ -61,5 +64,7 @@ private:
 
 	// Internal info
 	vector<MapLine*> connected_lines_;
+
+	void updateGeometry();
 };
 } // namespace slade
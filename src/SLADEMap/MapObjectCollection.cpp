@@ -181,6 +181,11 @@ void MapObjectCollection::restoreObjectIdList(MapObject::Type type, vector<unsig
 			things_.back()->index_ = things_.size() - 1;
 		}
 	}
+
+	// Object indices may have changed, so update the line and side geometry
+	// arrays that refer to them
+	lines_.updateAllGeometry();
+	sides_.updateAllGeometry();
 }
 
 // -----------------------------------------------------------------------------
@@ -207,6 +212,10 @@ void MapObjectCollection::refreshIndices()
 	// Thing indices
 	for (unsigned a = 0; a < things_.size(); a++)
 		things_[a]->index_ = a;
+
+	// Update the line and side geometry arrays that refer to the indices
+	lines_.updateAllGeometry();
+	sides_.updateAllGeometry();
 }
 
 // -----------------------------------------------------------------------------
@@ -300,6 +309,11 @@ bool MapObjectCollection::removeVertex(unsigned index, bool merge_lines)
 	removeMapObject(vertex);
 	vertices_.remove(index);
 
+	// Update lines connected to the vertex that took its index
+	if (index < vertices_.size())
+		for (auto* line : vertices_[index]->connectedLines())
+			lines_.updateGeometry(line);
+
 	if (parent_map_)
 		parent_map_->setGeometryUpdated();
 
@@ -416,6 +430,10 @@ bool MapObjectCollection::removeSide(unsigned index, bool remove_from_line)
 	removeMapObject(sides_[index]);
 	sides_.remove(index);
 
+	// Update the parent line of the side that took its index
+	if (index < sides_.size() && sides_[index]->parentLine())
+		lines_.updateGeometry(sides_[index]->parentLine());
+
 	return true;
 }
 
@@ -444,6 +462,11 @@ bool MapObjectCollection::removeSector(unsigned index)
 	removeMapObject(sectors_[index]);
 	sectors_.remove(index);
 
+	// Update sides of the sector that took its index
+	if (index < sectors_.size())
+		for (auto* side : sectors_[index]->connectedSides())
+			sides_.updateGeometry(side);
+
 	return true;
 }
 
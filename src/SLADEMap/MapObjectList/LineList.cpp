@@ -42,22 +42,22 @@ using namespace slade;
 
 // -----------------------------------------------------------------------------
 //
-// LineList Class Functions
+// Functions
 //
 // -----------------------------------------------------------------------------
-
-
+namespace
+{
 // -----------------------------------------------------------------------------
-// Returns the line closest to the point, or null if none is found.
+// Returns the line in [lines] closest to the point, or null if none is found.
 // Ignores lines further away than [mindist]
 // -----------------------------------------------------------------------------
-MapLine* LineList::nearest(Vec2d point, double min) const
+MapLine* nearestIn(const vector<MapLine*>& lines, Vec2d point, double min)
 {
 	// Go through lines
 	double   dist;
 	double   min_dist = min;
 	MapLine* nearest  = nullptr;
-	for (const auto& line : objects_)
+	for (const auto& line : lines)
 	{
 		// Check with line bounding box first (since we have a minimum distance)
 		auto bbox = line->seg();
@@ -80,32 +80,18 @@ MapLine* LineList::nearest(Vec2d point, double min) const
 }
 
 // -----------------------------------------------------------------------------
-// Returns the first line in the list with vertices [v1] and [v2].
-// If [reverse] is false, only looks for lines with first vertex [v1] and second
-// vertex [v2] (not the other way around)
-// -----------------------------------------------------------------------------
-MapLine* LineList::withVertices(MapVertex* v1, MapVertex* v2, bool reverse) const
-{
-	for (const auto& line : objects_)
-		if (line->v1() == v1 && line->v2() == v2 || reverse && line->v2() == v1 && line->v1() == v2)
-			return line;
-
-	return nullptr;
-}
-
-// -----------------------------------------------------------------------------
-// Returns a list of points where the 'cutting' line [cutter] crosses any
-// existing lines in the list.
+// Returns a list of points where the 'cutting' line [cutter] crosses any of
+// [lines].
 // The point list is sorted along the direction of [cutter]
 // -----------------------------------------------------------------------------
-vector<Vec2d> LineList::cutPoints(const Seg2d& cutter) const
+vector<Vec2d> cutPointsIn(const vector<MapLine*>& lines, const Seg2d& cutter)
 {
 	// Init
 	vector<Vec2d> intersect_points;
 	Vec2d         intersection;
 
 	// Go through map lines
-	for (const auto& line : objects_)
+	for (const auto& line : lines)
 	{
 		// Check for intersection
 		intersection = cutter.start();
@@ -156,6 +142,145 @@ vector<Vec2d> LineList::cutPoints(const Seg2d& cutter) const
 	return intersect_points;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the index of [object], or -1 if it is null
+// -----------------------------------------------------------------------------
+int indexOrNone(const MapObject* object)
+{
+	return object ? static_cast<int>(object->index()) : -1;
+}
+
+// -----------------------------------------------------------------------------
+// Returns all lines in [lines] closer than [dist] to [point]
+// -----------------------------------------------------------------------------
+vector<MapLine*> allNearIn(const vector<MapLine*>& lines, Vec2d point, double dist)
+{
+	vector<MapLine*> near;
+	for (auto* line : lines)
+		if (line->distanceTo(point) < dist)
+			near.push_back(line);
+
+	return near;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// LineList Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Clears the list (and spatial index, geometry arrays)
+// -----------------------------------------------------------------------------
+void LineList::clear()
+{
+	grid_.clear();
+	v1_index_.clear();
+	v2_index_.clear();
+	s1_index_.clear();
+	s2_index_.clear();
+	MapObjectList::clear();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [line] to the list, spatial index and geometry arrays
+// -----------------------------------------------------------------------------
+void LineList::add(MapLine* line)
+{
+	grid_.insert(line, line->seg());
+	v1_index_.push_back(indexOrNone(line->v1()));
+	v2_index_.push_back(indexOrNone(line->v2()));
+	s1_index_.push_back(indexOrNone(line->s1()));
+	s2_index_.push_back(indexOrNone(line->s2()));
+	MapObjectList::add(line);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the line at [index] from the list, spatial index and geometry arrays
+// -----------------------------------------------------------------------------
+void LineList::remove(unsigned index)
+{
+	if (index >= count_)
+		return;
+
+	grid_.remove(objects_[index]);
+	removeValue(v1_index_, index);
+	removeValue(v2_index_, index);
+	removeValue(s1_index_, index);
+	removeValue(s2_index_, index);
+	MapObjectList::remove(index);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the last line from the list, spatial index and geometry arrays
+// -----------------------------------------------------------------------------
+void LineList::removeLast()
+{
+	grid_.remove(objects_.back());
+	v1_index_.pop_back();
+	v2_index_.pop_back();
+	s1_index_.pop_back();
+	s2_index_.pop_back();
+	MapObjectList::removeLast();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the line closest to the point, or null if none is found.
+// Ignores lines further away than [mindist]
+// -----------------------------------------------------------------------------
+MapLine* LineList::nearest(Vec2d point, double min) const
+{
+	vector<MapLine*> candidates;
+	grid_.nearestCandidates(point, min, [point](MapLine* line) { return line->distanceTo(point); }, candidates);
+
+	return nearestIn(candidates, point, min);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the first line in the list with vertices [v1] and [v2].
+// If [reverse] is false, only looks for lines with first vertex [v1] and second
+// vertex [v2] (not the other way around)
+// -----------------------------------------------------------------------------
+MapLine* LineList::withVertices(MapVertex* v1, MapVertex* v2, bool reverse) const
+{
+	for (const auto& line : objects_)
+		if (line->v1() == v1 && line->v2() == v2 || reverse && line->v2() == v1 && line->v1() == v2)
+			return line;
+
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Returns a list of points where the 'cutting' line [cutter] crosses any
+// existing lines in the list.
+// The point list is sorted along the direction of [cutter]
+// -----------------------------------------------------------------------------
+vector<Vec2d> LineList::cutPoints(const Seg2d& cutter) const
+{
+	vector<MapLine*> candidates;
+	MapObjectGrid<MapLine>::sortedCandidates([&](auto&& func) { grid_.forEachAlong(cutter, func); }, candidates);
+
+	return cutPointsIn(candidates, cutter);
+}
+
+// -----------------------------------------------------------------------------
+// Returns all lines closer than [dist] to [point], in index order
+// -----------------------------------------------------------------------------
+vector<MapLine*> LineList::allNear(Vec2d point, double dist) const
+{
+	BBox box;
+	box.min.set(point.x - dist, point.y - dist);
+	box.max.set(point.x + dist, point.y + dist);
+
+	vector<MapLine*> candidates;
+	MapObjectGrid<MapLine>::sortedCandidates([&](auto&& func) { grid_.forEachInBox(box, func); }, candidates);
+
+	return allNearIn(candidates, point, dist);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the first line found with [id], or null if none found
 // -----------------------------------------------------------------------------
@@ -336,3 +461,54 @@ int LineList::firstFreeId(MapFormat format) const
 
 	return id;
 }
+
+// -----------------------------------------------------------------------------
+// Updates [line] in the spatial index and geometry arrays, if it is in this
+// list
+// -----------------------------------------------------------------------------
+void LineList::updateGeometry(MapLine* line) const
+{
+	if (!isListed(line))
+		return;
+
+	const auto index = line->index();
+	grid_.update(line, line->seg());
+	v1_index_[index] = indexOrNone(line->v1());
+	v2_index_[index] = indexOrNone(line->v2());
+	s1_index_[index] = indexOrNone(line->s1());
+	s2_index_[index] = indexOrNone(line->s2());
+}
+
+// -----------------------------------------------------------------------------
+// Updates the geometry arrays for all lines (eg. after vertex or side indices
+// have changed)
+// -----------------------------------------------------------------------------
+void LineList::updateAllGeometry() const
+{
+	for (auto* line : objects_)
+		updateGeometry(line);
+}
+
+// -----------------------------------------------------------------------------
+// Same as nearest, but checks every line in the list
+// -----------------------------------------------------------------------------
+MapLine* LineList::nearestLinear(Vec2d point, double min) const
+{
+	return nearestIn(objects_, point, min);
+}
+
+// -----------------------------------------------------------------------------
+// Same as cutPoints, but checks every line in the list
+// -----------------------------------------------------------------------------
+vector<Vec2d> LineList::cutPointsLinear(const Seg2d& cutter) const
+{
+	return cutPointsIn(objects_, cutter);
+}
+
+// -----------------------------------------------------------------------------
+// Same as allNear, but checks every line in the list
+// -----------------------------------------------------------------------------
+vector<MapLine*> LineList::allNearLinear(Vec2d point, double dist) const
+{
+	return allNearIn(objects_, point, dist);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "General/Defs.h"
+#include "MapObjectGrid.h"
 #include "MapObjectList.h"
 #include "SLADEMap/MapObject/MapLine.h"
 
@@ -9,13 +10,42 @@ namespace slade
 class LineList : public MapObjectList<MapLine>
 {
 public:
+	// MapObjectList overrides
+	void clear() override;
+	void add(MapLine* line) override;
+	void remove(unsigned index) override;
+	void removeLast() override;
+
 	MapLine*         nearest(Vec2d point, double min = 64) const;
 	MapLine*         withVertices(MapVertex* v1, MapVertex* v2, bool reverse = true) const;
 	vector<Vec2d>    cutPoints(const Seg2d& cutter) const;
+	vector<MapLine*> allNear(Vec2d point, double dist) const;
 	MapLine*         firstWithId(int id) const;
 	void             putAllWithId(int id, vector<MapLine*>& list) const;
 	vector<MapLine*> allWithId(int id) const;
 	void             putAllTaggingWithId(int id, int type, vector<MapLine*>& list) const;
 	int              firstFreeId(MapFormat format) const;
+
+	// Line vertex and side indices (-1 for no side) in index order, for fast
+	// read-only passes over all lines
+	const vector<int>& v1Indices() const { return v1_index_; }
+	const vector<int>& v2Indices() const { return v2_index_; }
+	const vector<int>& s1Indices() const { return s1_index_; }
+	const vector<int>& s2Indices() const { return s2_index_; }
+
+	void updateGeometry(MapLine* line) const;
+	void updateAllGeometry() const;
+
+	// Brute-force versions of the above queries (for checking the grid)
+	MapLine*         nearestLinear(Vec2d point, double min = 64) const;
+	vector<Vec2d>    cutPointsLinear(const Seg2d& cutter) const;
+	vector<MapLine*> allNearLinear(Vec2d point, double dist) const;
+
+private:
+	mutable MapObjectGrid<MapLine> grid_;
+	mutable vector<int>            v1_index_;
+	mutable vector<int>            v2_index_;
+	mutable vector<int>            s1_index_;
+	mutable vector<int>            s2_index_;
 };
 } // namespace slade
@@ -0,0 +1,273 @@
+#pragma once
+
+namespace slade
+{
+// Uniform grid spatial index of map objects, used by the object lists to avoid
+// going through every object for position-based queries. Each object is stored
+// in every cell its segment (a point for vertices/things) touches, and must be
+// updated via update() whenever that segment changes.
+// Queries return candidates only - they may include objects that don't match
+// (and the same object more than once), so results need to be checked exactly
+template<class T> class MapObjectGrid
+{
+public:
+	static constexpr double CELL_SIZE = 128.;
+
+	// If [box_cells] is true, objects are stored in every cell overlapping the
+	// bounding box of their segment rather than just the cells along it
+	explicit MapObjectGrid(bool box_cells = false) : box_cells_{ box_cells } {}
+
+	unsigned size() const { return entries_.size(); }
+
+	void clear()
+	{
+		cells_.clear();
+		entries_.clear();
+		bounds_ = CellRange{};
+	}
+
+	void insert(T* object, const Seg2d& seg)
+	{
+		if (entries_.count(object))
+			return update(object, seg);
+
+		entries_[object] = seg;
+		forEachCell(seg, [&](int cx, int cy) { addToCell(cx, cy, object); });
+	}
+
+	void remove(T* object)
+	{
+		auto i = entries_.find(object);
+		if (i == entries_.end())
+			return;
+
+		forEachCell(i->second, [&](int cx, int cy) { removeFromCell(cx, cy, object); });
+		entries_.erase(i);
+	}
+
+	// Moves [object] to [seg] if it is in the grid, does nothing otherwise
+	void update(T* object, const Seg2d& seg)
+	{
+		auto i = entries_.find(object);
+		if (i == entries_.end() || (i->second.tl == seg.tl && i->second.br == seg.br))
+			return;
+
+		vector<CellPos> old_cells, new_cells;
+		forEachCell(i->second, [&](int cx, int cy) { old_cells.push_back({ cx, cy }); });
+		forEachCell(seg, [&](int cx, int cy) { new_cells.push_back({ cx, cy }); });
+		i->second = seg;
+		if (old_cells == new_cells)
+			return;
+
+		for (const auto& cell : old_cells)
+			removeFromCell(cell.x, cell.y, object);
+		for (const auto& cell : new_cells)
+			addToCell(cell.x, cell.y, object);
+	}
+
+	// Calls [func] for all objects in cells overlapping [box].
+	// Returns true if every object in the grid was checked
+	template<class F> bool forEachInBox(const BBox& box, F&& func) const
+	{
+		const CellRange range{ cellCoord(box.min.x), cellCoord(box.min.y), cellCoord(box.max.x), cellCoord(box.max.y) };
+		const bool      all = range.x1 <= bounds_.x1 && range.y1 <= bounds_.y1 && range.x2 >= bounds_.x2
+						 && range.y2 >= bounds_.y2;
+
+		// Go through all cells if the box covers more cells than are in use
+		const auto n_cells = (static_cast<int64_t>(range.x2) - range.x1 + 1)
+							 * (static_cast<int64_t>(range.y2) - range.y1 + 1);
+		if (all || n_cells > static_cast<int64_t>(cells_.size()))
+		{
+			for (const auto& cell : cells_)
+				for (auto* object : cell.second)
+					func(object);
+
+			return true;
+		}
+
+		for (int cx = range.x1; cx <= range.x2; ++cx)
+			for (int cy = range.y1; cy <= range.y2; ++cy)
+				forEachInCell(cx, cy, func);
+
+		return false;
+	}
+
+	// Calls [func] for all objects in cells touched by [seg]
+	template<class F> void forEachAlong(const Seg2d& seg, F&& func) const
+	{
+		vector<CellPos> cells;
+		forEachCell(seg, [&cells](int cx, int cy) { cells.push_back({ cx, cy }); });
+
+		if (cells.size() > cells_.size())
+		{
+			for (const auto& cell : cells_)
+				for (auto* object : cell.second)
+					func(object);
+		}
+		else
+		{
+			for (const auto& cell : cells)
+				forEachInCell(cell.x, cell.y, func);
+		}
+	}
+
+	// Adds candidates for the nearest objects to [point] to [list], in index
+	// order with no duplicates. [distance] gives the distance of an object from
+	// [point], and must never be less than the larger of the x/y distances
+	// from [point] to the nearest part of the object.
+	// The list will contain all objects at the minimum distance from [point],
+	// as long as that distance is no more than [max_dist]
+	template<class F> void nearestCandidates(Vec2d point, double max_dist, F&& distance, vector<T*>& list) const
+	{
+		if (entries_.empty())
+			return;
+		max_dist = std::max(max_dist, 0.);
+
+		// Search increasingly large areas around the point until the nearest
+		// object found is within the searched area
+		for (double radius = CELL_SIZE;; radius *= 2)
+		{
+			radius = std::min(radius, max_dist);
+			list.clear();
+
+			BBox box;
+			box.min.set(point.x - radius, point.y - radius);
+			box.max.set(point.x + radius, point.y + radius);
+			const bool all = forEachInBox(box, [&list](T* object) { list.push_back(object); });
+
+			double min_dist = std::numeric_limits<double>::max();
+			for (auto* object : list)
+				min_dist = std::min(min_dist, distance(object));
+
+			if (all || min_dist <= radius || radius >= max_dist)
+				break;
+		}
+
+		std::sort(list.begin(), list.end(), [](T* left, T* right) { return left->index() < right->index(); });
+		list.erase(std::unique(list.begin(), list.end()), list.end());
+	}
+
+	// Adds candidates in index order with no duplicates, found via [query]
+	// (one of the forEach functions) to [list]
+	template<class Q> static void sortedCandidates(Q&& query, vector<T*>& list)
+	{
+		query([&list](T* object) { list.push_back(object); });
+		std::sort(list.begin(), list.end(), [](T* left, T* right) { return left->index() < right->index(); });
+		list.erase(std::unique(list.begin(), list.end()), list.end());
+	}
+
+private:
+	struct CellPos
+	{
+		int  x, y;
+		bool operator==(const CellPos& other) const { return x == other.x && y == other.y; }
+	};
+	struct CellRange
+	{
+		int x1 = std::numeric_limits<int>::max();
+		int y1 = std::numeric_limits<int>::max();
+		int x2 = std::numeric_limits<int>::min();
+		int y2 = std::numeric_limits<int>::min();
+	};
+
+	std::unordered_map<uint64_t, vector<T*>> cells_;
+	std::unordered_map<T*, Seg2d>            entries_;
+	CellRange                                bounds_; // All cells ever used
+	bool                                     box_cells_ = false;
+
+	static constexpr double EPSILON = 0.01; // Margin for segment cell coverage, to allow for rounding errors
+
+	static int cellCoord(double pos)
+	{
+		const double cell = std::floor(pos / CELL_SIZE);
+		if (!(cell > -1e9)) // Also catches NaN
+			return -1000000000;
+		return cell < 1e9 ? static_cast<int>(cell) : 1000000000;
+	}
+
+	static uint64_t cellKey(int cx, int cy)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+	}
+
+	// Calls [func] with the coordinates of each cell touched by [seg]
+	template<class F> void forEachCell(const Seg2d& seg, F&& func) const
+	{
+		// Points are in a single cell
+		if (seg.start() == seg.end())
+		{
+			func(cellCoord(seg.start().x), cellCoord(seg.start().y));
+			return;
+		}
+
+		const double min_x = std::min(seg.start().x, seg.end().x);
+		const double max_x = std::max(seg.start().x, seg.end().x);
+		const int    cx1   = cellCoord(min_x - EPSILON);
+		const int    cx2   = cellCoord(max_x + EPSILON);
+
+		// Boxes, vertical segments (or any within a single column of cells)
+		if (box_cells_ || cx1 == cx2 || seg.start().x == seg.end().x)
+		{
+			const int cy1 = cellCoord(std::min(seg.start().y, seg.end().y) - EPSILON);
+			const int cy2 = cellCoord(std::max(seg.start().y, seg.end().y) + EPSILON);
+			for (int cx = cx1; cx <= cx2; ++cx)
+				for (int cy = cy1; cy <= cy2; ++cy)
+					func(cx, cy);
+			return;
+		}
+
+		// Otherwise go through each column, finding the range of cells the
+		// segment covers within it
+		const double slope = (seg.end().y - seg.start().y) / (seg.end().x - seg.start().x);
+		for (int cx = cx1; cx <= cx2; ++cx)
+		{
+			const double x1  = std::max(min_x, cx * CELL_SIZE - EPSILON);
+			const double x2  = std::min(max_x, (cx + 1) * CELL_SIZE + EPSILON);
+			const double y1  = seg.start().y + (x1 - seg.start().x) * slope;
+			const double y2  = seg.start().y + (x2 - seg.start().x) * slope;
+			const int    cy1 = cellCoord(std::min(y1, y2) - EPSILON);
+			const int    cy2 = cellCoord(std::max(y1, y2) + EPSILON);
+			for (int cy = cy1; cy <= cy2; ++cy)
+				func(cx, cy);
+		}
+	}
+
+	template<class F> void forEachInCell(int cx, int cy, F& func) const
+	{
+		auto i = cells_.find(cellKey(cx, cy));
+		if (i != cells_.end())
+			for (auto* object : i->second)
+				func(object);
+	}
+
+	void addToCell(int cx, int cy, T* object)
+	{
+		cells_[cellKey(cx, cy)].push_back(object);
+		bounds_.x1 = std::min(bounds_.x1, cx);
+		bounds_.y1 = std::min(bounds_.y1, cy);
+		bounds_.x2 = std::max(bounds_.x2, cx);
+		bounds_.y2 = std::max(bounds_.y2, cy);
+	}
+
+	void removeFromCell(int cx, int cy, T* object)
+	{
+		auto i = cells_.find(cellKey(cx, cy));
+		if (i == cells_.end())
+			return;
+
+		auto& objects = i->second;
+		for (unsigned a = 0; a < objects.size(); ++a)
+		{
+			if (objects[a] == object)
+			{
+				objects[a] = objects.back();
+				objects.pop_back();
+				break;
+			}
+		}
+
+		if (objects.empty())
+			cells_.erase(i);
+	}
+};
+} // namespace slade
@@ -76,5 +76,16 @@ public:
 protected:
 	vector<T*> objects_;
 	unsigned   count_ = 0;
+
+	// Returns true if [object] is in the list
+	bool isListed(const T* object) const { return object->index() < count_ && objects_[object->index()] == object; }
+
+	// Removes the value at [index] from [values] the same way remove() does for
+	// objects (for keeping arrays of per-object values in sync with the list)
+	template<class V> static void removeValue(vector<V>& values, unsigned index)
+	{
+		values[index] = values.back();
+		values.pop_back();
+	}
 };
 } // namespace slade
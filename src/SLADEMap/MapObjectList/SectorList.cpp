@@ -47,11 +47,13 @@ using namespace slade;
 
 
 // -----------------------------------------------------------------------------
-// Clears the list (and texture usage)
+// Clears the list (and texture usage, spatial index)
 // -----------------------------------------------------------------------------
 void SectorList::clear()
 {
 	usage_tex_.clear();
+	grid_.clear();
+	bbox_changed_.clear();
 	MapObjectList::clear();
 }
 
@@ -64,6 +66,9 @@ void SectorList::add(MapSector* sector)
 	usage_tex_[strutil::upper(sector->floor().texture)] += 1;
 	usage_tex_[strutil::upper(sector->ceiling().texture)] += 1;
 
+	// Add to spatial index on next query (it likely has no sides yet)
+	bbox_changed_.insert(sector);
+
 	MapObjectList::add(sector);
 }
 
@@ -79,16 +84,40 @@ void SectorList::remove(unsigned index)
 	usage_tex_[strutil::upper(objects_[index]->floor().texture)] -= 1;
 	usage_tex_[strutil::upper(objects_[index]->ceiling().texture)] -= 1;
 
+	// Remove from spatial index
+	grid_.remove(objects_[index]);
+	bbox_changed_.erase(objects_[index]);
+
 	MapObjectList::remove(index);
 }
 
+// -----------------------------------------------------------------------------
+// Removes the last sector from the list and spatial index
+// -----------------------------------------------------------------------------
+void SectorList::removeLast()
+{
+	grid_.remove(objects_.back());
+	bbox_changed_.erase(objects_.back());
+	MapObjectList::removeLast();
+}
+
 // -----------------------------------------------------------------------------
 // Returns the sector at the given [point], or null if not within a sector
 // -----------------------------------------------------------------------------
 MapSector* SectorList::atPos(Vec2d point) const
 {
+	updateGrid();
+
+	// Get sectors with bounding boxes around the point
+	BBox box;
+	box.min = point;
+	box.max = point;
+	vector<MapSector*> candidates;
+	MapObjectGrid<MapSector>::sortedCandidates(
+		[&](auto&& func) { grid_.forEachInBox(box, func); }, candidates);
+
 	// Go through sectors
-	for (const auto& sector : objects_)
+	for (const auto& sector : candidates)
 	{
 		// Check if point is within sector
 		if (sector->containsPoint(point))
@@ -218,3 +247,49 @@ int SectorList::texUsageCount(string_view tex) const
 {
 	return usage_tex_[strutil::upper(tex)];
 }
+
+// -----------------------------------------------------------------------------
+// Flags the bounding box of [sector] as changed, so it is updated in the
+// spatial index before the next query (if it is in this list)
+// -----------------------------------------------------------------------------
+void SectorList::updateSpatialIndex(MapSector* sector) const
+{
+	if (isListed(sector))
+		bbox_changed_.insert(sector);
+}
+
+// -----------------------------------------------------------------------------
+// Same as atPos, but checks every sector in the list
+// -----------------------------------------------------------------------------
+MapSector* SectorList::atPosLinear(Vec2d point) const
+{
+	for (const auto& sector : objects_)
+		if (sector->containsPoint(point))
+			return sector;
+
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the spatial index entries of all sectors with changed bounding boxes
+// -----------------------------------------------------------------------------
+void SectorList::updateGrid() const
+{
+	if (bbox_changed_.empty())
+		return;
+
+	vector<MapSector*> degenerate;
+	for (auto* sector : bbox_changed_)
+	{
+		auto bbox = sector->boundingBox();
+		grid_.insert(sector, { bbox.min, bbox.max });
+
+		// Sectors with an empty/zero-size bbox recalculate it every time it is
+		// requested, so it can change without being flagged
+		if (!bbox.isValid())
+			degenerate.push_back(sector);
+	}
+
+	bbox_changed_.clear();
+	bbox_changed_.insert(degenerate.begin(), degenerate.end());
+}
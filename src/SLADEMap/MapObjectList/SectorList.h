@@ -1,7 +1,9 @@
 #pragma once
 
+#include "MapObjectGrid.h"
 #include "MapObjectList.h"
 #include "SLADEMap/MapObject/MapSector.h"
+#include <unordered_set>
 
 namespace slade
 {
@@ -12,6 +14,7 @@ public:
 	void clear() override;
 	void add(MapSector* sector) override;
 	void remove(unsigned index) override;
+	void removeLast() override;
 
 	MapSector*         atPos(Vec2d point) const;
 	BBox               allSectorBounds() const;
@@ -26,7 +29,19 @@ public:
 	void updateTexUsage(string_view tex, int adjust) const;
 	int  texUsageCount(string_view tex) const;
 
+	void updateSpatialIndex(MapSector* sector) const;
+
+	// Brute-force version of atPos (for checking the grid)
+	MapSector* atPosLinear(Vec2d point) const;
+
 private:
 	mutable std::map<string, int> usage_tex_;
+
+	// Grid of sector bounding boxes, entries for sectors in bbox_changed_ are
+	// updated before the next query
+	mutable MapObjectGrid<MapSector>       grid_{ true };
+	mutable std::unordered_set<MapSector*> bbox_changed_;
+
+	void updateGrid() const;
 };
 } // namespace slade
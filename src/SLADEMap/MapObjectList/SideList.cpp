@@ -33,6 +33,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "SideList.h"
+#include "SLADEMap/MapObject/MapSector.h"
 #include "Utility/StringUtils.h"
 
 using namespace slade;
@@ -46,11 +47,12 @@ using namespace slade;
 
 
 // -----------------------------------------------------------------------------
-// Clears the list (and texture usage)
+// Clears the list (and texture usage, geometry arrays)
 // -----------------------------------------------------------------------------
 void SideList::clear()
 {
 	usage_tex_.clear();
+	sector_index_.clear();
 	MapObjectList::clear();
 }
 
@@ -64,6 +66,8 @@ void SideList::add(MapSide* side)
 	usage_tex_[strutil::upper(side->tex_middle_)] += 1;
 	usage_tex_[strutil::upper(side->tex_lower_)] += 1;
 
+	sector_index_.push_back(side->sector() ? static_cast<int>(side->sector()->index()) : -1);
+
 	MapObjectList::add(side);
 }
 
@@ -80,9 +84,20 @@ void SideList::remove(unsigned index)
 	usage_tex_[strutil::upper(objects_[index]->tex_middle_)] -= 1;
 	usage_tex_[strutil::upper(objects_[index]->tex_lower_)] -= 1;
 
+	removeValue(sector_index_, index);
+
 	MapObjectList::remove(index);
 }
 
+// -----------------------------------------------------------------------------
+// Removes the last side from the list and geometry arrays
+// -----------------------------------------------------------------------------
+void SideList::removeLast()
+{
+	sector_index_.pop_back();
+	MapObjectList::removeLast();
+}
+
 // -----------------------------------------------------------------------------
 // Adjusts the usage count of [tex] by [adjust]
 // -----------------------------------------------------------------------------
@@ -98,3 +113,23 @@ int SideList::texUsageCount(string_view tex) const
 {
 	return usage_tex_[strutil::upper(tex)];
 }
+
+// -----------------------------------------------------------------------------
+// Updates the sector index of [side] in the geometry arrays, if it is in this
+// list
+// -----------------------------------------------------------------------------
+void SideList::updateGeometry(MapSide* side) const
+{
+	if (isListed(side))
+		sector_index_[side->index()] = side->sector() ? static_cast<int>(side->sector()->index()) : -1;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the geometry arrays for all sides (eg. after sector indices have
+// changed)
+// -----------------------------------------------------------------------------
+void SideList::updateAllGeometry() const
+{
+	for (auto* side : objects_)
+		updateGeometry(side);
+}
@@ -12,12 +12,21 @@ public:
 	void clear() override;
 	void add(MapSide* side) override;
 	void remove(unsigned index) override;
+	void removeLast() override;
 
 	void clearTexUsage() const { usage_tex_.clear(); }
 	void updateTexUsage(string_view tex, int adjust) const;
 	int  texUsageCount(string_view tex) const;
 
+	// Side sector indices (-1 for no sector) in index order, for fast read-only
+	// passes over all sides
+	const vector<int>& sectorIndices() const { return sector_index_; }
+
+	void updateGeometry(MapSide* side) const;
+	void updateAllGeometry() const;
+
 private:
 	mutable std::map<string, int> usage_tex_;
+	mutable vector<int>           sector_index_;
 };
 } // namespace slade
@@ -42,22 +42,22 @@ using namespace slade;
 
 // -----------------------------------------------------------------------------
 //
-// ThingList Class Functions
+// Functions
 //
 // -----------------------------------------------------------------------------
-
-
+namespace
+{
 // -----------------------------------------------------------------------------
-// Returns the thing closest to the point, or null if none found.
+// Returns the thing in [things] closest to the point, or null if none found.
 // Igonres any thing further away than [min]
 // -----------------------------------------------------------------------------
-MapThing* ThingList::nearest(Vec2d point, double min) const
+MapThing* nearestIn(const vector<MapThing*>& things, Vec2d point, double min)
 {
 	// Go through things
 	double    dist;
 	double    min_dist = 999999999;
 	MapThing* nearest  = nullptr;
-	for (const auto& thing : objects_)
+	for (const auto& thing : things)
 	{
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicabDistanceTo(thing->position());
@@ -83,17 +83,17 @@ MapThing* ThingList::nearest(Vec2d point, double min) const
 }
 
 // -----------------------------------------------------------------------------
-// Same as 'nearest', but returns a list of things for the case where there are
+// Same as nearestIn, but returns a list of things for the case where there are
 // multiple things at the same point
 // -----------------------------------------------------------------------------
-vector<MapThing*> ThingList::multiNearest(Vec2d point) const
+vector<MapThing*> multiNearestIn(const vector<MapThing*>& things, Vec2d point)
 {
 	vector<MapThing*> ret;
 
 	// Go through things
 	double min_dist = 999999999;
 	double dist     = 0;
-	for (const auto& thing : objects_)
+	for (const auto& thing : things)
 	{
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicabDistanceTo(thing->position());
@@ -111,6 +111,101 @@ vector<MapThing*> ThingList::multiNearest(Vec2d point) const
 
 	return ret;
 }
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// ThingList Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Clears the list (and spatial index, geometry arrays)
+// -----------------------------------------------------------------------------
+void ThingList::clear()
+{
+	grid_.clear();
+	pos_x_.clear();
+	pos_y_.clear();
+	types_.clear();
+	angles_.clear();
+	MapObjectList::clear();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [thing] to the list, spatial index and geometry arrays
+// -----------------------------------------------------------------------------
+void ThingList::add(MapThing* thing)
+{
+	grid_.insert(thing, { thing->position(), thing->position() });
+	pos_x_.push_back(thing->xPos());
+	pos_y_.push_back(thing->yPos());
+	types_.push_back(thing->type());
+	angles_.push_back(thing->angle());
+	MapObjectList::add(thing);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the thing at [index] from the list, spatial index and geometry
+// arrays
+// -----------------------------------------------------------------------------
+void ThingList::remove(unsigned index)
+{
+	if (index >= count_)
+		return;
+
+	grid_.remove(objects_[index]);
+	removeValue(pos_x_, index);
+	removeValue(pos_y_, index);
+	removeValue(types_, index);
+	removeValue(angles_, index);
+	MapObjectList::remove(index);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the last thing from the list, spatial index and geometry arrays
+// -----------------------------------------------------------------------------
+void ThingList::removeLast()
+{
+	grid_.remove(objects_.back());
+	pos_x_.pop_back();
+	pos_y_.pop_back();
+	types_.pop_back();
+	angles_.pop_back();
+	MapObjectList::removeLast();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the thing closest to the point, or null if none found.
+// Igonres any thing further away than [min]
+// -----------------------------------------------------------------------------
+MapThing* ThingList::nearest(Vec2d point, double min) const
+{
+	// Any thing within [min] has a taxicab distance of no more than ~1.41x [min]
+	vector<MapThing*> candidates;
+	grid_.nearestCandidates(
+		point, min * 1.5, [point](MapThing* thing) { return point.taxicabDistanceTo(thing->position()); }, candidates);
+
+	return nearestIn(candidates, point, min);
+}
+
+// -----------------------------------------------------------------------------
+// Same as 'nearest', but returns a list of things for the case where there are
+// multiple things at the same point
+// -----------------------------------------------------------------------------
+vector<MapThing*> ThingList::multiNearest(Vec2d point) const
+{
+	vector<MapThing*> candidates;
+	grid_.nearestCandidates(
+		point,
+		std::numeric_limits<double>::max(),
+		[point](MapThing* thing) { return point.taxicabDistanceTo(thing->position()); },
+		candidates);
+
+	return multiNearestIn(candidates, point);
+}
 
 // -----------------------------------------------------------------------------
 // Returns a bounding box for all things's positions
@@ -121,8 +216,8 @@ BBox ThingList::allThingBounds() const
 		return {};
 
 	BBox bbox;
-	for (const auto& thing : objects_)
-		bbox.extend(thing->position());
+	for (unsigned i = 0; i < count_; ++i)
+		bbox.extend(pos_x_[i], pos_y_[i]);
 
 	return bbox;
 }
@@ -313,3 +408,35 @@ int ThingList::firstFreeId() const
 
 	return id;
 }
+
+// -----------------------------------------------------------------------------
+// Updates [thing] in the spatial index and geometry arrays, if it is in this
+// list
+// -----------------------------------------------------------------------------
+void ThingList::updateGeometry(MapThing* thing) const
+{
+	if (!isListed(thing))
+		return;
+
+	grid_.update(thing, { thing->position(), thing->position() });
+	pos_x_[thing->index()]  = thing->xPos();
+	pos_y_[thing->index()]  = thing->yPos();
+	types_[thing->index()]  = thing->type();
+	angles_[thing->index()] = thing->angle();
+}
+
+// -----------------------------------------------------------------------------
+// Same as nearest, but checks every thing in the list
+// -----------------------------------------------------------------------------
+MapThing* ThingList::nearestLinear(Vec2d point, double min) const
+{
+	return nearestIn(objects_, point, min);
+}
+
+// -----------------------------------------------------------------------------
+// Same as multiNearest, but checks every thing in the list
+// -----------------------------------------------------------------------------
+vector<MapThing*> ThingList::multiNearestLinear(Vec2d point) const
+{
+	return multiNearestIn(objects_, point);
+}
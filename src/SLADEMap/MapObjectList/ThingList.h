@@ -1,5 +1,6 @@
 #pragma once
 
+#include "MapObjectGrid.h"
 #include "MapObjectList.h"
 #include "SLADEMap/MapObject/MapThing.h"
 
@@ -8,6 +9,12 @@ namespace slade
 class ThingList : public MapObjectList<MapThing>
 {
 public:
+	// MapObjectList overrides
+	void clear() override;
+	void add(MapThing* thing) override;
+	void remove(unsigned index) override;
+	void removeLast() override;
+
 	MapThing*         nearest(Vec2d point, double min = 64) const;
 	vector<MapThing*> multiNearest(Vec2d point) const;
 	BBox              allThingBounds() const;
@@ -17,5 +24,25 @@ public:
 	void              putAllPathed(vector<MapThing*>& list) const;
 	void              putAllTaggingWithId(int id, int type, vector<MapThing*>& list, int ttype) const;
 	int               firstFreeId() const;
+
+	// Thing positions, types and angles in index order, for fast read-only
+	// passes over all things
+	const vector<double>& xPositions() const { return pos_x_; }
+	const vector<double>& yPositions() const { return pos_y_; }
+	const vector<int>&    types() const { return types_; }
+	const vector<int>&    angles() const { return angles_; }
+
+	void updateGeometry(MapThing* thing) const;
+
+	// Brute-force versions of the above queries (for checking the grid)
+	MapThing*         nearestLinear(Vec2d point, double min = 64) const;
+	vector<MapThing*> multiNearestLinear(Vec2d point) const;
+
+private:
+	mutable MapObjectGrid<MapThing> grid_;
+	mutable vector<double>          pos_x_;
+	mutable vector<double>          pos_y_;
+	mutable vector<int>             types_;
+	mutable vector<int>             angles_;
 };
 } // namespace slade
@@ -40,22 +40,22 @@ using namespace slade;
 
 // -----------------------------------------------------------------------------
 //
-// VertexList Class Functions
+// Functions
 //
 // -----------------------------------------------------------------------------
-
-
+namespace
+{
 // -----------------------------------------------------------------------------
-// Returns the vertex closest to the point, or null if none found.
+// Returns the vertex in [vertices] closest to the point, or null if none found.
 // Igonres any vertices further away than [min]
 // -----------------------------------------------------------------------------
-MapVertex* VertexList::nearest(Vec2d point, double min) const
+MapVertex* nearestIn(const vector<MapVertex*>& vertices, Vec2d point, double min)
 {
 	// Go through vertices
 	double     dist;
 	double     min_dist = 999999999;
 	MapVertex* nearest  = nullptr;
-	for (const auto& vertex : objects_)
+	for (const auto& vertex : vertices)
 	{
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicabDistanceTo(vertex->position());
@@ -81,14 +81,14 @@ MapVertex* VertexList::nearest(Vec2d point, double min) const
 }
 
 // -----------------------------------------------------------------------------
-// Returns the vertex at [x,y], or null if none there
+// Returns the vertex in [vertices] at [x,y], or null if none there
 // -----------------------------------------------------------------------------
-MapVertex* VertexList::vertexAt(double x, double y) const
+MapVertex* vertexAtIn(const vector<MapVertex*>& vertices, double x, double y)
 {
 	// Go through all vertices
-	for (auto& vertex : objects_)
+	for (auto& vertex : vertices)
 	{
-		if (vertex->position_.x == x && vertex->position_.y == y)
+		if (vertex->xPos() == x && vertex->yPos() == y)
 			return vertex;
 	}
 
@@ -97,14 +97,14 @@ MapVertex* VertexList::vertexAt(double x, double y) const
 }
 
 // -----------------------------------------------------------------------------
-// Returns the first vertex that [line] crosses over
+// Returns the first vertex in [vertices] that [line] crosses over
 // -----------------------------------------------------------------------------
-MapVertex* VertexList::firstCrossed(const Seg2d& line) const
+MapVertex* firstCrossedIn(const vector<MapVertex*>& vertices, const Seg2d& line)
 {
 	// Go through vertices
 	MapVertex* cv       = nullptr;
 	double     min_dist = 999999;
-	for (const auto& vertex : objects_)
+	for (const auto& vertex : vertices)
 	{
 		auto point = vertex->position();
 
@@ -132,3 +132,157 @@ MapVertex* VertexList::firstCrossed(const Seg2d& line) const
 	// Return closest overlapping vertex to line start
 	return cv;
 }
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// VertexList Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Clears the list (and spatial index, geometry arrays)
+// -----------------------------------------------------------------------------
+void VertexList::clear()
+{
+	grid_.clear();
+	pos_x_.clear();
+	pos_y_.clear();
+	MapObjectList::clear();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [vertex] to the list, spatial index and geometry arrays
+// -----------------------------------------------------------------------------
+void VertexList::add(MapVertex* vertex)
+{
+	grid_.insert(vertex, { vertex->position(), vertex->position() });
+	pos_x_.push_back(vertex->xPos());
+	pos_y_.push_back(vertex->yPos());
+	MapObjectList::add(vertex);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the vertex at [index] from the list, spatial index and geometry
+// arrays
+// -----------------------------------------------------------------------------
+void VertexList::remove(unsigned index)
+{
+	if (index >= count_)
+		return;
+
+	grid_.remove(objects_[index]);
+	removeValue(pos_x_, index);
+	removeValue(pos_y_, index);
+	MapObjectList::remove(index);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the last vertex from the list, spatial index and geometry arrays
+// -----------------------------------------------------------------------------
+void VertexList::removeLast()
+{
+	grid_.remove(objects_.back());
+	pos_x_.pop_back();
+	pos_y_.pop_back();
+	MapObjectList::removeLast();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the vertex closest to the point, or null if none found.
+// Igonres any vertices further away than [min]
+// -----------------------------------------------------------------------------
+MapVertex* VertexList::nearest(Vec2d point, double min) const
+{
+	// Any vertex within [min] has a taxicab distance of no more than ~1.41x [min]
+	vector<MapVertex*> candidates;
+	grid_.nearestCandidates(
+		point, min * 1.5, [point](MapVertex* vertex) { return point.taxicabDistanceTo(vertex->position()); }, candidates);
+
+	return nearestIn(candidates, point, min);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the vertex at [x,y], or null if none there
+// -----------------------------------------------------------------------------
+MapVertex* VertexList::vertexAt(double x, double y) const
+{
+	BBox box;
+	box.min.set(x, y);
+	box.max.set(x, y);
+
+	vector<MapVertex*> candidates;
+	MapObjectGrid<MapVertex>::sortedCandidates(
+		[&](auto&& func) { grid_.forEachInBox(box, func); }, candidates);
+
+	return vertexAtIn(candidates, x, y);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the first vertex that [line] crosses over
+// -----------------------------------------------------------------------------
+MapVertex* VertexList::firstCrossed(const Seg2d& line) const
+{
+	vector<MapVertex*> candidates;
+	MapObjectGrid<MapVertex>::sortedCandidates(
+		[&](auto&& func) { grid_.forEachAlong(line, func); }, candidates);
+
+	return firstCrossedIn(candidates, line);
+}
+
+// -----------------------------------------------------------------------------
+// Returns all vertices within [box], in index order
+// -----------------------------------------------------------------------------
+vector<MapVertex*> VertexList::allInBox(const BBox& box) const
+{
+	vector<MapVertex*> candidates;
+	MapObjectGrid<MapVertex>::sortedCandidates(
+		[&](auto&& func) { grid_.forEachInBox(box, func); }, candidates);
+
+	vector<MapVertex*> vertices;
+	for (auto* vertex : candidates)
+		if (box.contains(vertex->position()))
+			vertices.push_back(vertex);
+
+	return vertices;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the position of [vertex] in the spatial index and geometry arrays,
+// if it is in this list
+// -----------------------------------------------------------------------------
+void VertexList::updateGeometry(MapVertex* vertex) const
+{
+	if (!isListed(vertex))
+		return;
+
+	grid_.update(vertex, { vertex->position(), vertex->position() });
+	pos_x_[vertex->index()] = vertex->xPos();
+	pos_y_[vertex->index()] = vertex->yPos();
+}
+
+// -----------------------------------------------------------------------------
+// Same as nearest, but checks every vertex in the list
+// -----------------------------------------------------------------------------
+MapVertex* VertexList::nearestLinear(Vec2d point, double min) const
+{
+	return nearestIn(objects_, point, min);
+}
+
+// -----------------------------------------------------------------------------
+// Same as vertexAt, but checks every vertex in the list
+// -----------------------------------------------------------------------------
+MapVertex* VertexList::vertexAtLinear(double x, double y) const
+{
+	return vertexAtIn(objects_, x, y);
+}
+
+// -----------------------------------------------------------------------------
+// Same as firstCrossed, but checks every vertex in the list
+// -----------------------------------------------------------------------------
+MapVertex* VertexList::firstCrossedLinear(const Seg2d& line) const
+{
+	return firstCrossedIn(objects_, line);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "MapObjectGrid.h"
 #include "MapObjectList.h"
 #include "SLADEMap/MapObject/MapVertex.h"
 
@@ -8,8 +9,32 @@ namespace slade
 class VertexList : public MapObjectList<MapVertex>
 {
 public:
-	MapVertex* nearest(Vec2d point, double min = 64) const;
-	MapVertex* vertexAt(double x, double y) const;
-	MapVertex* firstCrossed(const Seg2d& line) const;
+	// MapObjectList overrides
+	void clear() override;
+	void add(MapVertex* vertex) override;
+	void remove(unsigned index) override;
+	void removeLast() override;
+
+	MapVertex*         nearest(Vec2d point, double min = 64) const;
+	MapVertex*         vertexAt(double x, double y) const;
+	MapVertex*         firstCrossed(const Seg2d& line) const;
+	vector<MapVertex*> allInBox(const BBox& box) const;
+
+	// Vertex positions in index order, for fast read-only passes over all
+	// vertices
+	const vector<double>& xPositions() const { return pos_x_; }
+	const vector<double>& yPositions() const { return pos_y_; }
+
+	void updateGeometry(MapVertex* vertex) const;
+
+	// Brute-force versions of the above queries (for checking the grid)
+	MapVertex* nearestLinear(Vec2d point, double min = 64) const;
+	MapVertex* vertexAtLinear(double x, double y) const;
+	MapVertex* firstCrossedLinear(const Seg2d& line) const;
+
+private:
+	mutable MapObjectGrid<MapVertex> grid_;
+	mutable vector<double>           pos_x_;
+	mutable vector<double>           pos_y_;
 };
 } // namespace slade
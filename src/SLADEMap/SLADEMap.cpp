@@ -546,18 +546,14 @@ MapVertex* SLADEMap::createVertex(Vec2d pos, double split_dist)
 	// Check if this vertex splits any lines (if needed)
 	if (split_dist >= 0)
 	{
-		auto lines = data_.lines();
-		for (auto* line : lines)
+		for (auto* line : data_.lines().allNear(pos, split_dist))
 		{
 			// Skip line if it shares the vertex
 			if (line->v1() == nv || line->v2() == nv)
 				continue;
 
-			if (line->distanceTo(pos) < split_dist)
-			{
-				log::debug("Vertex at ({:1.2f},{:1.2f}) splits line {}", pos.x, pos.y, line->index());
-				splitLine(line, nv);
-			}
+			log::debug("Vertex at ({:1.2f},{:1.2f}) splits line {}", pos.x, pos.y, line->index());
+			splitLine(line, nv);
 		}
 	}
 
@@ -692,6 +688,8 @@ void SLADEMap::mergeVertices(unsigned vertex1, unsigned vertex2)
 			v1->connectLine(line);
 		}
 
+		data_.lines().updateGeometry(line);
+
 		if (line->vertex1_ == v1 && line->vertex2_ == v1)
 			zlines.push_back(line);
 	}
@@ -757,6 +755,7 @@ MapLine* SLADEMap::splitLine(MapLine* line, MapVertex* vertex)
 	line->vertex2_ = vertex;
 	vertex->connectLine(line);
 	line->length_ = -1;
+	data_.lines().updateGeometry(line);
 
 	// Create and add new sides
 	MapSide* s1 = nullptr;
@@ -805,26 +804,20 @@ MapLine* SLADEMap::splitLine(MapLine* line, MapVertex* vertex)
 void SLADEMap::splitLinesAt(MapVertex* vertex, double split_dist)
 {
 	// Check if this vertex splits any lines (if needed)
-	const auto nlines = data_.lines().size();
-	for (unsigned i = 0; i < nlines; ++i)
+	for (auto* line : data_.lines().allNear(vertex->position(), split_dist))
 	{
-		auto* line = this->line(i);
-
 		// Skip line if it shares the vertex
 		if (line->v1() == vertex || line->v2() == vertex)
 			continue;
 
-		if (line->distanceTo(vertex->position()) < split_dist)
-		{
-			log::info(
-				2,
-				"Vertex {} at ({:1.2f},{:1.2f}) splits line {}",
-				vertex->index_,
-				vertex->position_.x,
-				vertex->position_.y,
-				i);
-			splitLine(line, vertex);
-		}
+		log::info(
+			2,
+			"Vertex {} at ({:1.2f},{:1.2f}) splits line {}",
+			vertex->index_,
+			vertex->position_.x,
+			vertex->position_.y,
+			line->index_);
+		splitLine(line, vertex);
 	}
 }
 
@@ -863,6 +856,7 @@ bool SLADEMap::setLineSector(unsigned line_index, unsigned sector_index, bool fr
 			line->side1_ = side;
 		else
 			line->side2_ = side;
+		data_.lines().updateGeometry(line);
 
 		// Set appropriate line flags
 		const bool twosided = line->side1_ && line->side2_;
@@ -982,6 +976,7 @@ void SLADEMap::setLineSide(MapLine* line, MapSide* side, bool front)
 	else
 		line->side2_ = side;
 	side->parent_ = line;
+	data_.lines().updateGeometry(line);
 }
 
 // -----------------------------------------------------------------------------
@@ -1020,11 +1015,16 @@ bool SLADEMap::mergeArch(const vector<MapVertex*>& vertices)
 	// Split lines that moved onto existing vertices
 	for (unsigned a = 0; a < connected_lines.size(); a++)
 	{
-		const unsigned nvertices = nVertices();
-		for (unsigned b = 0; b < nvertices; b++)
+		// Only vertices around the line can be close enough to split it
+		// (with a little extra to allow for rounding)
+		const auto seg    = connected_lines[a]->seg();
+		const auto margin = split_dist + 1.;
+		BBox       box;
+		box.min.set(seg.left() - margin, seg.top() - margin);
+		box.max.set(seg.right() + margin, seg.bottom() + margin);
+
+		for (auto* vertex : data_.vertices().allInBox(box))
 		{
-			auto* vertex = this->vertex(b);
-
 			// Skip line if it shares the vertex
 			if (connected_lines[a]->v1() == vertex || connected_lines[a]->v2() == vertex)
 				continue;
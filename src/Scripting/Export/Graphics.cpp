@@ -39,6 +39,10 @@
 #include "Graphics/Palette/Palette.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "Graphics/SImage/SImage.h"
+#include "MainEditor/GfxConversion.h"
+#include "MainEditor/UI/ArchiveManagerPanel.h"
+#include "MainEditor/UI/ArchivePanel.h"
+#include "MainEditor/UI/MainWindow.h"
 #include "Scripting/Lua.h"
 #include "thirdparty/sol/sol.hpp"
 
@@ -771,6 +775,36 @@ sol::table getImageInfo(MemChunk& data, int index)
 		info.has_palette);
 }
 
+// -----------------------------------------------------------------------------
+// Converts all image [entries] to [format] using [options] and writes them
+// back. If the entries' archive is open in a tab, the conversion is recorded as
+// a single undo level there.
+// Returns a table with info about the conversion (gfxconversion::Result)
+// -----------------------------------------------------------------------------
+sol::table convertEntries(vector<ArchiveEntry*> entries, SIFormat* format, const SIFormat::ConvertOptions& options)
+{
+	UndoManager* undo_manager = nullptr;
+	if (!entries.empty() && entries[0]->parent() && theMainWindow)
+		if (auto panel = theMainWindow->archiveManagerPanel()->tabForArchive(entries[0]->parent()))
+			undo_manager = panel->undoManager();
+
+	auto result = gfxconversion::convertEntries(entries, { format, options }, undo_manager);
+
+	return lua::state().create_table_with(
+		"converted",
+		result.converted,
+		"skipped",
+		result.skipped,
+		"bytesIn",
+		result.bytes_in,
+		"bytesOut",
+		result.bytes_out,
+		"time",
+		result.time_ms,
+		"errors",
+		result.errors);
+}
+
 // -----------------------------------------------------------------------------
 // Registers the Graphics function namespace with lua
 // -----------------------------------------------------------------------------
@@ -796,6 +830,10 @@ void registerGraphicsNamespace(sol::state& lua)
 	};
 	gfx["DetectImageFormat"] = [](MemChunk& mc) { return SIFormat::determineFormat(mc); };
 	gfx["GetImageInfo"]      = sol::overload(&getImageInfo, [](MemChunk& data) { return getImageInfo(data, 0); });
+	gfx["ConvertEntries"]    = sol::overload(
+        &convertEntries,
+        [](const vector<ArchiveEntry*>& entries, SIFormat* format)
+        { return convertEntries(entries, format, SIFormat::ConvertOptions{}); });
 }
 
 } // namespace slade::lua
@@ -372,11 +372,11 @@ void registerMapObject(sol::state& lua)
 
 	// Functions
 	// -------------------------------------------------------------------------
-	lua_mapobject["HasProperty"]       = &MapObject::hasProp;
-	lua_mapobject["BoolProperty"]      = &MapObject::boolProperty;
-	lua_mapobject["IntProperty"]       = &MapObject::intProperty;
-	lua_mapobject["FloatProperty"]     = &MapObject::floatProperty;
-	lua_mapobject["StringProperty"]    = &MapObject::stringProperty;
+	lua_mapobject["HasProperty"]       = sol::resolve<bool(string_view) const>(&MapObject::hasProp);
+	lua_mapobject["BoolProperty"]      = sol::resolve<bool(string_view)>(&MapObject::boolProperty);
+	lua_mapobject["IntProperty"]       = sol::resolve<int(string_view)>(&MapObject::intProperty);
+	lua_mapobject["FloatProperty"]     = sol::resolve<double(string_view)>(&MapObject::floatProperty);
+	lua_mapobject["StringProperty"]    = sol::resolve<string(string_view)>(&MapObject::stringProperty);
 	lua_mapobject["SetBoolProperty"]   = &objectSetBoolProperty;
 	lua_mapobject["SetIntProperty"]    = &objectSetIntProperty;
 	lua_mapobject["SetFloatProperty"]  = &objectSetFloatProperty;
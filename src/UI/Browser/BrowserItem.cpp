@@ -173,10 +173,10 @@ void BrowserItem::draw(
 		return;
 	}
 
-	// Determine texture dimensions
+	// Determine image dimensions
 	auto&  tex_info = gl::Texture::info(image_tex_);
-	double width    = tex_info.size.x;
-	double height   = tex_info.size.y;
+	double width    = image_size_.x > 0 ? image_size_.x : tex_info.size.x;
+	double height   = image_size_.y > 0 ? image_size_.y : tex_info.size.y;
 
 	// Scale up if size > 128
 	if (size > 128)
@@ -35,9 +35,10 @@ protected:
 	wxString            type_;
 	wxString            name_;
 	unsigned            index_     = 0;
-	unsigned            image_tex_ = 0;
-	BrowserWindow*      parent_    = nullptr;
-	bool                blank_     = false;
+	unsigned            image_tex_  = 0;
+	Vec2i               image_size_ = { 0, 0 }; // Full image size if image_tex_ is a downscaled thumbnail
+	BrowserWindow*      parent_     = nullptr;
+	bool                blank_      = false;
 	unique_ptr<TextBox> text_box_;
 };
 } // namespace slade
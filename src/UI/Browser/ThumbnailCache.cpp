@@ -0,0 +1,580 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2022 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         https://slade.mancubus.net
+// Filename:    ThumbnailCache.cpp
+// Description: Persistent on-disk cache of browser item thumbnails, so large
+//              texture/flat sets don't need to be fully decoded again every
+//              time a browser is opened
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "ThumbnailCache.h"
+#include "App.h"
+#include "Archive/Archive.h"
+#include "General/Misc.h"
+#include "Utility/Compression.h"
+#include "Utility/FileUtils.h"
+#include <filesystem>
+#include <mutex>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, browser_thumbnail_cache, true, CVar::Flag::Save)
+CVAR(Int, thumbnail_cache_max_size, 256, CVar::Flag::Save) // In MB, unused thumbnails are dropped if larger
+CVAR(Int, thumbnail_size, 128, CVar::Flag::Save)           // Max thumbnail width/height
+
+namespace slade::thumbnailcache
+{
+// Pack file layout:
+// "SLTHUMB2", then for each thumbnail:
+// key length (u16), key, width, height, full width, full height (u16 each),
+// scale x, scale y (float each), data size (u32), deflated RGBA data
+const string file_header = "SLTHUMB2";
+
+struct Record
+{
+	uint32_t offset; // Offset of the compressed data
+	uint32_t data_size;
+	uint16_t width;
+	uint16_t height;
+	uint16_t full_width;
+	uint16_t full_height;
+	float    scale_x;
+	float    scale_y;
+	bool     used; // Read or written this session
+};
+
+#pragma pack(push, 1)
+struct RecordHeader
+{
+	uint16_t width;
+	uint16_t height;
+	uint16_t full_width;
+	uint16_t full_height;
+	float    scale_x;
+	float    scale_y;
+	uint32_t data_size;
+};
+#pragma pack(pop)
+
+std::unordered_map<string, Record> records;
+wxFile                             file;
+uint32_t                           file_end    = 0;
+bool                               file_opened = false;
+std::mutex                         file_mutex;
+Stats                              cache_stats;
+} // namespace slade::thumbnailcache
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the path to the thumbnail pack file
+// -----------------------------------------------------------------------------
+string packFilePath()
+{
+	return app::path("thumbnails.dat", app::Dir::User);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the maximum size of the pack file in bytes
+// -----------------------------------------------------------------------------
+uint32_t maxPackFileSize()
+{
+	return static_cast<uint32_t>(std::clamp<int>(thumbnail_cache_max_size, 1, 4095)) * 1024 * 1024;
+}
+
+// -----------------------------------------------------------------------------
+// Writes a thumbnail record for [key] with [record] info and compressed [data]
+// to [out] at its current position.
+// Returns false if it couldn't be fully written
+// -----------------------------------------------------------------------------
+bool writeRecord(wxFile& out, const string& key, const thumbnailcache::Record& record, const uint8_t* data)
+{
+	const auto                   key_length = static_cast<uint16_t>(key.size());
+	thumbnailcache::RecordHeader rh         = { record.width,   record.height,  record.full_width, record.full_height,
+												record.scale_x, record.scale_y, record.data_size };
+
+	return out.Write(&key_length, 2) == 2 && out.Write(key.data(), key_length) == key_length
+		   && out.Write(&rh, sizeof(rh)) == sizeof(rh) && out.Write(data, record.data_size) == record.data_size;
+}
+
+// -----------------------------------------------------------------------------
+// Creates (or truncates) the pack file at [path] with just the header, and
+// opens it. The cache mutex must be locked
+// -----------------------------------------------------------------------------
+bool createPackFile(const string& path)
+{
+	using namespace thumbnailcache;
+
+	records.clear();
+	file_end = 0;
+
+	{
+		wxFile new_file;
+		if (!new_file.Create(path, true)
+			|| new_file.Write(file_header.data(), file_header.size()) != file_header.size())
+			return false;
+	}
+
+	if (!file.Open(path, wxFile::read_write))
+		return false;
+
+	file_end = file_header.size();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the index of the opened pack file, stopping at the first incomplete
+// record (anything after that will be overwritten by new thumbnails).
+// Returns false if the file isn't a valid pack file.
+// The cache mutex must be locked
+// -----------------------------------------------------------------------------
+bool readPackFileIndex()
+{
+	using namespace thumbnailcache;
+
+	// Check header
+	string header(file_header.size(), 0);
+	if (file.Read(header.data(), header.size()) != header.size() || header != file_header)
+		return false;
+
+	// Read index
+	const auto file_size = static_cast<uint32_t>(file.Length());
+	uint32_t   offset    = file_header.size();
+	while (true)
+	{
+		uint16_t     key_length;
+		RecordHeader rh;
+		string       key;
+
+		if (file.Read(&key_length, 2) != 2)
+			break;
+		key.resize(key_length);
+		if (file.Read(key.data(), key_length) != key_length)
+			break;
+		if (file.Read(&rh, sizeof(RecordHeader)) != sizeof(RecordHeader))
+			break;
+
+		const uint32_t data_offset = offset + 2 + key_length + sizeof(RecordHeader);
+		if (data_offset + rh.data_size > file_size)
+			break;
+
+		records[key] = { data_offset,    rh.data_size, rh.width,   rh.height, rh.full_width,
+						 rh.full_height, rh.scale_x,   rh.scale_y, false };
+		offset       = data_offset + rh.data_size;
+		file.Seek(offset);
+	}
+	file_end = offset;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Opens the pack file and reads its index, if it isn't already.
+// The cache mutex must be locked
+// -----------------------------------------------------------------------------
+bool openPackFile()
+{
+	using namespace thumbnailcache;
+
+	if (file_opened)
+		return file.IsOpened();
+	file_opened = true;
+
+	// Open the existing pack file, unless it is too large or invalid
+	auto path = packFilePath();
+	if (fileutil::fileExists(path) && file.Open(path, wxFile::read_write))
+	{
+		if (file.Length() <= static_cast<wxFileOffset>(maxPackFileSize()) && readPackFileIndex())
+			return true;
+
+		file.Close();
+		records.clear();
+	}
+
+	// Otherwise start a new one
+	if (!createPackFile(path))
+	{
+		log::warning("Unable to create thumbnail cache file {}", path);
+		return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Rewrites the pack file with only the thumbnails used this session, to make
+// room for [needed] more bytes. Kept thumbnails fill at most half of the
+// maximum size, so this isn't needed again straight away.
+// The cache mutex must be locked
+// -----------------------------------------------------------------------------
+void compactPackFile(uint32_t needed)
+{
+	using namespace thumbnailcache;
+
+	const auto path      = packFilePath();
+	const auto temp_path = path + ".tmp";
+	const auto max_kept  = maxPackFileSize() / 2 > needed ? maxPackFileSize() / 2 - needed : 0;
+
+	// Write used thumbnails to a new pack file
+	std::unordered_map<string, Record> kept;
+	uint32_t                           offset = file_header.size();
+	bool                               ok     = true;
+	{
+		wxFile temp;
+		ok = temp.Create(temp_path, true) && temp.Write(file_header.data(), file_header.size()) == file_header.size();
+
+		MemChunk data;
+		for (const auto& [key, record] : records)
+		{
+			const auto record_size = static_cast<uint32_t>(2 + key.size() + sizeof(RecordHeader) + record.data_size);
+			if (!ok || !record.used || offset + record_size > max_kept)
+				continue;
+
+			file.Seek(record.offset);
+			if (!data.importFileStreamWx(file, record.data_size))
+				continue;
+
+			ok = writeRecord(temp, key, record, data.data());
+
+			auto& kept_record  = kept[key];
+			kept_record        = record;
+			kept_record.offset = static_cast<uint32_t>(offset + 2 + key.size() + sizeof(RecordHeader));
+			offset += record_size;
+		}
+	}
+
+	// Replace the pack file with it
+	std::error_code ec;
+	file.Close();
+	if (ok)
+		std::filesystem::rename(temp_path, path, ec);
+	if (ok && !ec && file.Open(path, wxFile::read_write))
+	{
+		log::info(2, "Compacted thumbnail cache ({} of {} thumbnails kept)", kept.size(), records.size());
+		records  = std::move(kept);
+		file_end = offset;
+		return;
+	}
+
+	// Something went wrong, start again
+	fileutil::removeFile(temp_path);
+	if (!createPackFile(path))
+		log::warning("Unable to create thumbnail cache file {}", path);
+}
+
+// -----------------------------------------------------------------------------
+// Returns [rgba] data of a [width]x[height] image, box-filtered down to fit
+// within [max_size]x[max_size]. [width] and [height] are updated to the new
+// size
+// -----------------------------------------------------------------------------
+vector<uint8_t> downscale(const uint8_t* rgba, int& width, int& height, int max_size)
+{
+	const int sw = width;
+	const int sh = height;
+	if (sw <= max_size && sh <= max_size)
+		return { rgba, rgba + sw * sh * 4 };
+
+	const double scale = static_cast<double>(max_size) / std::max(sw, sh);
+	width              = std::max(1, static_cast<int>(sw * scale + 0.5));
+	height             = std::max(1, static_cast<int>(sh * scale + 0.5));
+
+	vector<uint8_t> out(width * height * 4);
+	for (int y = 0; y < height; ++y)
+	{
+		const int y1 = y * sh / height;
+		const int y2 = std::max(y1 + 1, (y + 1) * sh / height);
+		for (int x = 0; x < width; ++x)
+		{
+			const int x1 = x * sw / width;
+			const int x2 = std::max(x1 + 1, (x + 1) * sw / width);
+
+			// Average the source box, weighting colour by alpha so transparent
+			// pixels don't bleed into the edges
+			unsigned r = 0, g = 0, b = 0, a = 0;
+			for (int sy = y1; sy < y2; ++sy)
+			{
+				auto* src = rgba + (sy * sw + x1) * 4;
+				for (int sx = x1; sx < x2; ++sx, src += 4)
+				{
+					r += src[0] * src[3];
+					g += src[1] * src[3];
+					b += src[2] * src[3];
+					a += src[3];
+				}
+			}
+
+			const unsigned count = (x2 - x1) * (y2 - y1);
+			auto*          dest  = out.data() + (y * width + x) * 4;
+			if (a > 0)
+			{
+				dest[0] = r / a;
+				dest[1] = g / a;
+				dest[2] = b / a;
+			}
+			dest[3] = a / count;
+		}
+	}
+
+	return out;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// ThumbnailCache Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns true if the thumbnail cache is enabled
+// -----------------------------------------------------------------------------
+bool thumbnailcache::enabled()
+{
+	return browser_thumbnail_cache;
+}
+
+// -----------------------------------------------------------------------------
+// Returns a string identifying the data of [entry] as it is on disk, from its
+// archive file path and modification time and its location in the archive.
+// Returns an empty string if [entry] has been modified since its archive was
+// opened or its archive isn't a file on disk, since its data can't be
+// identified without reading all of it
+// -----------------------------------------------------------------------------
+string thumbnailcache::sourceId(ArchiveEntry* entry)
+{
+	auto* archive = entry ? entry->parent() : nullptr;
+	if (!archive || !archive->isOnDisk() || archive->parentEntry()
+		|| entry->state() != ArchiveEntry::State::Unmodified)
+		return {};
+
+	return fmt::format(
+		"{}@{}:{}@{}+{}",
+		archive->filename(),
+		archive->fileModifiedTime(),
+		entry->path(true),
+		entry->fileOffset(),
+		entry->size());
+}
+
+// -----------------------------------------------------------------------------
+// Returns the cache key for a thumbnail of item [name], built from [sources]
+// (see sourceId) and converted using [pal]
+// -----------------------------------------------------------------------------
+string thumbnailcache::key(string_view name, string_view sources, const Palette* pal)
+{
+	uint32_t pal_crc = 0;
+	if (pal)
+	{
+		uint8_t pal_data[1024];
+		for (unsigned a = 0; a < 256; ++a)
+		{
+			auto col            = pal->colour(a);
+			pal_data[a * 4]     = col.r;
+			pal_data[a * 4 + 1] = col.g;
+			pal_data[a * 4 + 2] = col.b;
+			pal_data[a * 4 + 3] = col.a;
+		}
+		pal_crc = misc::crc(pal_data, 1024);
+	}
+
+	const auto sources_crc = misc::crc(reinterpret_cast<const uint8_t*>(sources.data()), sources.size());
+	return fmt::format("{}|{:08x}|{:08x}", name, sources_crc, pal_crc);
+}
+
+// -----------------------------------------------------------------------------
+// Loads the thumbnail for [key] into [thumb] if it exists in the cache.
+// Returns false if it doesn't
+// -----------------------------------------------------------------------------
+bool thumbnailcache::get(const string& key, Thumbnail& thumb)
+{
+	if (!browser_thumbnail_cache)
+		return false;
+
+	// Read compressed data
+	MemChunk data;
+	Record   record;
+	{
+		std::lock_guard lock(file_mutex);
+
+		auto i = openPackFile() ? records.find(key) : records.end();
+		if (i == records.end())
+		{
+			cache_stats.misses++;
+			return false;
+		}
+
+		record = i->second;
+		file.Seek(record.offset);
+		if (!data.importFileStreamWx(file, record.data_size))
+			return false;
+		i->second.used = true;
+		cache_stats.hits++;
+	}
+
+	// Decompress
+	vector<uint8_t> rgba(record.width * record.height * 4);
+	if (!compression::zipInflate(data.data(), data.size(), rgba.data(), rgba.size()))
+		return false;
+
+	thumb.image.setImageData(rgba, record.width, record.height, SImage::Type::RGBA);
+	thumb.size  = { record.full_width, record.full_height };
+	thumb.scale = { record.scale_x, record.scale_y };
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Creates a thumbnail of [image] (with [scale]) in [thumb] and adds it to the
+// cache as [key], unless [key] is empty. [pal] is used if the image is paletted
+// -----------------------------------------------------------------------------
+void thumbnailcache::put(const string& key, const SImage& image, const Vec2d& scale, Thumbnail& thumb, Palette* pal)
+{
+	// Create thumbnail
+	MemChunk full;
+	image.putRGBAData(full, pal);
+	int  width  = image.width();
+	int  height = image.height();
+	auto data   = downscale(full.data(), width, height, std::max<int>(thumbnail_size, 1));
+	thumb.image.setImageData(data, width, height, SImage::Type::RGBA);
+	thumb.size  = { image.width(), image.height() };
+	thumb.scale = scale;
+
+	if (!browser_thumbnail_cache || key.empty() || key.size() > 65535 || image.width() > 65535
+		|| image.height() > 65535)
+		return;
+
+	// Compress
+	MemChunk compressed;
+	if (!compression::zipDeflate(data.data(), data.size(), compressed))
+		return;
+
+	// Write to pack file, dropping unused thumbnails first if it would get too large
+	std::lock_guard lock(file_mutex);
+	if (!openPackFile() || records.count(key) > 0)
+		return;
+
+	const auto record_size = static_cast<uint32_t>(2 + key.size() + sizeof(RecordHeader) + compressed.size());
+	if (static_cast<uint64_t>(file_end) + record_size > maxPackFileSize())
+	{
+		compactPackFile(record_size);
+		if (!file.IsOpened())
+			return;
+	}
+
+	Record record = { static_cast<uint32_t>(file_end + 2 + key.size() + sizeof(RecordHeader)),
+					  compressed.size(),
+					  static_cast<uint16_t>(width),
+					  static_cast<uint16_t>(height),
+					  static_cast<uint16_t>(image.width()),
+					  static_cast<uint16_t>(image.height()),
+					  static_cast<float>(scale.x),
+					  static_cast<float>(scale.y),
+					  true };
+	if (file.Seek(file_end) != file_end || !writeRecord(file, key, record, compressed.data()))
+	{
+		// Leave file_end where it was so the incomplete record is overwritten
+		log::warning("Unable to write to thumbnail cache file");
+		return;
+	}
+
+	records[key] = record;
+	file_end     = record.offset + record.data_size;
+}
+
+// -----------------------------------------------------------------------------
+// Removes all thumbnails from the cache and deletes the pack file
+// -----------------------------------------------------------------------------
+void thumbnailcache::clear()
+{
+	std::lock_guard lock(file_mutex);
+
+	if (file.IsOpened())
+		file.Close();
+	fileutil::removeFile(packFilePath());
+
+	records.clear();
+	file_end    = 0;
+	file_opened = false;
+	cache_stats = {};
+}
+
+// -----------------------------------------------------------------------------
+// Returns the cache hit/miss counters and current size
+// -----------------------------------------------------------------------------
+thumbnailcache::Stats thumbnailcache::stats()
+{
+	std::lock_guard lock(file_mutex);
+
+	openPackFile();
+	auto stats      = cache_stats;
+	stats.entries   = records.size();
+	stats.file_size = file_end;
+	return stats;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+#include "General/Console.h"
+
+CONSOLE_COMMAND(thumbnail_cache, 0, true)
+{
+	if (!args.empty() && args[0] == "clear")
+	{
+		thumbnailcache::clear();
+		log::console("Thumbnail cache cleared");
+		return;
+	}
+
+	const auto stats = thumbnailcache::stats();
+	const auto total = stats.hits + stats.misses;
+	log::console(fmt::format(
+		"Thumbnail cache: {} thumbnails ({:.1f}MB), {} hits, {} misses ({:.1f}% hit rate) this session",
+		stats.entries,
+		stats.file_size / (1024.0 * 1024.0),
+		stats.hits,
+		stats.misses,
+		total > 0 ? stats.hits * 100.0 / total : 0.0));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Graphics/SImage/SImage.h"
+
+namespace slade
+{
+class ArchiveEntry;
+
+// Persistent store of downscaled item images for the browser windows, kept in a
+// single pack file in the user directory. Thumbnails are keyed by the name of
+// the item, the archive files and locations of the entries it is built from
+// and the palette used, so modified resources simply stop matching their old
+// thumbnails. Unused thumbnails are dropped when the pack file grows too large
+namespace thumbnailcache
+{
+	struct Thumbnail
+	{
+		SImage image;              // RGBA, downscaled
+		Vec2i  size;               // Size of the full image
+		Vec2d  scale = { 1., 1. }; // Scale of the full image (eg. for hires textures)
+	};
+
+	struct Stats
+	{
+		unsigned hits      = 0;
+		unsigned misses    = 0;
+		unsigned entries   = 0;
+		size_t   file_size = 0;
+	};
+
+	bool   enabled();
+	string sourceId(ArchiveEntry* entry);
+	string key(string_view name, string_view sources, const Palette* pal);
+	bool   get(const string& key, Thumbnail& thumb);
+	void   put(const string& key, const SImage& image, const Vec2d& scale, Thumbnail& thumb, Palette* pal = nullptr);
+	void   clear();
+	Stats  stats();
+} // namespace thumbnailcache
+} // namespace slade
@@ -134,8 +134,8 @@ void ConsolePanel::update()
 	setupTextArea();
 
 	// Check if any new log messages were added since the last update
-	auto& log = log::history();
-	if (log.size() <= next_message_index_)
+	const auto log = log::history(next_message_index_);
+	if (log.empty())
 	{
 		// None added, check again in 500ms
 		timer_update_.Start(500);
@@ -145,14 +145,14 @@ void ConsolePanel::update()
 	// Add new log messages to log text area
 	text_log_->SetEditable(true);
 	int line_no = next_message_index_;
-	for (auto a = next_message_index_; a < log.size(); ++a)
+	for (const auto& msg : log)
 	{
-		if (a > 0)
+		if (line_no > 0)
 			text_log_->AppendText("\n");
 
 		// Add message line + timestamp margin
-		text_log_->AppendText(log[a].message);
-		text_log_->MarginSetText(line_no, wxDateTime(log[a].timestamp).FormatISOTime());
+		text_log_->AppendText(msg.message);
+		text_log_->MarginSetText(line_no, wxDateTime(msg.timestamp).FormatISOTime());
 		text_log_->MarginSetStyle(line_no, wxSTC_STYLE_LINENUMBER);
 
 		// Set line colour depending on message type
@@ -161,7 +161,7 @@ void ConsolePanel::update()
 			, 0
 #endif
 		);
-		switch (log[a].type)
+		switch (msg.type)
 		{
 		case log::MessageType::Error: text_log_->SetStyling(text_log_->GetLineLength(line_no), 200); break;
 		case log::MessageType::Warning: text_log_->SetStyling(text_log_->GetLineLength(line_no), 201); break;
@@ -174,7 +174,7 @@ void ConsolePanel::update()
 	}
 	text_log_->SetEditable(false);
 
-	next_message_index_ = log::history().size();
+	next_message_index_ += log.size();
 	text_log_->ScrollToEnd();
 
 	// Check again in 100ms
@@ -39,6 +39,7 @@
 #include "Graphics/Icons.h"
 #include "Graphics/Palette/PaletteManager.h"
 #include "Graphics/SImage/SIFormat.h"
+#include "MainEditor/GfxConversion.h"
 #include "UI/Canvas/GfxCanvas.h"
 #include "UI/Controls/ColourBox.h"
 #include "UI/Controls/PaletteChooser.h"
@@ -608,6 +609,14 @@ void GfxConvDialog::applyConversion()
 	item.modified   = true;
 	item.new_format = current_format_.format;
 	item.palette    = pal_chooser_target_->selectedPalette(item.entry);
+
+	// The chooser's archive palette is shared and reloaded for each entry, so
+	// keep a copy of it for this item
+	if (pal_chooser_target_->globalSelected())
+	{
+		item.target_palette = std::make_shared<Palette>(*item.palette);
+		item.palette        = item.target_palette.get();
+	}
 }
 
 
@@ -645,19 +654,67 @@ void GfxConvDialog::onBtnConvert(wxCommandEvent& e)
 // -----------------------------------------------------------------------------
 void GfxConvDialog::onBtnConvertAll(wxCommandEvent& e)
 {
+	// Convert the current image as previewed
+	applyConversion();
+
 	// Show splash window
-	ui::showSplash("Converting Gfx...", true);
+	ui::showSplash("Converting Gfx...");
 
-	// Convert all images
-	for (size_t a = current_item_; a < items_.size(); a++)
+	// Setup the remaining images to be converted with the current options. The
+	// chooser's archive palette is reloaded for each entry, so each item gets
+	// its own copies of the palettes
+	SIFormat::ConvertOptions opt;
+	convertOptions(opt);
+	vector<gfxconversion::Item> conv_items;
+	vector<size_t>              conv_indices;
+	for (size_t a = current_item_ + 1; a < items_.size(); a++)
 	{
-		applyConversion();
-		if (!nextItem())
-			break;
+		auto& item = items_[a];
+
+		// Textures need to be built here, entries are loaded during conversion
+		if (!item.image.isValid() && item.texture)
+		{
+			if (item.force_rgba)
+				item.image.convertRGBA(item.palette);
+			if (!item.texture->toImage(item.image, item.archive, item.palette, item.force_rgba))
+				continue;
+		}
+
+		auto& conv = conv_items.emplace_back();
+		if (item.image.isValid())
+			conv.image.copyImage(&item.image);
+		else
+			conv.entry = item.entry;
+		conv.options.format  = current_format_.format;
+		conv.options.convert = opt;
+		conv.setPalettes(
+			pal_chooser_current_->selectedPalette(item.entry), pal_chooser_target_->selectedPalette(item.entry));
+		conv_indices.push_back(a);
+	}
+
+	// Convert them in one batch
+	auto result = gfxconversion::convertItems(conv_items, false);
+	log::info(2, result.summary());
+
+	// Update items
+	for (size_t a = 0; a < conv_items.size(); a++)
+	{
+		auto& conv = conv_items[a];
+		if (!conv.converted)
+			continue;
+
+		auto& item = items_[conv_indices[a]];
+		item.image.copyImage(&conv.image);
+		item.modified       = true;
+		item.new_format     = current_format_.format;
+		item.target_palette = conv.palette_target;
+		item.palette        = item.target_palette.get();
 	}
 
 	// Hide splash window
 	ui::hideSplash();
+
+	Close(true);
 }
 
 // -----------------------------------------------------------------------------
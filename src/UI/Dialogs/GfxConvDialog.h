@@ -83,6 +83,8 @@ private:
 		Archive*      archive    = nullptr;
 		bool          force_rgba = false;
 
+		shared_ptr<Palette> target_palette; // Copy of the archive palette the item was converted with
+
 		ConvItem(ArchiveEntry* entry = nullptr) : entry{ entry } {}
 
 		ConvItem(CTexture* texture, Palette* palette = nullptr, Archive* archive = nullptr, bool force_rgba = false) :
@@ -45,6 +45,7 @@ using namespace slade;
 EXTERN_CVAR(String, path_pngout)
 EXTERN_CVAR(String, path_pngcrush)
 EXTERN_CVAR(String, path_deflopt)
+EXTERN_CVAR(Bool, png_optimize_external)
 CVAR(String, dir_last_pngtool, "", CVar::Flag::Save)
 
 
@@ -64,9 +65,12 @@ PNGPrefsPanel::PNGPrefsPanel(wxWindow* parent) : PrefsPanelBase(parent)
 	auto sizer = new wxBoxSizer(wxVERTICAL);
 	SetSizer(sizer);
 
+	cb_external_ = new wxCheckBox(this, -1, "Use external tools instead of the built-in PNG optimizer");
+
 	wxutil::layoutVertically(
 		sizer,
-		vector<wxObject*>{ wxutil::createLabelVBox(
+		vector<wxObject*>{ cb_external_,
+						   wxutil::createLabelVBox(
 							   this,
 							   "Location of PNGout:",
 							   flp_pngout_ = new FileLocationPanel(
@@ -107,6 +111,7 @@ void PNGPrefsPanel::init()
 	flp_pngout_->setLocation(path_pngout);
 	flp_pngcrush_->setLocation(path_pngcrush);
 	flp_deflopt_->setLocation(path_deflopt);
+	cb_external_->SetValue(png_optimize_external);
 }
 
 // -----------------------------------------------------------------------------
@@ -114,7 +119,8 @@ void PNGPrefsPanel::init()
 // -----------------------------------------------------------------------------
 void PNGPrefsPanel::applyPreferences()
 {
-	path_pngout   = wxutil::strToView(flp_pngout_->location());
-	path_pngcrush = wxutil::strToView(flp_pngcrush_->location());
-	path_deflopt  = wxutil::strToView(flp_deflopt_->location());
+	path_pngout           = wxutil::strToView(flp_pngout_->location());
+	path_pngcrush         = wxutil::strToView(flp_pngcrush_->location());
+	path_deflopt          = wxutil::strToView(flp_deflopt_->location());
+	png_optimize_external = cb_external_->GetValue();
 }
@@ -37,6 +37,99 @@
 using namespace slade;
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Deflates [in_size] bytes from [in] to [out] in one pass, with the given zlib
+// [windowbits] and [strategy]
+// -----------------------------------------------------------------------------
+bool deflateBuffer(
+	const uint8_t* in,
+	size_t         in_size,
+	MemChunk&      out,
+	int            level,
+	int            windowbits,
+	int            strategy,
+	const char*    function)
+{
+	z_stream strm{};
+	if (deflateInit2(&strm, level, Z_DEFLATED, windowbits, 9, strategy) != Z_OK)
+	{
+		log::error("{} init error: {}", function, strm.msg ? strm.msg : "");
+		return false;
+	}
+
+	// Deflate everything straight into an output buffer big enough for the
+	// worst case
+	const auto bound = deflateBound(&strm, static_cast<uLong>(in_size));
+	if (!out.reSize(static_cast<uint32_t>(bound), false))
+	{
+		deflateEnd(&strm);
+		return false;
+	}
+
+	strm.next_in   = const_cast<Bytef*>(in);
+	strm.avail_in  = static_cast<uInt>(in_size);
+	strm.next_out  = out.data();
+	strm.avail_out = static_cast<uInt>(bound);
+
+	const auto ret = deflate(&strm, Z_FINISH);
+	const auto len = strm.total_out;
+	deflateEnd(&strm);
+
+	if (ret != Z_STREAM_END)
+	{
+		log::error("{} error {}", function, ret);
+		return false;
+	}
+
+	return out.reSize(static_cast<uint32_t>(len));
+}
+
+// -----------------------------------------------------------------------------
+// Inflates [in_size] bytes from [in] directly into the [out] buffer, which
+// must be exactly [out_size] bytes (the uncompressed size)
+// -----------------------------------------------------------------------------
+bool inflateBuffer(
+	const uint8_t* in,
+	size_t         in_size,
+	uint8_t*       out,
+	size_t         out_size,
+	int            windowbits,
+	const char*    function)
+{
+	z_stream strm{};
+	if (inflateInit2(&strm, windowbits) != Z_OK)
+	{
+		log::error("{} init error: {}", function, strm.msg ? strm.msg : "");
+		return false;
+	}
+
+	strm.next_in   = const_cast<Bytef*>(in);
+	strm.avail_in  = static_cast<uInt>(in_size);
+	strm.next_out  = out;
+	strm.avail_out = static_cast<uInt>(out_size);
+
+	const auto ret = inflate(&strm, Z_FINISH);
+	const auto len = strm.total_out;
+	inflateEnd(&strm);
+
+	if (ret != Z_STREAM_END || len != out_size)
+	{
+		log::warning("{}: stream inflated to {}, expected {}", function, len, out_size);
+		return false;
+	}
+
+	return true;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // Compression Namespace Functions
@@ -147,6 +240,44 @@ bool compression::zipInflate(MemChunk& in, MemChunk& out, size_t maxsize)
 	return ret;
 }
 
+// -----------------------------------------------------------------------------
+// Inflates [in_size] bytes of zip stream data from [in] directly into the
+// [out] buffer, which must be exactly [out_size] bytes (the uncompressed size).
+// Returns false if the data couldn't be inflated or its size didn't match
+// -----------------------------------------------------------------------------
+bool compression::zipInflate(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size)
+{
+	return inflateBuffer(in, in_size, out, out_size, -MAX_WBITS, "ZipInflate");
+}
+
+// -----------------------------------------------------------------------------
+// Inflates only the start of the zip stream data in [in] into the [out] buffer,
+// stopping once [out_size] bytes have been inflated or [in] runs out. [in] can
+// be a truncated stream. [out_size] is set to the number of bytes inflated.
+// Returns false if the stream couldn't be inflated
+// -----------------------------------------------------------------------------
+bool compression::zipInflatePrefix(const uint8_t* in, size_t in_size, uint8_t* out, size_t& out_size)
+{
+	z_stream strm{};
+	if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+	{
+		log::error("ZipInflate init error: {}", strm.msg ? strm.msg : "");
+		out_size = 0;
+		return false;
+	}
+
+	strm.next_in   = const_cast<Bytef*>(in);
+	strm.avail_in  = static_cast<uInt>(in_size);
+	strm.next_out  = out;
+	strm.avail_out = static_cast<uInt>(out_size);
+
+	const auto ret = inflate(&strm, Z_SYNC_FLUSH);
+	out_size       = strm.total_out;
+	inflateEnd(&strm);
+
+	return ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR;
+}
+
 // -----------------------------------------------------------------------------
 // Deflates the content of [in] as a gzip stream to [out].
 // GZip streams use a windowbits size of MAX_WBITS (15).
@@ -157,6 +288,16 @@ bool compression::zipDeflate(MemChunk& in, MemChunk& out, int level)
 	return compression::genericDeflate(in, out, level, -MAX_WBITS, "ZipDeflate");
 }
 
+// -----------------------------------------------------------------------------
+// Deflates [in_size] bytes from [in] as a zip stream to [out], in one pass.
+// Doesn't modify any state other than [out], so can be called for different
+// data on multiple threads at once
+// -----------------------------------------------------------------------------
+bool compression::zipDeflate(const uint8_t* in, size_t in_size, MemChunk& out, int level)
+{
+	return deflateBuffer(in, in_size, out, level, -MAX_WBITS, Z_DEFAULT_STRATEGY, "ZipDeflate");
+}
+
 // -----------------------------------------------------------------------------
 // Inflates the content of [in] as a gzip stream to [out].
 // GZip streams use a windowbits size of MAX_WBITS (15).
@@ -206,6 +347,36 @@ bool compression::zlibDeflate(MemChunk& in, MemChunk& out, int level)
 	return compression::genericDeflate(in, out, level, 0, "ZlibDeflate");
 }
 
+// -----------------------------------------------------------------------------
+// Inflates [in_size] bytes of zlib stream data from [in] directly into the
+// [out] buffer, which must be exactly [out_size] bytes (the uncompressed size).
+// Returns false if the data couldn't be inflated or its size didn't match
+// -----------------------------------------------------------------------------
+bool compression::zlibInflate(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size)
+{
+	return inflateBuffer(in, in_size, out, out_size, MAX_WBITS, "ZlibInflate");
+}
+
+// -----------------------------------------------------------------------------
+// Deflates [in_size] bytes from [in] as a zlib stream to [out], in one pass,
+// using the given deflate [strategy].
+// Doesn't modify any state other than [out], so can be called for different
+// data on multiple threads at once
+// -----------------------------------------------------------------------------
+bool compression::zlibDeflate(const uint8_t* in, size_t in_size, MemChunk& out, int level, DeflateStrategy strategy)
+{
+	int z_strategy = Z_DEFAULT_STRATEGY;
+	switch (strategy)
+	{
+	case DeflateStrategy::Filtered: z_strategy = Z_FILTERED; break;
+	case DeflateStrategy::HuffmanOnly: z_strategy = Z_HUFFMAN_ONLY; break;
+	case DeflateStrategy::RLE: z_strategy = Z_RLE; break;
+	default: break;
+	}
+
+	return deflateBuffer(in, in_size, out, level, MAX_WBITS, z_strategy, "ZlibDeflate");
+}
+
 // -----------------------------------------------------------------------------
 // Decompress the content of [in] as a bzip2 stream to [out]
 // -----------------------------------------------------------------------------
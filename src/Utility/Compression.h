@@ -2,14 +2,32 @@
 
 namespace slade::compression
 {
+enum class DeflateStrategy
+{
+	Default,
+	Filtered,
+	HuffmanOnly,
+	RLE
+};
+
 bool genericInflate(MemChunk& in, MemChunk& out, int windowbits, const char* function);
 bool genericDeflate(MemChunk& in, MemChunk& out, int level, int windowbits, const char* function);
 bool gzipInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
 bool gzipDeflate(MemChunk& in, MemChunk& out, int level = -1);
 bool zipInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
+bool zipInflate(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size);
+bool zipInflatePrefix(const uint8_t* in, size_t in_size, uint8_t* out, size_t& out_size);
 bool zipDeflate(MemChunk& in, MemChunk& out, int level = -1);
+bool zipDeflate(const uint8_t* in, size_t in_size, MemChunk& out, int level = -1);
 bool zlibInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
 bool zlibDeflate(MemChunk& in, MemChunk& out, int level = -1);
+bool zlibInflate(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size);
+bool zlibDeflate(
+	const uint8_t*  in,
+	size_t          in_size,
+	MemChunk&       out,
+	int             level    = -1,
+	DeflateStrategy strategy = DeflateStrategy::Default);
 bool zipExplode(MemChunk& in, MemChunk& out, size_t size, int flags);
 bool zipUnshrink(MemChunk& in, MemChunk& out, size_t maxsize);
 bool bzip2Decompress(MemChunk& in, MemChunk& out, size_t maxsize = 0);
@@ -0,0 +1,377 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2022 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MappedFile.cpp
+// Description: MappedFile class, a copy-on-write memory mapping of a file that
+//              MemChunks can reference instead of copying the file data
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MappedFile.h"
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+vector<weak_ptr<MappedFile>> mapped_files; // All currently existing file mappings
+std::mutex                   mapped_files_mutex;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MappedFile Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MappedFile class destructor
+// -----------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	unmap();
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the mapped file hasn't been changed (by another program)
+// since it was mapped. If it has, the mapped data may no longer match what was
+// originally read, and accessing data past the new end of the file (if it was
+// truncated) would crash (SIGBUS on posix systems).
+// This checks the mapped file itself, so it isn't affected by the file being
+// renamed, deleted or replaced with another one
+// -----------------------------------------------------------------------------
+bool MappedFile::fileUnchanged()
+{
+	if (changed_)
+		return false;
+
+	uint64_t size;
+	int64_t  time;
+	if (readFileInfo(size, time) && size == file_size_ && time == file_time_)
+		return true;
+
+	if (!changed_.exchange(true))
+		log::warning("Memory mapped file {} has been changed by another program", path_);
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Registers [mc] as viewing data within this mapping
+// -----------------------------------------------------------------------------
+void MappedFile::addView(MemChunk* mc)
+{
+	std::lock_guard lock(views_mutex_);
+	views_.insert(mc);
+}
+
+// -----------------------------------------------------------------------------
+// Unregisters [mc] as viewing data within this mapping
+// -----------------------------------------------------------------------------
+void MappedFile::removeView(MemChunk* mc)
+{
+	std::lock_guard lock(views_mutex_);
+	views_.erase(mc);
+}
+
+// -----------------------------------------------------------------------------
+// Maps the file at [path] into memory.
+// Returns false if the file couldn't be opened or mapped
+// -----------------------------------------------------------------------------
+bool MappedFile::map(string_view path)
+{
+	path_ = path;
+
+#ifdef _WIN32
+	auto wpath = std::filesystem::path{ path }.wstring();
+	auto file  = CreateFileW(
+		wpath.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	file_handle_ = file;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 || file_size.QuadPart > 0xFFFFFFFF)
+		return false;
+
+	auto mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (!mapping)
+		return false;
+	mapping_handle_ = mapping;
+
+	auto view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	if (!view)
+		return false;
+
+	data_ = static_cast<uint8_t*>(view);
+	size_ = static_cast<unsigned>(file_size.QuadPart);
+#else
+	const int fd = ::open(path_.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0 || file_stat.st_size > 0xFFFFFFFF)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// Private read/write mapping: any writes to the data are copy-on-write and
+	// never make it back to the file
+	auto view = mmap(nullptr, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// Keep the file open to check for changes to it
+	fd_   = fd;
+	data_ = static_cast<uint8_t*>(view);
+	size_ = static_cast<unsigned>(file_stat.st_size);
+#endif
+
+	uint64_t size;
+	int64_t  time;
+	if (!readFileInfo(size, time))
+		return false;
+	file_size_ = size;
+	file_time_ = time;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Unmaps the file from memory
+// -----------------------------------------------------------------------------
+void MappedFile::unmap()
+{
+#ifdef _WIN32
+	if (data_)
+		UnmapViewOfFile(data_);
+	if (mapping_handle_)
+		CloseHandle(mapping_handle_);
+	if (file_handle_)
+		CloseHandle(file_handle_);
+	mapping_handle_ = nullptr;
+	file_handle_    = nullptr;
+#else
+	if (data_)
+		munmap(data_, size_);
+	if (fd_ >= 0)
+		::close(fd_);
+	fd_ = -1;
+#endif
+
+	data_ = nullptr;
+	size_ = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Gets the current [size] and modification [time] of the mapped file.
+// Returns false if they couldn't be read
+// -----------------------------------------------------------------------------
+bool MappedFile::readFileInfo(uint64_t& size, int64_t& time) const
+{
+#ifdef _WIN32
+	BY_HANDLE_FILE_INFORMATION info;
+	if (!file_handle_ || !GetFileInformationByHandle(file_handle_, &info))
+		return false;
+
+	size = static_cast<uint64_t>(info.nFileSizeHigh) << 32 | info.nFileSizeLow;
+	time = static_cast<int64_t>(info.ftLastWriteTime.dwHighDateTime) << 32 | info.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat file_stat;
+	if (fd_ < 0 || fstat(fd_, &file_stat) != 0)
+		return false;
+
+	size = static_cast<uint64_t>(file_stat.st_size);
+#ifdef __APPLE__
+	time = static_cast<int64_t>(file_stat.st_mtimespec.tv_sec) * 1000000000 + file_stat.st_mtimespec.tv_nsec;
+#else
+	time = static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1000000000 + file_stat.st_mtim.tv_nsec;
+#endif
+#endif
+
+	return true;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// MappedFile Class Static Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Maps the file at [path] into memory.
+// Returns the mapping, or nullptr if the file could not be mapped
+// -----------------------------------------------------------------------------
+shared_ptr<MappedFile> MappedFile::open(string_view path)
+{
+	shared_ptr<MappedFile> mapped_file{ new MappedFile };
+	if (!mapped_file->map(path))
+	{
+		log::warning("Unable to memory map file {}", path);
+		return nullptr;
+	}
+
+	std::lock_guard lock(mapped_files_mutex);
+
+	// Clean up any expired mappings while we're here
+	mapped_files.erase(
+		std::remove_if(mapped_files.begin(), mapped_files.end(), [](const auto& mf) { return mf.expired(); }),
+		mapped_files.end());
+
+	mapped_files.push_back(mapped_file);
+
+	return mapped_file;
+}
+
+// -----------------------------------------------------------------------------
+// Returns all current mappings of the file at [path]
+// -----------------------------------------------------------------------------
+vector<shared_ptr<MappedFile>> MappedFile::mappingsOf(string_view path)
+{
+	vector<shared_ptr<MappedFile>> mappings;
+
+	std::lock_guard lock(mapped_files_mutex);
+	for (const auto& weak_mf : mapped_files)
+	{
+		auto            mf = weak_mf.lock();
+		std::error_code ec;
+		if (mf && mf->isMapped() && std::filesystem::equivalent(mf->path_, path, ec))
+			mappings.push_back(mf);
+	}
+
+	return mappings;
+}
+
+// -----------------------------------------------------------------------------
+// Detaches all MemChunks viewing mappings of the file at [path], copying the
+// data into their own memory, so that the file can be overwritten in place.
+// The mappings are considered changed from then on, so no new views of them
+// are created, and each is unmapped once nothing references it any more.
+// Only needed if the file can't be replaced instead (see writeFile)
+// -----------------------------------------------------------------------------
+void MappedFile::release(string_view path)
+{
+	for (const auto& mf : mappingsOf(path))
+	{
+		mf->changed_ = true;
+
+		vector<MemChunk*> views;
+		{
+			std::lock_guard lock(mf->views_mutex_);
+			views.assign(mf->views_.begin(), mf->views_.end());
+		}
+		for (auto* mc : views)
+			mc->unmap();
+
+		log::info(2, "Released memory mapped file {} ({} views detached)", mf->path_, views.size());
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Updates the recorded size and modification time of all mappings of the file
+// at [path], after SLADE has written to it in place. The writes must not have
+// changed any data viewed by MemChunks (eg. only appending to the file or
+// rewriting a header), otherwise release should be used beforehand
+// -----------------------------------------------------------------------------
+void MappedFile::fileUpdated(string_view path)
+{
+	for (const auto& mf : mappingsOf(path))
+	{
+		uint64_t size;
+		int64_t  time;
+		if (!mf->changed_ && mf->readFileInfo(size, time))
+		{
+			mf->file_size_ = size;
+			mf->file_time_ = time;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Writes the file at [path] by calling [write] with the path to write to.
+// If the file is memory mapped, it is written to a temporary file which then
+// replaces the original, so any data viewing the original mapping stays valid.
+// If it can't be replaced, the mappings are released and it is overwritten in
+// place instead.
+// Returns false if [write] failed
+// -----------------------------------------------------------------------------
+bool MappedFile::writeFile(string_view path, const std::function<bool(const string&)>& write)
+{
+	if (mappingsOf(path).empty())
+		return write(string{ path });
+
+	// Write to a temporary file next to the original, with the same permissions
+	const auto      temp_path = fmt::format("{}.slade.tmp", path);
+	std::error_code ec;
+	if (write(temp_path))
+	{
+		std::filesystem::permissions(temp_path, std::filesystem::status(path, ec).permissions(), ec);
+		std::filesystem::rename(temp_path, path, ec);
+		if (!ec)
+		{
+			log::info(2, "Replaced memory mapped file {}", path);
+			return true;
+		}
+
+		log::warning("Unable to replace memory mapped file {}: {}", path, ec.message());
+	}
+	std::filesystem::remove(temp_path, ec);
+
+	// Couldn't replace it, overwrite in place
+	release(path);
+	return write(string{ path });
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+namespace slade
+{
+class MemChunk;
+
+// A read-only, copy-on-write memory mapping of a file on disk. MemChunks can
+// 'view' part of a mapping rather than holding their own copy of the data (see
+// MemChunk::importMapped). Each view holds a reference to the mapping, which
+// stays mapped until the last view of it is gone.
+//
+// The file is kept open (shared, so other programs can still write, rename or
+// delete it) so that changes to it can be detected (see fileUnchanged). Files
+// that are mapped are replaced rather than overwritten when SLADE writes them
+// (see writeFile), so existing views always keep the original data
+class MappedFile
+{
+public:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	const string&  path() const { return path_; }
+	const uint8_t* data() const { return data_; }
+	uint8_t*       data() { return data_; }
+	unsigned       size() const { return size_; }
+	bool           isMapped() const { return data_ != nullptr; }
+	bool           fileUnchanged();
+
+	void addView(MemChunk* mc);
+	void removeView(MemChunk* mc);
+
+	static shared_ptr<MappedFile> open(string_view path);
+	static void                   release(string_view path);
+	static void                   fileUpdated(string_view path);
+	static bool                   writeFile(string_view path, const std::function<bool(const string&)>& write);
+
+private:
+	string                        path_;
+	uint8_t*                      data_ = nullptr;
+	unsigned                      size_ = 0;
+	std::unordered_set<MemChunk*> views_;
+	std::mutex                    views_mutex_;
+
+	// Size and modification time of the file when it was mapped (or last
+	// written by SLADE, see fileUpdated)
+	std::atomic<uint64_t> file_size_{ 0 };
+	std::atomic<int64_t>  file_time_{ 0 };
+	std::atomic<bool>     changed_{ false };
+
+#ifdef _WIN32
+	void* file_handle_    = nullptr;
+	void* mapping_handle_ = nullptr;
+#else
+	int fd_ = -1;
+#endif
+
+	MappedFile() = default;
+
+	bool map(string_view path);
+	void unmap();
+	bool readFileInfo(uint64_t& size, int64_t& time) const;
+
+	static vector<shared_ptr<MappedFile>> mappingsOf(string_view path);
+};
+} // namespace slade
@@ -34,10 +34,22 @@
 #include "MemChunk.h"
 #include "FileUtils.h"
 #include "General/Misc.h"
+#include "MappedFile.h"
 
 using namespace slade;
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+thread_local unsigned alloc_count = 0; // Data allocations made on this thread
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // MemChunk Class Functions
@@ -66,13 +78,33 @@ MemChunk::MemChunk(const uint8_t* data, uint32_t size) : size_{ size }
 	importMem(data, size);
 }
 
+// -----------------------------------------------------------------------------
+// MemChunk class copy constructor.
+// If [copy] is viewing memory mapped file data, this will view the same data
+// -----------------------------------------------------------------------------
+MemChunk::MemChunk(const MemChunk& copy)
+{
+	importMem(copy);
+}
+
 // -----------------------------------------------------------------------------
 // MemChunk class destructor
 // -----------------------------------------------------------------------------
 MemChunk::~MemChunk()
 {
 	// Free memory
-	delete[] data_;
+	freeData();
+}
+
+// -----------------------------------------------------------------------------
+// MemChunk copy assignment operator (see the copy constructor)
+// -----------------------------------------------------------------------------
+MemChunk& MemChunk::operator=(const MemChunk& copy)
+{
+	if (&copy != this)
+		importMem(copy);
+
+	return *this;
 }
 
 // -----------------------------------------------------------------------------
@@ -91,8 +123,7 @@ bool MemChunk::clear()
 {
 	if (hasData())
 	{
-		delete[] data_;
-		data_    = nullptr;
+		freeData();
 		size_    = 0;
 		cur_ptr_ = 0;
 		return true;
@@ -114,6 +145,13 @@ bool MemChunk::reSize(uint32_t new_size, bool preserve_data)
 		return false;
 	}
 
+	// Nothing to do if the (owned) data is already the requested size
+	if (new_size == size_ && data_ && !mapping_)
+	{
+		cur_ptr_ = preserve_data ? std::min(cur_ptr_, size_) : 0;
+		return true;
+	}
+
 	// Attempt to allocate memory for new size
 	auto ndata = allocData(new_size, false);
 	if (!ndata)
@@ -127,8 +165,8 @@ bool MemChunk::reSize(uint32_t new_size, bool preserve_data)
 	}
 	else if (data_ != nullptr)
 	{
-		memcpy(ndata, data_, size_ * sizeof(uint8_t));
-		delete[] data_;
+		memcpy(ndata, data_, std::min(size_, new_size) * sizeof(uint8_t));
+		freeData();
 		data_ = ndata;
 	}
 	else
@@ -280,6 +318,14 @@ bool MemChunk::importMem(const uint8_t* start, uint32_t len)
 	if (!start)
 		return false;
 
+	// Reuse the current (owned) data if it is already the right size
+	if (len > 0 && len == size_ && data_ && !mapping_)
+	{
+		memmove(data_, start, len);
+		cur_ptr_ = 0;
+		return true;
+	}
+
 	// Clear current data if it exists
 	clear();
 
@@ -298,6 +344,82 @@ bool MemChunk::importMem(const uint8_t* start, uint32_t len)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Loads the data from [other] into the MemChunk.
+// If [other] is viewing memory mapped file data, this will view the same data
+// rather than copying it
+// -----------------------------------------------------------------------------
+bool MemChunk::importMem(const MemChunk& other)
+{
+	if (other.mapping_ && other.hasData())
+		return importMapped(other.mapping_, other.data_ - other.mapping_->data(), other.size_);
+
+	return importMem(other.data_, other.size_);
+}
+
+// -----------------------------------------------------------------------------
+// Memory maps the file [filename] and sets the MemChunk to view all of it.
+// Returns false if the file couldn't be mapped
+// -----------------------------------------------------------------------------
+bool MemChunk::importFileMapped(string_view filename)
+{
+	auto mapping = MappedFile::open(filename);
+	if (!mapping)
+		return false;
+
+	return importMapped(mapping, 0, mapping->size());
+}
+
+// -----------------------------------------------------------------------------
+// Sets the MemChunk to view [len] bytes of the memory mapped file [mapping],
+// starting from [offset]. No data is copied until the MemChunk is written to
+// or resized (see unmap).
+// Returns false if the given range is outside of the mapped data
+// -----------------------------------------------------------------------------
+bool MemChunk::importMapped(const shared_ptr<MappedFile>& mapping, uint32_t offset, uint32_t len)
+{
+	// Check parameters
+	if (!mapping || !mapping->isMapped() || offset > mapping->size() || len > mapping->size() - offset)
+		return false;
+
+	// Clear current data if it exists
+	clear();
+
+	// Empty, no need to view anything
+	if (len == 0)
+		return true;
+
+	// View mapped data
+	mapping_ = mapping;
+	mapping_->addView(this);
+	data_    = mapping_->data() + offset;
+	size_    = len;
+	cur_ptr_ = 0;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// If the MemChunk is viewing memory mapped file data, copies it into memory
+// owned by the MemChunk.
+// Returns false if the copy failed
+// -----------------------------------------------------------------------------
+bool MemChunk::unmap()
+{
+	if (!mapping_)
+		return true;
+
+	auto ndata = allocData(size_, false);
+	if (!ndata)
+		return false;
+
+	memcpy(ndata, data_, size_);
+	freeData();
+	data_ = ndata;
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Writes the MemChunk data to a new file of [filename], starting from [start]
 // to [start+size].
@@ -317,19 +439,21 @@ bool MemChunk::exportFile(string_view filename, uint32_t start, uint32_t size) c
 	if (size == 0)
 		size = size_ - start;
 
-	// Open file for writing
-	wxFile file(wxString{ filename.data(), filename.size() }, wxFile::write);
-	if (!file.IsOpened())
-	{
-		log::error("Unable to write to file {}", filename);
-		global::error = "Unable to open file for writing";
-		return false;
-	}
-
-	// Write the data
-	file.Write(data_ + start, size);
+	// Write the data (replacing the file if it is memory mapped)
+	return MappedFile::writeFile(
+		filename,
+		[this, start, size](const string& path)
+		{
+			wxFile file(path, wxFile::write);
+			if (!file.IsOpened())
+			{
+				log::error("Unable to write to file {}", path);
+				global::error = "Unable to open file for writing";
+				return false;
+			}
 
-	return true;
+			return file.Write(data_ + start, size) == size;
+		});
 }
 
 // -----------------------------------------------------------------------------
@@ -351,6 +475,10 @@ bool MemChunk::exportMemChunk(MemChunk& mc, uint32_t start, uint32_t size) const
 	if (size == 0)
 		size = size_ - start;
 
+	// Memory mapped data can be shared rather than copied
+	if (mapping_)
+		return mc.importMapped(mapping_, data_ - mapping_->data() + start, size);
+
 	// Write data to MemChunk
 	mc.reSize(size, false);
 	return mc.importMem(data_ + start, size);
@@ -377,6 +505,10 @@ bool MemChunk::write(unsigned offset, const void* data, unsigned size, bool expa
 			return false;
 	}
 
+	// Don't write to memory mapped data
+	if (!unmap())
+		return false;
+
 	// Write the data
 	memcpy(data_ + offset, data, size);
 
@@ -420,6 +552,10 @@ bool MemChunk::write(const void* buffer, uint32_t count)
 	if (cur_ptr_ + count > size_)
 		reSize(cur_ptr_ + count, true);
 
+	// Don't write to memory mapped data
+	if (!unmap())
+		return false;
+
 	// Write the data and move to the byte after what was written
 	memcpy(data_ + cur_ptr_, buffer, count);
 	cur_ptr_ += count;
@@ -529,10 +665,10 @@ bool MemChunk::readMC(MemChunk& mc, uint32_t size)
 // Overwrites all data bytes with [val] (basically is memset).
 // Returns false if no data exists, true otherwise
 // -----------------------------------------------------------------------------
-bool MemChunk::fillData(uint8_t val) const
+bool MemChunk::fillData(uint8_t val)
 {
-	// Check data exists
-	if (!hasData())
+	// Check data exists (and isn't shared memory mapped data)
+	if (!hasData() || !unmap())
 		return false;
 
 	// Fill data with value
@@ -566,6 +702,15 @@ string MemChunk::asString(uint32_t offset, uint32_t length) const
 	return s;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the number of data allocations made by MemChunks on the calling
+// thread so far
+// -----------------------------------------------------------------------------
+unsigned MemChunk::allocationCount()
+{
+	return alloc_count;
+}
+
 
 // -----------------------------------------------------------------------------
 // Allocates [size] bytes of data and returns it, or null if the allocation
@@ -593,8 +738,25 @@ uint8_t* MemChunk::allocData(uint32_t size, bool set_data)
 		return nullptr;
 	}
 
+	alloc_count++;
 	if (set_data)
 		data_ = ndata;
 
 	return ndata;
 }
+
+// -----------------------------------------------------------------------------
+// Frees the current data, or stops viewing it if it is memory mapped
+// -----------------------------------------------------------------------------
+void MemChunk::freeData()
+{
+	if (mapping_)
+	{
+		mapping_->removeView(this);
+		mapping_.reset();
+	}
+	else
+		delete[] data_;
+
+	data_ = nullptr;
+}
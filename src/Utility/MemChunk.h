@@ -5,6 +5,7 @@
 namespace slade
 {
 class SFile;
+class MappedFile;
 
 class MemChunk : public SeekableData
 {
@@ -12,13 +13,27 @@ public:
 	MemChunk() = default;
 	MemChunk(uint32_t size);
 	MemChunk(const uint8_t* data, uint32_t size);
+	MemChunk(const MemChunk& copy);
 	~MemChunk() override;
 
-	uint8_t& operator[](int a) const { return data_[a]; }
+	MemChunk& operator=(const MemChunk& copy);
+
+	// Non-const access to memory mapped data copies it first (see unmap), so
+	// any changes don't show up in other MemChunks viewing the same data
+	const uint8_t& operator[](int a) const { return data_[a]; }
+	uint8_t&       operator[](int a)
+	{
+		unmap();
+		return data_[a];
+	}
 
 	// Accessors
 	const uint8_t* data() const { return data_; }
-	uint8_t*       data() { return data_; }
+	uint8_t*       data()
+	{
+		unmap();
+		return data_;
+	}
 
 	// SeekableData
 	unsigned size() const override { return size_; }
@@ -39,7 +54,14 @@ public:
 	bool importFileStreamWx(wxFile& file, uint32_t len = 0);
 	bool importFileStream(SFile& file, unsigned len = 0);
 	bool importMem(const uint8_t* start, uint32_t len);
-	bool importMem(const MemChunk& other) { return importMem(other.data_, other.size_); }
+	bool importMem(const MemChunk& other);
+
+	// Memory mapped data
+	bool                          isMapped() const { return mapping_ != nullptr; }
+	const shared_ptr<MappedFile>& mapping() const { return mapping_; }
+	bool                          importFileMapped(string_view filename);
+	bool                          importMapped(const shared_ptr<MappedFile>& mapping, uint32_t offset, uint32_t len);
+	bool                          unmap();
 
 	// Data export
 	bool exportFile(string_view filename, uint32_t start = 0, uint32_t size = 0) const;
@@ -58,10 +80,12 @@ public:
 	bool readMC(MemChunk& mc, uint32_t size);
 
 	// Misc
-	bool     fillData(uint8_t val) const;
+	bool     fillData(uint8_t val);
 	uint32_t crc() const;
 	string   asString(uint32_t offset = 0, uint32_t length = 0) const;
 
+	static unsigned allocationCount();
+
 	// Platform-independent functions to read values in little (L##) or big (B##) endian
 	uint16_t readL16(unsigned i) const { return data_[i] + (data_[i + 1] << 8); }
 	uint32_t readL24(unsigned i) const { return data_[i] + (data_[i + 1] << 8) + (data_[i + 2] << 16); }
@@ -77,10 +101,12 @@ public:
 	}
 
 protected:
-	uint8_t* data_    = nullptr;
-	uint32_t cur_ptr_ = 0;
-	uint32_t size_    = 0;
+	uint8_t*               data_    = nullptr;
+	uint32_t               cur_ptr_ = 0;
+	uint32_t               size_    = 0;
+	shared_ptr<MappedFile> mapping_; // If set, data_ points into this mapping rather than owned memory
 
 	uint8_t* allocData(uint32_t size, bool set_data = true);
+	void     freeData();
 };
 } // namespace slade
@@ -34,10 +34,136 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "Property.h"
+#include <deque>
+#include <mutex>
 
 using namespace slade;
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Names of the keys in property::keys, in order
+const char* hot_key_names[] = {
+	"alpha",           "renderstyle",     "wrapmidtex",         "offsetx_top",          "offsety_top",
+	"scalex_top",      "scaley_top",      "offsetx_mid",        "offsety_mid",          "scalex_mid",
+	"scaley_mid",      "offsetx_bottom",  "offsety_bottom",     "scalex_bottom",        "scaley_bottom",
+	"xpanningfloor",   "ypanningfloor",   "xscalefloor",        "yscalefloor",          "rotationfloor",
+	"xpanningceiling", "ypanningceiling", "xscaleceiling",      "yscaleceiling",        "rotationceiling",
+	"lightfloor",      "lightceiling",    "lightfloorabsolute", "lightceilingabsolute", "lightcolor",
+	"fadecolor"
+};
+static_assert(std::size(hot_key_names) == property::keys::Count);
+
+// A table of interned property keys. Key names are indexed by an open
+// addressing hash table for case-insensitive lookups.
+// Keys are only added to a table while it has room, and each key's name is
+// written before the key is published in the index, so the table can be read
+// without locking while a key is being added
+struct KeyTable
+{
+	unsigned                                      capacity;
+	unsigned                                      index_mask;
+	std::unique_ptr<std::atomic<const string*>[]> names; // By key
+	std::unique_ptr<std::atomic<unsigned>[]>      index; // Key + 1 in each slot (0 if empty)
+	std::atomic<unsigned>                         count = 0;
+
+	explicit KeyTable(unsigned capacity) :
+		capacity{ capacity },
+		index_mask{ capacity * 2 - 1 },
+		names{ std::make_unique<std::atomic<const string*>[]>(capacity) },
+		index{ std::make_unique<std::atomic<unsigned>[]>(capacity * 2) }
+	{
+	}
+
+	std::optional<property::Key> find(string_view name, uint32_t hash) const
+	{
+		for (auto slot = hash & index_mask;; slot = (slot + 1) & index_mask)
+		{
+			const auto entry = index[slot].load(std::memory_order_acquire);
+			if (entry == 0)
+				return {};
+			if (strutil::equalCI(*names[entry - 1].load(std::memory_order_relaxed), name))
+				return entry - 1;
+		}
+	}
+
+	property::Key add(const string* name, uint32_t hash)
+	{
+		const auto key = count.load(std::memory_order_relaxed);
+		names[key].store(name, std::memory_order_relaxed);
+
+		auto slot = hash & index_mask;
+		while (index[slot].load(std::memory_order_relaxed) != 0)
+			slot = (slot + 1) & index_mask;
+		index[slot].store(key + 1, std::memory_order_release);
+		count.store(key + 1, std::memory_order_release);
+
+		return key;
+	}
+};
+
+// All interned property keys. Keys are added under the mutex, and a full table
+// is replaced with a copy twice its size. Replaced tables are kept since other
+// threads may still be reading them, which at most doubles the memory used
+struct KeyTables
+{
+	std::mutex                   mutex;
+	std::deque<string>           names; // By key, never moved
+	vector<unique_ptr<KeyTable>> tables;
+	std::atomic<KeyTable*>       current = nullptr;
+
+	KeyTables()
+	{
+		grow(256);
+		for (auto name : hot_key_names)
+			add(name, hash(name));
+	}
+
+	static uint32_t hash(string_view name)
+	{
+		// Case-insensitive FNV-1a
+		uint32_t hash = 2166136261u;
+		for (auto c : name)
+			hash = (hash ^ std::tolower(static_cast<unsigned char>(c))) * 16777619u;
+		return hash;
+	}
+
+	void grow(unsigned capacity)
+	{
+		auto table = std::make_unique<KeyTable>(capacity);
+		for (const auto& name : names)
+			table->add(&name, hash(name));
+
+		current.store(table.get(), std::memory_order_release);
+		tables.push_back(std::move(table));
+	}
+
+	property::Key add(string_view name, uint32_t hash)
+	{
+		auto table = current.load(std::memory_order_relaxed);
+		if (table->count.load(std::memory_order_relaxed) == table->capacity)
+		{
+			grow(table->capacity * 2);
+			table = current.load(std::memory_order_relaxed);
+		}
+
+		return table->add(&names.emplace_back(name), hash);
+	}
+};
+
+KeyTables& keyTables()
+{
+	static KeyTables tables;
+	return tables;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // Property namespace functions
@@ -131,6 +257,45 @@ string asString(const Property& prop, int float_precision)
 	default: return {};
 	}
 }
+
+// -----------------------------------------------------------------------------
+// Returns the interned key for property [name] (case-insensitive), adding it
+// to the key table if it doesn't exist yet
+// -----------------------------------------------------------------------------
+Key key(string_view name)
+{
+	auto&      tables = keyTables();
+	const auto hash   = KeyTables::hash(name);
+	if (auto key = tables.current.load(std::memory_order_acquire)->find(name, hash))
+		return *key;
+
+	// Not found, add it (unless another thread already has)
+	std::lock_guard lock(tables.mutex);
+	if (auto key = tables.current.load(std::memory_order_relaxed)->find(name, hash))
+		return *key;
+
+	return tables.add(name, hash);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the property name for [key] (as it was first given to property::key)
+// -----------------------------------------------------------------------------
+const string& keyName(Key key)
+{
+	const auto table = keyTables().current.load(std::memory_order_acquire);
+	if (key >= table->count.load(std::memory_order_acquire))
+		return strutil::EMPTY;
+
+	return *table->names[key].load(std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of property keys in the key table
+// -----------------------------------------------------------------------------
+unsigned numKeys()
+{
+	return keyTables().current.load(std::memory_order_acquire)->count.load(std::memory_order_acquire);
+}
 } // namespace slade::property
 
 // -----------------------------------------------------------------------------
@@ -162,3 +327,175 @@ string PropertyList::toString(bool condensed, int float_precision) const
 
 	return ret;
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// KeyedPropertyList Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the value held in the slot as a Property
+// -----------------------------------------------------------------------------
+Property KeyedPropertyList::Slot::value() const
+{
+	switch (type)
+	{
+	case property::ValueType::Bool: return b;
+	case property::ValueType::Int: return i;
+	case property::ValueType::UInt: return u;
+	case property::ValueType::Float: return f;
+	case property::ValueType::String: return *s;
+	default: return {};
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Copies all properties from [copy]
+// -----------------------------------------------------------------------------
+KeyedPropertyList& KeyedPropertyList::operator=(const KeyedPropertyList& copy)
+{
+	if (&copy == this)
+		return *this;
+
+	clear();
+	slots_ = copy.slots_;
+	for (auto& slot : slots_)
+		if (slot.type == property::ValueType::String)
+			slot.s = new string{ *slot.s };
+
+	return *this;
+}
+
+// -----------------------------------------------------------------------------
+// Takes all properties from [other], leaving it empty
+// -----------------------------------------------------------------------------
+KeyedPropertyList& KeyedPropertyList::operator=(KeyedPropertyList&& other) noexcept
+{
+	if (&other == this)
+		return *this;
+
+	clear();
+	slots_.swap(other.slots_);
+
+	return *this;
+}
+
+// -----------------------------------------------------------------------------
+// Returns all properties in the list as name+value pairs
+// -----------------------------------------------------------------------------
+vector<Named<Property>> KeyedPropertyList::properties() const
+{
+	vector<Named<Property>> list;
+	list.reserve(slots_.size());
+	for (const auto& slot : slots_)
+		list.emplace_back(property::keyName(slot.key), slot.value());
+
+	return list;
+}
+
+// -----------------------------------------------------------------------------
+// Sets the property [key] to [value], adding it if it doesn't exist
+// -----------------------------------------------------------------------------
+void KeyedPropertyList::set(property::Key key, Property value)
+{
+	Slot* slot = nullptr;
+	for (auto& existing : slots_)
+		if (existing.key == key)
+		{
+			slot = &existing;
+			break;
+		}
+
+	if (!slot)
+	{
+		slot       = &slots_.emplace_back();
+		slot->key  = key;
+		slot->type = property::ValueType::Bool;
+	}
+
+	// Reuse the existing string allocation if both old and new are strings
+	const auto type = property::valueType(value);
+	if (slot->type == property::ValueType::String)
+	{
+		if (type == property::ValueType::String)
+		{
+			*slot->s = std::move(std::get<string>(value));
+			return;
+		}
+
+		delete slot->s;
+	}
+
+	slot->type = type;
+	switch (type)
+	{
+	case property::ValueType::Bool: slot->b = std::get<bool>(value); break;
+	case property::ValueType::Int: slot->i = std::get<int>(value); break;
+	case property::ValueType::UInt: slot->u = std::get<unsigned int>(value); break;
+	case property::ValueType::Float: slot->f = std::get<double>(value); break;
+	case property::ValueType::String: slot->s = new string{ std::move(std::get<string>(value)) }; break;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Removes the property [key] from the list.
+// Returns false if the property didn't exist
+// -----------------------------------------------------------------------------
+bool KeyedPropertyList::remove(property::Key key)
+{
+	for (auto i = slots_.begin(); i != slots_.end(); ++i)
+		if (i->key == key)
+		{
+			if (i->type == property::ValueType::String)
+				delete i->s;
+
+			slots_.erase(i);
+			return true;
+		}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Removes all properties from the list
+// -----------------------------------------------------------------------------
+void KeyedPropertyList::clear()
+{
+	for (auto& slot : slots_)
+		if (slot.type == property::ValueType::String)
+			delete slot.s;
+
+	slots_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Returns a string representation of the property list
+// -----------------------------------------------------------------------------
+string KeyedPropertyList::toString(bool condensed, int float_precision) const
+{
+	string ret;
+
+	for (const auto& slot : slots_)
+	{
+		// Add "key = value;\n" to the return string
+		string val;
+		if (slot.type == property::ValueType::String)
+		{
+			val = strutil::escapedString(*slot.s, false, true);
+			val.insert(val.begin(), '\"');
+			val.push_back('\"');
+		}
+		else
+			val = property::asString(slot.value(), float_precision);
+
+		if (condensed)
+			ret += fmt::format("{}={};\n", property::keyName(slot.key), val);
+		else
+			ret += fmt::format("{} = {};\n", property::keyName(slot.key), val);
+	}
+
+	return ret;
+}
@@ -48,6 +48,60 @@ namespace property
 	double       asFloat(const Property& prop);
 	string       asString(const Property& prop, int float_precision = 0);
 
+	// Interned property keys.
+	// Each (case-insensitive) property name is given a unique integer Key the
+	// first time it is seen, so property lookups can compare integers instead
+	// of strings. Looking up existing keys and their names doesn't lock
+	using Key = unsigned;
+
+	Key           key(string_view name);
+	const string& keyName(Key key);
+	unsigned      numKeys();
+
+	// Keys for frequently read UDMF properties, which are interned before any
+	// others so they can be used without looking them up. These are only for
+	// properties kept in MapObject property lists, not ones a MapObject type
+	// handles itself (eg. a line's special)
+	namespace keys
+	{
+		enum : Key
+		{
+			Alpha,
+			RenderStyle,
+			WrapMidTex,
+			OffsetXTop,
+			OffsetYTop,
+			ScaleXTop,
+			ScaleYTop,
+			OffsetXMid,
+			OffsetYMid,
+			ScaleXMid,
+			ScaleYMid,
+			OffsetXBottom,
+			OffsetYBottom,
+			ScaleXBottom,
+			ScaleYBottom,
+			XPanningFloor,
+			YPanningFloor,
+			XScaleFloor,
+			YScaleFloor,
+			RotationFloor,
+			XPanningCeiling,
+			YPanningCeiling,
+			XScaleCeiling,
+			YScaleCeiling,
+			RotationCeiling,
+			LightFloor,
+			LightCeiling,
+			LightFloorAbsolute,
+			LightCeilingAbsolute,
+			LightColor,
+			FadeColor,
+
+			Count
+		};
+	} // namespace keys
+
 } // namespace property
 
 class PropertyList
@@ -144,4 +198,117 @@ public:
 private:
 	vector<Named<Property>> properties_;
 };
+
+// A compact property list keyed by interned property keys (see property::key).
+// Non-string values are stored inline in a 16 byte slot, strings are allocated
+// separately. Properties are kept in the order they were added
+class KeyedPropertyList
+{
+public:
+	KeyedPropertyList() = default;
+	KeyedPropertyList(const KeyedPropertyList& copy) { *this = copy; }
+	KeyedPropertyList(KeyedPropertyList&& other) noexcept { *this = std::move(other); }
+	~KeyedPropertyList() { clear(); }
+
+	KeyedPropertyList& operator=(const KeyedPropertyList& copy);
+	KeyedPropertyList& operator=(KeyedPropertyList&& other) noexcept;
+
+	bool     empty() const { return slots_.empty(); }
+	unsigned size() const { return slots_.size(); }
+
+	bool contains(property::Key key) const { return find(key) != nullptr; }
+	bool contains(string_view key) const { return contains(property::key(key)); }
+
+	std::optional<Property> getIf(property::Key key) const
+	{
+		if (auto* slot = find(key))
+			return slot->value();
+
+		return {};
+	}
+	std::optional<Property> getIf(string_view key) const { return getIf(property::key(key)); }
+
+	template<typename T> std::optional<T> getIf(property::Key key) const
+	{
+		auto* slot = find(key);
+		if (!slot)
+			return {};
+
+		if constexpr (std::is_same_v<T, bool>)
+		{
+			if (slot->type == property::ValueType::Bool)
+				return slot->b;
+		}
+		else if constexpr (std::is_same_v<T, int>)
+		{
+			if (slot->type == property::ValueType::Int)
+				return slot->i;
+		}
+		else if constexpr (std::is_same_v<T, unsigned int>)
+		{
+			if (slot->type == property::ValueType::UInt)
+				return slot->u;
+		}
+		else if constexpr (std::is_same_v<T, double>)
+		{
+			if (slot->type == property::ValueType::Float)
+				return slot->f;
+		}
+		else if constexpr (std::is_same_v<T, string>)
+		{
+			if (slot->type == property::ValueType::String)
+				return *slot->s;
+		}
+
+		return {};
+	}
+	template<typename T> std::optional<T> getIf(string_view key) const { return getIf<T>(property::key(key)); }
+
+	template<typename T> T getOr(property::Key key, T default_val) const
+	{
+		if (auto val = getIf<T>(key))
+			return *val;
+
+		return default_val;
+	}
+
+	// Returns all properties as name+value pairs
+	vector<Named<Property>> properties() const;
+
+	void set(property::Key key, Property value);
+	void set(string_view key, Property value) { set(property::key(key), std::move(value)); }
+	bool remove(property::Key key);
+	bool remove(string_view key) { return remove(property::key(key)); }
+	void clear();
+
+	string toString(bool condensed = false, int float_precision = 0) const;
+
+private:
+	struct Slot
+	{
+		property::Key       key;
+		property::ValueType type;
+		union
+		{
+			bool         b;
+			int          i;
+			unsigned int u;
+			double       f;
+			string*      s; // Owned by the list
+		};
+
+		Property value() const;
+	};
+
+	vector<Slot> slots_;
+
+	const Slot* find(property::Key key) const
+	{
+		for (const auto& slot : slots_)
+			if (slot.key == key)
+				return &slot;
+
+		return nullptr;
+	}
+};
 } // namespace slade
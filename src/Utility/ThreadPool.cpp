@@ -0,0 +1,245 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2022 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    ThreadPool.cpp
+// Description: A simple pool of worker threads for running background tasks
+//              and splitting loops across multiple cores
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "ThreadPool.h"
+#include <atomic>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, max_worker_threads, 0, CVar::Flag::Save)
+
+
+// -----------------------------------------------------------------------------
+//
+// ThreadPool Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// ThreadPool class constructor.
+// If [num_threads] is 0, the default number of threads is used (see
+// defaultNumThreads)
+// -----------------------------------------------------------------------------
+ThreadPool::ThreadPool(unsigned num_threads)
+{
+	if (num_threads == 0)
+		num_threads = defaultNumThreads();
+
+	for (unsigned a = 0; a < num_threads; ++a)
+		workers_.emplace_back([this] { workerLoop(); });
+}
+
+// -----------------------------------------------------------------------------
+// ThreadPool class destructor.
+// Waits for any queued tasks to finish before returning
+// -----------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(mutex_);
+		stopping_ = true;
+	}
+	task_added_.notify_all();
+
+	for (auto& worker : workers_)
+		worker.join();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [task] to the queue, to be run on the next available worker thread.
+// Returns a future that becomes ready once the task has completed
+// -----------------------------------------------------------------------------
+std::future<void> ThreadPool::queue(std::function<void()> task)
+{
+	std::packaged_task<void()> ptask(std::move(task));
+	auto                       future = ptask.get_future();
+
+	// No workers, just run it now
+	if (workers_.empty())
+	{
+		ptask();
+		return future;
+	}
+
+	{
+		std::lock_guard lock(mutex_);
+		tasks_.push_back(std::move(ptask));
+	}
+	task_added_.notify_one();
+
+	return future;
+}
+
+// -----------------------------------------------------------------------------
+// Calls [func] for each index from 0 to [count]-1, spread across the worker
+// threads and the calling thread. Blocks until all indices are processed.
+//
+// [func] must be safe to call concurrently for different indices. Indices are
+// handed out in ascending order, but may complete in any order.
+// [min_per_task] is the minimum number of indices worth giving to each thread,
+// for loops where each call is very cheap.
+// If [func] throws, no further indices are processed and the first exception is
+// rethrown once all threads have stopped using [func]
+// -----------------------------------------------------------------------------
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func, size_t min_per_task)
+{
+	if (count == 0)
+		return;
+
+	// Not worth splitting up, just run everything on this thread
+	const auto max_tasks = count / std::max<size_t>(min_per_task, 1);
+	if (workers_.empty() || max_tasks < 2)
+	{
+		for (size_t a = 0; a < count; ++a)
+			func(a);
+		return;
+	}
+
+	// Shared state, kept alive by any helper tasks that start late
+	struct State
+	{
+		std::atomic<size_t>     next{ 0 };
+		std::atomic<size_t>     done{ 0 };
+		size_t                  count = 0;
+		std::mutex              mutex;
+		std::condition_variable finished;
+		std::atomic<bool>       failed{ false };
+		std::exception_ptr      error; // First exception thrown by func (guarded by mutex)
+	};
+	auto state   = std::make_shared<State>();
+	state->count = count;
+
+	// Processes indices until there are none left. Indices are always counted
+	// as done, even if func throws or is skipped after an earlier exception,
+	// so the wait below always finishes
+	auto process = [state, &func]()
+	{
+		size_t n_done = 0;
+		for (auto i = state->next++; i < state->count; i = state->next++)
+		{
+			if (!state->failed)
+			{
+				try
+				{
+					func(i);
+				}
+				catch (...)
+				{
+					std::lock_guard lock(state->mutex);
+					if (!state->error)
+						state->error = std::current_exception();
+					state->failed = true;
+				}
+			}
+			++n_done;
+		}
+
+		if (n_done > 0 && state->done.fetch_add(n_done) + n_done == state->count)
+		{
+			std::lock_guard lock(state->mutex);
+			state->finished.notify_all();
+		}
+	};
+
+	// Queue helper tasks on the workers
+	const auto n_helpers = std::min<size_t>(workers_.size(), max_tasks - 1);
+	for (size_t a = 0; a < n_helpers; ++a)
+		queue(process);
+
+	// Help out on this thread, then wait for any indices still being processed
+	process();
+	std::unique_lock lock(state->mutex);
+	state->finished.wait(lock, [&state] { return state->done == state->count; });
+
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+// -----------------------------------------------------------------------------
+// Worker thread main loop, runs queued tasks until the pool is stopped
+// -----------------------------------------------------------------------------
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::packaged_task<void()> task;
+		{
+			std::unique_lock lock(mutex_);
+			task_added_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+			if (stopping_ && tasks_.empty())
+				return;
+
+			task = std::move(tasks_.front());
+			tasks_.pop_front();
+		}
+
+		task();
+	}
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// ThreadPool Class Static Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the global, shared ThreadPool (created on first use)
+// -----------------------------------------------------------------------------
+ThreadPool& ThreadPool::global()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of worker threads to use by default: the number of
+// hardware threads minus one (for the main thread), or the max_worker_threads
+// cvar if it is set
+// -----------------------------------------------------------------------------
+unsigned ThreadPool::defaultNumThreads()
+{
+	if (max_worker_threads > 0)
+		return static_cast<unsigned>(max_worker_threads);
+
+	const auto hw_threads = std::thread::hardware_concurrency();
+	return hw_threads > 1 ? hw_threads - 1 : 0;
+}
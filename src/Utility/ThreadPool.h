@@ -0,0 +1,34 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace slade
+{
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned num_threads = 0);
+	~ThreadPool();
+
+	unsigned numThreads() const { return static_cast<unsigned>(workers_.size()); }
+
+	std::future<void> queue(std::function<void()> task);
+	void              parallelFor(size_t count, const std::function<void(size_t)>& func, size_t min_per_task = 1);
+
+	static ThreadPool& global();
+	static unsigned    defaultNumThreads();
+
+private:
+	vector<std::thread>                    workers_;
+	std::deque<std::packaged_task<void()>> tasks_;
+	std::mutex                             mutex_;
+	std::condition_variable                task_added_;
+	bool                                   stopping_ = false;
+
+	void workerLoop();
+};
+} // namespace slade